@@ -20,6 +20,9 @@
 
 #include "AAudioFlowGraph.h"
 
+#include <algorithm>
+#include <audio_utils/format.h>
+
 #include <flowgraph/Limiter.h>
 #include <flowgraph/ManyToMultiConverter.h>
 #include <flowgraph/MonoBlend.h>
@@ -39,6 +42,19 @@
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
 
+// Formats that the Source and Sink nodes convert with the audio_utils primitives,
+// so the fused graph gives the same output by using memcpy_by_audio_format().
+static bool isFusibleFormat(audio_format_t format) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_FLOAT:
+        case AUDIO_FORMAT_PCM_16_BIT:
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+            return true;
+        default:
+            return false;
+    }
+}
+
 aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
                           int32_t sourceChannelCount,
                           int32_t sourceSampleRate,
@@ -153,19 +169,72 @@ aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
     }
     lastOutput->connect(&mSink->input);
 
+    mFused = isFusibleFormat(sourceFormat) && isFusibleFormat(sinkFormat)
+            && !useMonoBlend
+            && sourceSampleRate == sinkSampleRate
+            && sourceChannelCount == sinkChannelCount;
+    if (mFused) {
+        mSourceFormat = sourceFormat;
+        mSinkFormat = sinkFormat;
+        mChannelCount = sinkChannelCount;
+        mSourceBytesPerFrame = audio_bytes_per_frame(sourceChannelCount, sourceFormat);
+        mSinkBytesPerFrame = audio_bytes_per_frame(sinkChannelCount, sinkFormat);
+        mFusedBuffer.resize(kFusedBlockFrames * sinkChannelCount);
+    }
+
     return AAUDIO_OK;
 }
 
 int32_t AAudioFlowGraph::pull(void *destination, int32_t targetFramesToRead) {
+    if (mFused) {
+        return processFused(static_cast<uint8_t *>(destination), targetFramesToRead);
+    }
     return mSink->read(destination, targetFramesToRead);
 }
 
 int32_t AAudioFlowGraph::process(const void *source, int32_t numFramesToWrite, void *destination,
                     int32_t targetFramesToRead) {
+    if (mFused) {
+        mFusedSource = static_cast<const uint8_t *>(source);
+        mFusedFramesPending = numFramesToWrite;
+        return processFused(static_cast<uint8_t *>(destination), targetFramesToRead);
+    }
     mSource->setData(source, numFramesToWrite);
     return mSink->read(destination, targetFramesToRead);
 }
 
+int32_t AAudioFlowGraph::processFused(uint8_t *destination, int32_t framesToRead) {
+    const int32_t framesToProcess = std::min(framesToRead, mFusedFramesPending);
+    int32_t framesLeft = framesToProcess;
+    while (framesLeft > 0) {
+        const int32_t frames = std::min(framesLeft, kFusedBlockFrames);
+        const int32_t numSamples = frames * mChannelCount;
+        // A float sink is processed in place in the destination.
+        float *block = mSinkFormat == AUDIO_FORMAT_PCM_FLOAT
+                ? reinterpret_cast<float *>(destination) : mFusedBuffer.data();
+
+        // The same conversions as the Source and Sink nodes.
+        memcpy_by_audio_format(block, AUDIO_FORMAT_PCM_FLOAT,
+                               mFusedSource, mSourceFormat, numSamples);
+        if (mLimiter) {
+            mLimiter->process(block, block, numSamples);
+        }
+        for (int32_t i = 0; i < static_cast<int32_t>(mVolumeRamps.size()); i++) {
+            mVolumeRamps[i]->process(block + i, block + i, frames, mChannelCount);
+        }
+        if (mSinkFormat != AUDIO_FORMAT_PCM_FLOAT) {
+            memcpy_by_audio_format(destination, mSinkFormat,
+                                   block, AUDIO_FORMAT_PCM_FLOAT, numSamples);
+        }
+
+        mFusedSource += frames * mSourceBytesPerFrame;
+        destination += frames * mSinkBytesPerFrame;
+        framesLeft -= frames;
+    }
+    mFusedFramesPending -= framesToProcess;
+    return framesToProcess;
+}
+
 /**
  * @param volume between 0.0 and 1.0
  */
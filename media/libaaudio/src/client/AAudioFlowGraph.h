@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <stdint.h>
+#include <vector>
 #include <sys/types.h>
 #include <system/audio.h>
 
@@ -76,6 +77,7 @@ public:
     // target value and sample rate converters start with no phase offset.
     void reset() {
         mSink->pullReset();
+        mFusedFramesPending = 0;
     }
 
     /**
@@ -113,6 +115,34 @@ public:
     void setRampLengthInFrames(int32_t numFrames);
 
 private:
+    /**
+     * Process up to framesToRead of the pending source frames in a single pass,
+     * used when the graph is fused. See mFused.
+     *
+     * @return number of frames written to the destination
+     */
+    int32_t processFused(uint8_t *destination, int32_t framesToRead);
+
+    // Frames processed per pass by processFused().
+    // Larger than kDefaultBufferSize so that the loops of each step can be vectorized,
+    // and small enough that the block stays in the L1 cache between steps.
+    static constexpr int32_t kFusedBlockFrames = 256;
+
+    // When there is no sample rate conversion, mono blend or channel conversion,
+    // the graph is only a format conversion with an optional Limiter and volume ramps.
+    // Then process() and pull() run all those steps on blocks of kFusedBlockFrames,
+    // instead of pulling kDefaultBufferSize frames at a time through each node.
+    // The nodes are still connected so reset() and the ramp setters are unchanged.
+    bool mFused = false;
+    audio_format_t mSourceFormat = AUDIO_FORMAT_INVALID;
+    audio_format_t mSinkFormat = AUDIO_FORMAT_INVALID;
+    int32_t mChannelCount = 0;
+    size_t mSourceBytesPerFrame = 0;
+    size_t mSinkBytesPerFrame = 0;
+    std::vector<float> mFusedBuffer;
+    const uint8_t *mFusedSource = nullptr;
+    int32_t mFusedFramesPending = 0;
+
     std::unique_ptr<FLOWGRAPH_OUTER_NAMESPACE::flowgraph::FlowGraphSourceBuffered> mSource;
     std::unique_ptr<RESAMPLER_OUTER_NAMESPACE::resampler::MultiChannelResampler> mResampler;
     std::unique_ptr<FLOWGRAPH_OUTER_NAMESPACE::flowgraph::SampleRateConverter> mRateConverter;
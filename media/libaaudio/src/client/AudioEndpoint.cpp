@@ -215,6 +215,21 @@ android::fifo_frames_t AudioEndpoint::write(void *buffer, android::fifo_frames_t
     return mDataQueue == nullptr ? 0 : mDataQueue->write(buffer, numFrames);
 }
 
+android::fifo_frames_t AudioEndpoint::readWithConversion(void *buffer, audio_format_t format,
+                                                         audio_format_t deviceFormat,
+                                                         android::fifo_frames_t numFrames) {
+    return mDataQueue == nullptr ? 0
+            : mDataQueue->readWithConversion(buffer, format, deviceFormat, numFrames);
+}
+
+android::fifo_frames_t AudioEndpoint::writeWithConversion(const void *buffer,
+                                                          audio_format_t format,
+                                                          audio_format_t deviceFormat,
+                                                          android::fifo_frames_t numFrames) {
+    return mDataQueue == nullptr ? 0
+            : mDataQueue->writeWithConversion(buffer, format, deviceFormat, numFrames);
+}
+
 void AudioEndpoint::advanceWriteIndex(int32_t deltaFrames) {
     if (mDataQueue != nullptr) {
         mDataQueue->advanceWriteIndex(deltaFrames);
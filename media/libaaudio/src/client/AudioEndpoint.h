@@ -65,6 +65,22 @@ public:
 
     android::fifo_frames_t write(void* buffer, android::fifo_frames_t numFrames);
 
+    /**
+     * Read and convert from the device format of the data queue.
+     * See FifoBuffer::readWithConversion().
+     */
+    android::fifo_frames_t readWithConversion(void* buffer, audio_format_t format,
+                                              audio_format_t deviceFormat,
+                                              android::fifo_frames_t numFrames);
+
+    /**
+     * Convert to the device format of the data queue and write.
+     * See FifoBuffer::writeWithConversion().
+     */
+    android::fifo_frames_t writeWithConversion(const void* buffer, audio_format_t format,
+                                               audio_format_t deviceFormat,
+                                               android::fifo_frames_t numFrames);
+
     void advanceReadIndex(int32_t deltaFrames);
 
     void advanceWriteIndex(int32_t deltaFrames);
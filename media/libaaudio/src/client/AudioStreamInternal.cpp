@@ -982,3 +982,16 @@ int32_t AudioStreamInternal::getDeviceBufferCapacity() const {
 bool AudioStreamInternal::isClockModelInControl() const {
     return isActive() && mAudioEndpoint->isFreeRunning() && mClockModel.isRunning();
 }
+
+bool AudioStreamInternal::canConvertInFifo(audio_format_t sourceFormat,
+                                           audio_format_t sinkFormat,
+                                           bool useVolumeRamps) const {
+    return !useVolumeRamps
+            && !getRequireMonoBlend()
+            && getSampleRate() == getDeviceSampleRate()
+            && getSamplesPerFrame() == getDeviceSamplesPerFrame()
+            && android::FifoBuffer::isConversionSupported(sourceFormat)
+            && android::FifoBuffer::isConversionSupported(sinkFormat)
+            // The flowgraph applies a Limiter for float to float.
+            && !(sourceFormat == AUDIO_FORMAT_PCM_FLOAT && sinkFormat == AUDIO_FORMAT_PCM_FLOAT);
+}
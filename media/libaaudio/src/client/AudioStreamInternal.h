@@ -153,6 +153,19 @@ protected:
      */
     bool isClockModelInControl() const;
 
+    /**
+     * Does the data path only need a format conversion, with the same sample rate and
+     * channel count and no other processing? Then it can be done by the FifoBuffer while
+     * copying to or from the endpoint, rather than by mFlowGraph.
+     *
+     * @param sourceFormat format of the data going into the flowgraph
+     * @param sinkFormat format of the data coming out of the flowgraph
+     * @param useVolumeRamps as passed to AAudioFlowGraph::configure()
+     * @return true if the flowgraph can be skipped
+     */
+    bool canConvertInFifo(audio_format_t sourceFormat, audio_format_t sinkFormat,
+                          bool useVolumeRamps) const;
+
     IsochronousClockModel    mClockModel;      // timing model for chasing the HAL
 
     std::unique_ptr<AudioEndpoint> mAudioEndpoint;   // source for reads or sink for writes
@@ -183,6 +196,7 @@ protected:
     int64_t                  mLastFramesRead = 0;
 
     AAudioFlowGraph          mFlowGraph;
+    bool                     mConvertInFifo = false; // skip mFlowGraph, see canConvertInFifo()
 
 private:
     /*
@@ -64,6 +64,8 @@ aaudio_result_t AudioStreamInternalCapture::open(const AudioStreamBuilder &build
         if (result != AAUDIO_OK) {
             safeReleaseClose();
         }
+        mConvertInFifo = canConvertInFifo(getDeviceFormat(), getFormat(),
+                                          false /* useVolumeRamps */);
     }
     return result;
 }
@@ -188,6 +190,11 @@ aaudio_result_t AudioStreamInternalCapture::processDataNow(void *buffer, int32_t
 
 aaudio_result_t AudioStreamInternalCapture::readNowWithConversion(void *buffer,
                                                                 int32_t numFrames) {
+    if (mConvertInFifo) {
+        return mAudioEndpoint->readWithConversion(buffer, getFormat(), getDeviceFormat(),
+                                                  numFrames);
+    }
+
     WrappingBuffer wrappingBuffer;
     uint8_t *byteBuffer = (uint8_t *) buffer;
     int32_t framesLeftInByteBuffer = numFrames;
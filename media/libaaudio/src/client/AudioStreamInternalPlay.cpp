@@ -66,6 +66,7 @@ aaudio_result_t AudioStreamInternalPlay::open(const AudioStreamBuilder &builder)
         if (result != AAUDIO_OK) {
             safeReleaseClose();
         }
+        mConvertInFifo = canConvertInFifo(getFormat(), getDeviceFormat(), useVolumeRamps);
         // Sample rate is constrained to common values by now and should not overflow.
         int32_t numFrames = kRampMSec * getSampleRate() / AAUDIO_MILLIS_PER_SECOND;
         mFlowGraph.setRampLengthInFrames(numFrames);
@@ -295,6 +296,11 @@ aaudio_result_t AudioStreamInternalPlay::processDataNow(void *buffer, int32_t nu
 
 aaudio_result_t AudioStreamInternalPlay::writeNowWithConversion(const void *buffer,
                                                             int32_t numFrames) {
+    if (mConvertInFifo) {
+        return mAudioEndpoint->writeWithConversion(buffer, getFormat(), getDeviceFormat(),
+                                                   numFrames);
+    }
+
     WrappingBuffer wrappingBuffer;
     uint8_t *byteBuffer = (uint8_t *) buffer;
     int32_t framesLeftInByteBuffer = numFrames;
@@ -25,6 +25,8 @@
 #include <algorithm>
 #include <memory>
 
+#include <audio_utils/format.h>
+
 #include "FifoControllerBase.h"
 #include "FifoController.h"
 #include "FifoControllerIndirect.h"
@@ -174,6 +176,92 @@ fifo_frames_t FifoBuffer::write(const void *buffer, fifo_frames_t numFrames) {
     return framesWritten;
 }
 
+/* static */
+bool FifoBuffer::isConversionSupported(audio_format_t format) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_16_BIT:
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+        case AUDIO_FORMAT_PCM_FLOAT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+fifo_frames_t FifoBuffer::readWithConversion(void *buffer, audio_format_t destinationFormat,
+                                             audio_format_t fifoFormat,
+                                             fifo_frames_t numFrames) {
+    WrappingBuffer wrappingBuffer;
+    uint8_t *destination = (uint8_t *) buffer;
+    fifo_frames_t framesLeft = numFrames;
+    const int32_t samplesPerFrame = mBytesPerFrame / audio_bytes_per_sample(fifoFormat);
+    const int32_t bytesPerDestinationFrame =
+            samplesPerFrame * audio_bytes_per_sample(destinationFormat);
+
+    getFullDataAvailable(&wrappingBuffer);
+
+    // Read and convert data in one or two parts.
+    int partIndex = 0;
+    while (framesLeft > 0 && partIndex < WrappingBuffer::SIZE) {
+        fifo_frames_t framesToRead = framesLeft;
+        fifo_frames_t framesAvailable = wrappingBuffer.numFrames[partIndex];
+        if (framesAvailable > 0) {
+            if (framesToRead > framesAvailable) {
+                framesToRead = framesAvailable;
+            }
+            // Uses the vectorized audio_utils primitives, or memcpy for the same format.
+            memcpy_by_audio_format(destination, destinationFormat,
+                                   wrappingBuffer.data[partIndex], fifoFormat,
+                                   framesToRead * samplesPerFrame);
+
+            destination += framesToRead * bytesPerDestinationFrame;
+            framesLeft -= framesToRead;
+        } else {
+            break;
+        }
+        partIndex++;
+    }
+    fifo_frames_t framesRead = numFrames - framesLeft;
+    mFifo->advanceReadIndex(framesRead);
+    return framesRead;
+}
+
+fifo_frames_t FifoBuffer::writeWithConversion(const void *buffer, audio_format_t sourceFormat,
+                                              audio_format_t fifoFormat,
+                                              fifo_frames_t numFrames) {
+    WrappingBuffer wrappingBuffer;
+    const uint8_t *source = (const uint8_t *) buffer;
+    fifo_frames_t framesLeft = numFrames;
+    const int32_t samplesPerFrame = mBytesPerFrame / audio_bytes_per_sample(fifoFormat);
+    const int32_t bytesPerSourceFrame = samplesPerFrame * audio_bytes_per_sample(sourceFormat);
+
+    getEmptyRoomAvailable(&wrappingBuffer);
+
+    // Convert and write data in one or two parts.
+    int partIndex = 0;
+    while (framesLeft > 0 && partIndex < WrappingBuffer::SIZE) {
+        fifo_frames_t framesToWrite = framesLeft;
+        fifo_frames_t framesAvailable = wrappingBuffer.numFrames[partIndex];
+        if (framesAvailable > 0) {
+            if (framesToWrite > framesAvailable) {
+                framesToWrite = framesAvailable;
+            }
+            memcpy_by_audio_format(wrappingBuffer.data[partIndex], fifoFormat,
+                                   source, sourceFormat,
+                                   framesToWrite * samplesPerFrame);
+
+            source += framesToWrite * bytesPerSourceFrame;
+            framesLeft -= framesToWrite;
+        } else {
+            break;
+        }
+        partIndex++;
+    }
+    fifo_frames_t framesWritten = numFrames - framesLeft;
+    mFifo->advanceWriteIndex(framesWritten);
+    return framesWritten;
+}
+
 fifo_frames_t FifoBuffer::getThreshold() {
     return mFifo->getThreshold();
 }
@@ -20,6 +20,8 @@
 #include <memory>
 #include <stdint.h>
 
+#include <system/audio.h>
+
 #include "FifoControllerBase.h"
 
 namespace android {
@@ -48,6 +50,32 @@ public:
 
     fifo_frames_t write(const void *source, fifo_frames_t framesToWrite);
 
+    /**
+     * Read frames of fifoFormat from the FIFO and convert them to destinationFormat
+     * while copying, across the wrap point if needed.
+     * This avoids a separate conversion pass for streams that need no other processing.
+     *
+     * Both formats must pass isConversionSupported().
+     * @return frames read
+     */
+    fifo_frames_t readWithConversion(void *destination, audio_format_t destinationFormat,
+                                     audio_format_t fifoFormat, fifo_frames_t framesToRead);
+
+    /**
+     * Convert frames from sourceFormat to fifoFormat while writing them to the FIFO,
+     * across the wrap point if needed.
+     *
+     * Both formats must pass isConversionSupported().
+     * @return frames written
+     */
+    fifo_frames_t writeWithConversion(const void *source, audio_format_t sourceFormat,
+                                      audio_format_t fifoFormat, fifo_frames_t framesToWrite);
+
+    /**
+     * @return true if format can be used with readWithConversion() and writeWithConversion().
+     */
+    static bool isConversionSupported(audio_format_t format);
+
     fifo_frames_t getThreshold();
 
     void setThreshold(fifo_frames_t threshold);
@@ -26,12 +26,16 @@ ClipToRange::ClipToRange(int32_t channelCount)
 }
 
 int32_t ClipToRange::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
+    // The ports own separate buffers, and the range is read once,
+    // so the compiler can vectorize the loop.
+    const float * __restrict__ inputBuffer = input.getBuffer();
+    float * __restrict__ outputBuffer = output.getBuffer();
+    const float minimum = mMinimum;
+    const float maximum = mMaximum;
 
     int32_t numSamples = numFrames * output.getSamplesPerFrame();
     for (int32_t i = 0; i < numSamples; i++) {
-        *outputBuffer++ = std::min(mMaximum, std::max(mMinimum, *inputBuffer++));
+        outputBuffer[i] = std::min(maximum, std::max(minimum, inputBuffer[i]));
     }
 
     return numFrames;
@@ -27,41 +27,44 @@ Limiter::Limiter(int32_t channelCount)
 }
 
 int32_t Limiter::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
-
-    int32_t numSamples = numFrames * output.getSamplesPerFrame();
-
-    // Cache the last valid output to reduce memory read/write
-    float lastValidOutput = mLastValidOutput;
+    process(input.getBuffer(), output.getBuffer(), numFrames * output.getSamplesPerFrame());
+    return numFrames;
+}
 
+void Limiter::process(const float *inputBuffer, float *outputBuffer, int32_t numSamples) {
+    // The first pass has no dependency between samples so the compiler can vectorize it.
+    // A NaN input is passed through and replaced in a second pass, which is rarely needed.
+    bool hasNaN = false;
     for (int32_t i = 0; i < numSamples; i++) {
+        const float in = inputBuffer[i];
+        const bool inIsNaN = isnan(in);
+        hasNaN |= inIsNaN;
+        outputBuffer[i] = inIsNaN ? in : processFloat(in);
+    }
+
+    if (hasNaN) {
         // Use the previous output if the input is NaN
-        if (!isnan(*inputBuffer)) {
-            lastValidOutput = processFloat(*inputBuffer);
+        float lastValidOutput = mLastValidOutput;
+        for (int32_t i = 0; i < numSamples; i++) {
+            if (isnan(outputBuffer[i])) {
+                outputBuffer[i] = lastValidOutput;
+            } else {
+                lastValidOutput = outputBuffer[i];
+            }
         }
-        inputBuffer++;
-        *outputBuffer++ = lastValidOutput;
     }
-    mLastValidOutput = lastValidOutput;
-
-    return numFrames;
+    if (numSamples > 0) {
+        mLastValidOutput = outputBuffer[numSamples - 1];
+    }
 }
 
 float Limiter::processFloat(float in)
 {
-    float in_abs = fabsf(in);
-    if (in_abs <= 1) {
-        return in;
-    }
-    float out;
-    if (in_abs < kXWhenYis3Decibels) {
-        out = (kPolynomialSplineA * in_abs + kPolynomialSplineB) * in_abs + kPolynomialSplineC;
-    } else {
-        out = M_SQRT2;
-    }
-    if (in < 0) {
-        out = -out;
-    }
-    return out;
+    // Select rather than branch, so that process() can be vectorized.
+    const float in_abs = fabsf(in);
+    const float spline =
+            (kPolynomialSplineA * in_abs + kPolynomialSplineB) * in_abs + kPolynomialSplineC;
+    float out = in_abs < kXWhenYis3Decibels ? spline : (float) M_SQRT2;
+    out = in_abs <= 1 ? in_abs : out;
+    return copysignf(out, in);
 }
@@ -31,6 +31,17 @@ public:
 
     int32_t onProcess(int32_t numFrames) override;
 
+    /**
+     * Limit numSamples samples, outside of the graph.
+     * This is used by AAudioFlowGraph to process several nodes in one pass.
+     * The input and output may be the same buffer.
+     *
+     * @param inputBuffer
+     * @param outputBuffer
+     * @param numSamples
+     */
+    void process(const float *inputBuffer, float *outputBuffer, int32_t numSamples);
+
     const char *getName() override {
         return "Limiter";
     }
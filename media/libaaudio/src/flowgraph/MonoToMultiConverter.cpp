@@ -26,9 +26,18 @@ MonoToMultiConverter::MonoToMultiConverter(int32_t outputChannelCount)
 }
 
 int32_t MonoToMultiConverter::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
+    const float * __restrict__ inputBuffer = input.getBuffer();
+    float * __restrict__ outputBuffer = output.getBuffer();
     int32_t channelCount = output.getSamplesPerFrame();
+    if (channelCount == 2) {
+        // Stereo is the common case. A fixed channel count lets the compiler vectorize.
+        for (int i = 0; i < numFrames; i++) {
+            const float sample = inputBuffer[i];
+            outputBuffer[2 * i] = sample;
+            outputBuffer[2 * i + 1] = sample;
+        }
+        return numFrames;
+    }
     for (int i = 0; i < numFrames; i++) {
         // read one, write many
         float sample = *inputBuffer++;
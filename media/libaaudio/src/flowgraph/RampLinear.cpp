@@ -43,9 +43,19 @@ float RampLinear::interpolateCurrent() {
 }
 
 int32_t RampLinear::onProcess(int32_t numFrames) {
-    const float *inputBuffer = input.getBuffer();
-    float *outputBuffer = output.getBuffer();
-    int32_t channelCount = output.getSamplesPerFrame();
+    const int32_t channelCount = output.getSamplesPerFrame();
+    process(input.getBuffer(), output.getBuffer(), numFrames, channelCount);
+    return numFrames;
+}
+
+void RampLinear::process(const float *inputBuffer, float *outputBuffer, int32_t numFrames,
+                         int32_t stride) {
+    // When called directly, rather than from pullData(), the ramp is now in use,
+    // so a later setTarget() must ramp instead of jumping to the new level.
+    if (mLastCallCount == kInitialCallCount) {
+        mLastCallCount = 0;
+    }
+    const int32_t channelCount = output.getSamplesPerFrame();
 
     float target = getTarget();
     if (target != mLevelTo) {
@@ -56,26 +66,34 @@ int32_t RampLinear::onProcess(int32_t numFrames) {
         mScaler = (mLevelTo - mLevelFrom) / mLengthInFrames; // for interpolation
     }
 
-    int32_t framesLeft = numFrames;
+    int32_t frame = 0;
 
     if (mRemaining > 0) { // Ramping? This doesn't happen very often.
-        int32_t framesToRamp = std::min(framesLeft, mRemaining);
-        framesLeft -= framesToRamp;
-        while (framesToRamp > 0) {
-            float currentLevel = interpolateCurrent();
+        const int32_t framesToRamp = std::min(numFrames, mRemaining);
+        for (; frame < framesToRamp; frame++) {
+            // Same as interpolateCurrent() with mRemaining decremented once per frame.
+            const float currentLevel = mLevelTo - ((mRemaining - frame) * mScaler);
             for (int ch = 0; ch < channelCount; ch++) {
-                *outputBuffer++ = *inputBuffer++ * currentLevel;
+                outputBuffer[frame * stride + ch] = inputBuffer[frame * stride + ch]
+                        * currentLevel;
             }
-            mRemaining--;
-            framesToRamp--;
         }
+        mRemaining -= framesToRamp;
     }
 
     // Process any frames after the ramp.
-    int32_t samplesLeft = framesLeft * channelCount;
-    for (int i = 0; i < samplesLeft; i++) {
-        *outputBuffer++ = *inputBuffer++ * mLevelTo;
+    // Keep the level in a local so the loop has no loads other than the input.
+    const float level = mLevelTo;
+    if (stride == channelCount) {
+        const int32_t numSamples = numFrames * channelCount;
+        for (int32_t i = frame * channelCount; i < numSamples; i++) {
+            outputBuffer[i] = inputBuffer[i] * level;
+        }
+    } else {
+        for (; frame < numFrames; frame++) {
+            for (int ch = 0; ch < channelCount; ch++) {
+                outputBuffer[frame * stride + ch] = inputBuffer[frame * stride + ch] * level;
+            }
+        }
     }
-
-    return numFrames;
 }
@@ -41,6 +41,22 @@ public:
 
     int32_t onProcess(int32_t numFrames) override;
 
+    /**
+     * Apply the ramp to numFrames frames, outside of the graph.
+     * This is used by AAudioFlowGraph to process several nodes in one pass.
+     *
+     * The frames may be part of a wider interleaved buffer, for example one channel of a
+     * stereo buffer, in which case stride is the number of samples between frames.
+     * The input and output may be the same buffer.
+     *
+     * @param inputBuffer
+     * @param outputBuffer
+     * @param numFrames
+     * @param stride in samples, at least the channel count of the ramp
+     */
+    void process(const float *inputBuffer, float *outputBuffer, int32_t numFrames,
+                 int32_t stride);
+
     /**
      * This is used for the next ramp.
      * Calling this does not affect a ramp that is in progress.
@@ -36,25 +36,69 @@ PolyphaseResampler::PolyphaseResampler(const MultiChannelResampler::Builder &bui
                          builder.getNormalizedCutoff());
 }
 
-void PolyphaseResampler::readFrame(float *frame) {
-    // Clear accumulator for mixing.
-    std::fill(mSingleFrame.begin(), mSingleFrame.end(), 0.0);
+/**
+ * Run the FIR for kChannels adjacent channels of the interleaved frames in x.
+ *
+ * The channels are the inner loop, with one accumulator each,
+ * so with a compile time channel count the compiler keeps the accumulators
+ * in vector registers and multiplies all channels of a frame by the same
+ * coefficient in one or a few vector operations.
+ */
+template <int kChannels>
+static void convolveChannels(const float *coefficients, const float *x, int numTaps,
+                             int32_t stride, float *frame) {
+    float accumulators[kChannels] = {};
+    for (int tap = 0; tap < numTaps; tap++) {
+        const float coefficient = coefficients[tap];
+        for (int channel = 0; channel < kChannels; channel++) {
+            accumulators[channel] += x[channel] * coefficient;
+        }
+        x += stride;
+    }
+    for (int channel = 0; channel < kChannels; channel++) {
+        frame[channel] = accumulators[channel];
+    }
+}
 
+void PolyphaseResampler::readFrame(float *frame) {
     // Multiply input times windowed sinc function.
-    float *coefficients = &mCoefficients[mCoefficientCursor];
-    float *xFrame = &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
-    for (int i = 0; i < mNumTaps; i++) {
-        float coefficient = *coefficients++;
-        for (int channel = 0; channel < getChannelCount(); channel++) {
-            mSingleFrame[channel] += *xFrame++ * coefficient;
-        }
+    const float *coefficients = &mCoefficients[mCoefficientCursor];
+    const float *xFrame =
+            &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
+    const int32_t channelCount = getChannelCount();
+
+    // Specialize the common multichannel layouts, for example 5.1, 7.1 and 7.1.4.
+    switch (channelCount) {
+        case 4:
+            convolveChannels<4>(coefficients, xFrame, mNumTaps, channelCount, frame);
+            break;
+        case 6:
+            convolveChannels<6>(coefficients, xFrame, mNumTaps, channelCount, frame);
+            break;
+        case 8:
+            convolveChannels<8>(coefficients, xFrame, mNumTaps, channelCount, frame);
+            break;
+        case 12:
+            convolveChannels<12>(coefficients, xFrame, mNumTaps, channelCount, frame);
+            break;
+        default: {
+            // Otherwise process groups of 8 then 4 channels, then single channels.
+            int32_t channel = 0;
+            for (; channel + 8 <= channelCount; channel += 8) {
+                convolveChannels<8>(coefficients, xFrame + channel, mNumTaps, channelCount,
+                                    frame + channel);
+            }
+            for (; channel + 4 <= channelCount; channel += 4) {
+                convolveChannels<4>(coefficients, xFrame + channel, mNumTaps, channelCount,
+                                    frame + channel);
+            }
+            for (; channel < channelCount; channel++) {
+                convolveChannels<1>(coefficients, xFrame + channel, mNumTaps, channelCount,
+                                    frame + channel);
+            }
+        } break;
     }
 
     // Advance and wrap through coefficients.
     mCoefficientCursor = (mCoefficientCursor + mNumTaps) % mCoefficients.size();
-
-    // Copy accumulator to output.
-    for (int channel = 0; channel < getChannelCount(); channel++) {
-        frame[channel] = mSingleFrame[channel];
-    }
 }
@@ -35,37 +35,84 @@ SincResampler::SincResampler(const MultiChannelResampler::Builder &builder)
                          builder.getNormalizedCutoff());
 }
 
-void SincResampler::readFrame(float *frame) {
-    // Clear accumulator for mixing.
-    std::fill(mSingleFrame.begin(), mSingleFrame.end(), 0.0);
-    std::fill(mSingleFrame2.begin(), mSingleFrame2.end(), 0.0);
+/**
+ * Run the FIR with two rows of coefficients for kChannels adjacent channels
+ * of the interleaved frames in x, then interpolate between the two results.
+ * See convolveChannels() in PolyphaseResampler.cpp.
+ */
+template <int kChannels>
+static void convolveChannelsInterpolated(const float *coefficientsLow,
+                                         const float *coefficientsHigh,
+                                         const float *x, int numTaps, int32_t stride,
+                                         float fraction, float *frame) {
+    float accumulatorsLow[kChannels] = {};
+    float accumulatorsHigh[kChannels] = {};
+    for (int tap = 0; tap < numTaps; tap++) {
+        const float coefficientLow = coefficientsLow[tap];
+        const float coefficientHigh = coefficientsHigh[tap];
+        for (int channel = 0; channel < kChannels; channel++) {
+            const float sample = x[channel];
+            accumulatorsLow[channel] += sample * coefficientLow;
+            accumulatorsHigh[channel] += sample * coefficientHigh;
+        }
+        x += stride;
+    }
+    for (int channel = 0; channel < kChannels; channel++) {
+        const float low = accumulatorsLow[channel];
+        const float high = accumulatorsHigh[channel];
+        frame[channel] = low + (fraction * (high - low));
+    }
+}
 
+void SincResampler::readFrame(float *frame) {
     // Determine indices into coefficients table.
     const double tablePhase = getIntegerPhase() * mPhaseScaler;
     const int indexLow = static_cast<int>(floor(tablePhase));
     const int indexHigh = indexLow + 1; // OK because using a guard row.
     assert (indexHigh < mNumRows);
-    float *coefficientsLow = &mCoefficients[static_cast<size_t>(indexLow)
-                                            * static_cast<size_t>(getNumTaps())];
-    float *coefficientsHigh = &mCoefficients[static_cast<size_t>(indexHigh)
-                                             * static_cast<size_t>(getNumTaps())];
+    const float *coefficientsLow = &mCoefficients[static_cast<size_t>(indexLow)
+                                                  * static_cast<size_t>(getNumTaps())];
+    const float *coefficientsHigh = &mCoefficients[static_cast<size_t>(indexHigh)
+                                                   * static_cast<size_t>(getNumTaps())];
+    const float fraction = tablePhase - indexLow;
 
-    float *xFrame = &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
-    for (int tap = 0; tap < mNumTaps; tap++) {
-        const float coefficientLow = *coefficientsLow++;
-        const float coefficientHigh = *coefficientsHigh++;
-        for (int channel = 0; channel < getChannelCount(); channel++) {
-            const float sample = *xFrame++;
-            mSingleFrame[channel] += sample * coefficientLow;
-            mSingleFrame2[channel] += sample * coefficientHigh;
-        }
-    }
+    const float *xFrame =
+            &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
+    const int32_t channelCount = getChannelCount();
 
-    // Interpolate and copy to output.
-    const float fraction = tablePhase - indexLow;
-    for (int channel = 0; channel < getChannelCount(); channel++) {
-        const float low = mSingleFrame[channel];
-        const float high = mSingleFrame2[channel];
-        frame[channel] = low + (fraction * (high - low));
+    // Specialize the common multichannel layouts, for example 5.1, 7.1 and 7.1.4.
+    switch (channelCount) {
+        case 4:
+            convolveChannelsInterpolated<4>(coefficientsLow, coefficientsHigh, xFrame,
+                                            mNumTaps, channelCount, fraction, frame);
+            break;
+        case 6:
+            convolveChannelsInterpolated<6>(coefficientsLow, coefficientsHigh, xFrame,
+                                            mNumTaps, channelCount, fraction, frame);
+            break;
+        case 8:
+            convolveChannelsInterpolated<8>(coefficientsLow, coefficientsHigh, xFrame,
+                                            mNumTaps, channelCount, fraction, frame);
+            break;
+        case 12:
+            convolveChannelsInterpolated<12>(coefficientsLow, coefficientsHigh, xFrame,
+                                             mNumTaps, channelCount, fraction, frame);
+            break;
+        default: {
+            // Otherwise process groups of 8 then 4 channels, then single channels.
+            int32_t channel = 0;
+            for (; channel + 8 <= channelCount; channel += 8) {
+                convolveChannelsInterpolated<8>(coefficientsLow, coefficientsHigh,
+                        xFrame + channel, mNumTaps, channelCount, fraction, frame + channel);
+            }
+            for (; channel + 4 <= channelCount; channel += 4) {
+                convolveChannelsInterpolated<4>(coefficientsLow, coefficientsHigh,
+                        xFrame + channel, mNumTaps, channelCount, fraction, frame + channel);
+            }
+            for (; channel < channelCount; channel++) {
+                convolveChannelsInterpolated<1>(coefficientsLow, coefficientsHigh,
+                        xFrame + channel, mNumTaps, channelCount, fraction, frame + channel);
+            }
+        } break;
     }
 }
@@ -672,6 +672,23 @@ int32_t AAudioProperty_getOutputMMapOffsetMicros() {
     return AAudioProperty_getMMapOffsetMicros(__func__, AAUDIO_PROP_OUTPUT_MMAP_OFFSET_USEC);
 }
 
+int32_t AAudioProperty_getMixerHelperMinStreams() {
+    const int32_t minStreams = 2; // the helper mixes half of the streams
+    const int32_t defaultStreams = 0; // disabled
+    const int32_t maxStreams = 128; // arbitrary
+    int32_t prop = property_get_int32(AAUDIO_PROP_MIXER_HELPER_MIN_STREAMS, defaultStreams);
+    if (prop <= 0) {
+        prop = 0;
+    } else if (prop < minStreams) {
+        ALOGW("AAudioProperty_getMixerHelperMinStreams: clipped %d to %d", prop, minStreams);
+        prop = minStreams;
+    } else if (prop > maxStreams) {
+        ALOGW("AAudioProperty_getMixerHelperMinStreams: clipped %d to %d", prop, maxStreams);
+        prop = maxStreams;
+    }
+    return prop;
+}
+
 int32_t AAudioProperty_getLogMask() {
     return property_get_int32(AAUDIO_PROP_LOG_MASK, 0);
 }
@@ -173,6 +173,17 @@ int32_t AAudioProperty_getOutputMMapOffsetMicros();
 #define AAUDIO_LOG_RESERVED_4              4
 #define AAUDIO_LOG_RESERVED_8              8
 
+/**
+ * Read a system property that enables the helper thread of shared output endpoints.
+ * An endpoint with at least this many active streams mixes half of them on the helper,
+ * in parallel with its own mixer thread.
+ * The helper is disabled by default, as its benefit depends on the CPUs of the device.
+ *
+ * @return minimum number of active streams to use the helper, or 0 if it is disabled
+ */
+int32_t AAudioProperty_getMixerHelperMinStreams();
+#define AAUDIO_PROP_MIXER_HELPER_MIN_STREAMS   "aaudio.mixer_helper_min_streams"
+
 /**
  * Use a mask to enable various logs in AAudio.
  * @return mask that enables various AAudio logs, such as AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM
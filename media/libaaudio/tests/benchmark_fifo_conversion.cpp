@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares writing app data to an endpoint FIFO through the AAudioFlowGraph,
+// as done by AudioStreamInternalPlay for a stream needing processing,
+// with converting while copying by FifoBuffer::writeWithConversion().
+
+#include <algorithm>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "client/AAudioFlowGraph.h"
+#include "fifo/FifoBuffer.h"
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+using android::FifoBuffer;
+using android::FifoBufferAllocated;
+using android::WrappingBuffer;
+
+static constexpr int32_t kChannelCount = 2;
+static constexpr int32_t kSampleRate = 48000;
+
+static const std::pair<audio_format_t, audio_format_t> kFormats[] = {
+    {AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_FLOAT},
+    {AUDIO_FORMAT_PCM_FLOAT, AUDIO_FORMAT_PCM_16_BIT},
+    {AUDIO_FORMAT_PCM_24_BIT_PACKED, AUDIO_FORMAT_PCM_FLOAT},
+    {AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_24_BIT_PACKED},
+};
+
+// The same loop as AudioStreamInternalPlay::writeNowWithConversion().
+static int32_t writeWithFlowGraph(AAudioFlowGraph &flowGraph, FifoBuffer &fifo,
+                                  const uint8_t *source, int32_t bytesPerFrame,
+                                  int32_t bytesPerDeviceFrame, int32_t numFrames) {
+    WrappingBuffer wrappingBuffer;
+    int32_t framesLeft = numFrames;
+    int32_t framesWritten = 0;
+    fifo.getEmptyRoomAvailable(&wrappingBuffer);
+    for (int partIndex = 0; framesLeft > 0 && partIndex < WrappingBuffer::SIZE; ++partIndex) {
+        int32_t framesAvailable = wrappingBuffer.numFrames[partIndex];
+        uint8_t *destination = (uint8_t *) wrappingBuffer.data[partIndex];
+        if (framesAvailable <= 0) break;
+        const int32_t framesPulled = flowGraph.pull(destination, framesAvailable);
+        destination += framesPulled * bytesPerDeviceFrame;
+        framesAvailable -= framesPulled;
+        framesWritten += framesPulled;
+        while (framesAvailable > 0 && framesLeft > 0) {
+            const int32_t framesToWrite = framesAvailable < kDefaultBufferSize
+                    ? 1 : std::min(kDefaultBufferSize, framesLeft);
+            const int32_t framesProcessed = flowGraph.process(
+                    source, framesToWrite, destination, framesAvailable);
+            source += framesToWrite * bytesPerFrame;
+            framesLeft -= framesToWrite;
+            destination += framesProcessed * bytesPerDeviceFrame;
+            framesAvailable -= framesProcessed;
+            framesWritten += framesProcessed;
+        }
+    }
+    fifo.advanceWriteIndex(framesWritten);
+    return numFrames - framesLeft;
+}
+
+// Args: frames per write, index into kFormats.
+static void BM_FifoWriteFlowGraph(benchmark::State& state) {
+    const int32_t frames = state.range(0);
+    const auto [format, deviceFormat] = kFormats[state.range(1)];
+    const int32_t bytesPerFrame = audio_bytes_per_frame(kChannelCount, format);
+    const int32_t bytesPerDeviceFrame = audio_bytes_per_frame(kChannelCount, deviceFormat);
+    FifoBufferAllocated fifo(bytesPerDeviceFrame, 3 * frames + 1 /* so writes wrap */);
+    std::vector<uint8_t> source(frames * bytesPerFrame);
+    AAudioFlowGraph flowGraph;
+    flowGraph.configure(format, kChannelCount, kSampleRate,
+                        deviceFormat, kChannelCount, kSampleRate,
+                        false /* useMonoBlend */, false /* useVolumeRamps */,
+                        0.f /* audioBalance */,
+                        aaudio::resampler::MultiChannelResampler::Quality::Medium);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(writeWithFlowGraph(flowGraph, fifo, source.data(),
+                bytesPerFrame, bytesPerDeviceFrame, frames));
+        fifo.advanceReadIndex(frames);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+
+static void BM_FifoWriteWithConversion(benchmark::State& state) {
+    const int32_t frames = state.range(0);
+    const auto [format, deviceFormat] = kFormats[state.range(1)];
+    const int32_t bytesPerFrame = audio_bytes_per_frame(kChannelCount, format);
+    const int32_t bytesPerDeviceFrame = audio_bytes_per_frame(kChannelCount, deviceFormat);
+    FifoBufferAllocated fifo(bytesPerDeviceFrame, 3 * frames + 1 /* so writes wrap */);
+    std::vector<uint8_t> source(frames * bytesPerFrame);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fifo.writeWithConversion(source.data(), format,
+                deviceFormat, frames));
+        fifo.advanceReadIndex(frames);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+
+static void FifoArgs(benchmark::internal::Benchmark* b) {
+    for (int frames : {64, 192, 480, 960}) {
+        for (int formats = 0; formats < (int)std::size(kFormats); ++formats) {
+            b->Args({frames, formats});
+        }
+    }
+}
+
+BENCHMARK(BM_FifoWriteFlowGraph)->Apply(FifoArgs);
+BENCHMARK(BM_FifoWriteWithConversion)->Apply(FifoArgs);
+
+BENCHMARK_MAIN();
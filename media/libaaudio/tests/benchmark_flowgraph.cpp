@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures AAudioFlowGraph::process() for the stream configurations commonly
+// set up by AudioStreamInternal, from the graphs processed in one pass
+// (format conversion, Limiter, volume ramps) to those pulled through each node
+// (channel and sample rate conversion).
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "client/AAudioFlowGraph.h"
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+struct FlowGraphConfig {
+    const char *name;
+    audio_format_t sourceFormat;
+    int32_t sourceChannelCount;
+    int32_t sourceSampleRate;
+    audio_format_t sinkFormat;
+    int32_t sinkChannelCount;
+    bool useVolumeRamps;
+};
+
+static const FlowGraphConfig kConfigs[] = {
+    {"i16_to_float", AUDIO_FORMAT_PCM_16_BIT, 2, 48000, AUDIO_FORMAT_PCM_FLOAT, 2, false},
+    {"float_to_i16_ramps", AUDIO_FORMAT_PCM_FLOAT, 2, 48000, AUDIO_FORMAT_PCM_16_BIT, 2, true},
+    {"float_to_float_limiter_ramps", AUDIO_FORMAT_PCM_FLOAT, 2, 48000,
+            AUDIO_FORMAT_PCM_FLOAT, 2, true},
+    {"i24_to_float_ramps", AUDIO_FORMAT_PCM_24_BIT_PACKED, 2, 48000,
+            AUDIO_FORMAT_PCM_FLOAT, 2, true},
+    {"mono_i16_to_stereo_float", AUDIO_FORMAT_PCM_16_BIT, 1, 48000, AUDIO_FORMAT_PCM_FLOAT, 2,
+            false},
+    {"i16_44100_to_float_48000", AUDIO_FORMAT_PCM_16_BIT, 2, 44100, AUDIO_FORMAT_PCM_FLOAT, 2,
+            false},
+};
+
+// Args: frames per process(), index into kConfigs.
+static void BM_FlowGraphProcess(benchmark::State& state) {
+    constexpr int32_t kSinkSampleRate = 48000;
+    const int32_t frames = state.range(0);
+    const FlowGraphConfig &config = kConfigs[state.range(1)];
+    state.SetLabel(config.name);
+
+    AAudioFlowGraph flowGraph;
+    if (flowGraph.configure(config.sourceFormat, config.sourceChannelCount,
+            config.sourceSampleRate, config.sinkFormat, config.sinkChannelCount,
+            kSinkSampleRate, false /* useMonoBlend */, config.useVolumeRamps,
+            0.f /* audioBalance */,
+            aaudio::resampler::MultiChannelResampler::Quality::Medium) != AAUDIO_OK) {
+        state.SkipWithError("configure failed");
+        return;
+    }
+    std::vector<uint8_t> source(
+            frames * audio_bytes_per_frame(config.sourceChannelCount, config.sourceFormat));
+    // Leave room for the extra frames from upsampling.
+    const int32_t maxFramesOut = frames * 2;
+    std::vector<uint8_t> destination(
+            maxFramesOut * audio_bytes_per_frame(config.sinkChannelCount, config.sinkFormat));
+    float volume = 1.f;
+
+    for (auto _ : state) {
+        if (config.useVolumeRamps) {
+            // Keep a ramp running, as when the app changes the volume.
+            volume = volume == 1.f ? 0.5f : 1.f;
+            flowGraph.setTargetVolume(volume);
+        }
+        benchmark::DoNotOptimize(flowGraph.process(source.data(), frames,
+                destination.data(), maxFramesOut));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+
+static void FlowGraphArgs(benchmark::internal::Benchmark* b) {
+    for (int frames : {48, 192, 480, 960}) {
+        for (int config = 0; config < (int)std::size(kConfigs); ++config) {
+            b->Args({frames, config});
+        }
+    }
+}
+
+BENCHMARK(BM_FlowGraphProcess)->Apply(FlowGraphArgs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the output frames per second of the MultiChannelResampler
+// for each channel count and quality level, with a ratio that uses
+// the polyphase resamplers and one that uses the sinc resamplers.
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "flowgraph/resampler/MultiChannelResampler.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+static constexpr int32_t kSinkRate = 48000;
+// 44100 reduces to a small ratio with 48000, which uses a polyphase table.
+// 44101 does not, which uses the sinc resampler that interpolates coefficients.
+static constexpr int32_t kSourceRates[] = {44100, 44101};
+
+// Args: channel count, quality, index into kSourceRates.
+static void BM_Resampler(benchmark::State& state) {
+    constexpr int32_t kNumOutputFrames = 480;
+    const int32_t channelCount = state.range(0);
+    const auto quality = static_cast<MultiChannelResampler::Quality>(state.range(1));
+    const int32_t sourceRate = kSourceRates[state.range(2)];
+    std::unique_ptr<MultiChannelResampler> resampler(
+            MultiChannelResampler::make(channelCount, sourceRate, kSinkRate, quality));
+
+    std::vector<float> input(channelCount);
+    std::vector<float> output(kNumOutputFrames * channelCount);
+    float phase = 0.f;
+    for (auto _ : state) {
+        float *frame = output.data();
+        for (int32_t framesRead = 0; framesRead < kNumOutputFrames;) {
+            if (resampler->isWriteNeeded()) {
+                std::fill(input.begin(), input.end(), phase);
+                phase = phase > 1.f ? -1.f : phase + 0.01f;
+                resampler->writeNextFrame(input.data());
+            } else {
+                resampler->readNextFrame(frame);
+                frame += channelCount;
+                framesRead++;
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kNumOutputFrames);
+}
+
+static void ResamplerArgs(benchmark::internal::Benchmark* b) {
+    for (int rate = 0; rate < (int)std::size(kSourceRates); ++rate) {
+        for (int quality = (int)MultiChannelResampler::Quality::Low;
+                quality <= (int)MultiChannelResampler::Quality::Best; ++quality) {
+            for (int channelCount : {1, 2, 4, 6, 8, 12}) {
+                b->Args({channelCount, quality, rate});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_Resampler)->Apply(ResamplerArgs)->ArgNames({"channels", "quality", "sinc"});
+
+BENCHMARK_MAIN();
@@ -26,6 +26,7 @@ using android::fifo_frames_t;
 using android::fifo_counter_t;
 using android::FifoController;
 using android::FifoBuffer;
+using android::FifoBufferAllocated;
 using android::FifoBufferIndirect;
 using android::WrappingBuffer;
 
@@ -387,3 +388,48 @@ TEST(test_fifo_buffer, fifo_full_wrap) {
     TestFifoBuffer tester(capacity);
     tester.checkFullWrap();
 }
+
+// Write int16 data converted to a float FIFO, across the wrap point,
+// then read it back converted to int16 and to packed 24 bit.
+TEST(test_fifo_buffer, fifo_conversion_wrap) {
+    constexpr int kChannels = 2;
+    constexpr int kCapacity = 53; // arbitrary, odd so the transfers wrap
+    constexpr int kFrames = 37;
+    FifoBufferAllocated fifo(kChannels * sizeof(float), kCapacity);
+    ASSERT_TRUE(FifoBuffer::isConversionSupported(AUDIO_FORMAT_PCM_16_BIT));
+    ASSERT_FALSE(FifoBuffer::isConversionSupported(AUDIO_FORMAT_PCM_8_24_BIT));
+
+    int16_t source[kFrames * kChannels];
+    int16_t destination16[kFrames * kChannels];
+    uint8_t destination24[kFrames * kChannels * 3];
+    for (int pass = 0; pass < 4; ++pass) {
+        for (int i = 0; i < kFrames * kChannels; ++i) {
+            source[i] = (int16_t)((i + pass) * 997); // arbitrary, wraps around int16
+        }
+        ASSERT_EQ(kFrames, fifo.writeWithConversion(source, AUDIO_FORMAT_PCM_16_BIT,
+                                                    AUDIO_FORMAT_PCM_FLOAT, kFrames));
+        // Each float sample is the int16 sample / 32768, checked through a raw read of
+        // the first sample.
+        WrappingBuffer wrappingBuffer;
+        ASSERT_EQ(kFrames, fifo.getFullDataAvailable(&wrappingBuffer));
+        ASSERT_EQ(source[0] / 32768.f, *(float *)wrappingBuffer.data[0]);
+
+        const int firstFrames = kFrames / 2;
+        ASSERT_EQ(firstFrames, fifo.readWithConversion(destination16, AUDIO_FORMAT_PCM_16_BIT,
+                                                       AUDIO_FORMAT_PCM_FLOAT, firstFrames));
+        ASSERT_EQ(kFrames - firstFrames,
+                  fifo.readWithConversion(destination24, AUDIO_FORMAT_PCM_24_BIT_PACKED,
+                                          AUDIO_FORMAT_PCM_FLOAT, kFrames));
+        ASSERT_EQ(0, fifo.getFullFramesAvailable());
+        for (int i = 0; i < firstFrames * kChannels; ++i) {
+            ASSERT_EQ(source[i], destination16[i]);
+        }
+        for (int i = firstFrames * kChannels; i < kFrames * kChannels; ++i) {
+            // int16 is the most significant 16 bits of packed 24 bit.
+            const uint8_t *sample = &destination24[(i - firstFrames * kChannels) * 3];
+            const int32_t value24 = (int32_t)((sample[2] << 24) | (sample[1] << 16)
+                    | (sample[0] << 8)) >> 8;
+            ASSERT_EQ(source[i] * 256, value24);
+        }
+    }
+}
@@ -29,8 +29,10 @@
 #include "client/AAudioFlowGraph.h"
 #include "flowgraph/ClipToRange.h"
 #include "flowgraph/Limiter.h"
+#include "flowgraph/ManyToMultiConverter.h"
 #include "flowgraph/MonoBlend.h"
 #include "flowgraph/MonoToMultiConverter.h"
+#include "flowgraph/MultiToManyConverter.h"
 #include "flowgraph/RampLinear.h"
 #include "flowgraph/SinkFloat.h"
 #include "flowgraph/SinkI16.h"
@@ -509,6 +511,96 @@ TEST(test_flowgraph, module_sourceI8_24) {
     }
 }
 
+// AAudioFlowGraph processes a graph without rate or channel conversion in one pass.
+// Check that it matches the same graph built from nodes, across volume ramps
+// and with data left to be pulled later.
+static void checkFusedMatchesNodes(audio_format_t sinkFormat) {
+    constexpr int32_t kChannelCount = 2;
+    constexpr int32_t kRampLength = 100;
+    constexpr float kAudioBalance = 0.25f;
+    constexpr int32_t kNumFrames = 1000;
+    const size_t bytesPerFrame = audio_bytes_per_frame(kChannelCount, sinkFormat);
+
+    AAudioFlowGraph flowgraph;
+    ASSERT_EQ(AAUDIO_OK, flowgraph.configure(AUDIO_FORMAT_PCM_FLOAT, kChannelCount, 48000,
+            sinkFormat, kChannelCount, 48000,
+            false /* useMonoBlend */, true /* useVolumeRamps */, kAudioBalance,
+            MultiChannelResampler::Quality::Medium));
+    flowgraph.setRampLengthInFrames(kRampLength);
+
+    SourceFloat sourceFloat{kChannelCount};
+    Limiter limiter{kChannelCount};
+    MultiToManyConverter multiToMany{kChannelCount};
+    ManyToMultiConverter manyToMulti{kChannelCount};
+    std::vector<std::unique_ptr<RampLinear>> ramps;
+    std::unique_ptr<FlowGraphSink> sink;
+    if (sinkFormat == AUDIO_FORMAT_PCM_FLOAT) {
+        sink = std::make_unique<SinkFloat>(kChannelCount);
+        sourceFloat.output.connect(&limiter.input);
+        limiter.output.connect(&multiToMany.input);
+    } else {
+        sink = std::make_unique<SinkI16>(kChannelCount);
+        sourceFloat.output.connect(&multiToMany.input);
+    }
+    for (int i = 0; i < kChannelCount; i++) {
+        ramps.emplace_back(std::make_unique<RampLinear>(1));
+        ramps[i]->setLengthInFrames(kRampLength);
+        multiToMany.outputs[i]->connect(&ramps[i]->input);
+        ramps[i]->output.connect(manyToMulti.inputs[i].get());
+    }
+    manyToMulti.output.connect(&sink->input);
+
+    android::audio_utils::Balance balance;
+    float panning[kChannelCount];
+    balance.computeStereoBalance(kAudioBalance, &panning[0], &panning[1]);
+    auto setTargetVolume = [&](float volume) {
+        flowgraph.setTargetVolume(volume);
+        for (int i = 0; i < kChannelCount; i++) {
+            ramps[i]->setTarget(volume * panning[i]);
+        }
+    };
+
+    std::vector<float> input(kNumFrames * kChannelCount);
+    for (size_t i = 0; i < input.size(); i++) {
+        // Beyond full scale so the Limiter and clipping are used.
+        input[i] = 2.5f * sinf(i * 0.01f);
+    }
+    input[7] = NAN;
+    std::vector<uint8_t> expected(kNumFrames * bytesPerFrame);
+    std::vector<uint8_t> actual(kNumFrames * bytesPerFrame);
+
+    setTargetVolume(0.5f);
+    int32_t framesDone = 0;
+    int32_t framesPerProcess = 1;
+    while (framesDone < kNumFrames) {
+        const int32_t frames = std::min(framesPerProcess, kNumFrames - framesDone);
+        const float *source = input.data() + framesDone * kChannelCount;
+        uint8_t *destination = actual.data() + framesDone * bytesPerFrame;
+        // Read half now and half later.
+        int32_t framesRead = flowgraph.process(source, frames, destination, frames / 2);
+        ASSERT_EQ(frames / 2, framesRead);
+        framesRead += flowgraph.pull(destination + framesRead * bytesPerFrame,
+                frames - framesRead);
+        ASSERT_EQ(frames, framesRead);
+
+        sourceFloat.setData(source, frames);
+        ASSERT_EQ(frames, sink->read(expected.data() + framesDone * bytesPerFrame, frames));
+
+        framesDone += frames;
+        framesPerProcess += 37;
+        setTargetVolume(framesDone % 2 ? 1.0f : 0.1f);
+    }
+    EXPECT_EQ(expected, actual);
+}
+
+TEST(test_flowgraph, flowgraph_fused_float) {
+    checkFusedMatchesNodes(AUDIO_FORMAT_PCM_FLOAT);
+}
+
+TEST(test_flowgraph, flowgraph_fused_i16) {
+    checkFusedMatchesNodes(AUDIO_FORMAT_PCM_16_BIT);
+}
+
 void checkSampleRateConversionVariedSizes(int32_t sourceSampleRate,
                     int32_t sinkSampleRate,
                     MultiChannelResampler::Quality resamplerQuality) {
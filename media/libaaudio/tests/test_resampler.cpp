@@ -22,6 +22,7 @@
  */
 
 #include <iostream>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -223,3 +224,74 @@ TEST(test_resampler, resampler_48000_44100_best) {
 TEST(test_resampler, resampler_44100_11025_best) {
     checkResampler(44100, 11025, MultiChannelResampler::Quality::Best);
 }
+
+/**
+ * Resample a different signal in each channel and compare each output channel
+ * with a mono resampler, which does not use the multichannel FIR.
+ */
+static void checkMultiChannelMatchesMono(int32_t channelCount, int32_t sourceRate,
+        int32_t sinkRate, MultiChannelResampler::Quality quality) {
+    constexpr int kNumInputFrames = 1000;
+    constexpr float kTolerance = 0.000001f;
+
+    std::vector<float> input(kNumInputFrames * channelCount);
+    for (int frame = 0; frame < kNumInputFrames; frame++) {
+        for (int channel = 0; channel < channelCount; channel++) {
+            input[frame * channelCount + channel] = sinf(frame * 0.01f * (channel + 1));
+        }
+    }
+
+    auto resample = [&](MultiChannelResampler *resampler, int32_t resamplerChannelCount,
+                        const float *source, int32_t sourceStride) {
+        std::vector<float> output;
+        std::vector<float> frame(resamplerChannelCount);
+        for (int i = 0; i < kNumInputFrames;) {
+            if (resampler->isWriteNeeded()) {
+                resampler->writeNextFrame(source + i * sourceStride);
+                i++;
+            } else {
+                resampler->readNextFrame(frame.data());
+                output.insert(output.end(), frame.begin(), frame.end());
+            }
+        }
+        return output;
+    };
+
+    std::unique_ptr<MultiChannelResampler> multiResampler(
+            MultiChannelResampler::make(channelCount, sourceRate, sinkRate, quality));
+    const std::vector<float> multiOutput =
+            resample(multiResampler.get(), channelCount, input.data(), channelCount);
+    const size_t numOutputFrames = multiOutput.size() / channelCount;
+    ASSERT_GT(numOutputFrames, 0);
+
+    for (int channel = 0; channel < channelCount; channel++) {
+        std::unique_ptr<MultiChannelResampler> monoResampler(
+                MultiChannelResampler::make(1, sourceRate, sinkRate, quality));
+        const std::vector<float> monoOutput =
+                resample(monoResampler.get(), 1, input.data() + channel, channelCount);
+        ASSERT_EQ(numOutputFrames, monoOutput.size());
+        for (size_t frame = 0; frame < numOutputFrames; frame++) {
+            ASSERT_NEAR(monoOutput[frame], multiOutput[frame * channelCount + channel],
+                        kTolerance) << "channel " << channel << ", frame " << frame;
+        }
+    }
+}
+
+TEST(test_resampler, resampler_multichannel_polyphase) {
+    for (int32_t channelCount : {3, 4, 6, 8, 12, 13}) {
+        checkMultiChannelMatchesMono(channelCount, 44100, 48000,
+                MultiChannelResampler::Quality::Medium);
+        checkMultiChannelMatchesMono(channelCount, 48000, 44100,
+                MultiChannelResampler::Quality::Best);
+    }
+}
+
+TEST(test_resampler, resampler_multichannel_sinc) {
+    // The reduced ratio is too large for a polyphase table, so a SincResampler is used.
+    for (int32_t channelCount : {3, 4, 6, 8, 12, 13}) {
+        checkMultiChannelMatchesMono(channelCount, 44100, 48001,
+                MultiChannelResampler::Quality::Medium);
+        checkMultiChannelMatchesMono(channelCount, 48001, 44100,
+                MultiChannelResampler::Quality::Best);
+    }
+}
@@ -346,17 +346,53 @@ void AudioMixer::Track::reconfigureBufferProviders()
         mAdjustChannelsBufferProvider->setBufferProvider(bufferProvider);
         bufferProvider = mAdjustChannelsBufferProvider.get();
     }
-    if (mReformatBufferProvider.get() != nullptr) {
-        mReformatBufferProvider->setBufferProvider(bufferProvider);
-        bufferProvider = mReformatBufferProvider.get();
-    }
-    if (mDownmixerBufferProvider.get() != nullptr) {
-        mDownmixerBufferProvider->setBufferProvider(bufferProvider);
-        bufferProvider = mDownmixerBufferProvider.get();
+
+    // the reformat and downmix stages are fused if they can all be.
+    std::vector<CopyBufferProvider *> stages;
+    bool fusable = true;
+    for (PassthruBufferProvider *provider : { mReformatBufferProvider.get(),
+            mDownmixerBufferProvider.get(), mPostDownmixReformatBufferProvider.get() }) {
+        if (provider != nullptr) {
+            CopyBufferProvider *stage = static_cast<CopyBufferProvider *>(provider);
+            fusable = fusable && stage->isFusable();
+            stages.push_back(stage);
+        }
     }
-    if (mPostDownmixReformatBufferProvider.get() != nullptr) {
-        mPostDownmixReformatBufferProvider->setBufferProvider(bufferProvider);
-        bufferProvider = mPostDownmixReformatBufferProvider.get();
+    if (!fusable || stages.size() < 2) {
+        stages.clear();
+    }
+    if (mFusedBufferProvider.get() != nullptr && !static_cast<FusedBufferProvider *>(
+            mFusedBufferProvider.get())->isFusing(stages)) {
+        // like the other providers, drops any buffer held from a replaced upstream provider.
+        mFusedBufferProvider->setBufferProvider(bufferProvider);
+        mFusedBufferProvider.reset(nullptr);
+    }
+    if (!stages.empty()) {
+        if (mFusedBufferProvider.get() == nullptr) {
+            // release any buffers held while the stages were chained,
+            // from downstream to upstream.
+            for (size_t i = stages.size(); i-- > 0; ) {
+                stages[i]->setBufferProvider(i == 0 ? bufferProvider : stages[i - 1]);
+                stages[i]->reset();
+            }
+            mFusedBufferProvider.reset(
+                    new FusedBufferProvider(stages, kCopyBufferFrameCount));
+        }
+        mFusedBufferProvider->setBufferProvider(bufferProvider);
+        bufferProvider = mFusedBufferProvider.get();
+    } else {
+        if (mReformatBufferProvider.get() != nullptr) {
+            mReformatBufferProvider->setBufferProvider(bufferProvider);
+            bufferProvider = mReformatBufferProvider.get();
+        }
+        if (mDownmixerBufferProvider.get() != nullptr) {
+            mDownmixerBufferProvider->setBufferProvider(bufferProvider);
+            bufferProvider = mDownmixerBufferProvider.get();
+        }
+        if (mPostDownmixReformatBufferProvider.get() != nullptr) {
+            mPostDownmixReformatBufferProvider->setBufferProvider(bufferProvider);
+            bufferProvider = mPostDownmixReformatBufferProvider.get();
+        }
     }
     if (mTimestretchBufferProvider.get() != nullptr) {
         mTimestretchBufferProvider->setBufferProvider(bufferProvider);
@@ -539,6 +575,8 @@ void AudioMixer::setBufferProvider(int name, AudioBufferProvider* bufferProvider
     // reset order from downstream to upstream buffer providers.
     if (track->mTimestretchBufferProvider.get() != nullptr) {
         track->mTimestretchBufferProvider->reset();
+    } else if (track->mFusedBufferProvider.get() != nullptr) {
+        track->mFusedBufferProvider->reset();
     } else if (track->mPostDownmixReformatBufferProvider.get() != nullptr) {
         track->mPostDownmixReformatBufferProvider->reset();
     } else if (track->mDownmixerBufferProvider != nullptr) {
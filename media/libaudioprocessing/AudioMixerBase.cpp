@@ -19,8 +19,13 @@
 //#define LOG_NDEBUG 0
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <pthread.h>
 #include <sstream>
 #include <string.h>
+#include <thread>
 
 #include <audio_utils/primitives.h>
 #include <cutils/compiler.h>
@@ -56,6 +61,110 @@ namespace android {
 
 // ----------------------------------------------------------------------------
 
+// A fixed set of threads mixing the prepared parallel tracks of a mixer together with
+// the calling thread.
+// The threads are created with the scheduling policy and priority of the creating thread.
+class AudioMixerBase::WorkerPool {
+public:
+    WorkerPool(AudioMixerBase *mixer, size_t threadCount) : mMixer(mixer) {
+        for (size_t thread = 1; thread <= threadCount; ++thread) {
+            mThreads.emplace_back(&WorkerPool::threadLoop, this, thread);
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mExit = true;
+        }
+        mStartCv.notify_all();
+        for (auto &thread : mThreads) {
+            thread.join();
+        }
+    }
+
+    size_t threadCount() const { return mThreads.size(); }
+
+    // Starts mixing the first count tracks of mParallelTracks on the worker threads,
+    // join() must be called before the tracks change.
+    void start(size_t count) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mCount = count;
+            mNext.store(0, std::memory_order_relaxed);
+            mBusy = mThreads.size();
+            ++mGeneration;
+        }
+        mStartCv.notify_all();
+    }
+
+    // Runs the remaining items on the calling thread and waits for the workers.
+    void join() {
+        runItems(0 /* thread */);
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDoneCv.wait(lock, [this] { return mBusy == 0; });
+    }
+
+private:
+    // thread is in [0, threadCount()], thread 0 is the calling thread.
+    void runItems(size_t thread) {
+        for (size_t index; (index = mNext.fetch_add(1, std::memory_order_relaxed)) < mCount; ) {
+            mMixer->mixParallelTrack(index, thread);
+        }
+    }
+
+    void threadLoop(size_t thread) {
+        pthread_setname_np(pthread_self(), "AudioMixerWork");
+        uint64_t generation = 0;
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (true) {
+            mStartCv.wait(lock, [&] { return mExit || mGeneration != generation; });
+            if (mExit) return;
+            generation = mGeneration;
+            lock.unlock();
+            runItems(thread);
+            lock.lock();
+            if (--mBusy == 0) {
+                mDoneCv.notify_one();
+            }
+        }
+    }
+
+    AudioMixerBase * const mMixer;
+    std::mutex mMutex;
+    std::condition_variable mStartCv;
+    std::condition_variable mDoneCv;
+    uint64_t mGeneration = 0;     // GUARDED_BY(mMutex), incremented by start().
+    size_t mBusy = 0;             // GUARDED_BY(mMutex), workers running the current job.
+    bool mExit = false;           // GUARDED_BY(mMutex)
+    size_t mCount = 0;            // items in the current job.
+    std::atomic<size_t> mNext{0}; // next item to run.
+    std::vector<std::thread> mThreads;
+};
+
+AudioMixerBase::AudioMixerBase(size_t frameCount, uint32_t sampleRate)
+    : mSampleRate(sampleRate)
+    , mFrameCount(frameCount)
+{
+}
+
+AudioMixerBase::~AudioMixerBase()
+{
+}
+
+void AudioMixerBase::setParallelThreadCount(size_t threadCount)
+{
+    if (threadCount == (mWorkerPool == nullptr ? 0 : mWorkerPool->threadCount())) {
+        return;
+    }
+    mWorkerPool.reset();
+    if (threadCount > 0) {
+        mWorkerPool = std::make_unique<WorkerPool>(this, threadCount);
+    }
+    mParallelTemp.reset();
+    invalidate();
+}
+
 bool AudioMixerBase::isValidFormat(audio_format_t format) const
 {
     switch (format) {
@@ -714,6 +823,10 @@ void AudioMixerBase::process__validate()
                 mResampleTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
             }
             mHook = &AudioMixerBase::process__genericResampling;
+            if (mWorkerPool != nullptr && mEnabled.size() >= kParallelMinTracks) {
+                prepareParallel();
+                mHook = &AudioMixerBase::process__genericResamplingParallel;
+            }
         } else {
             // we keep temp arrays around.
             mHook = &AudioMixerBase::process__genericNoResampling;
@@ -1184,41 +1297,131 @@ void AudioMixerBase::process__genericResampling()
         // clear temp buffer
         memset(outTemp, 0, sizeof(*outTemp) * t1->mMixerChannelCount * mFrameCount);
         for (const int name : group) {
-            const std::shared_ptr<TrackBase> &t = mTracks[name];
-            int32_t *aux = NULL;
-            if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
-                aux = t->auxBuffer;
-            }
+            mixTrack(mTracks[name].get(), outTemp, numFrames, mResampleTemp.get());
+        }
+        convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
+                outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
+    }
+}
 
-            // this is a little goofy, on the resampling case we don't
-            // acquire/release the buffers because it's done by
-            // the resampler.
-            if (t->needs & NEEDS_RESAMPLE) {
-                (t.get()->*t->hook)(outTemp, numFrames, mResampleTemp.get() /* naked ptr */, aux);
-            } else {
+void AudioMixerBase::mixTrack(TrackBase *t, int32_t *out, size_t numFrames, int32_t *temp)
+{
+    int32_t *aux = NULL;
+    if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
+        aux = t->auxBuffer;
+    }
 
-                size_t outFrames = 0;
+    // this is a little goofy, on the resampling case we don't
+    // acquire/release the buffers because it's done by
+    // the resampler.
+    if (t->needs & NEEDS_RESAMPLE) {
+        (t->*t->hook)(out, numFrames, temp, aux);
+    } else {
 
-                while (outFrames < numFrames) {
-                    t->buffer.frameCount = numFrames - outFrames;
-                    t->bufferProvider->getNextBuffer(&t->buffer);
-                    t->mIn = t->buffer.raw;
-                    // t->mIn == nullptr can happen if the track was flushed just after having
-                    // been enabled for mixing.
-                    if (t->mIn == nullptr) break;
+        size_t outFrames = 0;
+
+        while (outFrames < numFrames) {
+            t->buffer.frameCount = numFrames - outFrames;
+            t->bufferProvider->getNextBuffer(&t->buffer);
+            t->mIn = t->buffer.raw;
+            // t->mIn == nullptr can happen if the track was flushed just after having
+            // been enabled for mixing.
+            if (t->mIn == nullptr) break;
 
-                    (t.get()->*t->hook)(
-                            outTemp + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
-                            mResampleTemp.get() /* naked ptr */,
-                            aux != nullptr ? aux + outFrames : nullptr);
-                    outFrames += t->buffer.frameCount;
+            (t->*t->hook)(
+                    out + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
+                    temp, aux != nullptr ? aux + outFrames : nullptr);
+            outFrames += t->buffer.frameCount;
 
-                    t->bufferProvider->releaseBuffer(&t->buffer);
-                }
+            t->bufferProvider->releaseBuffer(&t->buffer);
+        }
+    }
+}
+
+void AudioMixerBase::prepareParallel()
+{
+    size_t size = 0;
+    for (const int name : mEnabled) {
+        size += mTracks[name]->mMixerChannelCount * mFrameCount;
+    }
+    mParallelBuffer.resize(size);
+    mParallelTracks.clear();
+    mSerialTracks.clear();
+    std::map<int /* name */, const int32_t * /* output */> outputs;
+    int32_t *output = mParallelBuffer.data();
+    for (const int name : mEnabled) {
+        TrackBase * const t = mTracks[name].get();
+        outputs[name] = output;
+        // aux buffers may be shared between tracks, so the aux send is done in order.
+        (t->needs & NEEDS_AUX ? mSerialTracks : mParallelTracks).push_back({t, output});
+        output += t->mMixerChannelCount * mFrameCount;
+    }
+    mParallelGroups.resize(mGroups.size());
+    auto parallelGroup = mParallelGroups.begin();
+    for (const auto &pair : mGroups) {
+        const auto &group = pair.second;
+        parallelGroup->track = mTracks[group[0]].get();
+        parallelGroup->outputs.clear();
+        for (const int name : group) {
+            parallelGroup->outputs.push_back(outputs[name]);
+        }
+        ++parallelGroup;
+    }
+    if (mParallelTemp.get() == nullptr) {
+        mParallelTemp.reset(new int32_t[
+                (mWorkerPool->threadCount() + 1) * MAX_NUM_CHANNELS * mFrameCount]);
+    }
+}
+
+void AudioMixerBase::mixParallelTrack(size_t index, size_t thread)
+{
+    const ParallelTrack &pt = mParallelTracks[index];
+    mixTrack(pt.track, pt.output, mFrameCount,
+            mParallelTemp.get() + thread * MAX_NUM_CHANNELS * mFrameCount);
+}
+
+template <typename T>
+static void accumulate(T *out, const T *in, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        out[i] += in[i];
+    }
+}
+
+// generic code with resampling, tracks are mixed on the worker pool.
+//
+// Each track is mixed into its own cleared buffer, then the buffers of a group are
+// summed in order of name.  As the track hooks add each output sample to the
+// buffer, this is the same sequence of additions as process__genericResampling().
+void AudioMixerBase::process__genericResamplingParallel()
+{
+    ALOGVV("process__genericResamplingParallel\n");
+    int32_t * const outTemp = mOutputTemp.get(); // naked ptr
+    const size_t numFrames = mFrameCount;
+
+    memset(mParallelBuffer.data(), 0, mParallelBuffer.size() * sizeof(int32_t));
+    mWorkerPool->start(mParallelTracks.size());
+    for (const ParallelTrack &pt : mSerialTracks) {
+        mixTrack(pt.track, pt.output, numFrames, mParallelTemp.get());
+    }
+    mWorkerPool->join();
+
+    for (const ParallelGroup &group : mParallelGroups) {
+        TrackBase * const t1 = group.track;
+        const size_t sampleCount = numFrames * t1->mMixerChannelCount;
+
+        // clear temp buffer
+        memset(outTemp, 0, sizeof(*outTemp) * sampleCount);
+        for (const int32_t *output : group.outputs) {
+            if (t1->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT) {
+                accumulate(reinterpret_cast<float *>(outTemp),
+                        reinterpret_cast<const float *>(output), sampleCount);
+            } else {
+                accumulate(outTemp, output, sampleCount);
             }
         }
         convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
-                outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
+                outTemp, t1->mMixerInFormat, sampleCount);
     }
 }
 
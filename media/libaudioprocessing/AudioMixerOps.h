@@ -17,10 +17,14 @@
 #ifndef ANDROID_AUDIO_MIXER_OPS_H
 #define ANDROID_AUDIO_MIXER_OPS_H
 
+#include <array>
+
 #include <audio_utils/channels.h>
 #include <audio_utils/primitives.h>
 #include <system/audio.h>
 
+#include "AudioMixerOpsSimd.h"
+
 namespace android {
 
 // Hack to make static_assert work in a constexpr
@@ -373,6 +377,158 @@ void stereoVolumeHelper(TO*& out, const TI*& in, const TV *vol, F f) {
     stereoVolumeHelperWithChannelMask<MIXTYPE, MASK, TO, TI, TV, F>(out, in, vol, f);
 }
 
+/*
+ * SIMD helpers for volumeRampMulti and volumeMulti (see AudioMixerOpsSimd.h).
+ *
+ * These accelerate the float output, float volume, no aux cases for float and int16_t input,
+ * which is what the AudioMixer uses for float mixing.  The per channel volume
+ * (left, right or center, derived exactly as in stereoVolumeHelper) is expanded into
+ * a per sample volume block, which is then applied by the runtime selected kernel.
+ * Volume ramps are still accumulated sequentially per frame, so the results are bit-exact
+ * with the scalar templates.
+ *
+ * The helpers process whole blocks of frames and return the number of frames processed;
+ * the caller finishes the remaining frames with the scalar code.
+ */
+
+template <int MIXTYPE, int NCHAN, typename TO, typename TI, typename TV>
+constexpr bool isSimdMixSupported() {
+    if constexpr (!std::is_same_v<TO, float> || !std::is_same_v<TV, float>
+            || !(std::is_same_v<TI, float> || std::is_same_v<TI, int16_t>)) {
+        return false;
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY) {
+        return NCHAN <= 2;
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI_STEREOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_STEREOVOL) {
+        return canonicalChannelMaskFromCount(NCHAN) != AUDIO_CHANNEL_NONE;
+    } else {
+        return MIXTYPE == MIXTYPE_MULTI_MONOVOL || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL;
+    }
+}
+
+constexpr inline bool isSimdMixAccumulate(int mixtype) {
+    return mixtype == MIXTYPE_MULTI
+            || mixtype == MIXTYPE_MULTI_MONOVOL
+            || mixtype == MIXTYPE_MULTI_STEREOVOL;
+}
+
+// Index of the volume used for each channel: 0 (vol[0]), 1 (vol[1]) or 2 (center).
+template <int MIXTYPE, int NCHAN>
+constexpr std::array<int, NCHAN> simdMixVolumeIndices() {
+    std::array<int, NCHAN> indices{};
+    if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY) {
+        for (int i = 0; i < NCHAN; ++i) indices[i] = i;
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI_STEREOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_STEREOVOL) {
+        using namespace audio_utils::channels;
+        constexpr audio_channel_mask_t MASK{canonicalChannelMaskFromCount(NCHAN)};
+        constexpr unsigned LFE_LFE2 =
+                AUDIO_CHANNEL_OUT_LOW_FREQUENCY | AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2;
+        constexpr bool has_LFE_LFE2 = (MASK & LFE_LFE2) == LFE_LFE2;
+        size_t i = 0;
+        for (size_t index = 0; index < FCC_26; ++index) {
+            const unsigned bit = 1u << index;
+            if ((MASK & bit) == 0) continue;
+            const auto side = kSideFromChannelIdx[index];
+            if (side == AUDIO_GEOMETRY_SIDE_LEFT
+                    || (has_LFE_LFE2 && bit == AUDIO_CHANNEL_OUT_LOW_FREQUENCY)) {
+                indices[i++] = 0;
+            } else if (side == AUDIO_GEOMETRY_SIDE_RIGHT
+                    || (has_LFE_LFE2 && bit == AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2)) {
+                indices[i++] = 1;
+            } else {
+                indices[i++] = 2;
+            }
+        }
+    } // else MONOVOL: all channels use vol[0].
+    return indices;
+}
+
+// Number of frames per block; the block sample count must be a multiple of kMaxLanes.
+constexpr size_t kSimdMixBlockFrames = mixerops_simd::kMaxLanes * 2;
+
+template <int MIXTYPE, int NCHAN>
+constexpr bool simdMixUsesVolumeIndex(int volumeIndex) {
+    for (const int index : simdMixVolumeIndices<MIXTYPE, NCHAN>()) {
+        if (index == volumeIndex) return true;
+    }
+    return false;
+}
+
+template <int MIXTYPE, int NCHAN>
+inline void simdMixVolumes(float (&volumes)[3], const float *vol) {
+    constexpr bool USES_RIGHT = simdMixUsesVolumeIndex<MIXTYPE, NCHAN>(1);
+    constexpr bool USES_CENTER = simdMixUsesVolumeIndex<MIXTYPE, NCHAN>(2);
+    volumes[0] = vol[0];
+    if constexpr (USES_RIGHT) volumes[1] = vol[1];
+    if constexpr (USES_CENTER) {
+        volumes[2] = (vol[0] + vol[1]) * 0.5; // same as stereoVolumeHelper.
+    }
+}
+
+template <int MIXTYPE, int NCHAN, typename TI>
+inline size_t simdVolumeMulti(float* out, size_t frameCount, const TI* in, const float *vol)
+{
+    if (frameCount < kSimdMixBlockFrames) return 0;
+    const auto mixBlock = mixerops_simd::getMixBlock<TI, isSimdMixAccumulate(MIXTYPE)>(
+            mixerops_simd::getIsa());
+    if (mixBlock == nullptr) return 0;
+
+    constexpr auto kIndices = simdMixVolumeIndices<MIXTYPE, NCHAN>();
+    constexpr size_t kBlockSamples = kSimdMixBlockFrames * NCHAN;
+    float volumes[3];
+    simdMixVolumes<MIXTYPE, NCHAN>(volumes, vol);
+    float blockVolumes[kBlockSamples];
+    for (size_t i = 0; i < kBlockSamples; i += NCHAN) {
+        for (int j = 0; j < NCHAN; ++j) {
+            blockVolumes[i + j] = volumes[kIndices[j]];
+        }
+    }
+    const size_t frames = frameCount - frameCount % kSimdMixBlockFrames;
+    for (size_t i = 0; i < frames * NCHAN; i += kBlockSamples) {
+        mixBlock(out + i, in + i, blockVolumes, kBlockSamples);
+    }
+    return frames;
+}
+
+template <int MIXTYPE, int NCHAN, typename TI>
+inline size_t simdVolumeRampMulti(float* out, size_t frameCount, const TI* in,
+        float *vol, const float *volinc)
+{
+    if (frameCount < kSimdMixBlockFrames) return 0;
+    const auto mixBlock = mixerops_simd::getMixBlock<TI, isSimdMixAccumulate(MIXTYPE)>(
+            mixerops_simd::getIsa());
+    if (mixBlock == nullptr) return 0;
+
+    constexpr auto kIndices = simdMixVolumeIndices<MIXTYPE, NCHAN>();
+    constexpr size_t kBlockSamples = kSimdMixBlockFrames * NCHAN;
+    float blockVolumes[kBlockSamples];
+    const size_t frames = frameCount - frameCount % kSimdMixBlockFrames;
+    for (size_t i = 0; i < frames * NCHAN; i += kBlockSamples) {
+        // The ramp is accumulated frame by frame, exactly as the scalar code does.
+        for (size_t k = 0; k < kBlockSamples; k += NCHAN) {
+            float volumes[3];
+            simdMixVolumes<MIXTYPE, NCHAN>(volumes, vol);
+            for (int j = 0; j < NCHAN; ++j) {
+                blockVolumes[k + j] = volumes[kIndices[j]];
+            }
+            if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY) {
+                for (int j = 0; j < NCHAN; ++j) {
+                    vol[j] += volinc[j];
+                }
+            } else if constexpr (MIXTYPE == MIXTYPE_MULTI_MONOVOL
+                    || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL) {
+                vol[0] += volinc[0];
+            } else /* constexpr */ {
+                vol[0] += volinc[0];
+                vol[1] += volinc[1];
+            }
+        }
+        mixBlock(out + i, in + i, blockVolumes, kBlockSamples);
+    }
+    return frames;
+}
+
 /*
  * The volumeRampMulti and volumeRamp functions take a MIXTYPE
  * which indicates the per-frame mixing and accumulation strategy.
@@ -437,6 +593,16 @@ inline void volumeRampMulti(TO* out, size_t frameCount,
 #ifdef ALOGVV
     ALOGVV("volumeRampMulti, MIXTYPE:%d\n", MIXTYPE);
 #endif
+    if constexpr (isSimdMixSupported<MIXTYPE, NCHAN, TO, TI, TV>()) {
+        if (aux == NULL) {
+            const size_t frames =
+                    simdVolumeRampMulti<MIXTYPE, NCHAN>(out, frameCount, in, vol, volinc);
+            if (frames == frameCount) return;
+            out += frames * NCHAN;
+            in += frames * NCHAN;
+            frameCount -= frames;
+        }
+    }
     if (aux != NULL) {
         do {
             TA auxaccum = 0;
@@ -531,6 +697,15 @@ inline void volumeMulti(TO* out, size_t frameCount,
 #ifdef ALOGVV
     ALOGVV("volumeMulti MIXTYPE:%d\n", MIXTYPE);
 #endif
+    if constexpr (isSimdMixSupported<MIXTYPE, NCHAN, TO, TI, TV>()) {
+        if (aux == NULL) {
+            const size_t frames = simdVolumeMulti<MIXTYPE, NCHAN>(out, frameCount, in, vol);
+            if (frames == frameCount) return;
+            out += frames * NCHAN;
+            in += frames * NCHAN;
+            frameCount -= frames;
+        }
+    }
     if (aux != NULL) {
         do {
             TA auxaccum = 0;
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXER_OPS_SIMD_H
+#define ANDROID_AUDIO_MIXER_OPS_SIMD_H
+
+#include <atomic>
+#include <initializer_list>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+#if defined(__i386__) || defined(__x86_64__)
+#define USE_MIXEROPS_X86 (true)
+#include <immintrin.h>
+#else
+#define USE_MIXEROPS_X86 (false)
+#endif
+
+namespace android::mixerops_simd {
+
+/*
+ * Explicit SIMD kernels for the float output mixer paths, selected at runtime.
+ *
+ * The kernels have no knowledge of MIXTYPE or channel geometry; they compute
+ *
+ *   out[i] = MixMul<float, TI, float>(in[i], vol[i])    (save only)
+ *   out[i] += MixMul<float, TI, float>(in[i], vol[i])   (accumulate)
+ *
+ * for a count of samples that is a multiple of kMaxLanes, with TI float or int16_t.
+ * The per sample volume array is prepared by the caller (see AudioMixerOps.h).
+ *
+ * Each lane performs exactly the same IEEE operations in the same order as the scalar
+ * MixMul (a multiply, optionally a second multiply by the Q0.15 scale, then an add),
+ * and no fused multiply-add is used, so the results are bit-exact with the scalar path.
+ */
+
+// Number of samples processed per vector iteration by the widest kernel.
+// Callers must pass a count that is a multiple of this.
+constexpr size_t kMaxLanes = 16;
+
+enum class Isa {
+    SCALAR,  // no SIMD kernel, use the templated scalar code.
+    SSE2,
+    AVX2,
+    AVX512,
+};
+
+constexpr const char* toString(Isa isa) {
+    switch (isa) {
+    case Isa::SCALAR: return "scalar";
+    case Isa::SSE2: return "sse2";
+    case Isa::AVX2: return "avx2";
+    case Isa::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+template <typename TI>
+using MixBlockFn = void (*)(float* out, const TI* in, const float* vol, size_t count);
+
+#if USE_MIXEROPS_X86
+
+// Matches float_from_q_15 in MixMul<float, int16_t, float>.
+constexpr float kFloatFromQ15 = 1.f / (1 << 15);
+
+#ifdef __SSE2__
+template <typename TI, bool ACCUMULATE>
+void mixBlockSse2(float* out, const TI* in, const float* vol, size_t count) {
+    for (size_t i = 0; i < count; i += 4) {
+        __m128 value;
+        if constexpr (std::is_same_v<TI, int16_t>) {
+            const __m128i s16 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i));
+            // sign extend to 32 bits: place each sample in the upper half, then shift down.
+            const __m128i s32 = _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
+            value = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(s32), _mm_loadu_ps(vol + i)),
+                    _mm_set1_ps(kFloatFromQ15));
+        } else {
+            value = _mm_mul_ps(_mm_loadu_ps(in + i), _mm_loadu_ps(vol + i));
+        }
+        if constexpr (ACCUMULATE) {
+            value = _mm_add_ps(_mm_loadu_ps(out + i), value);
+        }
+        _mm_storeu_ps(out + i, value);
+    }
+}
+#endif // __SSE2__
+
+template <typename TI, bool ACCUMULATE>
+__attribute__((target("avx2")))
+void mixBlockAvx2(float* out, const TI* in, const float* vol, size_t count) {
+    for (size_t i = 0; i < count; i += 8) {
+        __m256 value;
+        if constexpr (std::is_same_v<TI, int16_t>) {
+            const __m128i s16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            value = _mm256_mul_ps(
+                    _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(s16)),
+                            _mm256_loadu_ps(vol + i)),
+                    _mm256_set1_ps(kFloatFromQ15));
+        } else {
+            value = _mm256_mul_ps(_mm256_loadu_ps(in + i), _mm256_loadu_ps(vol + i));
+        }
+        if constexpr (ACCUMULATE) {
+            value = _mm256_add_ps(_mm256_loadu_ps(out + i), value);
+        }
+        _mm256_storeu_ps(out + i, value);
+    }
+}
+
+template <typename TI, bool ACCUMULATE>
+__attribute__((target("avx512f")))
+void mixBlockAvx512(float* out, const TI* in, const float* vol, size_t count) {
+    for (size_t i = 0; i < count; i += 16) {
+        __m512 value;
+        if constexpr (std::is_same_v<TI, int16_t>) {
+            const __m256i s16 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+            value = _mm512_mul_ps(
+                    _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(s16)),
+                            _mm512_loadu_ps(vol + i)),
+                    _mm512_set1_ps(kFloatFromQ15));
+        } else {
+            value = _mm512_mul_ps(_mm512_loadu_ps(in + i), _mm512_loadu_ps(vol + i));
+        }
+        if constexpr (ACCUMULATE) {
+            value = _mm512_add_ps(_mm512_loadu_ps(out + i), value);
+        }
+        _mm512_storeu_ps(out + i, value);
+    }
+}
+
+#endif // USE_MIXEROPS_X86
+
+inline bool isIsaSupported(Isa isa) {
+    switch (isa) {
+    case Isa::SCALAR:
+        return true;
+#if USE_MIXEROPS_X86
+#ifdef __SSE2__
+    case Isa::SSE2:
+        return true;
+#endif
+    case Isa::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    case Isa::AVX512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+inline Isa detectIsa() {
+    for (const Isa isa : { Isa::AVX512, Isa::AVX2, Isa::SSE2 }) {
+        if (isIsaSupported(isa)) return isa;
+    }
+    return Isa::SCALAR;
+}
+
+// The ISA used by the mixer.  Detected once per process, may be overridden for testing.
+inline std::atomic<Isa> gIsa{detectIsa()};
+
+inline Isa getIsa() {
+    return gIsa.load(std::memory_order_relaxed);
+}
+
+// Returns false (and leaves the ISA unchanged) if the CPU does not support it.
+inline bool setIsa(Isa isa) {
+    if (!isIsaSupported(isa)) return false;
+    gIsa.store(isa, std::memory_order_relaxed);
+    return true;
+}
+
+// Returns the block kernel for the ISA, or nullptr if the scalar code should be used.
+template <typename TI, bool ACCUMULATE>
+MixBlockFn<TI> getMixBlock(Isa isa) {
+    static_assert(std::is_same_v<TI, float> || std::is_same_v<TI, int16_t>);
+    switch (isa) {
+#if USE_MIXEROPS_X86
+#ifdef __SSE2__
+    case Isa::SSE2:
+        return &mixBlockSse2<TI, ACCUMULATE>;
+#endif
+    case Isa::AVX2:
+        return &mixBlockAvx2<TI, ACCUMULATE>;
+    case Isa::AVX512:
+        return &mixBlockAvx512<TI, ACCUMULATE>;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+} // namespace android::mixerops_simd
+
+#endif /* ANDROID_AUDIO_MIXER_OPS_SIMD_H */
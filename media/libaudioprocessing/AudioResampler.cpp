@@ -261,6 +261,11 @@ AudioResampler* AudioResampler::create(audio_format_t format, int inChannelCount
     return resampler;
 }
 
+// static
+std::string AudioResampler::dumpFilterCache() {
+    return FirCoefCache::toString();
+}
+
 AudioResampler::AudioResampler(int inChannelCount,
         int32_t sampleRate, src_quality quality) :
         mChannelCount(inChannelCount),
@@ -23,6 +23,9 @@
 #include <dlfcn.h>
 #include <math.h>
 
+#include <atomic>
+#include <sstream>
+
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
 #include <utils/Log.h>
@@ -34,6 +37,7 @@
 #include "AudioResamplerFirProcessSSE.h"
 #include "AudioResamplerFirGen.h" // requires math.h
 #include "AudioResamplerDyn.h"
+#include "AudioResamplerFirProcessAVX.h" // requires AudioResamplerDyn.h
 
 //#define DEBUG_RESAMPLER
 
@@ -58,6 +62,45 @@ namespace android {
  * r = extra space for implementing the ring buffer
  */
 
+static FirSimd detectFirSimd()
+{
+    if (isFirSimdSupported(FirSimd::AVX512)) return FirSimd::AVX512;
+    if (isFirSimdSupported(FirSimd::AVX2)) return FirSimd::AVX2;
+    return FirSimd::NONE;
+}
+
+static std::atomic<FirSimd> sFirSimd{detectFirSimd()};
+
+bool isFirSimdSupported(FirSimd simd)
+{
+    switch (simd) {
+    case FirSimd::NONE:
+        return true;
+#if USE_WIDE_SIMD
+    case FirSimd::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case FirSimd::AVX512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+FirSimd getFirSimd()
+{
+    return sFirSimd.load(std::memory_order_relaxed);
+}
+
+bool setFirSimd(FirSimd simd)
+{
+    if (!isFirSimdSupported(simd)) return false;
+    sFirSimd.store(simd, std::memory_order_relaxed);
+    return true;
+}
+
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::InBuffer::InBuffer()
     : mState(NULL), mImpulse(NULL), mRingFull(NULL), mStateCount(0)
@@ -181,8 +224,7 @@ template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
-      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY)
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -207,7 +249,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -232,6 +273,85 @@ void AudioResamplerDyn<TC, TI, TO>::setVolume(float left, float right)
     }
 }
 
+std::mutex FirCoefCache::sMutex;
+std::map<FirCoefCache::Key, FirCoefCache::Entry> FirCoefCache::sEntries;
+FirCoefCache::Statistics FirCoefCache::sStatistics;
+
+// static
+std::shared_ptr<const void> FirCoefCache::acquire(const Key& key, size_t bytes,
+        const std::function<void(void* coefs)>& design)
+{
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        auto it = sEntries.find(key);
+        if (it != sEntries.end()) {
+            std::shared_ptr<const void> coefs = it->second.coefs.lock();
+            if (coefs != nullptr) {
+                ++sStatistics.hits;
+                return coefs;
+            }
+        }
+    }
+
+    // Design outside of the lock, filter generation may take milliseconds.
+    void *buffer = nullptr;
+    int ret = posix_memalign(&buffer, CACHE_LINE_SIZE /* alignment */, bytes);
+    LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
+    design(buffer);
+    std::shared_ptr<const void> coefs(buffer, [](const void *p) { free(const_cast<void *>(p)); });
+
+    std::lock_guard<std::mutex> lock(sMutex);
+    Entry& entry = sEntries[key];
+    std::shared_ptr<const void> existing = entry.coefs.lock();
+    if (existing != nullptr) { // designed concurrently by another resampler.
+        ++sStatistics.hits;
+        return existing;
+    }
+    ++sStatistics.misses;
+    entry.coefs = coefs;
+    entry.bytes = bytes;
+    purge_l();
+    return coefs;
+}
+
+// static
+void FirCoefCache::purge_l()
+{
+    for (auto it = sEntries.begin(); it != sEntries.end(); ) {
+        if (it->second.coefs.expired()) {
+            it = sEntries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// static
+FirCoefCache::Statistics FirCoefCache::getStatistics()
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    Statistics statistics = sStatistics;
+    for (const auto& [key, entry] : sEntries) {
+        if (!entry.coefs.expired()) {
+            ++statistics.entries;
+            statistics.bytes += entry.bytes;
+        }
+    }
+    return statistics;
+}
+
+// static
+std::string FirCoefCache::toString()
+{
+    const Statistics statistics = getStatistics();
+    std::stringstream ss;
+    ss << "Resampler filter cache: hits:" << statistics.hits
+            << " misses:" << statistics.misses
+            << " filters:" << statistics.entries
+            << " bytes:" << statistics.bytes << "\n";
+    return ss.str();
+}
+
 // TODO: update to C++11
 
 template<typename T> T max(T a, T b) {return a > b ? a : b;}
@@ -263,24 +383,20 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     const int phases = c.mL;
     const int halfLength = c.mHalfNumCoefs;
 
-    // create buffer
-    TC *coefs = nullptr;
-    int ret = posix_memalign(
-            reinterpret_cast<void **>(&coefs),
-            CACHE_LINE_SIZE /* alignment */,
-            (phases + 1) * halfLength * sizeof(TC));
-    LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
-
     // square the computed minimum passband value (extra safety).
     double attenuation =
             computeWindowedSincMinimumPassbandValue(stopBandAtten);
     attenuation *= attenuation;
 
-    // design filter
-    firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    // design filter, or share an identical one designed for another resampler.
+    const FirCoefCache::Key key{
+            FirCoefCache::coefTypeOf<TC>(), phases, halfLength, stopBandAtten, fcr};
+    mCoefBuffer = std::static_pointer_cast<const TC>(FirCoefCache::acquire(
+            key, (phases + 1) * halfLength * sizeof(TC), [&](void *coefs) {
+                firKaiserGen(static_cast<TC *>(coefs), phases, halfLength,
+                        stopBandAtten, fcr, attenuation);
+            }));
+    c.mFirCoefs = mCoefBuffer.get();
 
     // update the design criteria
     mNormalizedCutoffFrequency = fcr;
@@ -306,7 +422,7 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
 
     const int32_t passSteps = 1000;
 
-    testFir(coefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
+    testFir(c.mFirCoefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
             passMin, passMax, passRipple, stopMax, stopRipple);
     ALOGD("passband(%lf, %lf): %.8lf %.8lf %.8lf\n", 0., fp, passMin, passMax, passRipple);
     ALOGD("stopband(%lf, %lf): %.8lf %.3lf\n", fs, 0.5, stopMax, stopRipple);
@@ -555,9 +671,11 @@ void AudioResamplerDyn<TC, TI, TO>::setSampleRate(int32_t inSampleRate)
 #undef AUDIORESAMPLERDYN_CASE
 #define AUDIORESAMPLERDYN_CASE(CHANNEL, LOCKED) \
     case CHANNEL: if constexpr (CHANNEL <= FCC_LIMIT) {\
-        mResampleFunc = &AudioResamplerDyn<TC, TI, TO>::resample<CHANNEL, LOCKED, 16>; \
+        mResampleFunc = getResampleFunc<CHANNEL, LOCKED>(simd); \
     } break
 
+    const FirSimd simd = getFirSimd();
+
     if (locked) {
         switch (mChannelCount) {
         AUDIORESAMPLERDYN_CASE(1, true);
@@ -616,10 +734,33 @@ void AudioResamplerDyn<TC, TI, TO>::setSampleRate(int32_t inSampleRate)
 #pragma pop_macro("AUDIORESAMPLERDYN_CASE")
 
 #ifdef DEBUG_RESAMPLER
-    printf("channels:%d  %s  stride:%d  %s  coef:%d  shift:%d\n",
+    printf("channels:%d  %s  stride:%d  %s  coef:%d  shift:%d  simd:%d\n",
             mChannelCount, locked ? "locked" : "interpolated",
-            stride, useS32 ? "S32" : "S16", 2*c.mHalfNumCoefs, c.mShift);
+            stride, useS32 ? "S32" : "S16", 2*c.mHalfNumCoefs, c.mShift, (int)simd);
+#endif
+}
+
+template<typename TC, typename TI, typename TO>
+template<int CHANNELS, bool LOCKED>
+typename AudioResamplerDyn<TC, TI, TO>::resample_ABP_t
+AudioResamplerDyn<TC, TI, TO>::getResampleFunc(FirSimd simd __unused)
+{
+#if USE_WIDE_SIMD
+    // Fall back to a narrower kernel if the configuration is not supported by the wider one.
+    if constexpr (isFirWideSupported<FirSimd::AVX512, CHANNELS, TC, TI, TO>()) {
+        if (simd == FirSimd::AVX512) {
+            return &AudioResamplerDyn<TC, TI, TO>::resample<CHANNELS, LOCKED, 16,
+                    FirSimd::AVX512>;
+        }
+    }
+    if constexpr (isFirWideSupported<FirSimd::AVX2, CHANNELS, TC, TI, TO>()) {
+        if (simd == FirSimd::AVX512 || simd == FirSimd::AVX2) {
+            return &AudioResamplerDyn<TC, TI, TO>::resample<CHANNELS, LOCKED, 16,
+                    FirSimd::AVX2>;
+        }
+    }
 #endif
+    return &AudioResamplerDyn<TC, TI, TO>::resample<CHANNELS, LOCKED, 16, FirSimd::NONE>;
 }
 
 template<typename TC, typename TI, typename TO>
@@ -630,7 +771,7 @@ size_t AudioResamplerDyn<TC, TI, TO>::resample(int32_t* out, size_t outFrameCoun
 }
 
 template<typename TC, typename TI, typename TO>
-template<int CHANNELS, bool LOCKED, int STRIDE>
+template<int CHANNELS, bool LOCKED, int STRIDE, FirSimd SIMD>
 size_t AudioResamplerDyn<TC, TI, TO>::resample(TO* out, size_t outFrameCount,
         AudioBufferProvider* provider)
 {
@@ -719,11 +860,22 @@ size_t AudioResamplerDyn<TC, TI, TO>::resample(TO* out, size_t outFrameCount,
             //        "  phaseFraction:%u  phaseWrapLimit:%u",
             //        inFrameCount, outputIndex, outFrameCount, phaseFraction, phaseWrapLimit);
             ALOG_ASSERT(phaseFraction < phaseWrapLimit);
-            fir<CHANNELS, LOCKED, STRIDE>(
-                    &out[outputIndex],
-                    phaseFraction, phaseWrapLimit,
-                    coefShift, halfNumCoefs, coefs,
-                    impulse, volumeSimd);
+#if USE_WIDE_SIMD
+            if constexpr (SIMD != FirSimd::NONE) {
+                firWide<SIMD, CHANNELS, LOCKED>(
+                        &out[outputIndex],
+                        phaseFraction, phaseWrapLimit,
+                        coefShift, halfNumCoefs, coefs,
+                        impulse, volumeSimd);
+            } else
+#endif
+            {
+                fir<CHANNELS, LOCKED, STRIDE>(
+                        &out[outputIndex],
+                        phaseFraction, phaseWrapLimit,
+                        coefShift, halfNumCoefs, coefs,
+                        impulse, volumeSimd);
+            }
 
             outputIndex += OUTPUT_CHANNELS;
 
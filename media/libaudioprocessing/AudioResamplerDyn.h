@@ -21,10 +21,113 @@
 #include <sys/types.h>
 #include <android/log.h>
 
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
 #include <media/AudioResampler.h>
 
 namespace android {
 
+/*
+ * Wide vector FIR kernels (x86 only), see AudioResamplerFirProcessAVX.h.
+ *
+ * The kernel is chosen at runtime from the CPU features when the filter is
+ * configured in setSampleRate().  NONE uses the compile time selected
+ * NEON, SSE or scalar code.
+ */
+enum class FirSimd : int32_t {
+    NONE,
+    AVX2,
+    AVX512,
+};
+
+// Returns true if the CPU supports the kernel.
+bool isFirSimdSupported(FirSimd simd);
+
+// Returns the kernel used by resamplers subsequently configured.
+FirSimd getFirSimd();
+
+// Overrides the kernel for resamplers subsequently configured (for testing and
+// benchmarking).  Returns false and leaves the selection unchanged if not supported.
+bool setFirSimd(FirSimd simd);
+
+/*
+ * Process wide cache of polyphase filter banks.
+ *
+ * Designing a Kaiser filter bank is the most expensive part of resampler
+ * configuration, and tracks with the same rate pair and quality design exactly
+ * the same filter.  The cache is keyed by the design parameters that
+ * createKaiserFir() derives from the input rate, output rate and quality, together
+ * with the coefficient type, so identical resamplers share one read-only table.
+ *
+ * Entries are reference counted: the table is freed when the last resampler using
+ * it is reconfigured or destroyed.
+ */
+class FirCoefCache {
+public:
+    enum class CoefType : int32_t {
+        S16,
+        S32,
+        FLOAT,
+    };
+
+    template<typename TC>
+    static constexpr CoefType coefTypeOf() {
+        return std::is_same_v<TC, float> ? CoefType::FLOAT
+                : sizeof(TC) == sizeof(int32_t) ? CoefType::S32 : CoefType::S16;
+    }
+
+    struct Key {
+        CoefType coefType;
+        int32_t phases;
+        int32_t halfNumCoefs;
+        double stopBandAtten;
+        double fcr;
+
+        bool operator<(const Key& other) const {
+            return std::tie(coefType, phases, halfNumCoefs, stopBandAtten, fcr)
+                    < std::tie(other.coefType, other.phases, other.halfNumCoefs,
+                            other.stopBandAtten, other.fcr);
+        }
+    };
+
+    struct Statistics {
+        uint64_t hits = 0;     // filter banks shared with an existing resampler.
+        uint64_t misses = 0;   // filter banks designed.
+        size_t entries = 0;    // filter banks currently in use.
+        size_t bytes = 0;      // memory of the filter banks currently in use.
+    };
+
+    // Returns the filter bank for the key, calling design() to fill in a newly
+    // allocated (cache line aligned) buffer of the given size if not present.
+    // design() is called without the cache lock held.
+    static std::shared_ptr<const void> acquire(const Key& key, size_t bytes,
+            const std::function<void(void* coefs)>& design);
+
+    static Statistics getStatistics();
+
+    // For dumpsys.
+    static std::string toString();
+
+private:
+    struct Entry {
+        std::weak_ptr<const void> coefs;
+        size_t bytes;
+    };
+
+    // removes entries no longer referenced by any resampler, requires sMutex.
+    static void purge_l();
+
+    static std::mutex sMutex;
+    static std::map<Key, Entry> sEntries; // GUARDED_BY(sMutex)
+    static Statistics sStatistics;        // GUARDED_BY(sMutex), entries and bytes unused.
+};
+
 /* AudioResamplerDyn
  *
  * This class template is used for floating point and integer resamplers.
@@ -152,13 +255,17 @@ private:
 
     void createKaiserFir(Constants &c, double stopBandAtten, double fcr);
 
-    template<int CHANNELS, bool LOCKED, int STRIDE>
+    template<int CHANNELS, bool LOCKED, int STRIDE, FirSimd SIMD>
     size_t resample(TO* out, size_t outFrameCount, AudioBufferProvider* provider);
 
     // define a pointer to member function type for resample
     typedef size_t (AudioResamplerDyn<TC, TI, TO>::*resample_ABP_t)(TO* out,
             size_t outFrameCount, AudioBufferProvider* provider);
 
+    // returns the resample function for the channel count and the wide vector kernel.
+    template<int CHANNELS, bool LOCKED>
+    resample_ABP_t getResampleFunc(FirSimd simd);
+
     // data - the contiguous storage and layout of these is important.
            InBuffer mInBuffer;
           Constants mConstants;        // current set of coefficient parameters
@@ -166,7 +273,7 @@ private:
      resample_ABP_t mResampleFunc;     // called function for resampling
             int32_t mFilterSampleRate; // designed filter sample rate.
         src_quality mFilterQuality;    // designed filter quality.
-              void* mCoefBuffer;       // if a filter is created, this is not null
+    std::shared_ptr<const TC> mCoefBuffer; // if a filter is created, this is not null
 
     // Property selected design parameters.
               // This will enable fixed high quality resampling.
@@ -49,6 +49,15 @@ namespace android {
 #define USE_AVX2(false)
 #endif
 
+// Wide vector (AVX2, AVX-512) kernels are compiled with function target attributes
+// and selected at runtime, see AudioResamplerFirProcessAVX.h.
+#if defined(__i386__) || defined(__x86_64__)
+#define USE_WIDE_SIMD (true)
+#include <immintrin.h>
+#else
+#define USE_WIDE_SIMD (false)
+#endif
+
 
 template<typename T, typename U>
 struct is_same
@@ -0,0 +1,515 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX_H
+#define ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX_H
+
+namespace android {
+
+// depends on AudioResamplerFirOps.h, AudioResamplerFirProcess.h, AudioResamplerDyn.h
+
+#if USE_WIDE_SIMD
+
+//
+// Wide vector (AVX2 and AVX-512) equivalents of fir(), ProcessL() and Process().
+//
+// Unlike the SSE and NEON specializations, which are selected at compile time,
+// these are compiled with function target attributes and selected at runtime
+// by AudioResamplerDyn::setSampleRate() through getFirSimd().  As the kernels
+// cannot be inlined into the (baseline ISA) resample loop, firWide() is one call
+// per output frame and does the polyphase index computation itself.
+//
+// Supported configurations (see isFirWideSupported()):
+//
+// TC=float,   TI=float,   TO=float:   any channel count, AVX2 (FMA) and AVX-512.
+// TC=int16_t, TI=int16_t, TO=int32_t: mono and stereo, AVX2.
+// TC=int32_t, TI=int16_t, TO=int32_t: mono and stereo, AVX2.
+//
+// The integer kernels evaluate exactly the same per tap products as mac() and
+// interpolate() in AudioResamplerFirProcess.h, so the output is bit-exact with the
+// scalar code.  The float kernels reorder the accumulation, like the SSE and NEON paths.
+//
+
+template <FirSimd SIMD, int CHANNELS, typename TC, typename TI, typename TO>
+constexpr bool isFirWideSupported() {
+    if constexpr (SIMD == FirSimd::NONE) {
+        return false;
+    } else if constexpr (is_same<TC, float>::value && is_same<TI, float>::value
+            && is_same<TO, float>::value) {
+        return true;
+    } else if constexpr ((is_same<TC, int16_t>::value || is_same<TC, int32_t>::value)
+            && is_same<TI, int16_t>::value && is_same<TO, int32_t>::value) {
+        return SIMD == FirSimd::AVX2 && CHANNELS <= 2;
+    } else {
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 float
+
+// Sums the 8 lanes of v.
+__attribute__((target("avx2,fma")))
+static inline float hsumAvx2(__m256 v)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x55));
+    return _mm_cvtss_f32(s);
+}
+
+// Loads 8 (FIXED) or interpolated coefficients for the positive and negative half.
+template <bool FIXED>
+__attribute__((target("avx2,fma")))
+static inline void loadCoefsAvx2(__m256& posCoef, __m256& negCoef,
+        const float* coefsP, const float* coefsN, int count, __m256 interp)
+{
+    posCoef = _mm256_loadu_ps(coefsP);
+    negCoef = _mm256_loadu_ps(coefsN);
+    if (!FIXED) {
+        // posCoef = interp * (posCoef1 - posCoef) + posCoef
+        // negCoef = interp * (negCoef - negCoef1) + negCoef1
+        const __m256 posCoef1 = _mm256_loadu_ps(coefsP + count);
+        const __m256 negCoef1 = _mm256_loadu_ps(coefsN + count);
+        posCoef = _mm256_fmadd_ps(_mm256_sub_ps(posCoef1, posCoef), interp, posCoef);
+        negCoef = _mm256_fmadd_ps(_mm256_sub_ps(negCoef, negCoef1), interp, negCoef1);
+    }
+}
+
+// Loads vector v of a multichannel frame, masking the channels past the end of the frame.
+template <int VECTORS>
+__attribute__((target("avx2,fma")))
+static inline __m256 loadChannelsAvx2(const float* p, int v, __m256i lastMask)
+{
+    return v == VECTORS - 1
+            ? _mm256_maskload_ps(p + 8 * v, lastMask) : _mm256_loadu_ps(p + 8 * v);
+}
+
+template <int CHANNELS, bool FIXED>
+__attribute__((target("avx2,fma"), noinline))
+static void ProcessAVX2(float* const out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* sP,
+        const float* sN,
+        float lerpP,
+        const float* const volumeLR)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    const __m256 interp = _mm256_set1_ps(lerpP);
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+    if constexpr (CHANNELS == 1) {
+        __m256 accL = _mm256_setzero_ps();
+        sP -= 8 - 1;
+        for (int i = 0; i < count; i += 8) {
+            __m256 posCoef, negCoef;
+            loadCoefsAvx2<FIXED>(posCoef, negCoef, coefsP + i, coefsN + i, count, interp);
+            const __m256 posSamp = _mm256_permutevar8x32_ps(_mm256_loadu_ps(sP - i), reverse);
+            const __m256 negSamp = _mm256_loadu_ps(sN + i);
+            accL = _mm256_fmadd_ps(posSamp, posCoef, accL);
+            accL = _mm256_fmadd_ps(negSamp, negCoef, accL);
+        }
+        const float l = hsumAvx2(accL);
+        out[0] += volumeAdjust(l, volumeLR[0]);
+        out[1] += volumeAdjust(l, volumeLR[1]);
+    } else if constexpr (CHANNELS == 2) {
+        // deinterleave leaves frames {0, 1, 4, 5, 2, 3, 6, 7} across the lanes.
+        const __m256i negOrder = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+        const __m256i posOrder = _mm256_setr_epi32(7, 6, 3, 2, 5, 4, 1, 0);
+        __m256 accL = _mm256_setzero_ps();
+        __m256 accR = _mm256_setzero_ps();
+        sP -= 2 * (8 - 1);
+        for (int i = 0; i < count; i += 8) {
+            __m256 posCoef, negCoef;
+            loadCoefsAvx2<FIXED>(posCoef, negCoef, coefsP + i, coefsN + i, count, interp);
+            const __m256 posSamp0 = _mm256_loadu_ps(sP - 2 * i);
+            const __m256 posSamp1 = _mm256_loadu_ps(sP - 2 * i + 8);
+            const __m256 negSamp0 = _mm256_loadu_ps(sN + 2 * i);
+            const __m256 negSamp1 = _mm256_loadu_ps(sN + 2 * i + 8);
+            const __m256 posSampL = _mm256_permutevar8x32_ps(
+                    _mm256_shuffle_ps(posSamp0, posSamp1, 0x88), posOrder);
+            const __m256 posSampR = _mm256_permutevar8x32_ps(
+                    _mm256_shuffle_ps(posSamp0, posSamp1, 0xDD), posOrder);
+            const __m256 negSampL = _mm256_permutevar8x32_ps(
+                    _mm256_shuffle_ps(negSamp0, negSamp1, 0x88), negOrder);
+            const __m256 negSampR = _mm256_permutevar8x32_ps(
+                    _mm256_shuffle_ps(negSamp0, negSamp1, 0xDD), negOrder);
+            accL = _mm256_fmadd_ps(posSampL, posCoef, accL);
+            accR = _mm256_fmadd_ps(posSampR, posCoef, accR);
+            accL = _mm256_fmadd_ps(negSampL, negCoef, accL);
+            accR = _mm256_fmadd_ps(negSampR, negCoef, accR);
+        }
+        out[0] += volumeAdjust(hsumAvx2(accL), volumeLR[0]);
+        out[1] += volumeAdjust(hsumAvx2(accR), volumeLR[1]);
+    } else {
+        // Multichannel: vectorize across the interleaved channels of each frame,
+        // broadcasting the coefficient for the frame.
+        constexpr int VECTORS = (CHANNELS + 7) / 8;
+        constexpr int REMAINDER = CHANNELS - (VECTORS - 1) * 8;
+        const __m256i lastMask = _mm256_cmpgt_epi32(
+                _mm256_set1_epi32(REMAINDER), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256 acc[VECTORS];
+        for (int v = 0; v < VECTORS; ++v) {
+            acc[v] = _mm256_setzero_ps();
+        }
+        for (int i = 0; i < count; i += 8) {
+            __m256 posCoef, negCoef;
+            loadCoefsAvx2<FIXED>(posCoef, negCoef, coefsP + i, coefsN + i, count, interp);
+            float __attribute__((aligned(32))) posCoefs[8];
+            float __attribute__((aligned(32))) negCoefs[8];
+            _mm256_store_ps(posCoefs, posCoef);
+            _mm256_store_ps(negCoefs, negCoef);
+            for (int j = 0; j < 8; ++j) {
+                const __m256 pc = _mm256_set1_ps(posCoefs[j]);
+                const __m256 nc = _mm256_set1_ps(negCoefs[j]);
+                const float* const pSamp = sP - (i + j) * CHANNELS;
+                const float* const nSamp = sN + (i + j) * CHANNELS;
+                for (int v = 0; v < VECTORS; ++v) {
+                    acc[v] = _mm256_fmadd_ps(
+                            loadChannelsAvx2<VECTORS>(pSamp, v, lastMask), pc, acc[v]);
+                    acc[v] = _mm256_fmadd_ps(
+                            loadChannelsAvx2<VECTORS>(nSamp, v, lastMask), nc, acc[v]);
+                }
+            }
+        }
+        // for (int j = 0; j < CHANNELS; ++j) out[j] += acc[j] * volumeLR[0];
+        const __m256 vol = _mm256_set1_ps(volumeLR[0]);
+        for (int v = 0; v < VECTORS; ++v) {
+            // not fused, the volume adjusted value is added as in ProcessBase().
+            const __m256 result = _mm256_add_ps(
+                    loadChannelsAvx2<VECTORS>(out, v, lastMask), _mm256_mul_ps(acc[v], vol));
+            if (v == VECTORS - 1) {
+                _mm256_maskstore_ps(out + 8 * v, lastMask, result);
+            } else {
+                _mm256_storeu_ps(out + 8 * v, result);
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512 float
+
+template <bool FIXED>
+__attribute__((target("avx512f")))
+static inline void loadCoefsAvx512(__m512& posCoef, __m512& negCoef,
+        const float* coefsP, const float* coefsN, int count, __m512 interp)
+{
+    posCoef = _mm512_loadu_ps(coefsP);
+    negCoef = _mm512_loadu_ps(coefsN);
+    if (!FIXED) {
+        const __m512 posCoef1 = _mm512_loadu_ps(coefsP + count);
+        const __m512 negCoef1 = _mm512_loadu_ps(coefsN + count);
+        posCoef = _mm512_fmadd_ps(_mm512_sub_ps(posCoef1, posCoef), interp, posCoef);
+        negCoef = _mm512_fmadd_ps(_mm512_sub_ps(negCoef, negCoef1), interp, negCoef1);
+    }
+}
+
+template <int VECTORS>
+__attribute__((target("avx512f")))
+static inline __m512 loadChannelsAvx512(const float* p, int v, __mmask16 lastMask)
+{
+    return v == VECTORS - 1
+            ? _mm512_maskz_loadu_ps(lastMask, p + 16 * v) : _mm512_loadu_ps(p + 16 * v);
+}
+
+template <int CHANNELS, bool FIXED>
+__attribute__((target("avx512f"), noinline))
+static void ProcessAVX512(float* const out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* sP,
+        const float* sN,
+        float lerpP,
+        const float* const volumeLR)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    if constexpr (CHANNELS > 2) {
+        // Multichannel: a full 16 channel vector per frame.
+        constexpr int VECTORS = (CHANNELS + 15) / 16;
+        constexpr int REMAINDER = CHANNELS - (VECTORS - 1) * 16;
+        constexpr __mmask16 lastMask = (1u << REMAINDER) - 1;
+        __m512 acc[VECTORS];
+        for (int v = 0; v < VECTORS; ++v) {
+            acc[v] = _mm512_setzero_ps();
+        }
+        for (int i = 0; i < count; ++i) {
+            float pc = coefsP[i];
+            float nc = coefsN[i];
+            if (!FIXED) {
+                pc = lerpP * (coefsP[count + i] - pc) + pc;
+                nc = lerpP * (nc - coefsN[count + i]) + coefsN[count + i];
+            }
+            const __m512 pcv = _mm512_set1_ps(pc);
+            const __m512 ncv = _mm512_set1_ps(nc);
+            for (int v = 0; v < VECTORS; ++v) {
+                acc[v] = _mm512_fmadd_ps(
+                        loadChannelsAvx512<VECTORS>(sP - i * CHANNELS, v, lastMask), pcv, acc[v]);
+                acc[v] = _mm512_fmadd_ps(
+                        loadChannelsAvx512<VECTORS>(sN + i * CHANNELS, v, lastMask), ncv, acc[v]);
+            }
+        }
+        const __m512 vol = _mm512_set1_ps(volumeLR[0]);
+        for (int v = 0; v < VECTORS; ++v) {
+            // not fused, the volume adjusted value is added as in ProcessBase().
+            const __m512 result = _mm512_add_ps(
+                    loadChannelsAvx512<VECTORS>(out, v, lastMask), _mm512_mul_ps(acc[v], vol));
+            if (v == VECTORS - 1) {
+                _mm512_mask_storeu_ps(out + 16 * v, lastMask, result);
+            } else {
+                _mm512_storeu_ps(out + 16 * v, result);
+            }
+        }
+        return;
+    }
+
+    // Mono and stereo: 16 coefficients per iteration, gathering the (reversed) positive
+    // and (forward) negative samples of each channel with a single permute.
+    const __m512 interp = _mm512_set1_ps(lerpP);
+    const __m512i posIndex = _mm512_setr_epi32(
+            15 * CHANNELS, 14 * CHANNELS, 13 * CHANNELS, 12 * CHANNELS,
+            11 * CHANNELS, 10 * CHANNELS, 9 * CHANNELS, 8 * CHANNELS,
+            7 * CHANNELS, 6 * CHANNELS, 5 * CHANNELS, 4 * CHANNELS,
+            3 * CHANNELS, 2 * CHANNELS, 1 * CHANNELS, 0);
+    const __m512i negIndex = _mm512_setr_epi32(
+            0, 1 * CHANNELS, 2 * CHANNELS, 3 * CHANNELS,
+            4 * CHANNELS, 5 * CHANNELS, 6 * CHANNELS, 7 * CHANNELS,
+            8 * CHANNELS, 9 * CHANNELS, 10 * CHANNELS, 11 * CHANNELS,
+            12 * CHANNELS, 13 * CHANNELS, 14 * CHANNELS, 15 * CHANNELS);
+    const __m512i one = _mm512_set1_epi32(1);
+    __m512 accL = _mm512_setzero_ps();
+    __m512 accR = _mm512_setzero_ps();
+    const int count16 = count & ~15;
+    int i = 0;
+    for (; i < count16; i += 16) {
+        __m512 posCoef, negCoef;
+        loadCoefsAvx512<FIXED>(posCoef, negCoef, coefsP + i, coefsN + i, count, interp);
+        if constexpr (CHANNELS == 1) {
+            const __m512 posSamp = _mm512_permutexvar_ps(posIndex, _mm512_loadu_ps(sP - i - 15));
+            const __m512 negSamp = _mm512_loadu_ps(sN + i);
+            accL = _mm512_fmadd_ps(posSamp, posCoef, accL);
+            accL = _mm512_fmadd_ps(negSamp, negCoef, accL);
+        } else {
+            const __m512 posSamp0 = _mm512_loadu_ps(sP - 2 * i - 30);
+            const __m512 posSamp1 = _mm512_loadu_ps(sP - 2 * i - 14);
+            const __m512 negSamp0 = _mm512_loadu_ps(sN + 2 * i);
+            const __m512 negSamp1 = _mm512_loadu_ps(sN + 2 * i + 16);
+            // As a 32 entry table [posSamp0, posSamp1], frame i + m is at 2 * (15 - m).
+            const __m512 posSampL = _mm512_permutex2var_ps(posSamp0, posIndex, posSamp1);
+            const __m512 posSampR = _mm512_permutex2var_ps(
+                    posSamp0, _mm512_add_epi32(posIndex, one), posSamp1);
+            const __m512 negSampL = _mm512_permutex2var_ps(negSamp0, negIndex, negSamp1);
+            const __m512 negSampR = _mm512_permutex2var_ps(
+                    negSamp0, _mm512_add_epi32(negIndex, one), negSamp1);
+            accL = _mm512_fmadd_ps(posSampL, posCoef, accL);
+            accR = _mm512_fmadd_ps(posSampR, posCoef, accR);
+            accL = _mm512_fmadd_ps(negSampL, negCoef, accL);
+            accR = _mm512_fmadd_ps(negSampR, negCoef, accR);
+        }
+    }
+    float l = _mm512_reduce_add_ps(accL);
+    float r = CHANNELS == 2 ? _mm512_reduce_add_ps(accR) : 0.f;
+    for (; i < count; ++i) { // remaining 8 coefficients when count is an odd multiple of 8.
+        float pc = coefsP[i];
+        float nc = coefsN[i];
+        if (!FIXED) {
+            pc = lerpP * (coefsP[count + i] - pc) + pc;
+            nc = lerpP * (nc - coefsN[count + i]) + coefsN[count + i];
+        }
+        l += sP[-i * CHANNELS] * pc + sN[i * CHANNELS] * nc;
+        if constexpr (CHANNELS == 2) {
+            r += sP[-i * CHANNELS + 1] * pc + sN[i * CHANNELS + 1] * nc;
+        }
+    }
+    if constexpr (CHANNELS == 1) {
+        out[0] += volumeAdjust(l, volumeLR[0]);
+        out[1] += volumeAdjust(l, volumeLR[1]);
+    } else {
+        out[0] += volumeAdjust(l, volumeLR[0]);
+        out[1] += volumeAdjust(r, volumeLR[1]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 int16_t input, int16_t or int32_t coefficients, int32_t accumulation.
+
+// Loads 8 coefficients widened to int32_t, interpolated as interpolate() does.
+template <bool FIXED, typename TC>
+__attribute__((target("avx2")))
+static inline __m256i loadIntCoefsAvx2(const TC* c0, const TC* c1, uint32_t lerp)
+{
+    if constexpr (is_same<TC, int16_t>::value) {
+        __m128i coef = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c0));
+        if (!FIXED) {
+            // (int16_t(lerp) * int16_t(c1 - c0) >> 15) + c0, truncated to int16_t.
+            const __m128i d = _mm_sub_epi16(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(c1)), coef);
+            const __m128i l = _mm_set1_epi16(static_cast<int16_t>(lerp));
+            const __m128i lo = _mm_mullo_epi16(l, d);
+            const __m128i hi = _mm_mulhi_epi16(l, d);
+            const __m128i shifted = _mm_or_si128(_mm_srli_epi16(lo, 15), _mm_slli_epi16(hi, 1));
+            coef = _mm_add_epi16(shifted, coef);
+        }
+        return _mm256_cvtepi16_epi32(coef);
+    } else {
+        __m256i coef = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c0));
+        if (!FIXED) {
+            // (lerp * int64_t(c1 - c0) >> 31) + c0, truncated to int32_t.
+            // lerp < 2^31, so a signed 32x32 multiply is exact.  Only bits 31..62 of the
+            // product are kept, so a logical 64 bit shift is sufficient.
+            const __m256i d = _mm256_sub_epi32(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c1)), coef);
+            const __m256i l = _mm256_set1_epi32(static_cast<int32_t>(lerp));
+            const __m256i even = _mm256_srli_epi64(_mm256_mul_epi32(l, d), 31);
+            const __m256i odd = _mm256_srli_epi64(
+                    _mm256_mul_epi32(l, _mm256_srli_epi64(d, 32)), 31);
+            coef = _mm256_add_epi32(
+                    _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA), coef);
+        }
+        return coef;
+    }
+}
+
+// Per tap product as mac() computes it: v * s for int16_t coefficients,
+// (int64_t(v) * s) >> 16 for int32_t coefficients.
+template <typename TC>
+__attribute__((target("avx2")))
+static inline __m256i macAvx2(__m256i acc, __m256i v, __m256i s)
+{
+    if constexpr (is_same<TC, int16_t>::value) {
+        return _mm256_add_epi32(acc, _mm256_mullo_epi32(v, s));
+    } else {
+        // With v = vh * 2^16 + vl (vl unsigned 16 bits),
+        // (v * s) >> 16 == vh * s + ((vl * s) >> 16), and vl * s fits in 32 bits.
+        const __m256i vh = _mm256_srai_epi32(v, 16);
+        const __m256i vl = _mm256_and_si256(v, _mm256_set1_epi32(0xffff));
+        return _mm256_add_epi32(acc, _mm256_add_epi32(_mm256_mullo_epi32(vh, s),
+                _mm256_srai_epi32(_mm256_mullo_epi32(vl, s), 16)));
+    }
+}
+
+__attribute__((target("avx2")))
+static inline int32_t hsumAvx2(__m256i v)
+{
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+
+template <int CHANNELS, bool FIXED, typename TC>
+__attribute__((target("avx2"), noinline))
+static void ProcessAVX2(int32_t* const out,
+        int count,
+        const TC* coefsP,
+        const TC* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        uint32_t lerpP,
+        const int32_t* const volumeLR)
+{
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    __m256i accL = _mm256_setzero_si256();
+    __m256i accR = _mm256_setzero_si256();
+    sP -= CHANNELS * (8 - 1);
+    for (int i = 0; i < count; i += 8) {
+        // see interpolatep() and interpolaten() for the coefficient order,
+        // InterpNull::interpolaten() returns coefsN[i].
+        const __m256i posCoef = loadIntCoefsAvx2<FIXED>(coefsP + i, coefsP + count + i, lerpP);
+        const __m256i negCoef = FIXED ? loadIntCoefsAvx2<FIXED>(coefsN + i, coefsN + i, lerpP)
+                : loadIntCoefsAvx2<FIXED>(coefsN + count + i, coefsN + i, lerpP);
+        if constexpr (CHANNELS == 1) {
+            const __m256i posSamp = _mm256_permutevar8x32_epi32(_mm256_cvtepi16_epi32(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(sP - i))), reverse);
+            const __m256i negSamp = _mm256_cvtepi16_epi32(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(sN + i)));
+            accL = macAvx2<TC>(accL, posCoef, posSamp);
+            accL = macAvx2<TC>(accL, negCoef, negSamp);
+        } else {
+            // each 32 bit lane holds one frame: L in the low half, R in the high half.
+            const __m256i posFrames = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(sP - 2 * i)), reverse);
+            const __m256i negFrames = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(sN + 2 * i));
+            accL = macAvx2<TC>(accL, posCoef,
+                    _mm256_srai_epi32(_mm256_slli_epi32(posFrames, 16), 16));
+            accR = macAvx2<TC>(accR, posCoef, _mm256_srai_epi32(posFrames, 16));
+            accL = macAvx2<TC>(accL, negCoef,
+                    _mm256_srai_epi32(_mm256_slli_epi32(negFrames, 16), 16));
+            accR = macAvx2<TC>(accR, negCoef, _mm256_srai_epi32(negFrames, 16));
+        }
+    }
+    const int32_t l = hsumAvx2(accL);
+    if constexpr (CHANNELS == 1) {
+        out[0] += volumeAdjust(l, volumeLR[0]);
+        out[1] += volumeAdjust(l, volumeLR[1]);
+    } else {
+        out[0] += volumeAdjust(l, volumeLR[0]);
+        out[1] += volumeAdjust(hsumAvx2(accR), volumeLR[1]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+/*
+ * Calculates a single output frame with the wide vector kernel selected by SIMD.
+ * The parameters and the polyphase index computation are the same as fir().
+ */
+template<FirSimd SIMD, int CHANNELS, bool LOCKED, typename TC, typename TI, typename TO>
+static inline
+void firWide(TO* const out,
+        const uint32_t phase, const uint32_t phaseWrapLimit,
+        const int coefShift, const int halfNumCoefs, const TC* const coefs,
+        const TI* const samples, const TO* const volumeLR)
+{
+    static_assert(isFirWideSupported<SIMD, CHANNELS, TC, TI, TO>());
+    const uint32_t indexP = phase >> coefShift;
+    const uint32_t indexN = LOCKED
+            ? (phaseWrapLimit - phase) >> coefShift
+            : (phaseWrapLimit - phase - 1) >> coefShift; // one's complement.
+    const TC* coefsP = coefs + indexP*halfNumCoefs;
+    const TC* coefsN = coefs + indexN*halfNumCoefs;
+    const TI* sP = samples;
+    const TI* sN = samples + CHANNELS;
+
+    if constexpr (is_same<TC, float>::value) {
+        static const TC scale = 1. / (65536. * 65536.); // scale phase bits to [0.0, 1.0)
+        const float lerpP = LOCKED ? 0.f : TC(phase << (sizeof(phase)*8 - coefShift)) * scale;
+        if constexpr (SIMD == FirSimd::AVX512) {
+            ProcessAVX512<CHANNELS, LOCKED>(out, halfNumCoefs, coefsP, coefsN, sP, sN,
+                    lerpP, volumeLR);
+        } else {
+            ProcessAVX2<CHANNELS, LOCKED>(out, halfNumCoefs, coefsP, coefsN, sP, sN,
+                    lerpP, volumeLR);
+        }
+    } else {
+        const uint32_t lerpP = LOCKED ? 0 : phase << (sizeof(phase)*8 - coefShift)
+                >> ((sizeof(phase)-sizeof(*coefs))*8 + 1);
+        ProcessAVX2<CHANNELS, LOCKED>(out, halfNumCoefs, coefsP, coefsN, sP, sN,
+                lerpP, volumeLR);
+    }
+}
+
+#endif // USE_WIDE_SIMD
+
+} // namespace android
+
+#endif /*ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX_H*/
@@ -431,6 +431,66 @@ void ClampFloatBufferProvider::copyFrames(void *dst, const void *src, size_t fra
                                              FLOAT_NOMINAL_RANGE_HEADROOM);
 }
 
+FusedBufferProvider::FusedBufferProvider(const std::vector<CopyBufferProvider *> &stages,
+        size_t bufferFrameCount) :
+        CopyBufferProvider(
+                stages.front()->getInputFrameSize(),
+                stages.back()->getOutputFrameSize(),
+                bufferFrameCount),
+        mStages(stages),
+        mStripFrameSize(getStripFrameSize(stages)),
+        mStripData{}
+{
+    ALOGV("FusedBufferProvider(%p)(%zu stages)", this, stages.size());
+    for (const CopyBufferProvider *stage : mStages) {
+        LOG_ALWAYS_FATAL_IF(!stage->isFusable(), "stage %p is not fusable", stage);
+    }
+    if (mStripFrameSize != 0) {
+        const size_t stripSize = mStripFrameSize * kStripFrameCount;
+        (void)posix_memalign(&mStripData[0], 32, stripSize * 2);
+        mStripData[1] = (uint8_t *)mStripData[0] + stripSize;
+    }
+}
+
+FusedBufferProvider::~FusedBufferProvider()
+{
+    free(mStripData[0]);
+}
+
+/*static*/ size_t FusedBufferProvider::getStripFrameSize(
+        const std::vector<CopyBufferProvider *> &stages)
+{
+    size_t stripFrameSize = 0;
+    for (size_t i = 0; i + 1 < stages.size(); ++i) {
+        stripFrameSize = std::max(stripFrameSize, stages[i]->getOutputFrameSize());
+    }
+    return stripFrameSize;
+}
+
+bool FusedBufferProvider::isFusing(const std::vector<CopyBufferProvider *> &stages) const
+{
+    return stages == mStages
+            && stages.front()->getInputFrameSize() == mInputFrameSize
+            && stages.back()->getOutputFrameSize() == mOutputFrameSize
+            && getStripFrameSize(stages) == mStripFrameSize;
+}
+
+void FusedBufferProvider::copyFrames(void *dst, const void *src, size_t frames)
+{
+    const size_t last = mStages.size() - 1;
+    for (size_t done = 0; done < frames; ) {
+        const size_t count = std::min(frames - done, kStripFrameCount);
+        const void *stageSrc = (const uint8_t *)src + done * mInputFrameSize;
+        for (size_t i = 0; i < last; ++i) {
+            void *stageDst = mStripData[i & 1];
+            mStages[i]->copyFrames(stageDst, stageSrc, count);
+            stageSrc = stageDst;
+        }
+        mStages[last]->copyFrames((uint8_t *)dst + done * mOutputFrameSize, stageSrc, count);
+        done += count;
+    }
+}
+
 TimestretchBufferProvider::TimestretchBufferProvider(int32_t channelCount,
         audio_format_t format, uint32_t sampleRate, const AudioPlaybackRate &playbackRate) :
         mChannelCount(channelCount),
@@ -29,6 +29,12 @@
 #define ARRAY_SIZE(x) (sizeof(x)/sizeof((x)[0]))
 #endif
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 template <typename T>
 static inline T max(const T& a, const T& b)
 {
@@ -37,6 +43,213 @@ static inline T max(const T& a, const T& b)
 
 namespace android {
 
+namespace {
+
+/*
+ * Fused legacy channel and format conversion for PCM_16_BIT and PCM_FLOAT.
+ *
+ * The kernels replace, in a single pass and without a float staging buffer,
+ *   memcpy_by_audio_format() to float,
+ *   downmix_to_mono_float_from_stereo_float() or upmix_to_stereo_float_from_mono_float(),
+ *   memcpy_by_audio_format() from float.
+ *
+ * Results are bit-exact with those primitives for all non-NaN samples:
+ * int16 to float is an exact scale, the downmix is (left + right) * 0.5f,
+ * and float to int16 rounds to nearest even and saturates as clamp16_from_float().
+ */
+
+template <typename T> inline float toFloat(T sample);
+template <> inline float toFloat(float sample) { return sample; }
+template <> inline float toFloat(int16_t sample) { return float_from_i16(sample); }
+
+template <typename T> inline T fromFloat(float sample);
+template <> inline float fromFloat(float sample) { return sample; }
+template <> inline int16_t fromFloat(float sample) { return clamp16_from_float(sample); }
+
+#if defined(__SSE2__) || defined(__aarch64__)
+#define USE_FUSED_VECTOR
+
+constexpr size_t kVectorFrames = 4;
+#endif
+
+#if defined(__SSE2__)
+
+using vfloat = __m128;
+
+inline vfloat vAverage(vfloat a, vfloat b) {
+    return _mm_mul_ps(_mm_add_ps(a, b), _mm_set1_ps(0.5f));
+}
+
+inline vfloat vFromI32(__m128i v) {
+    return _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.f / (1 << 15)));
+}
+
+inline __m128i vToI32(vfloat v) {
+    // clamp before the conversion, which overflows to INT32_MIN.
+    v = _mm_mul_ps(v, _mm_set1_ps(1 << 15));
+    v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(INT16_MIN)), _mm_set1_ps(INT16_MAX));
+    return _mm_cvtps_epi32(v); // round to nearest even.
+}
+
+inline void vLoadStereo(const float *src, vfloat *left, vfloat *right) {
+    const vfloat a = _mm_loadu_ps(src);
+    const vfloat b = _mm_loadu_ps(src + 4);
+    *left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    *right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+inline void vLoadStereo(const int16_t *src, vfloat *left, vfloat *right) {
+    const __m128i v = _mm_loadu_si128((const __m128i *)src);
+    *left = vFromI32(_mm_srai_epi32(_mm_slli_epi32(v, 16), 16));
+    *right = vFromI32(_mm_srai_epi32(v, 16));
+}
+
+inline vfloat vLoadMono(const float *src) {
+    return _mm_loadu_ps(src);
+}
+
+inline vfloat vLoadMono(const int16_t *src) {
+    const __m128i v = _mm_loadl_epi64((const __m128i *)src);
+    return vFromI32(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+}
+
+inline void vStoreMono(float *dst, vfloat v) {
+    _mm_storeu_ps(dst, v);
+}
+
+inline void vStoreMono(int16_t *dst, vfloat v) {
+    const __m128i i32 = vToI32(v);
+    _mm_storel_epi64((__m128i *)dst, _mm_packs_epi32(i32, i32));
+}
+
+inline void vStoreStereo(float *dst, vfloat left, vfloat right) {
+    _mm_storeu_ps(dst, _mm_unpacklo_ps(left, right));
+    _mm_storeu_ps(dst + 4, _mm_unpackhi_ps(left, right));
+}
+
+inline void vStoreStereo(int16_t *dst, vfloat left, vfloat right) {
+    const __m128i l = vToI32(left);
+    const __m128i r = vToI32(right);
+    _mm_storeu_si128((__m128i *)dst,
+            _mm_packs_epi32(_mm_unpacklo_epi32(l, r), _mm_unpackhi_epi32(l, r)));
+}
+
+#elif defined(__aarch64__)
+
+using vfloat = float32x4_t;
+
+inline vfloat vAverage(vfloat a, vfloat b) {
+    return vmulq_n_f32(vaddq_f32(a, b), 0.5f);
+}
+
+inline vfloat vFromI16(int16x4_t v) {
+    return vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(v)), 1.f / (1 << 15));
+}
+
+inline int16x4_t vToI16(vfloat v) {
+    // round to nearest even, saturating.
+    return vqmovn_s32(vcvtnq_s32_f32(vmulq_n_f32(v, 1 << 15)));
+}
+
+inline void vLoadStereo(const float *src, vfloat *left, vfloat *right) {
+    const float32x4x2_t v = vld2q_f32(src);
+    *left = v.val[0];
+    *right = v.val[1];
+}
+
+inline void vLoadStereo(const int16_t *src, vfloat *left, vfloat *right) {
+    const int16x4x2_t v = vld2_s16(src);
+    *left = vFromI16(v.val[0]);
+    *right = vFromI16(v.val[1]);
+}
+
+inline vfloat vLoadMono(const float *src) {
+    return vld1q_f32(src);
+}
+
+inline vfloat vLoadMono(const int16_t *src) {
+    return vFromI16(vld1_s16(src));
+}
+
+inline void vStoreMono(float *dst, vfloat v) {
+    vst1q_f32(dst, v);
+}
+
+inline void vStoreMono(int16_t *dst, vfloat v) {
+    vst1_s16(dst, vToI16(v));
+}
+
+inline void vStoreStereo(float *dst, vfloat left, vfloat right) {
+    vst2q_f32(dst, (float32x4x2_t){{ left, right }});
+}
+
+inline void vStoreStereo(int16_t *dst, vfloat left, vfloat right) {
+    vst2_s16(dst, (int16x4x2_t){{ vToI16(left), vToI16(right) }});
+}
+
+#endif
+
+// the two input channels are averaged.
+template <typename TO, typename TI>
+struct DownmixToMono {
+    static void run(TO *dst, const TI *src, size_t frames) {
+        size_t i = 0;
+#ifdef USE_FUSED_VECTOR
+        for (; i + kVectorFrames <= frames; i += kVectorFrames) {
+            vfloat left, right;
+            vLoadStereo(src + i * 2, &left, &right);
+            vStoreMono(dst + i, vAverage(left, right));
+        }
+#endif
+        for (; i < frames; ++i) {
+            dst[i] = fromFloat<TO>((toFloat(src[i * 2]) + toFloat(src[i * 2 + 1])) * 0.5f);
+        }
+    }
+};
+
+// the mono input is duplicated to both output channels.
+template <typename TO, typename TI>
+struct UpmixToStereo {
+    static void run(TO *dst, const TI *src, size_t frames) {
+        size_t i = 0;
+#ifdef USE_FUSED_VECTOR
+        for (; i + kVectorFrames <= frames; i += kVectorFrames) {
+            const vfloat v = vLoadMono(src + i);
+            vStoreStereo(dst + i * 2, v, v);
+        }
+#endif
+        for (; i < frames; ++i) {
+            dst[i * 2] = dst[i * 2 + 1] = fromFloat<TO>(toFloat(src[i]));
+        }
+    }
+};
+
+bool isFusedFormat(audio_format_t format) {
+    return format == AUDIO_FORMAT_PCM_16_BIT || format == AUDIO_FORMAT_PCM_FLOAT;
+}
+
+// dispatches on the source and destination formats, both of which must be fused formats.
+template <template <typename, typename> class Kernel>
+void convertFused(void *dst, audio_format_t dstFormat,
+        const void *src, audio_format_t srcFormat, size_t frames)
+{
+    if (dstFormat == AUDIO_FORMAT_PCM_16_BIT) {
+        if (srcFormat == AUDIO_FORMAT_PCM_16_BIT) {
+            Kernel<int16_t, int16_t>::run((int16_t *)dst, (const int16_t *)src, frames);
+        } else {
+            Kernel<int16_t, float>::run((int16_t *)dst, (const float *)src, frames);
+        }
+    } else {
+        if (srcFormat == AUDIO_FORMAT_PCM_16_BIT) {
+            Kernel<float, int16_t>::run((float *)dst, (const int16_t *)src, frames);
+        } else {
+            Kernel<float, float>::run((float *)dst, (const float *)src, frames);
+        }
+    }
+}
+
+} // namespace
+
 RecordBufferConverter::RecordBufferConverter(
         audio_channel_mask_t srcChannelMask, audio_format_t srcFormat,
         uint32_t srcSampleRate,
@@ -55,6 +268,7 @@ RecordBufferConverter::RecordBufferConverter(
             mResampler(NULL),
             mIsLegacyDownmix(false),
             mIsLegacyUpmix(false),
+            mIsFusedLegacy(false),
             mRequiresFloat(false),
             mInputConverterProvider(NULL)
 {
@@ -185,14 +399,21 @@ status_t RecordBufferConverter::updateParameters(
                    && (mDstChannelMask == AUDIO_CHANNEL_IN_STEREO
                             || mDstChannelMask == AUDIO_CHANNEL_IN_FRONT_BACK);
 
+    // can legacy channel conversion be done in a single pass from the source format?
+    mIsFusedLegacy = mResampler == NULL && (mIsLegacyDownmix || mIsLegacyUpmix)
+            && isFusedFormat(mSrcFormat) && isFusedFormat(mDstFormat);
+
     // do we need to process in float?
-    mRequiresFloat = mResampler != NULL || mIsLegacyDownmix || mIsLegacyUpmix;
+    mRequiresFloat = mResampler != NULL
+            || ((mIsLegacyDownmix || mIsLegacyUpmix) && !mIsFusedLegacy);
 
     // do we need a staging buffer to convert for destination (we can still optimize this)?
     // we use mBufFrameSize > 0 to indicate both frame size as well as buffer necessity
     if (mResampler != NULL) {
         mBufFrameSize = max(mSrcChannelCount, (uint32_t)FCC_2)
                 * audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT);
+    } else if (mIsFusedLegacy) {
+        mBufFrameSize = 0;
     } else if (mIsLegacyUpmix || mIsLegacyDownmix) { // legacy modes always float
         mBufFrameSize = mDstChannelCount * audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT);
     } else if (mSrcChannelMask != mDstChannelMask && mDstFormat != mSrcFormat) {
@@ -224,7 +445,16 @@ status_t RecordBufferConverter::updateParameters(
 void RecordBufferConverter::convertNoResampler(
         void *dst, const void *src, size_t frames)
 {
-    // src is native type unless there is legacy upmix or downmix, whereupon it is float.
+    // src is native type unless there is unfused legacy upmix or downmix,
+    // whereupon it is float.
+    if (mIsFusedLegacy) {
+        if (mIsLegacyUpmix) {
+            convertFused<UpmixToStereo>(dst, mDstFormat, src, mSrcFormat, frames);
+        } else /* mIsLegacyDownmix */ {
+            convertFused<DownmixToMono>(dst, mDstFormat, src, mSrcFormat, frames);
+        }
+        return;
+    }
     if (mBufFrameSize != 0 && mBufFrames < frames) {
         free(mBuf);
         mBufFrames = frames;
@@ -271,6 +501,10 @@ void RecordBufferConverter::convertResampler(
             || (mSrcChannelMask == mDstChannelMask && mSrcChannelCount == 1)) {
         // the resampler outputs stereo for mono input channel (a feature?)
         // must convert to mono
+        if (isFusedFormat(mDstFormat)) {
+            convertFused<DownmixToMono>(dst, mDstFormat, src, AUDIO_FORMAT_PCM_FLOAT, frames);
+            return;
+        }
         downmix_to_mono_float_from_stereo_float((float *)src,
                 (const float *)src, frames);
     } else if (mSrcChannelMask != mDstChannelMask) {
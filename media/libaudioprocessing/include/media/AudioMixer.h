@@ -77,6 +77,7 @@ private:
             // Ensure the order of destruction of buffer providers as they
             // release the upstream provider in the destructor.
             mTimestretchBufferProvider.reset(nullptr);
+            mFusedBufferProvider.reset(nullptr);
             mPostDownmixReformatBufferProvider.reset(nullptr);
             mDownmixerBufferProvider.reset(nullptr);
             mReformatBufferProvider.reset(nullptr);
@@ -124,6 +125,10 @@ private:
          * 6) mPostDownmixReformatBufferProvider: If not NULL, performs reformatting from
          *    the downmixer requirements to the mixer engine input requirements.
          * 7) mTimestretchBufferProvider: Adds timestretching for playback rate
+         *
+         * When 4), 5) and 6) are all fusable, and at least two are present,
+         * mFusedBufferProvider runs them in a single pass over the data and replaces
+         * them in the chain.
          */
         AudioBufferProvider* mInputBufferProvider;    // externally provided buffer provider.
         std::unique_ptr<PassthruBufferProvider> mTeeBufferProvider;
@@ -131,6 +136,7 @@ private:
         std::unique_ptr<PassthruBufferProvider> mReformatBufferProvider;
         std::unique_ptr<PassthruBufferProvider> mDownmixerBufferProvider;
         std::unique_ptr<PassthruBufferProvider> mPostDownmixReformatBufferProvider;
+        std::unique_ptr<PassthruBufferProvider> mFusedBufferProvider;
         std::unique_ptr<PassthruBufferProvider> mTimestretchBufferProvider;
 
         audio_format_t mDownmixRequiresFormat;  // required downmixer format
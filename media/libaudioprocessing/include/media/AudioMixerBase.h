@@ -91,12 +91,9 @@ public:
         AUXLEVEL        = 0x4210,
     };
 
-    AudioMixerBase(size_t frameCount, uint32_t sampleRate)
-        : mSampleRate(sampleRate)
-        , mFrameCount(frameCount) {
-    }
+    AudioMixerBase(size_t frameCount, uint32_t sampleRate);
 
-    virtual ~AudioMixerBase() {}
+    virtual ~AudioMixerBase();
 
     virtual bool isValidFormat(audio_format_t format) const;
     virtual bool isValidChannelMask(audio_channel_mask_t channelMask) const;
@@ -137,6 +134,16 @@ public:
 
     size_t      getUnreleasedFrames(int name) const;
 
+    // Resample and apply volume to the tracks on up to threadCount worker threads,
+    // in addition to the calling thread, when kParallelMinTracks or more tracks are
+    // resampled.  The output is identical to the serial mix, tracks with an aux send
+    // are mixed on the calling thread.  0 (the default) mixes all tracks serially.
+    //
+    // This is opt-in, AudioFlinger does not call it.  The worker threads take the
+    // scheduling policy and priority of the calling thread, so call it from the
+    // thread calling process().
+    void        setParallelThreadCount(size_t threadCount);
+
     std::string trackNames() const;
 
   protected:
@@ -350,6 +357,7 @@ public:
     void process__nop();
     void process__genericNoResampling();
     void process__genericResampling();
+    void process__genericResamplingParallel();
     void process__oneTrack16BitsStereoNoResampling();
 
     template <int MIXTYPE, typename TO, typename TI, typename TA>
@@ -382,6 +390,38 @@ public:
 
     // track smart pointers, by name, in increasing order of name.
     std::map<int /* name */, std::shared_ptr<TrackBase>> mTracks;
+
+    // Minimum number of enabled tracks to use process__genericResamplingParallel().
+    static constexpr size_t kParallelMinTracks = 4;
+
+    // Mixes numFrames of a track into out, see process__genericResampling().
+    void mixTrack(TrackBase *t, int32_t *out, size_t numFrames, int32_t *temp);
+
+    // Prepares the track and group slots for process__genericResamplingParallel(),
+    // when the process hook is selected, so that mixing does not allocate.
+    void prepareParallel();
+
+    // Mixes mParallelTracks[index] on the given thread of mWorkerPool.
+    void mixParallelTrack(size_t index, size_t thread);
+
+    class WorkerPool; // see AudioMixerBase.cpp
+    std::unique_ptr<WorkerPool> mWorkerPool;
+
+    // For process__genericResamplingParallel(), each track is mixed into its own
+    // output buffer, and the buffers of a group are summed in order of name.
+    struct ParallelTrack {
+        TrackBase *track;
+        int32_t *output;
+    };
+    struct ParallelGroup {
+        TrackBase *track;  // the first track, with the main buffer and formats of the group.
+        std::vector<const int32_t *> outputs; // of the tracks, in order of name.
+    };
+    std::vector<ParallelTrack> mParallelTracks; // mixed on any thread.
+    std::vector<ParallelTrack> mSerialTracks;   // mixed on the calling thread (aux send).
+    std::vector<ParallelGroup> mParallelGroups;
+    std::vector<int32_t> mParallelBuffer;     // storage for the track outputs.
+    std::unique_ptr<int32_t[]> mParallelTemp; // resample temp for each thread.
 };
 
 }  // namespace android
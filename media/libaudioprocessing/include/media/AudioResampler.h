@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <string>
+
 #include <cutils/compiler.h>
 #include <utils/Compat.h>
 
@@ -83,6 +85,9 @@ public:
     // called from destructor, so must not be virtual
     src_quality getQuality() const { return mQuality; }
 
+    // Returns the dynamic resampler filter cache statistics, for dumpsys.
+    static std::string dumpFilterCache();
+
 protected:
     // number of bits for phase fraction - 30 bits allows nearly 2x downsampling
     static const int kNumPhaseBits = 30;
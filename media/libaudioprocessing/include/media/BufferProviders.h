@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <vector>
+
 #include <audio_utils/ChannelMix.h>
 #include <media/AudioBufferProvider.h>
 #include <media/AudioResamplerPublic.h>
@@ -87,6 +89,13 @@ public:
     // of the internal buffers.
     virtual void copyFrames(void *dst, const void *src, size_t frames) = 0;
 
+    // Returns true if copyFrames() depends only on the frames passed in, so that
+    // the provider may be run by a FusedBufferProvider on arbitrary pieces of the input.
+    virtual bool isFusable() const { return true; }
+
+    size_t getInputFrameSize() const { return mInputFrameSize; }
+    size_t getOutputFrameSize() const { return mOutputFrameSize; }
+
 protected:
     const size_t         mInputFrameSize;
     const size_t         mOutputFrameSize;
@@ -108,6 +117,9 @@ public:
     //Overrides
     virtual void copyFrames(void *dst, const void *src, size_t frames);
 
+    // The effect may keep state between calls and each call may cross the HAL.
+    bool isFusable() const override { return false; }
+
     bool isValid() const { return mDownmixInterface.get() != NULL; }
     static status_t init();
     static bool isMultichannelCapable() { return sIsMultichannelCapable; }
@@ -196,6 +208,34 @@ protected:
     const uint32_t       mChannelCount;
 };
 
+// FusedBufferProvider derives from CopyBufferProvider to run a chain of fusable
+// CopyBufferProviders in a single pass over the upstream buffer.
+// Each stage converts a small strip of frames that stays in cache for the next stage,
+// instead of filling its own private buffer for the next stage to read back.
+// The stages are not owned; their private buffers and upstream providers are not used.
+class FusedBufferProvider : public CopyBufferProvider {
+public:
+    FusedBufferProvider(const std::vector<CopyBufferProvider *> &stages,
+            size_t bufferFrameCount);
+    virtual ~FusedBufferProvider();
+    //Overrides
+    void copyFrames(void *dst, const void *src, size_t frames) override;
+
+    // Returns true if this provider runs the stages given, which must all be fusable.
+    // The stages may have been recreated in place, so their frame sizes are checked as well.
+    bool isFusing(const std::vector<CopyBufferProvider *> &stages) const;
+
+    // frames converted by each stage call, 2KB for 8 channels of float.
+    static constexpr size_t kStripFrameCount = 64;
+
+protected:
+    static size_t getStripFrameSize(const std::vector<CopyBufferProvider *> &stages);
+
+    const std::vector<CopyBufferProvider *> mStages;
+    const size_t         mStripFrameSize; // largest intermediate frame size
+    void                *mStripData[2];   // alternating strips for the intermediate stages
+};
+
 // TimestretchBufferProvider derives from PassthruBufferProvider for time stretching
 class TimestretchBufferProvider : public PassthruBufferProvider {
 public:
@@ -266,6 +306,7 @@ public:
     status_t getNextBuffer(Buffer* pBuffer) override;
     void copyFrames(void *dst, const void *src, size_t frames) override;
     void reset() override;
+    bool isFusable() const override { return false; }
 
     void clearContractedFrames() { mContractedWrittenFrames = 0; }
 
@@ -295,6 +336,7 @@ public:
               mFrameCopied(0) {};
 
     void copyFrames(void *dst, const void *src, size_t frames) override;
+    bool isFusable() const override { return false; }
 
     void clearFramesCopied();
 
@@ -108,6 +108,7 @@ private:
 
     bool                 mIsLegacyDownmix;  // legacy stereo to mono conversion needed
     bool                 mIsLegacyUpmix;    // legacy mono to stereo conversion needed
+    bool                 mIsFusedLegacy;    // legacy conversion in one pass from source format
     bool                 mRequiresFloat;    // data processing requires float (e.g. resampler)
     PassthruBufferProvider *mInputConverterProvider;    // converts input to float
     int8_t               mIdxAry[sizeof(uint32_t) * 8]; // used for channel mask conversion
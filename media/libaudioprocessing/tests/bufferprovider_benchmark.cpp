@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <audio_utils/format.h>
+#include <benchmark/benchmark.h>
+#include <media/BufferProviders.h>
+
+using namespace android;
+
+/*
+ * Converts 5.1 track data to the stereo mixer input through the AudioMixer
+ * reformat and downmix stages, chained (each through its own buffer) and
+ * through a FusedBufferProvider.
+ *
+ * Before timing, the fused output is checked to be identical to the chained output.
+ */
+
+static constexpr size_t kFrameCount = 960;            // 20 ms, a typical normal mixer period.
+static constexpr size_t kCopyBufferFrameCount = 256;  // as used by AudioMixer.
+static constexpr audio_channel_mask_t kInputChannelMask = AUDIO_CHANNEL_OUT_5POINT1;
+static constexpr audio_channel_mask_t kOutputChannelMask = AUDIO_CHANNEL_OUT_STEREO;
+
+enum Conversion {
+    PCM_16_CHANNELMIX,        // int16 5.1 -> reformat -> ChannelMix -> float stereo
+    PCM_16_REMIX_PCM_16,      // int16 5.1 -> reformat -> remix -> reformat -> int16 stereo
+    FLOAT_CLAMP_CHANNELMIX,   // float 5.1 -> clamp -> ChannelMix -> float stereo
+};
+
+// Provides looped noise, in buffers of arbitrary size as an AudioTrack would.
+class LoopProvider : public AudioBufferProvider {
+public:
+    LoopProvider(audio_format_t format, size_t channelCount)
+        : mFrameSize(audio_bytes_per_sample(format) * channelCount)
+        , mFrames(4801) // not a multiple of the copy buffer or strip sizes.
+        , mData(mFrames * mFrameSize) {
+        std::vector<float> noise(mFrames * channelCount);
+        uint32_t seed = 1;
+        for (float& sample : noise) {
+            seed = seed * 1664525 + 1013904223;
+            sample = (int32_t)seed * (1.5f / INT32_MAX); // some samples beyond unity.
+        }
+        memcpy_by_audio_format(mData.data(), format, noise.data(), AUDIO_FORMAT_PCM_FLOAT,
+                noise.size());
+    }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        buffer->frameCount = std::min(buffer->frameCount, mFrames - mPosition);
+        buffer->raw = &mData[mPosition * mFrameSize];
+        return OK;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        mPosition = (mPosition + buffer->frameCount) % mFrames;
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+    }
+
+private:
+    const size_t mFrameSize;
+    const size_t mFrames;
+    std::vector<uint8_t> mData;
+    size_t mPosition = 0;
+};
+
+class ConversionFixture {
+public:
+    ConversionFixture(Conversion conversion, bool fused) {
+        const size_t inChannels = audio_channel_count_from_out_mask(kInputChannelMask);
+        const size_t outChannels = audio_channel_count_from_out_mask(kOutputChannelMask);
+        audio_format_t outFormat = AUDIO_FORMAT_PCM_FLOAT;
+        switch (conversion) {
+        case PCM_16_CHANNELMIX:
+            mUpstream = std::make_unique<LoopProvider>(AUDIO_FORMAT_PCM_16_BIT, inChannels);
+            mStages.emplace_back(new ReformatBufferProvider(inChannels,
+                    AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_FLOAT, kCopyBufferFrameCount));
+            mStages.emplace_back(new ChannelMixBufferProvider(kInputChannelMask,
+                    kOutputChannelMask, AUDIO_FORMAT_PCM_FLOAT, kCopyBufferFrameCount));
+            break;
+        case PCM_16_REMIX_PCM_16:
+            mUpstream = std::make_unique<LoopProvider>(AUDIO_FORMAT_PCM_16_BIT, inChannels);
+            mStages.emplace_back(new ReformatBufferProvider(inChannels,
+                    AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_FLOAT, kCopyBufferFrameCount));
+            mStages.emplace_back(new RemixBufferProvider(kInputChannelMask,
+                    kOutputChannelMask, AUDIO_FORMAT_PCM_FLOAT, kCopyBufferFrameCount));
+            mStages.emplace_back(new ReformatBufferProvider(outChannels,
+                    AUDIO_FORMAT_PCM_FLOAT, AUDIO_FORMAT_PCM_16_BIT, kCopyBufferFrameCount));
+            outFormat = AUDIO_FORMAT_PCM_16_BIT;
+            break;
+        case FLOAT_CLAMP_CHANNELMIX:
+            mUpstream = std::make_unique<LoopProvider>(AUDIO_FORMAT_PCM_FLOAT, inChannels);
+            mStages.emplace_back(new ClampFloatBufferProvider(inChannels, kCopyBufferFrameCount));
+            mStages.emplace_back(new ChannelMixBufferProvider(kInputChannelMask,
+                    kOutputChannelMask, AUDIO_FORMAT_PCM_FLOAT, kCopyBufferFrameCount));
+            break;
+        }
+        mOutput.resize(kFrameCount * outChannels * audio_bytes_per_sample(outFormat));
+
+        AudioBufferProvider* provider = mUpstream.get();
+        if (fused) {
+            std::vector<CopyBufferProvider*> stages;
+            for (const auto& stage : mStages) {
+                stages.push_back(stage.get());
+            }
+            mFused = std::make_unique<FusedBufferProvider>(stages, kCopyBufferFrameCount);
+            mFused->setBufferProvider(provider);
+            provider = mFused.get();
+        } else {
+            for (const auto& stage : mStages) {
+                stage->setBufferProvider(provider);
+                provider = stage.get();
+            }
+        }
+        mProvider = provider;
+    }
+
+    ~ConversionFixture() {
+        // release any held buffers from downstream to upstream.
+        mFused.reset();
+        while (!mStages.empty()) {
+            mStages.pop_back();
+        }
+    }
+
+    // Pulls one mixer period, as the mixer does.
+    const std::vector<uint8_t>& process() {
+        const size_t frameSize = mOutput.size() / kFrameCount;
+        for (size_t done = 0; done < kFrameCount; ) {
+            AudioBufferProvider::Buffer buffer;
+            buffer.frameCount = kFrameCount - done;
+            if (mProvider->getNextBuffer(&buffer) != OK || buffer.frameCount == 0) {
+                break;
+            }
+            memcpy(&mOutput[done * frameSize], buffer.raw, buffer.frameCount * frameSize);
+            done += buffer.frameCount;
+            mProvider->releaseBuffer(&buffer);
+        }
+        return mOutput;
+    }
+
+private:
+    std::unique_ptr<LoopProvider> mUpstream;
+    std::vector<std::unique_ptr<CopyBufferProvider>> mStages;
+    std::unique_ptr<FusedBufferProvider> mFused;
+    AudioBufferProvider* mProvider = nullptr;
+    std::vector<uint8_t> mOutput;
+};
+
+static void BM_BufferProviders(benchmark::State& state) {
+    const Conversion conversion = (Conversion)state.range(0);
+    const bool fused = state.range(1) != 0;
+    ConversionFixture fixture(conversion, fused);
+
+    if (fused) {
+        ConversionFixture chained(conversion, false /* fused */);
+        for (size_t i = 0; i < 10; ++i) {
+            if (chained.process() != fixture.process()) {
+                state.SkipWithError("fused conversion differs from chained conversion");
+                return;
+            }
+        }
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fixture.process().data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameCount);
+}
+
+static void BufferProvidersArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"conversion", "fused"});
+    for (int conversion : { PCM_16_CHANNELMIX, PCM_16_REMIX_PCM_16, FLOAT_CLAMP_CHANNELMIX }) {
+        for (int fused : { 0, 1 }) {
+            b->Args({conversion, fused});
+        }
+    }
+}
+
+BENCHMARK(BM_BufferProviders)->Apply(BufferProvidersArgs);
+
+BENCHMARK_MAIN();
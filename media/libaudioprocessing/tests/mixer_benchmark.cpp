@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/AudioMixer.h>
+
+using namespace android;
+
+/*
+ * Mixes 1 to 64 resampled stereo float tracks, serially (0 threads)
+ * and with AudioMixerBase::setParallelThreadCount().
+ *
+ * mixer_tests checks that the parallel output is identical to the serial output.
+ */
+
+static constexpr size_t kFrameCount = 960;     // 20 ms, a typical normal mixer period.
+static constexpr uint32_t kSampleRate = 48000;
+static constexpr uint32_t kTrackSampleRates[] = { 44100, 32000, 22050, 48000 };
+
+// Provides a looped sine wave.
+class LoopProvider : public AudioBufferProvider {
+public:
+    LoopProvider(uint32_t sampleRate, float frequency)
+        : mData(sampleRate / 10 * FCC_2) { // 100 ms loop
+        const size_t frames = mData.size() / FCC_2;
+        for (size_t i = 0; i < frames; ++i) {
+            const float value = sinf(2.f * M_PI * frequency * i / sampleRate);
+            mData[i * FCC_2] = value;
+            mData[i * FCC_2 + 1] = -value;
+        }
+    }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        const size_t frames = mData.size() / FCC_2;
+        buffer->frameCount = std::min(buffer->frameCount, frames - mPosition);
+        buffer->raw = &mData[mPosition * FCC_2];
+        return OK;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        const size_t frames = mData.size() / FCC_2;
+        mPosition = (mPosition + buffer->frameCount) % frames;
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+    }
+
+private:
+    std::vector<float> mData;
+    size_t mPosition = 0;
+};
+
+class MixerFixture {
+public:
+    MixerFixture(size_t tracks, size_t threads)
+        : mMixer(kFrameCount, kSampleRate)
+        , mOutput(kFrameCount * FCC_2) {
+        mMixer.setParallelThreadCount(threads);
+        mProviders.reserve(tracks);
+        const float volume = AudioMixer::UNITY_GAIN_FLOAT / tracks;
+        for (size_t i = 0; i < tracks; ++i) {
+            const int name = i;
+            const uint32_t sampleRate = kTrackSampleRates[i % std::size(kTrackSampleRates)];
+            mProviders.emplace_back(sampleRate, 100.f * (i + 1));
+            mMixer.create(name, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_FLOAT,
+                    AUDIO_SESSION_OUTPUT_MIX);
+            mMixer.setBufferProvider(name, &mProviders[i]);
+            mMixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER,
+                    mOutput.data());
+            mMixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+                    (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+            mMixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
+                    (void *)(uintptr_t)AUDIO_CHANNEL_OUT_STEREO);
+            mMixer.setParameter(name, AudioMixer::RESAMPLE, AudioMixer::SAMPLE_RATE,
+                    (void *)(uintptr_t)sampleRate);
+            // ramp the first period, so both volume ramp and constant volume are mixed.
+            mMixer.setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME0,
+                    (void *)&volume);
+            mMixer.setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME1,
+                    (void *)&volume);
+            mMixer.enable(name);
+        }
+    }
+
+    const std::vector<float>& process() {
+        mMixer.process();
+        return mOutput;
+    }
+
+private:
+    AudioMixer mMixer;
+    std::vector<LoopProvider> mProviders;
+    std::vector<float> mOutput;
+};
+
+static void BM_MixerTracks(benchmark::State& state) {
+    const size_t tracks = state.range(0);
+    const size_t threads = state.range(1);
+    MixerFixture mixer(tracks, threads);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mixer.process().data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFrameCount * tracks);
+}
+
+static void MixerTracksArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"tracks", "threads"});
+    for (int tracks : { 1, 2, 4, 8, 16, 32, 64 }) {
+        for (int threads : { 0, 1, 3 }) {
+            b->Args({tracks, threads});
+        }
+    }
+}
+
+BENCHMARK(BM_MixerTracks)->Apply(MixerTracksArgs)->UseRealTime();
+
+BENCHMARK_MAIN();
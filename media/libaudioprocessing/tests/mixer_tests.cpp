@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "mixer_tests"
+#include <log/log.h>
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/AudioMixer.h>
+
+using namespace android;
+
+/*
+ * Checks that mixing resampled tracks with AudioMixerBase::setParallelThreadCount()
+ * gives the same output, bit for bit, as mixing them serially.
+ */
+
+static constexpr size_t kFrameCount = 960;     // 20 ms, a typical normal mixer period.
+static constexpr uint32_t kSampleRate = 48000;
+static constexpr uint32_t kTrackSampleRates[] = { 44100, 32000, 22050, 48000 };
+
+// Provides a looped sine wave.
+class LoopProvider : public AudioBufferProvider {
+public:
+    LoopProvider(uint32_t sampleRate, float frequency)
+        : mData(sampleRate / 10 * FCC_2) { // 100 ms loop
+        const size_t frames = mData.size() / FCC_2;
+        for (size_t i = 0; i < frames; ++i) {
+            const float value = sinf(2.f * M_PI * frequency * i / sampleRate);
+            mData[i * FCC_2] = value;
+            mData[i * FCC_2 + 1] = -value;
+        }
+    }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        const size_t frames = mData.size() / FCC_2;
+        buffer->frameCount = std::min(buffer->frameCount, frames - mPosition);
+        buffer->raw = &mData[mPosition * FCC_2];
+        return OK;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        const size_t frames = mData.size() / FCC_2;
+        mPosition = (mPosition + buffer->frameCount) % frames;
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+    }
+
+private:
+    std::vector<float> mData;
+    size_t mPosition = 0;
+};
+
+struct MixerConfig {
+    size_t tracks;
+    size_t threads;
+    audio_format_t mixerFormat; // of the main buffers.
+    size_t mainBuffers;         // tracks are assigned to the main buffers in turn.
+    size_t auxTracks;           // the first tracks also send to the aux buffer.
+};
+
+// Resampled stereo float tracks, mixed into one or more main buffers.
+class MixerFixture {
+public:
+    MixerFixture(const MixerConfig& config, size_t threads)
+        : mMixer(kFrameCount, kSampleRate)
+        , mMainBuffers(config.mainBuffers, std::vector<int32_t>(kFrameCount * FCC_2))
+        , mAuxBuffer(kFrameCount) {
+        mMixer.setParallelThreadCount(threads);
+        const float volume = AudioMixer::UNITY_GAIN_FLOAT / config.tracks;
+        for (size_t i = 0; i < config.tracks; ++i) {
+            const int name = i;
+            const uint32_t sampleRate = kTrackSampleRates[i % std::size(kTrackSampleRates)];
+            mProviders.emplace_back(sampleRate, 100.f * (i + 1));
+            mMixer.create(name, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_FLOAT,
+                    AUDIO_SESSION_OUTPUT_MIX);
+            mMixer.setBufferProvider(name, &mProviders.back());
+            mMixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER,
+                    mMainBuffers[i % mMainBuffers.size()].data());
+            mMixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+                    (void *)(uintptr_t)config.mixerFormat);
+            mMixer.setParameter(name, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
+                    (void *)(uintptr_t)AUDIO_CHANNEL_OUT_STEREO);
+            mMixer.setParameter(name, AudioMixer::RESAMPLE, AudioMixer::SAMPLE_RATE,
+                    (void *)(uintptr_t)sampleRate);
+            if (i < config.auxTracks) {
+                const float auxLevel = 0.5f;
+                mMixer.setParameter(name, AudioMixer::TRACK, AudioMixer::AUX_BUFFER,
+                        mAuxBuffer.data());
+                mMixer.setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::AUXLEVEL,
+                        (void *)&auxLevel);
+            }
+            // ramp the first period, so both volume ramp and constant volume are mixed.
+            setVolume(name, volume);
+            mMixer.enable(name);
+        }
+    }
+
+    void process() {
+        std::fill(mAuxBuffer.begin(), mAuxBuffer.end(), 0);
+        mMixer.process();
+    }
+
+    void setVolume(int name, float volume) {
+        mMixer.setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME0,
+                (void *)&volume);
+        mMixer.setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME1,
+                (void *)&volume);
+    }
+
+    void setEnabled(int name, bool enabled) {
+        if (enabled) {
+            mMixer.enable(name);
+        } else {
+            mMixer.disable(name);
+        }
+    }
+
+    const std::vector<std::vector<int32_t>>& mainBuffers() const { return mMainBuffers; }
+    const std::vector<int32_t>& auxBuffer() const { return mAuxBuffer; }
+
+private:
+    AudioMixer mMixer;
+    std::deque<LoopProvider> mProviders; // not moved once given to the mixer.
+    std::vector<std::vector<int32_t>> mMainBuffers; // of float or int16_t samples.
+    std::vector<int32_t> mAuxBuffer;
+};
+
+class MixerParallelTest : public ::testing::TestWithParam<MixerConfig> {
+protected:
+    void SetUp() override {
+        const MixerConfig& config = GetParam();
+        mSerial = std::make_unique<MixerFixture>(config, 0 /* threads */);
+        mParallel = std::make_unique<MixerFixture>(config, config.threads);
+    }
+
+    // Both mixers must run the same sequence of operations.
+    template <typename F>
+    void apply(F f) {
+        f(mSerial.get());
+        f(mParallel.get());
+    }
+
+    void expectSameOutput(size_t periods) {
+        for (size_t period = 0; period < periods; ++period) {
+            mSerial->process();
+            mParallel->process();
+            for (size_t i = 0; i < mSerial->mainBuffers().size(); ++i) {
+                ASSERT_EQ(mSerial->mainBuffers()[i], mParallel->mainBuffers()[i])
+                        << "main buffer " << i << " period " << period;
+            }
+            ASSERT_EQ(mSerial->auxBuffer(), mParallel->auxBuffer()) << "period " << period;
+        }
+    }
+
+    std::unique_ptr<MixerFixture> mSerial;
+    std::unique_ptr<MixerFixture> mParallel;
+};
+
+TEST_P(MixerParallelTest, MatchesSerialMix) {
+    ASSERT_NO_FATAL_FAILURE(expectSameOutput(10));
+}
+
+TEST_P(MixerParallelTest, MatchesSerialMixAfterChanges) {
+    const size_t tracks = GetParam().tracks;
+    ASSERT_NO_FATAL_FAILURE(expectSameOutput(2));
+
+    // Fewer tracks, which may go back to the serial mix.
+    apply([tracks](MixerFixture *mixer) {
+        for (size_t i = 0; i < tracks; i += 3) {
+            mixer->setEnabled(i, false);
+        }
+    });
+    ASSERT_NO_FATAL_FAILURE(expectSameOutput(3));
+
+    // All tracks again, with a volume ramp.
+    apply([tracks](MixerFixture *mixer) {
+        for (size_t i = 0; i < tracks; i += 3) {
+            mixer->setEnabled(i, true);
+            mixer->setVolume(i, AudioMixer::UNITY_GAIN_FLOAT / (2 * tracks));
+        }
+    });
+    ASSERT_NO_FATAL_FAILURE(expectSameOutput(3));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        MixerParallel, MixerParallelTest,
+        ::testing::Values(
+                // too few tracks, mixed serially.
+                MixerConfig{2, 1, AUDIO_FORMAT_PCM_FLOAT, 1, 0},
+                MixerConfig{4, 1, AUDIO_FORMAT_PCM_FLOAT, 1, 0},
+                MixerConfig{5, 3, AUDIO_FORMAT_PCM_FLOAT, 1, 0},
+                MixerConfig{16, 3, AUDIO_FORMAT_PCM_FLOAT, 1, 0},
+                MixerConfig{8, 3, AUDIO_FORMAT_PCM_16_BIT, 1, 0},
+                MixerConfig{12, 2, AUDIO_FORMAT_PCM_FLOAT, 3, 0},
+                // aux send tracks are mixed on the calling thread.
+                MixerConfig{8, 3, AUDIO_FORMAT_PCM_FLOAT, 2, 3},
+                MixerConfig{6, 1, AUDIO_FORMAT_PCM_FLOAT, 1, 6}),
+        [](const ::testing::TestParamInfo<MixerConfig>& info) {
+            const MixerConfig& config = info.param;
+            return "tracks" + std::to_string(config.tracks)
+                    + "_threads" + std::to_string(config.threads)
+                    + (config.mixerFormat == AUDIO_FORMAT_PCM_FLOAT ? "_float" : "_int16")
+                    + "_main" + std::to_string(config.mainBuffers)
+                    + "_aux" + std::to_string(config.auxTracks);
+        });
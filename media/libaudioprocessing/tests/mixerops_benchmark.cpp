@@ -101,4 +101,55 @@ BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8);
 
+// Throughput of each runtime selected kernel (see AudioMixerOpsSimd.h) against the
+// scalar templates, for float and int16_t input.
+template <int MIXTYPE, int NCHAN, typename TI, mixerops_simd::Isa ISA, bool RAMP>
+static void BM_VolumeSimd(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1024;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+
+    if (!mixerops_simd::setIsa(ISA)) {
+        state.SkipWithError("ISA not supported");
+        return;
+    }
+    float out[SAMPLE_COUNT]{};
+    TI in[SAMPLE_COUNT]{};
+    float vola = 0.f;
+    float vol[2] = {0.f, 0.f};
+    const float volinc[2] = {1e-6f, 1e-6f};
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out);
+        benchmark::DoNotOptimize(in);
+        if constexpr (RAMP) {
+            volumeRampMulti<MIXTYPE, NCHAN>(
+                    out, FRAME_COUNT, in, (float *)nullptr, vol, volinc, &vola, 0.f);
+        } else {
+            volumeMulti<MIXTYPE, NCHAN>(out, FRAME_COUNT, in, (float *)nullptr, vol, vola);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * FRAME_COUNT);
+    mixerops_simd::setIsa(mixerops_simd::detectIsa());
+}
+
+#define BENCHMARK_VOLUME_SIMD(MIXTYPE, NCHAN, TI, RAMP) \
+    BENCHMARK_TEMPLATE(BM_VolumeSimd, MIXTYPE, NCHAN, TI, mixerops_simd::Isa::SCALAR, RAMP); \
+    BENCHMARK_TEMPLATE(BM_VolumeSimd, MIXTYPE, NCHAN, TI, mixerops_simd::Isa::SSE2, RAMP); \
+    BENCHMARK_TEMPLATE(BM_VolumeSimd, MIXTYPE, NCHAN, TI, mixerops_simd::Isa::AVX2, RAMP); \
+    BENCHMARK_TEMPLATE(BM_VolumeSimd, MIXTYPE, NCHAN, TI, mixerops_simd::Isa::AVX512, RAMP)
+
+BENCHMARK_VOLUME_SIMD(MIXTYPE_MULTI, 2, float, false);
+BENCHMARK_VOLUME_SIMD(MIXTYPE_MULTI, 2, int16_t, false);
+BENCHMARK_VOLUME_SIMD(MIXTYPE_MULTI_STEREOVOL, 2, float, false);
+BENCHMARK_VOLUME_SIMD(MIXTYPE_MULTI_STEREOVOL, 2, int16_t, false);
+BENCHMARK_VOLUME_SIMD(MIXTYPE_MULTI_STEREOVOL, 8, float, false);
+BENCHMARK_VOLUME_SIMD(MIXTYPE_MULTI_STEREOVOL, 8, int16_t, false);
+BENCHMARK_VOLUME_SIMD(MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8, float, false);
+
+BENCHMARK_VOLUME_SIMD(MIXTYPE_MULTI, 2, float, true);
+BENCHMARK_VOLUME_SIMD(MIXTYPE_MULTI, 2, int16_t, true);
+BENCHMARK_VOLUME_SIMD(MIXTYPE_MULTI_STEREOVOL, 8, float, true);
+BENCHMARK_VOLUME_SIMD(MIXTYPE_MULTI_STEREOVOL, 8, int16_t, true);
+
 BENCHMARK_MAIN();
@@ -19,6 +19,8 @@
 #include <log/log.h>
 
 #include <inttypes.h>
+#include <random>
+#include <string.h>
 #include <type_traits>
 
 #include <../AudioMixerOps.h>
@@ -176,3 +178,85 @@ TEST(mixerops, channel_equivalence) {
         EXPECT_EQ(system, actual);
     }
 }
+
+// Verifies the runtime selected SIMD kernels are bit-exact with the scalar templates.
+template <int MIXTYPE, int NCHAN, typename TI>
+class MixerOpsSimdTest {
+public:
+    static void testEquivalence() {
+        using namespace android::mixerops_simd;
+        // odd frame count so the scalar tail is exercised as well.
+        constexpr size_t FRAME_COUNT = 1000 + 7;
+        constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+
+        std::minstd_rand gen(NCHAN * 100 + MIXTYPE);
+        std::uniform_real_distribution<float> dis(-1.f, 1.f);
+        TI in[SAMPLE_COUNT];
+        float outInit[SAMPLE_COUNT];
+        for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+            if constexpr (std::is_same_v<TI, int16_t>) {
+                in[i] = static_cast<int16_t>(dis(gen) * 32767.f);
+            } else {
+                in[i] = dis(gen);
+            }
+            outInit[i] = dis(gen);
+        }
+        const float volInit[2] = {0.75f, 0.3f};
+        const float volinc[2] = {-1e-4f, 3e-4f};
+
+        const Isa savedIsa = getIsa();
+        ASSERT_TRUE(setIsa(Isa::SCALAR));
+        float expectedOut[SAMPLE_COUNT];
+        float expectedRampOut[SAMPLE_COUNT];
+        float expectedVol[2] = {volInit[0], volInit[1]};
+        float vola = 0.f;  // unused without aux.
+        std::copy(outInit, outInit + SAMPLE_COUNT, expectedOut);
+        std::copy(outInit, outInit + SAMPLE_COUNT, expectedRampOut);
+        volumeMulti<MIXTYPE, NCHAN>(expectedOut, FRAME_COUNT, in, (float *)nullptr,
+                volInit, vola);
+        volumeRampMulti<MIXTYPE, NCHAN>(expectedRampOut, FRAME_COUNT, in, (float *)nullptr,
+                expectedVol, volinc, &vola, 0.f);
+
+        for (const Isa isa : { Isa::SSE2, Isa::AVX2, Isa::AVX512 }) {
+            if (!setIsa(isa)) continue;
+            SCOPED_TRACE(toString(isa));
+            float out[SAMPLE_COUNT];
+            std::copy(outInit, outInit + SAMPLE_COUNT, out);
+            volumeMulti<MIXTYPE, NCHAN>(out, FRAME_COUNT, in, (float *)nullptr, volInit, vola);
+            EXPECT_EQ(0, memcmp(expectedOut, out, sizeof(out)));
+
+            float vol[2] = {volInit[0], volInit[1]};
+            std::copy(outInit, outInit + SAMPLE_COUNT, out);
+            volumeRampMulti<MIXTYPE, NCHAN>(out, FRAME_COUNT, in, (float *)nullptr,
+                    vol, volinc, &vola, 0.f);
+            EXPECT_EQ(0, memcmp(expectedRampOut, out, sizeof(out)));
+            EXPECT_EQ(0, memcmp(expectedVol, vol, sizeof(vol)));
+        }
+        setIsa(savedIsa);
+    }
+};
+
+TEST(mixerops, simd_multi) {
+    MixerOpsSimdTest<MIXTYPE_MULTI, 1, float>::testEquivalence();
+    MixerOpsSimdTest<MIXTYPE_MULTI, 2, float>::testEquivalence();
+    MixerOpsSimdTest<MIXTYPE_MULTI_SAVEONLY, 2, float>::testEquivalence();
+    MixerOpsSimdTest<MIXTYPE_MULTI, 2, int16_t>::testEquivalence();
+    MixerOpsSimdTest<MIXTYPE_MULTI_SAVEONLY, 2, int16_t>::testEquivalence();
+}
+TEST(mixerops, simd_monovol) {
+    MixerOpsSimdTest<MIXTYPE_MULTI_MONOVOL, 6, float>::testEquivalence();
+    MixerOpsSimdTest<MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8, float>::testEquivalence();
+    MixerOpsSimdTest<MIXTYPE_MULTI_MONOVOL, 5, int16_t>::testEquivalence();
+}
+TEST(mixerops, simd_stereovol) {
+    MixerOpsSimdTest<MIXTYPE_MULTI_STEREOVOL, 2, float>::testEquivalence();
+    MixerOpsSimdTest<MIXTYPE_MULTI_STEREOVOL, 3, float>::testEquivalence();
+    MixerOpsSimdTest<MIXTYPE_MULTI_STEREOVOL, 6, float>::testEquivalence();
+    MixerOpsSimdTest<MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8, float>::testEquivalence();
+    MixerOpsSimdTest<MIXTYPE_MULTI_STEREOVOL, 2, int16_t>::testEquivalence();
+    MixerOpsSimdTest<MIXTYPE_MULTI_STEREOVOL, 6, int16_t>::testEquivalence();
+    MixerOpsSimdTest<MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8, int16_t>::testEquivalence();
+    if constexpr (FCC_LIMIT >= 12) {
+        MixerOpsSimdTest<MIXTYPE_MULTI_STEREOVOL, 12, float>::testEquivalence();
+    }
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <audio_utils/format.h>
+#include <audio_utils/primitives.h>
+#include <benchmark/benchmark.h>
+#include <media/RecordBufferConverter.h>
+
+using namespace android;
+
+/*
+ * Converts the RecordThread capture data to a record client's format.
+ *
+ * Each benchmark is one client; the time per iteration is that client's CPU cost
+ * for one 20 ms capture period.
+ *
+ * For the conversions without resampling, the output is first checked to be identical to
+ * the legacy multi-pass conversion through float.
+ */
+
+static constexpr uint32_t kCaptureSampleRate = 48000;
+static constexpr size_t kCaptureFrameCount = 960;  // 20 ms.
+
+struct Client {
+    audio_channel_mask_t srcChannelMask;
+    audio_format_t srcFormat;
+    audio_channel_mask_t dstChannelMask;
+    audio_format_t dstFormat;
+    uint32_t dstSampleRate;
+};
+
+static const Client kClients[] = {
+    // legacy downmix
+    { AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT,
+            AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 48000 },
+    { AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT,
+            AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_FLOAT, 48000 },
+    { AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_FLOAT,
+            AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 48000 },
+    // legacy upmix
+    { AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT,
+            AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT, 48000 },
+    { AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT,
+            AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_FLOAT, 48000 },
+    // format only
+    { AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT,
+            AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_FLOAT, 48000 },
+    // 48k to 16k
+    { AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT,
+            AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 16000 },
+    { AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT,
+            AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 16000 },
+    { AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_FLOAT,
+            AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_FLOAT, 16000 },
+};
+
+// Provides looped capture data, as the RecordThread ResamplerBufferProvider would.
+class CaptureProvider : public AudioBufferProvider {
+public:
+    CaptureProvider(audio_channel_mask_t channelMask, audio_format_t format)
+        : mFrameSize(audio_channel_count_from_in_mask(channelMask)
+                * audio_bytes_per_sample(format))
+        , mFrames(kCaptureFrameCount * 5 + 7) // not a multiple of the period.
+        , mData(mFrames * mFrameSize) {
+        const size_t samples = mData.size() / audio_bytes_per_sample(format);
+        std::vector<float> noise(samples);
+        uint32_t seed = 1;
+        for (float& sample : noise) {
+            seed = seed * 1664525 + 1013904223;
+            sample = (int32_t)seed * (1.25f / INT32_MAX); // some samples beyond unity.
+        }
+        memcpy_by_audio_format(mData.data(), format, noise.data(), AUDIO_FORMAT_PCM_FLOAT,
+                samples);
+    }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        buffer->frameCount = std::min(buffer->frameCount, mFrames - mPosition);
+        buffer->raw = &mData[mPosition * mFrameSize];
+        return OK;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        mPosition = (mPosition + buffer->frameCount) % mFrames;
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+    }
+
+    void rewind() { mPosition = 0; }
+    const void* data() const { return mData.data(); }
+
+private:
+    const size_t mFrameSize;
+    const size_t mFrames;
+    std::vector<uint8_t> mData;
+    size_t mPosition = 0;
+};
+
+// The conversion without the fused path: to float, legacy remix, from float.
+static void convertLegacy(const Client& client, void* dst, const void* src, size_t frames) {
+    const size_t srcChannels = audio_channel_count_from_in_mask(client.srcChannelMask);
+    const size_t dstChannels = audio_channel_count_from_in_mask(client.dstChannelMask);
+    std::vector<float> in(frames * srcChannels);
+    std::vector<float> out(frames * dstChannels);
+    memcpy_by_audio_format(in.data(), AUDIO_FORMAT_PCM_FLOAT, src, client.srcFormat, in.size());
+    if (srcChannels == 1) {
+        upmix_to_stereo_float_from_mono_float(out.data(), in.data(), frames);
+    } else {
+        downmix_to_mono_float_from_stereo_float(out.data(), in.data(), frames);
+    }
+    memcpy_by_audio_format(dst, client.dstFormat, out.data(), AUDIO_FORMAT_PCM_FLOAT, out.size());
+}
+
+static void BM_RecordBufferConverter(benchmark::State& state) {
+    const Client& client = kClients[state.range(0)];
+    CaptureProvider provider(client.srcChannelMask, client.srcFormat);
+    RecordBufferConverter converter(client.srcChannelMask, client.srcFormat, kCaptureSampleRate,
+            client.dstChannelMask, client.dstFormat, client.dstSampleRate);
+    if (converter.initCheck() != NO_ERROR) {
+        state.SkipWithError("invalid conversion");
+        return;
+    }
+    const size_t frames = kCaptureFrameCount * client.dstSampleRate / kCaptureSampleRate;
+    const size_t dstFrameSize = audio_channel_count_from_in_mask(client.dstChannelMask)
+            * audio_bytes_per_sample(client.dstFormat);
+    std::vector<uint8_t> dst(frames * dstFrameSize);
+
+    if (client.dstSampleRate == kCaptureSampleRate
+            && client.srcChannelMask != client.dstChannelMask) {
+        std::vector<uint8_t> expected(dst.size());
+        convertLegacy(client, expected.data(), provider.data(), frames);
+        if (converter.convert(dst.data(), &provider, frames) != frames || dst != expected) {
+            state.SkipWithError("conversion differs from the legacy conversion");
+            return;
+        }
+        provider.rewind();
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(converter.convert(dst.data(), &provider, frames));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+    state.SetLabel(std::string(audio_format_to_string(client.srcFormat)) + " "
+            + std::to_string(audio_channel_count_from_in_mask(client.srcChannelMask))
+            + "ch 48000 -> " + audio_format_to_string(client.dstFormat) + " "
+            + std::to_string(audio_channel_count_from_in_mask(client.dstChannelMask))
+            + "ch " + std::to_string(client.dstSampleRate));
+}
+
+BENCHMARK(BM_RecordBufferConverter)->DenseRange(0, std::size(kClients) - 1);
+
+BENCHMARK_MAIN();
@@ -30,6 +30,7 @@
 
 #include <iostream>
 #include <memory>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -601,3 +602,160 @@ TEST(audioflinger_resampler, generalresponse) {
         }
     }
 }
+
+template <typename ResamplerType>
+static std::unique_ptr<ResamplerType> createDynResampler(audio_format_t format,
+        size_t channels, unsigned inputFreq, unsigned outputFreq,
+        android::AudioResampler::src_quality quality)
+{
+    std::unique_ptr<ResamplerType> rdyn(static_cast<ResamplerType *>(
+            android::AudioResampler::create(format, channels, outputFreq, quality)));
+    rdyn->setSampleRate(inputFreq);
+    return rdyn;
+}
+
+TEST(audioflinger_resampler, filtercache) {
+    using FloatResampler = android::AudioResamplerDyn<float, float, float>;
+    using IntResampler = android::AudioResamplerDyn<int16_t, int16_t, int32_t>;
+    const android::FirCoefCache::Statistics initial = android::FirCoefCache::getStatistics();
+
+    // tracks with the same rates and quality share one filter, regardless of channel count.
+    auto stereo = createDynResampler<FloatResampler>(AUDIO_FORMAT_PCM_FLOAT,
+            2 /* channels */, 11025, 44100, android::AudioResampler::DYN_MED_QUALITY);
+    auto multichannel = createDynResampler<FloatResampler>(AUDIO_FORMAT_PCM_FLOAT,
+            6 /* channels */, 11025, 44100, android::AudioResampler::DYN_MED_QUALITY);
+    EXPECT_EQ(stereo->getFilterCoefs(), multichannel->getFilterCoefs());
+
+    android::FirCoefCache::Statistics statistics = android::FirCoefCache::getStatistics();
+    EXPECT_EQ(initial.misses + 1, statistics.misses);
+    EXPECT_EQ(initial.hits + 1, statistics.hits);
+    EXPECT_EQ(initial.entries + 1, statistics.entries);
+
+    // a different quality or coefficient type requires a different filter.
+    auto lowQuality = createDynResampler<FloatResampler>(AUDIO_FORMAT_PCM_FLOAT,
+            2 /* channels */, 11025, 44100, android::AudioResampler::DYN_LOW_QUALITY);
+    auto integer = createDynResampler<IntResampler>(AUDIO_FORMAT_PCM_16_BIT,
+            2 /* channels */, 11025, 44100, android::AudioResampler::DYN_MED_QUALITY);
+    EXPECT_NE(stereo->getFilterCoefs(), lowQuality->getFilterCoefs());
+    statistics = android::FirCoefCache::getStatistics();
+    EXPECT_EQ(initial.misses + 3, statistics.misses);
+    EXPECT_EQ(initial.entries + 3, statistics.entries);
+
+    // the filter is released with its last user.
+    stereo.reset();
+    EXPECT_EQ(initial.entries + 3, android::FirCoefCache::getStatistics().entries);
+    multichannel.reset();
+    lowQuality.reset();
+    integer.reset();
+    EXPECT_EQ(initial.entries, android::FirCoefCache::getStatistics().entries);
+}
+
+/* Wide vector FIR kernel tests
+ *
+ * Each runtime selectable kernel (see AudioResamplerFirProcessAVX.h) is compared
+ * with the compile time selected (FirSimd::NONE) path, and the cost in cycles
+ * per output frame is reported for each configuration.
+ */
+
+static inline uint64_t cycleCount() {
+#if defined(__i386__) || defined(__x86_64__)
+    return __builtin_ia32_rdtsc();
+#else
+    // no user accessible cycle counter, report nanoseconds.
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+// Resamples a chirp with the given kernel, returning the output and the cycles per frame.
+template <typename TO>
+static std::vector<TO> resampleWithFirSimd(android::FirSimd simd, size_t channels,
+        unsigned inputFreq, unsigned outputFreq,
+        enum android::AudioResampler::src_quality quality, double *cyclesPerFrame)
+{
+    constexpr bool useFloat = std::is_same_v<TO, float>;
+    const audio_format_t format = useFloat ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
+    SignalProvider provider;
+    if (useFloat) {
+        provider.setChirp<float>(channels, 0., inputFreq/2., inputFreq, 0.5);
+    } else {
+        provider.setChirp<int16_t>(channels, 0., inputFreq/2., inputFreq, 0.5);
+    }
+    const size_t outputFrames = ((int64_t) provider.getNumFrames() * outputFreq) / inputFreq;
+    const size_t outputChannels = channels == 1 ? 2 : channels;
+    std::vector<TO> output(outputFrames * outputChannels);
+
+    EXPECT_TRUE(android::setFirSimd(simd));
+    std::unique_ptr<android::AudioResampler> resampler(
+            android::AudioResampler::create(format, channels, outputFreq, quality));
+    resampler->setSampleRate(inputFreq);
+    resampler->setVolume(android::AudioResampler::UNITY_GAIN_FLOAT,
+            android::AudioResampler::UNITY_GAIN_FLOAT);
+
+    const uint64_t start = cycleCount();
+    resample(channels, output.data(), outputFrames, {outputFrames}, &provider, resampler.get());
+    *cyclesPerFrame = (double)(cycleCount() - start) / outputFrames;
+    return output;
+}
+
+template <typename TO>
+static void testFirSimd(size_t channels, unsigned inputFreq, unsigned outputFreq,
+        enum android::AudioResampler::src_quality quality)
+{
+    const android::FirSimd savedSimd = android::getFirSimd();
+    double referenceCycles;
+    const std::vector<TO> reference = resampleWithFirSimd<TO>(android::FirSimd::NONE,
+            channels, inputFreq, outputFreq, quality, &referenceCycles);
+    printf("channels:%zu %s %u->%u quality:%d  none:%.1f",
+            channels, std::is_same_v<TO, float> ? "float" : "int16",
+            inputFreq, outputFreq, quality, referenceCycles);
+
+    for (const auto simd : { android::FirSimd::AVX2, android::FirSimd::AVX512 }) {
+        if (!android::isFirSimdSupported(simd)) continue;
+        double cycles;
+        const std::vector<TO> test = resampleWithFirSimd<TO>(simd,
+                channels, inputFreq, outputFreq, quality, &cycles);
+        printf("  %s:%.1f", simd == android::FirSimd::AVX2 ? "avx2" : "avx512", cycles);
+        ASSERT_EQ(reference.size(), test.size());
+        if constexpr (std::is_same_v<TO, float>) {
+            // accumulation order differs, so allow for rounding.
+            for (size_t i = 0; i < reference.size(); ++i) {
+                ASSERT_NEAR(reference[i], test[i], 1e-5f) << "sample " << i;
+            }
+        } else {
+            // integer kernels are bit-exact.
+            buffercmp(reference.data(), test.data(), sizeof(TO), reference.size());
+        }
+    }
+    printf("  (cycles per frame)\n");
+    android::setFirSimd(savedSimd);
+}
+
+TEST(audioflinger_resampler, firsimd_float) {
+    static const enum android::AudioResampler::src_quality kQualityArray[] = {
+            android::AudioResampler::DYN_LOW_QUALITY,
+            android::AudioResampler::DYN_MED_QUALITY,
+            android::AudioResampler::DYN_HIGH_QUALITY,
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(kQualityArray); ++i) {
+        for (size_t channels : { 1, 2, 6, 8, 12 }) {
+            testFirSimd<float>(channels, 44100, 48000, kQualityArray[i]);  // interpolated
+            testFirSimd<float>(channels, 48000, 32000, kQualityArray[i]);  // fixed phase
+        }
+    }
+}
+
+TEST(audioflinger_resampler, firsimd_integer) {
+    static const enum android::AudioResampler::src_quality kQualityArray[] = {
+            android::AudioResampler::DYN_LOW_QUALITY,  // int16_t coefficients
+            android::AudioResampler::DYN_MED_QUALITY,
+            android::AudioResampler::DYN_HIGH_QUALITY, // int32_t coefficients
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(kQualityArray); ++i) {
+        for (size_t channels : { 1, 2, 6 }) {
+            testFirSimd<int32_t>(channels, 44100, 48000, kQualityArray[i]);
+            testFirSimd<int32_t>(channels, 48000, 32000, kQualityArray[i]);
+        }
+    }
+}
@@ -323,6 +323,37 @@ bool mediametrics::Item::selfrecord() {
     return true;
 }
 
+// static
+bool mediametrics::Item::selfrecord(const std::vector<const Item *>& items) {
+    // One-way transactions to the service share its asynchronous transaction space,
+    // so keep each batch small compared to it.
+    static constexpr size_t kMaxBatchSize = 64 * 1024;
+
+    std::vector<char> batch;
+    bool ok = true;
+    for (const Item *item : items) {
+        ALOGD_IF(DEBUG_API, "%s: delivering %s", __func__, item->toString().c_str());
+
+        char *str;
+        size_t size;
+        if (item->writeToByteString(&str, &size) != NO_ERROR) {
+            ALOGW("%s: failed to record: %s", __func__, item->toString().c_str());
+            ok = false;
+            continue;
+        }
+        if (!batch.empty() && batch.size() + size > kMaxBatchSize) {
+            ok &= submitBuffers(batch.data(), batch.size()) == NO_ERROR;
+            batch.clear();
+        }
+        batch.insert(batch.end(), str, str + size);
+        free(str);
+    }
+    if (!batch.empty()) {
+        ok &= submitBuffers(batch.data(), batch.size()) == NO_ERROR;
+    }
+    return ok;
+}
+
 //static
 bool BaseItem::isEnabled() {
     // completely skip logging from certain UIDs. We do this here
@@ -382,6 +413,31 @@ void BaseItem::dropInstance() {
     sMediaMetricsService = nullptr;
 }
 
+// Writes the buffer as the byte[] argument of a one-way call to the MediaMetrics service.
+//
+// This direct implementation of the Binder calling interface avoids
+// malloc/copy/free for the byte vector and reduces the overhead for logging.
+// We based this off of the AIDL generated file:
+// out/soong/.intermediates/frameworks/av/media/libmediametrics/mediametricsservice-aidl-unstable-cpp-source/gen/android/media/IMediaMetricsService.cpp
+// TODO: Create an AIDL C++ back end optimized form of vector writing.
+static status_t transactBuffer(const sp<media::IMediaMetricsService>& svc,
+        uint32_t code, const char *buffer, size_t size) {
+    ::android::Parcel _aidl_data;
+    ::android::Parcel _aidl_reply; // we don't care about this as it is one-way.
+
+    ::android::status_t status = _aidl_data.writeInterfaceToken(svc->getInterfaceDescriptor());
+    if (status != ::android::OK) return status;
+
+    status = _aidl_data.writeInt32(static_cast<int32_t>(size));
+    if (status != ::android::OK) return status;
+
+    status = _aidl_data.write(buffer, static_cast<int32_t>(size));
+    if (status != ::android::OK) return status;
+
+    return ::android::IInterface::asBinder(svc)->transact(
+            code, _aidl_data, &_aidl_reply, ::android::IBinder::FLAG_ONEWAY);
+}
+
 // static
 status_t BaseItem::submitBuffer(const char *buffer, size_t size) {
     ALOGD_IF(DEBUG_API, "%s: delivering %zu bytes", __func__, size);
@@ -397,33 +453,15 @@ status_t BaseItem::submitBuffer(const char *buffer, size_t size) {
     if constexpr (/* DISABLES CODE */ (false)) {
         // THIS PATH IS FOR REFERENCE ONLY.
         // It is compiled so that any changes to IMediaMetricsService::submitBuffer()
-        // will lead here.  If this code is changed, the else branch must
+        // will lead here.  If this code is changed, transactBuffer() must
         // be changed as well.
         //
         // Use the AIDL calling interface - this is a bit slower as a byte vector must be
         // constructed. As the call is one-way, the only a transaction error occurs.
         status = svc->submitBuffer({buffer, buffer + size}).transactionError();
     } else {
-        // Use the Binder calling interface - this direct implementation avoids
-        // malloc/copy/free for the vector and reduces the overhead for logging.
-        // We based this off of the AIDL generated file:
-        // out/soong/.intermediates/frameworks/av/media/libmediametrics/mediametricsservice-aidl-unstable-cpp-source/gen/android/media/IMediaMetricsService.cpp
-        // TODO: Create an AIDL C++ back end optimized form of vector writing.
-        ::android::Parcel _aidl_data;
-        ::android::Parcel _aidl_reply; // we don't care about this as it is one-way.
-
-        status = _aidl_data.writeInterfaceToken(svc->getInterfaceDescriptor());
-        if (status != ::android::OK) goto _aidl_error;
-
-        status = _aidl_data.writeInt32(static_cast<int32_t>(size));
-        if (status != ::android::OK) goto _aidl_error;
-
-        status = _aidl_data.write(buffer, static_cast<int32_t>(size));
-        if (status != ::android::OK) goto _aidl_error;
-
-        status = ::android::IInterface::asBinder(svc)->transact(
-                ::android::media::BnMediaMetricsService::TRANSACTION_submitBuffer,
-                _aidl_data, &_aidl_reply, ::android::IBinder::FLAG_ONEWAY);
+        status = transactBuffer(svc,
+                ::android::media::BnMediaMetricsService::TRANSACTION_submitBuffer, buffer, size);
 
         // AIDL permits setting a default implementation for additional functionality.
         // See go/aog/713984. This is not used here.
@@ -437,7 +475,32 @@ status_t BaseItem::submitBuffer(const char *buffer, size_t size) {
 
     if (status == NO_ERROR) return NO_ERROR;
 
-    _aidl_error:
+    ALOGW("%s: failed(%d) to record: %zu bytes", __func__, status, size);
+    return status;
+}
+
+// static
+status_t BaseItem::submitBuffers(const char *buffer, size_t size) {
+    ALOGD_IF(DEBUG_API, "%s: delivering %zu bytes", __func__, size);
+
+    // Validate size
+    if (size > std::numeric_limits<int32_t>::max()) return BAD_VALUE;
+
+    // Do we have the service available?
+    sp<media::IMediaMetricsService> svc = getService();
+    if (svc == nullptr)  return NO_INIT;
+
+    ::android::status_t status = NO_ERROR;
+    if constexpr (/* DISABLES CODE */ (false)) {
+        // THIS PATH IS FOR REFERENCE ONLY, see submitBuffer().
+        status = svc->submitBuffers({buffer, buffer + size}).transactionError();
+    } else {
+        status = transactBuffer(svc,
+                ::android::media::BnMediaMetricsService::TRANSACTION_submitBuffers, buffer, size);
+    }
+
+    if (status == NO_ERROR) return NO_ERROR;
+
     ALOGW("%s: failed(%d) to record: %zu bytes", __func__, status, size);
     return status;
 }
@@ -25,6 +25,7 @@
 #include <string>
 #include <sys/types.h>
 #include <variant>
+#include <vector>
 
 #include <binder/Parcel.h>
 #include <log/log.h>
@@ -275,6 +276,8 @@ public:
     static sp<media::IMediaMetricsService> getService();
     // submits a raw buffer directly to the MediaMetrics service - this is highly optimized.
     static status_t submitBuffer(const char *buffer, size_t len);
+    // submits the concatenated raw buffers of several items in one transaction.
+    static status_t submitBuffers(const char *buffer, size_t len);
 
 protected:
     static constexpr const char * const EnabledProperty = "media.metrics.enabled";
@@ -1068,6 +1071,8 @@ public:
 
         // Deliver the item to MediaMetrics
         bool selfrecord();
+        // Deliver several items to MediaMetrics, in as few transactions as possible
+        static bool selfrecord(const std::vector<const Item *>& items);
 
     // remove indicated attributes and their values
     // filterNot() could also be called keepOnly()
@@ -339,6 +339,8 @@ public:
     };
 
     void clear();
+    // Preallocates room for numItems items.
+    void reserve(size_t numItems);
     bool remove(uint32_t key);
 
     bool setCString(uint32_t key, const char *value);
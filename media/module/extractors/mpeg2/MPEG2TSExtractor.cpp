@@ -46,6 +46,8 @@ namespace android {
 using hardware::cas::V1_0::ICas;
 
 static const size_t kTSPacketSize = 188;
+// The number of packets fed to the parser at once by feedMore().
+static const size_t kFeedPackets = 32;
 static const int kMaxDurationReadSize = 250000LL;
 static const int kMaxDurationRetry = 6;
 
@@ -481,8 +483,11 @@ void MPEG2TSExtractor::init() {
 status_t MPEG2TSExtractor::feedMore(bool isInit) {
     std::lock_guard<std::mutex> autoLock(mLock);
 
-    uint8_t packet[kTSPacketSize];
-    ssize_t n = mDataSource->readAt(mOffset + mHeaderSkip, packet, kTSPacketSize);
+    // Packets of a TS file are back to back, so read several at once.
+    // An M2TS file has a header before each packet, so it is read packet by packet.
+    uint8_t packets[kTSPacketSize * kFeedPackets];
+    const size_t readSize = (mHeaderSkip == 0) ? sizeof(packets) : kTSPacketSize;
+    ssize_t n = mDataSource->readAt(mOffset + mHeaderSkip, packets, readSize);
 
     if (n < (ssize_t)kTSPacketSize) {
         if (n >= 0) {
@@ -492,8 +497,15 @@ status_t MPEG2TSExtractor::feedMore(bool isInit) {
     }
 
     ATSParser::SyncEvent event(mOffset);
-    mOffset += mHeaderSkip + n;
-    status_t err = mParser->feedTSPacket(packet, kTSPacketSize, &event);
+    status_t err;
+    if (mHeaderSkip == 0) {
+        size_t consumed;
+        err = mParser->feedTSPackets(packets, n, &consumed, &event);
+        mOffset += consumed;
+    } else {
+        mOffset += mHeaderSkip + n;
+        err = mParser->feedTSPacket(packets, kTSPacketSize, &event);
+    }
     if (event.hasReturnedData()) {
         if (isInit) {
             mLastSyncEvent = event;
@@ -25,16 +25,22 @@ AAtomizer AAtomizer::gAtomizer;
 
 // static
 const char *AAtomizer::Atomize(const char *name) {
-    return gAtomizer.atomize(name);
+    return gAtomizer.atomize(name, SIZE_MAX);
 }
 
-AAtomizer::AAtomizer() {
+// static
+const char *AAtomizer::Atomize(const char *name, size_t maxNumAtoms) {
+    return gAtomizer.atomize(name, maxNumAtoms);
+}
+
+AAtomizer::AAtomizer()
+    : mNumAtoms(0) {
     for (size_t i = 0; i < 128; ++i) {
         mAtoms.push(List<AString>());
     }
 }
 
-const char *AAtomizer::atomize(const char *name) {
+const char *AAtomizer::atomize(const char *name, size_t maxNumAtoms) {
     Mutex::Autolock autoLock(mLock);
 
     const size_t n = mAtoms.size();
@@ -48,6 +54,10 @@ const char *AAtomizer::atomize(const char *name) {
         ++it;
     }
 
+    if (mNumAtoms >= maxNumAtoms) {
+        return NULL;
+    }
+    ++mNumAtoms;
     entry.push_back(AString(name));
 
     return (*--entry.end()).c_str();
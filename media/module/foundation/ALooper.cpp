@@ -74,7 +74,8 @@ int64_t ALooper::getNowUs() {
 }
 
 ALooper::ALooper()
-    : mRunningLocally(false) {
+    : mNextEventSequence(0),
+      mRunningLocally(false) {
     // clean up stale AHandlers. Doing it here instead of in the destructor avoids
     // the side effect of objects being deleted from the unregister function recursively.
     gLooperRoster.unregisterStaleHandlers();
@@ -181,21 +182,9 @@ void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
         whenUs = getNowUs();
     }
 
-    List<Event>::iterator it = mEventQueue.begin();
-    while (it != mEventQueue.end() && (*it).mWhenUs <= whenUs) {
-        ++it;
-    }
-
-    Event event;
-    event.mWhenUs = whenUs;
-    event.mMessage = msg;
-    event.mToken = nullptr;
-
-    if (it == mEventQueue.begin()) {
+    if (pushEvent_l({whenUs, mNextEventSequence++, msg, nullptr /* token */})) {
         mQueueChangedCondition.signal();
     }
-
-    mEventQueue.insert(it, event);
 }
 
 status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token, int64_t delayUs) {
@@ -215,28 +204,16 @@ status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token,
     // We only need to wake the loop up if we're rescheduling to the earliest event in the queue.
     // This needs to be checked now, before we reschedule the message, in case this message is
     // already at the beginning of the queue.
-    bool shouldAwakeLoop = mEventQueue.empty() || whenUs < mEventQueue.begin()->mWhenUs;
+    bool shouldAwakeLoop = mEventQueue.empty() || whenUs < mEventQueue.front().mWhenUs;
 
     // Erase any previously-posted event with this token.
-    for (auto i = mEventQueue.begin(); i != mEventQueue.end();) {
-        if (i->mToken == token) {
-            i = mEventQueue.erase(i);
-        } else {
-            ++i;
-        }
+    auto it = mTokenIndices.find(token.get());
+    if (it != mTokenIndices.end()) {
+        removeEvent_l(it->second);
     }
 
-    // Find the insertion point for the rescheduled message.
-    List<Event>::iterator i = mEventQueue.begin();
-    while (i != mEventQueue.end() && i->mWhenUs <= whenUs) {
-        ++i;
-    }
-
-    Event event;
-    event.mWhenUs = whenUs;
-    event.mMessage = msg;
-    event.mToken = token;
-    mEventQueue.insert(i, event);
+    // The rescheduled message goes after the other messages of the same time.
+    pushEvent_l({whenUs, mNextEventSequence++, msg, token});
 
     // If we rescheduled the event to be earlier than the first event, then we need to wake up the
     // looper earlier than it was previously scheduled to be woken up. Otherwise, it can sleep until
@@ -247,6 +224,78 @@ status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token,
     return OK;
 }
 
+bool ALooper::pushEvent_l(Event &&event) {
+    const uint64_t sequence = event.mSequence;
+    mEventQueue.emplace_back();
+    setEvent_l(mEventQueue.size() - 1, std::move(event));
+    siftUp_l(mEventQueue.size() - 1);
+    return mEventQueue.front().mSequence == sequence;
+}
+
+ALooper::Event ALooper::removeEvent_l(size_t index) {
+    Event event = std::move(mEventQueue[index]);
+    if (event.mToken != nullptr) {
+        mTokenIndices.erase(event.mToken.get());
+    }
+    const size_t last = mEventQueue.size() - 1;
+    if (index != last) {
+        setEvent_l(index, std::move(mEventQueue[last]));
+        mEventQueue.pop_back();
+        // The last event may belong either before or after its new position.
+        if (index > 0 && mEventQueue[index].isBefore(mEventQueue[(index - 1) / 2])) {
+            siftUp_l(index);
+        } else {
+            siftDown_l(index);
+        }
+    } else {
+        mEventQueue.pop_back();
+    }
+    return event;
+}
+
+void ALooper::siftUp_l(size_t index) {
+    if (index == 0) {
+        return;
+    }
+    Event event = std::move(mEventQueue[index]);
+    while (index > 0) {
+        const size_t parent = (index - 1) / 2;
+        if (!event.isBefore(mEventQueue[parent])) {
+            break;
+        }
+        setEvent_l(index, std::move(mEventQueue[parent]));
+        index = parent;
+    }
+    setEvent_l(index, std::move(event));
+}
+
+void ALooper::siftDown_l(size_t index) {
+    const size_t size = mEventQueue.size();
+    Event event = std::move(mEventQueue[index]);
+    for (;;) {
+        size_t child = 2 * index + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && mEventQueue[child + 1].isBefore(mEventQueue[child])) {
+            ++child;
+        }
+        if (!mEventQueue[child].isBefore(event)) {
+            break;
+        }
+        setEvent_l(index, std::move(mEventQueue[child]));
+        index = child;
+    }
+    setEvent_l(index, std::move(event));
+}
+
+void ALooper::setEvent_l(size_t index, Event &&event) {
+    if (event.mToken != nullptr) {
+        mTokenIndices[event.mToken.get()] = index;
+    }
+    mEventQueue[index] = std::move(event);
+}
+
 bool ALooper::loop() {
 
     Event event;
@@ -260,7 +309,7 @@ bool ALooper::loop() {
             mQueueChangedCondition.wait(mLock);
             return true;
         }
-        int64_t whenUs = (*mEventQueue.begin()).mWhenUs;
+        int64_t whenUs = mEventQueue.front().mWhenUs;
         int64_t nowUs = getNowUs();
 
         if (whenUs > nowUs) {
@@ -273,8 +322,7 @@ bool ALooper::loop() {
             return true;
         }
 
-        event = *mEventQueue.begin();
-        mEventQueue.erase(mEventQueue.begin());
+        event = removeEvent_l(0);
     }
 
     event.mMessage->deliver();
@@ -19,6 +19,10 @@
 //#define DUMP_STATS
 
 #include <ctype.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
 
 #include "AMessage.h"
 
@@ -41,6 +45,148 @@ namespace android {
 
 extern ALooperRoster gLooperRoster;
 
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(hwaddress_sanitizer)
+// Let the sanitizer see each message being freed.
+#define AMESSAGE_NO_MEMORY_REUSE
+#endif
+#endif
+
+namespace {
+
+// Freed message memory kept by a thread for its next messages, as looper
+// threads create and release messages at a high rate.
+struct FreedMessages {
+    static constexpr size_t kMaxCount = 32;
+    // The thread is exiting, and no longer keeps freed messages.
+    static constexpr size_t kReleased = SIZE_MAX;
+
+    void *mMemory[kMaxCount];
+    size_t mCount;
+};
+
+thread_local FreedMessages tFreedMessages;
+
+// Releases the freed messages of a thread when it exits.
+struct FreedMessagesReleaser {
+    bool mUsed = false;
+
+    ~FreedMessagesReleaser() {
+        for (size_t i = 0; i < tFreedMessages.mCount; ++i) {
+            ::operator delete(tFreedMessages.mMemory[i]);
+        }
+        tFreedMessages.mCount = FreedMessages::kReleased;
+    }
+};
+
+thread_local FreedMessagesReleaser tFreedMessagesReleaser;
+
+// Item names are interned, so that they are not copied for each item and are
+// mostly compared by address. Names longer than this, and new names once there
+// are kMaxNumNameAtoms atoms, are copied instead, so that arbitrary names from
+// clients cannot grow the atomizer without bound.
+constexpr size_t kMaxNameAtomLength = 63;
+constexpr size_t kMaxNumNameAtoms = 4096;
+
+// A cache of the atoms of the names recently passed by a thread, by name address,
+// as most names are string literals. It saves locking the atomizer.
+struct NameAtomCacheEntry {
+    const char *mName;
+    const char *mAtom;
+    size_t mLength;
+};
+
+constexpr size_t kNameAtomCacheSize = 64;
+
+thread_local NameAtomCacheEntry tNameAtomCache[kNameAtomCacheSize];
+
+NameAtomCacheEntry *getNameAtomCacheEntry(const char *name) {
+    return &tNameAtomCache[(reinterpret_cast<uintptr_t>(name) >> 2) % kNameAtomCacheSize];
+}
+
+// Returns the cached atom of name, or nullptr if there is none.
+const char *findNameAtom(const char *name, size_t len) {
+    const NameAtomCacheEntry *entry = getNameAtomCacheEntry(name);
+    if (entry->mName == name && entry->mLength == len && !memcmp(entry->mAtom, name, len)) {
+        return entry->mAtom;
+    }
+    return nullptr;
+}
+
+// Returns the atom of name, or nullptr if name is not interned.
+const char *atomizeName(const char *name, size_t len) {
+    if (len > kMaxNameAtomLength) {
+        return nullptr;
+    }
+    const char *atom = findNameAtom(name, len);
+    if (atom == nullptr) {
+        atom = AAtomizer::Atomize(name, kMaxNumNameAtoms);
+        if (atom != nullptr) {
+            *getNameAtomCacheEntry(name) = {name, atom, len};
+        }
+    }
+    return atom;
+}
+
+}  // namespace
+
+// static
+void *AMessage::operator new(size_t size) {
+#ifndef AMESSAGE_NO_MEMORY_REUSE
+    FreedMessages &freed = tFreedMessages;
+    if (size == sizeof(AMessage) && freed.mCount > 0 && freed.mCount != FreedMessages::kReleased) {
+        return freed.mMemory[--freed.mCount];
+    }
+#endif
+    return ::operator new(size);
+}
+
+// static
+void AMessage::operator delete(void *ptr, size_t size) {
+#ifndef AMESSAGE_NO_MEMORY_REUSE
+    FreedMessages &freed = tFreedMessages;
+    if (size == sizeof(AMessage) && freed.mCount < FreedMessages::kMaxCount) {
+        // Make sure that the memory is released when the thread exits.
+        tFreedMessagesReleaser.mUsed = true;
+        freed.mMemory[freed.mCount++] = ptr;
+        return;
+    }
+#endif
+    ::operator delete(ptr);
+}
+
+AMessage::ItemList::~ItemList() {
+    if (mData != mInlineItems) {
+        delete[] mData;
+    }
+}
+
+AMessage::ItemList &AMessage::ItemList::operator=(const ItemList &other) {
+    if (this != &other) {
+        mSize = 0;
+        resize(other.mSize);
+        std::copy(other.begin(), other.end(), mData);
+    }
+    return *this;
+}
+
+void AMessage::ItemList::resize(size_t size) {
+    if (size > mCapacity) {
+        const size_t capacity = std::max(size, 2 * mCapacity);
+        Item *data = new Item[capacity];
+        std::copy(begin(), end(), data);
+        if (mData != mInlineItems) {
+            delete[] mData;
+        }
+        mData = data;
+        mCapacity = capacity;
+    }
+    for (size_t i = mSize; i < size; ++i) {
+        mData[i] = Item();
+    }
+    mSize = size;
+}
+
 status_t AReplyToken::setReply(const sp<AMessage> &reply) {
     if (mReplied) {
         ALOGE("trying to post a duplicate reply");
@@ -89,8 +235,7 @@ void AMessage::setTarget(const sp<const AHandler> &handler) {
 void AMessage::clear() {
     // Item needs to be handled delicately
     for (Item &item : mItems) {
-        delete[] item.mName;
-        item.mName = NULL;
+        item.freeName();
         freeItemValue(&item);
     }
     mItems.clear();
@@ -154,8 +299,20 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
 #ifdef DUMP_STATS
     size_t memchecks = 0;
 #endif
+    // Items named after the atom was created have the atom as name. An item named
+    // while the atomizer was full has a copy of the name, even if it was interned since
+    // (e.g. by AAtomizer::Atomize() from elsewhere), so copies are still compared.
+    const char *atom = findNameAtom(name, len);
     size_t i = 0;
     for (; i < mItems.size(); i++) {
+        if (atom != nullptr) {
+            if (mItems[i].mName == atom) {
+                break;
+            }
+            if (mItems[i].mNameIsAtom) {
+                continue;
+            }
+        }
         if (len != mItems[i].mNameLength) {
             continue;
         }
@@ -182,14 +339,20 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
 // assumes item's name was uninitialized or NULL
 void AMessage::Item::setName(const char *name, size_t len) {
     mNameLength = len;
-    mName = new char[len + 1];
-    memcpy((void*)mName, name, len + 1);
+    mName = atomizeName(name, len);
+    mNameIsAtom = mName != nullptr;
+    if (!mNameIsAtom) {
+        mName = new char[len + 1];
+        memcpy((void*)mName, name, len + 1);
+    }
 }
 
-AMessage::Item::Item(const char *name, size_t len)
-    : mType(kTypeInt32) {
-    // mName and mNameLength are initialized by setName
-    setName(name, len);
+void AMessage::Item::freeName() {
+    if (!mNameIsAtom) {
+        delete[] mName;
+    }
+    mName = nullptr;
+    mNameIsAtom = false;
 }
 
 AMessage::Item *AMessage::allocateItem(const char *name) {
@@ -204,8 +367,9 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
         CHECK(mItems.size() < kMaxNumItems);
         i = mItems.size();
         // place a 'blank' item at the end - this is of type kTypeInt32
-        mItems.emplace_back(name, len);
+        mItems.resize(i + 1);
         item = &mItems[i];
+        item->setName(name, len);
     }
 
     return item;
@@ -505,7 +669,10 @@ sp<AMessage> AMessage::dup() const {
         const Item *from = &mItems[i];
         Item *to = &msg->mItems[i];
 
-        to->setName(from->mName, from->mNameLength);
+        // atoms are shared, other names are copied.
+        if (!from->mNameIsAtom) {
+            to->setName(from->mName, from->mNameLength);
+        }
         to->mType = from->mType;
 
         switch (from->mType) {
@@ -1026,8 +1193,7 @@ status_t AMessage::setEntryNameAt(size_t index, const char *name) {
     if (findItemIndex(name, len) < mItems.size()) {
         return ALREADY_EXISTS;
     }
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    mItems[index].freeName();
     mItems[index].setName(name, len);
     return OK;
 }
@@ -1091,16 +1257,14 @@ status_t AMessage::removeEntryAt(size_t index) {
         return BAD_INDEX;
     }
     // delete entry data and objects
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    mItems[index].freeName();
     freeItemValue(&mItems[index]);
 
     // swap entry with last entry and clear last entry's data
     size_t lastIndex = mItems.size() - 1;
     if (index < lastIndex) {
         mItems[index] = mItems[lastIndex];
-        mItems[lastIndex].mName = nullptr;
-        mItems[lastIndex].mType = kTypeInt32;
+        mItems[lastIndex] = Item();
     }
     mItems.pop_back();
     return OK;
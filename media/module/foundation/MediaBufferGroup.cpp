@@ -17,7 +17,9 @@
 #define LOG_TAG "MediaBufferGroup"
 #include <utils/Log.h>
 
-#include <list>
+#include <algorithm>
+#include <atomic>
+#include <vector>
 
 #include <binder/MemoryDealer.h>
 #include <media/stagefright/foundation/ADebug.h>
@@ -36,13 +38,249 @@ constexpr T MIN(const T &a, const T &b) { return a <= b ? a : b; }
 static const size_t kSharedMemoryThreshold = MIN(
         (size_t)MediaBuffer::kSharedMemThreshold, (size_t)(4 * 1024));
 
+// Buffers returned to the group are listed as free without locking, in lock-free
+// stacks by size class, so that acquiring and returning a buffer only lock the
+// group when no suitable buffer is free. To find its node in the lists, each buffer
+// is observed by its own node, which forwards to the group.
 struct MediaBufferGroup::InternalData {
+    struct Node : public MediaBufferObserver {
+        InternalData *mGroup = nullptr;
+        uint32_t mIndex = 0;
+        // nullptr if the node is unused. Only changed with mLock held and the node claimed.
+        MediaBufferBase *mBuffer = nullptr;
+        std::atomic<uint32_t> mNext{kNoNode};
+        // Whether the node is in a free list, or is being taken from the free lists
+        // by a thread. A claimed buffer is only acquired if its refcount is 0.
+        std::atomic<bool> mClaimed{false};
+
+        void signalBufferReturned(MediaBufferBase *) override {
+            mGroup->onBufferReturned(this);
+        }
+    };
+
+    static constexpr uint32_t kNoNode = UINT32_MAX;
+    // Nodes are allocated in chunks of doubling size, which are never moved.
+    static constexpr size_t kFirstChunkSize = 16;
+    static constexpr size_t kNumChunks = 24;
+    // Buffers of sizes in [2^(c-1), 2^c) are in size class c.
+    static constexpr size_t kNumSizeClasses = sizeof(size_t) * 8 + 1;
+
     Mutex mLock;
     Condition mCondition;
     size_t mGrowthLimit;  // Do not automatically grow group larger than this.
-    std::list<MediaBufferBase *> mBuffers;
+    std::atomic<size_t> mNumBuffers{0};
+    // Number of threads blocked in acquire_buffer(), to be signaled when a buffer is returned.
+    std::atomic<int32_t> mNumWaiters{0};
+    std::atomic<Node *> mChunks[kNumChunks] = {};
+    uint32_t mNumNodes = 0;
+    std::vector<Node *> mUnusedNodes;
+    // The index of the first node of each free list, and a tag changed by each update
+    // against ABA.
+    std::atomic<uint64_t> mFreeLists[kNumSizeClasses] = {};
+
+    InternalData() {
+        for (std::atomic<uint64_t> &list : mFreeLists) {
+            list.store(makeHead(kNoNode, 0), std::memory_order_relaxed);
+        }
+    }
+
+    ~InternalData() {
+        for (size_t k = 0; k < kNumChunks; ++k) {
+            delete[] mChunks[k].load(std::memory_order_relaxed);
+        }
+    }
+
+    static uint64_t makeHead(uint32_t index, uint32_t tag) {
+        return (uint64_t)tag << 32 | index;
+    }
+
+    static size_t getSizeClass(size_t size) {
+        return size == 0 ? 0 : sizeof(size_t) * 8 - __builtin_clzl(size);
+    }
+
+    Node *getNode(uint32_t index) const {
+        const size_t chunk = 31 - __builtin_clz(index / kFirstChunkSize + 1);
+        const size_t offset = index - kFirstChunkSize * ((1u << chunk) - 1);
+        return &mChunks[chunk].load(std::memory_order_acquire)[offset];
+    }
+
+    template <typename F>
+    void forEachBuffer_l(F f) {
+        for (uint32_t i = 0; i < mNumNodes; ++i) {
+            Node *node = getNode(i);
+            if (node->mBuffer != nullptr) {
+                f(node);
+            }
+        }
+    }
+
+    Node *addNode_l(MediaBufferBase *buffer);
+    void removeNode_l(Node *node);
+
+    void push(Node *node);
+    Node *pop(size_t sizeClass);
+    Node *popFree(size_t requestedSize);
+
+    bool claimIfFree(Node *node);
+    void listIfFree(Node *node);
+    void collectFree_l(std::vector<Node *> *nodes);
+    void acquire(Node *node, MediaBufferBase **out);
+
+    void onBufferReturned(Node *node);
 };
 
+MediaBufferGroup::InternalData::Node *MediaBufferGroup::InternalData::addNode_l(
+        MediaBufferBase *buffer) {
+    Node *node;
+    if (!mUnusedNodes.empty()) {
+        node = mUnusedNodes.back();
+        mUnusedNodes.pop_back();
+    } else {
+        const uint32_t index = mNumNodes;
+        const size_t chunk = 31 - __builtin_clz(index / kFirstChunkSize + 1);
+        LOG_ALWAYS_FATAL_IF(chunk >= kNumChunks, "too many buffers in group");
+        if (mChunks[chunk].load(std::memory_order_relaxed) == nullptr) {
+            Node *nodes = new Node[kFirstChunkSize << chunk];
+            mChunks[chunk].store(nodes, std::memory_order_release);
+        }
+        node = getNode(index);
+        node->mGroup = this;
+        node->mIndex = index;
+        ++mNumNodes;
+    }
+    node->mBuffer = buffer;
+    node->mClaimed.store(false);
+    buffer->setObserver(node);
+    ++mNumBuffers;
+    return node;
+}
+
+// The node must be claimed.
+void MediaBufferGroup::InternalData::removeNode_l(Node *node) {
+    node->mBuffer->setObserver(nullptr);
+    node->mBuffer->release();
+    node->mBuffer = nullptr;
+    mUnusedNodes.push_back(node);
+    --mNumBuffers;
+}
+
+// The node must be claimed.
+void MediaBufferGroup::InternalData::push(Node *node) {
+    std::atomic<uint64_t> &list = mFreeLists[getSizeClass(node->mBuffer->size())];
+    uint64_t head = list.load();
+    uint64_t newHead;
+    do {
+        node->mNext.store((uint32_t)head, std::memory_order_relaxed);
+        newHead = makeHead(node->mIndex, (head >> 32) + 1);
+    } while (!list.compare_exchange_weak(head, newHead));
+}
+
+MediaBufferGroup::InternalData::Node *MediaBufferGroup::InternalData::pop(size_t sizeClass) {
+    std::atomic<uint64_t> &list = mFreeLists[sizeClass];
+    uint64_t head = list.load();
+    while ((uint32_t)head != kNoNode) {
+        // Nodes are never deleted, so that a node popped meanwhile can still be read,
+        // and the tag makes the exchange fail then.
+        Node *node = getNode((uint32_t)head);
+        const uint64_t newHead = makeHead(node->mNext.load(std::memory_order_relaxed),
+                (head >> 32) + 1);
+        if (list.compare_exchange_weak(head, newHead)) {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+// Returns a claimed free node of at least requestedSize, or nullptr if none is listed.
+MediaBufferGroup::InternalData::Node *MediaBufferGroup::InternalData::popFree(
+        size_t requestedSize) {
+    Node *tooSmall = nullptr;
+    Node *node = nullptr;
+    for (size_t sizeClass = getSizeClass(requestedSize);
+            sizeClass < kNumSizeClasses && node == nullptr; ) {
+        node = pop(sizeClass);
+        if (node == nullptr) {
+            ++sizeClass;
+            continue;
+        }
+        if (node->mBuffer->refcount() != 0) {
+            // Still referenced remotely, it is listed again by signalBufferReturned(nullptr).
+            node->mClaimed.store(false);
+            node = nullptr;
+        } else if (node->mBuffer->size() < requestedSize) {
+            // Only buffers of the first size class may be too small.
+            tooSmall = node;
+            node = nullptr;
+            ++sizeClass;
+        }
+    }
+    if (tooSmall != nullptr) {
+        push(tooSmall);
+    }
+    return node;
+}
+
+// Returns whether the node was claimed, for a buffer that was not listed as free.
+bool MediaBufferGroup::InternalData::claimIfFree(Node *node) {
+    bool claimed = false;
+    if (!node->mClaimed.compare_exchange_strong(claimed, true)) {
+        return false;
+    }
+    // Checked once claimed, as the buffer may have been acquired before.
+    if (node->mBuffer->refcount() != 0) {
+        node->mClaimed.store(false);
+        return false;
+    }
+    return true;
+}
+
+void MediaBufferGroup::InternalData::listIfFree(Node *node) {
+    if (claimIfFree(node)) {
+        push(node);
+    }
+}
+
+// Claims all free buffers, listed or not.
+void MediaBufferGroup::InternalData::collectFree_l(std::vector<Node *> *nodes) {
+    for (size_t sizeClass = 0; sizeClass < kNumSizeClasses; ++sizeClass) {
+        Node *node;
+        while ((node = pop(sizeClass)) != nullptr) {
+            if (node->mBuffer->refcount() == 0) {
+                nodes->push_back(node);
+            } else {
+                node->mClaimed.store(false);
+            }
+        }
+    }
+    forEachBuffer_l([this, nodes](Node *node) {
+        if (claimIfFree(node)) {
+            nodes->push_back(node);
+        }
+    });
+}
+
+// The node must be claimed.
+void MediaBufferGroup::InternalData::acquire(Node *node, MediaBufferBase **out) {
+    MediaBufferBase *buffer = node->mBuffer;
+    buffer->add_ref();
+    buffer->reset();
+    // Only unclaimed once referenced, so that the threads claiming it next see
+    // that it is not free.
+    node->mClaimed.store(false, std::memory_order_release);
+    *out = buffer;
+}
+
+void MediaBufferGroup::InternalData::onBufferReturned(Node *node) {
+    bool claimed = false;
+    if (node->mClaimed.compare_exchange_strong(claimed, true)) {
+        push(node);
+    }
+    if (mNumWaiters.load() > 0) {
+        Mutex::Autolock autoLock(mLock);
+        mCondition.signal();
+    }
+}
+
 MediaBufferGroup::MediaBufferGroup(size_t growthLimit)
     : mWrapper(nullptr), mInternal(new InternalData()) {
     mInternal->mGrowthLimit = growthLimit;
@@ -102,7 +340,8 @@ void MediaBufferGroup::init(size_t buffers, size_t buffer_size, size_t growthLim
 }
 
 MediaBufferGroup::~MediaBufferGroup() {
-    for (MediaBufferBase *buffer : mInternal->mBuffers) {
+    mInternal->forEachBuffer_l([](InternalData::Node *node) {
+        MediaBufferBase *buffer = node->mBuffer;
         if (buffer->refcount() != 0) {
             const int localRefcount = buffer->localRefcount();
             const int remoteRefcount = buffer->remoteRefcount();
@@ -123,7 +362,7 @@ MediaBufferGroup::~MediaBufferGroup() {
         // gracefully delete.
         buffer->setObserver(nullptr);
         buffer->release();
-    }
+    });
     delete mInternal;
     delete mWrapper;
 }
@@ -132,89 +371,102 @@ void MediaBufferGroup::add_buffer(MediaBufferBase *buffer) {
     Mutex::Autolock autoLock(mInternal->mLock);
 
     // if we're above our growth limit, release buffers if we can
-    for (auto it = mInternal->mBuffers.begin();
-            mInternal->mGrowthLimit > 0
-            && mInternal->mBuffers.size() >= mInternal->mGrowthLimit
-            && it != mInternal->mBuffers.end();) {
-        if ((*it)->refcount() == 0) {
-            (*it)->setObserver(nullptr);
-            (*it)->release();
-            it = mInternal->mBuffers.erase(it);
-        } else {
-            ++it;
+    if (mInternal->mGrowthLimit > 0 && mInternal->mNumBuffers >= mInternal->mGrowthLimit) {
+        std::vector<InternalData::Node *> free;
+        mInternal->collectFree_l(&free);
+        for (InternalData::Node *node : free) {
+            if (mInternal->mNumBuffers >= mInternal->mGrowthLimit) {
+                mInternal->removeNode_l(node);
+            } else {
+                mInternal->push(node);
+            }
         }
     }
 
-    buffer->setObserver(this);
-    mInternal->mBuffers.emplace_back(buffer);
+    mInternal->listIfFree(mInternal->addNode_l(buffer));
 }
 
 bool MediaBufferGroup::has_buffers() {
-    if (mInternal->mBuffers.size() < mInternal->mGrowthLimit) {
+    if (mInternal->mNumBuffers < mInternal->mGrowthLimit) {
         return true; // We can add more buffers internally.
     }
-    for (MediaBufferBase *buffer : mInternal->mBuffers) {
-        if (buffer->refcount() == 0) {
-            return true;
-        }
-    }
-    return false;
+    Mutex::Autolock autoLock(mInternal->mLock);
+    bool hasFree = false;
+    mInternal->forEachBuffer_l([&hasFree](InternalData::Node *node) {
+        hasFree |= node->mBuffer->refcount() == 0;
+    });
+    return hasFree;
 }
 
 status_t MediaBufferGroup::acquire_buffer(
         MediaBufferBase **out, bool nonBlocking, size_t requestedSize) {
+    InternalData::Node *node = mInternal->popFree(requestedSize);
+    if (node != nullptr) {
+        mInternal->acquire(node, out);
+        return OK;
+    }
+
     Mutex::Autolock autoLock(mInternal->mLock);
+    // A blocking caller is counted as a waiter before collecting the free buffers, so that
+    // a buffer returned meanwhile is either collected or signals mCondition, which cannot
+    // happen before we wait as it is signaled with mLock held.
+    if (!nonBlocking) {
+        ++mInternal->mNumWaiters;
+    }
     for (;;) {
-        size_t smallest = requestedSize;
+        std::vector<InternalData::Node *> free;
+        mInternal->collectFree_l(&free);
+
         size_t biggest = requestedSize;
-        MediaBufferBase *buffer = nullptr;
-        auto free = mInternal->mBuffers.end();
-        for (auto it = mInternal->mBuffers.begin(); it != mInternal->mBuffers.end(); ++it) {
-            const size_t size = (*it)->size();
-            if (size > biggest) {
-                biggest = size;
+        mInternal->forEachBuffer_l([&biggest](InternalData::Node *node) {
+            biggest = std::max(biggest, node->mBuffer->size());
+        });
+        // Reallocate the smallest free buffer if none is big enough.
+        InternalData::Node *smallest = nullptr;
+        for (InternalData::Node *candidate : free) {
+            const size_t size = candidate->mBuffer->size();
+            if (size >= requestedSize) {
+                node = candidate;
+                break;
             }
-            if ((*it)->refcount() == 0) {
-                if (size >= requestedSize) {
-                    buffer = *it;
-                    break;
-                }
-                if (size < smallest) {
-                    smallest = size; // always free the smallest buf
-                    free = it;
-                }
+            if (smallest == nullptr || size < smallest->mBuffer->size()) {
+                smallest = candidate;
             }
         }
-        if (buffer == nullptr
-                && (free != mInternal->mBuffers.end()
-                    || mInternal->mBuffers.size() < mInternal->mGrowthLimit)) {
+        if (node == nullptr
+                && (smallest != nullptr || mInternal->mNumBuffers < mInternal->mGrowthLimit)) {
             // We alloc before we free so failure leaves group unchanged.
             const size_t allocateSize = requestedSize == 0 ? biggest :
                     requestedSize < SIZE_MAX / 3 * 2 /* NB: ordering */ ?
                     requestedSize * 3 / 2 : requestedSize;
-            buffer = new MediaBuffer(allocateSize);
+            MediaBufferBase *buffer = new MediaBuffer(allocateSize);
             if (buffer->data() == nullptr) {
                 ALOGE("Allocation failure for size %zu", allocateSize);
                 delete buffer; // Invalid alloc, prefer not to call release.
-                buffer = nullptr;
+            } else if (smallest != nullptr) {
+                ALOGV("reallocate buffer, requested size %zu vs available %zu",
+                        requestedSize, smallest->mBuffer->size());
+                smallest->mBuffer->setObserver(nullptr);
+                smallest->mBuffer->release();
+                smallest->mBuffer = buffer; // in-place replace
+                buffer->setObserver(smallest);
+                node = smallest;
             } else {
-                buffer->setObserver(this);
-                if (free != mInternal->mBuffers.end()) {
-                    ALOGV("reallocate buffer, requested size %zu vs available %zu",
-                            requestedSize, (*free)->size());
-                    (*free)->setObserver(nullptr);
-                    (*free)->release();
-                    *free = buffer; // in-place replace
-                } else {
-                    ALOGV("allocate buffer, requested size %zu", requestedSize);
-                    mInternal->mBuffers.emplace_back(buffer);
-                }
+                ALOGV("allocate buffer, requested size %zu", requestedSize);
+                node = mInternal->addNode_l(buffer);
+                node->mClaimed.store(true);
+            }
+        }
+        for (InternalData::Node *candidate : free) {
+            if (candidate != node) {
+                mInternal->push(candidate);
             }
         }
-        if (buffer != nullptr) {
-            buffer->add_ref();
-            buffer->reset();
-            *out = buffer;
+        if (node != nullptr) {
+            if (!nonBlocking) {
+                --mInternal->mNumWaiters;
+            }
+            mInternal->acquire(node, out);
             return OK;
         }
         if (nonBlocking) {
@@ -228,11 +480,16 @@ status_t MediaBufferGroup::acquire_buffer(
 }
 
 size_t MediaBufferGroup::buffers() const {
-    return mInternal->mBuffers.size();
+    return mInternal->mNumBuffers;
 }
 
+// Called with nullptr when buffers may have been released remotely,
+// which is not signaled by their nodes.
 void MediaBufferGroup::signalBufferReturned(MediaBufferBase *) {
     Mutex::Autolock autoLock(mInternal->mLock);
+    mInternal->forEachBuffer_l([this](InternalData::Node *node) {
+        mInternal->listIfFree(node);
+    });
     mInternal->mCondition.signal();
 }
 
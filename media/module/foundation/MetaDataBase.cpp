@@ -17,13 +17,15 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "MetaDataBase"
 #include <inttypes.h>
-#include <utils/KeyedVector.h>
 #include <utils/Log.h>
 
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AString.h>
@@ -43,6 +45,9 @@ struct MetaDataBase::typed_data {
     typed_data(const MetaDataBase::typed_data &);
     typed_data &operator=(const MetaDataBase::typed_data &);
 
+    typed_data(MetaDataBase::typed_data &&) noexcept;
+    typed_data &operator=(MetaDataBase::typed_data &&) noexcept;
+
     void clear();
     void setData(uint32_t type, const void *data, size_t size);
     void getData(uint32_t *type, const void **data, size_t *size) const;
@@ -52,25 +57,32 @@ struct MetaDataBase::typed_data {
 private:
     uint32_t mType;
     size_t mSize;
+    // size of ext_data, or 0 if the data is in the reservoir.
+    size_t mCapacity;
 
+    // Values of the fixed size types are stored in the reservoir. Other data is
+    // only stored there if it is small, as before, so that pointers to strings and
+    // buffers are not invalidated by setting other keys.
     union {
         void *ext_data;
-        float reservoir;
+        int64_t reservoir[2];
     } u;
 
+    static bool fitsReservoir(uint32_t type, size_t size);
+
     bool usesReservoir() const {
-        return mSize <= sizeof(u.reservoir);
+        return mCapacity == 0;
     }
 
-    void *allocateStorage(size_t size);
+    void *allocateStorage(uint32_t type, size_t size);
     void freeStorage();
 
     void *storage() {
-        return usesReservoir() ? &u.reservoir : u.ext_data;
+        return usesReservoir() ? u.reservoir : u.ext_data;
     }
 
     const void *storage() const {
-        return usesReservoir() ? &u.reservoir : u.ext_data;
+        return usesReservoir() ? u.reservoir : u.ext_data;
     }
 };
 
@@ -80,8 +92,28 @@ struct MetaDataBase::Rect {
 
 
 struct MetaDataBase::MetaDataInternal {
+    struct Item {
+        uint32_t mKey;
+        typed_data mData;
+    };
+
     std::mutex mLock;
-    KeyedVector<uint32_t, MetaDataBase::typed_data> mItems;
+    // sorted by key.
+    std::vector<Item> mItems;
+
+    static bool isBefore(const Item &item, uint32_t key) {
+        return item.mKey < key;
+    }
+
+    // Returns the item of key, or the position where to insert it.
+    std::vector<Item>::iterator lowerBound(uint32_t key) {
+        return std::lower_bound(mItems.begin(), mItems.end(), key, isBefore);
+    }
+
+    const typed_data *find(uint32_t key) const {
+        auto it = std::lower_bound(mItems.begin(), mItems.end(), key, isBefore);
+        return (it != mItems.end() && it->mKey == key) ? &it->mData : nullptr;
+    }
 };
 
 
@@ -94,8 +126,12 @@ MetaDataBase::MetaDataBase(const MetaDataBase &from)
     mInternalData->mItems = from.mInternalData->mItems;
 }
 
+// Reuses the memory of the items already in this, which makes copying into
+// a recycled MetaDataBase mostly free of allocations.
 MetaDataBase& MetaDataBase::operator = (const MetaDataBase &rhs) {
-    this->mInternalData->mItems = rhs.mInternalData->mItems;
+    if (this != &rhs) {
+        this->mInternalData->mItems = rhs.mInternalData->mItems;
+    }
     return *this;
 }
 
@@ -109,15 +145,20 @@ void MetaDataBase::clear() {
     mInternalData->mItems.clear();
 }
 
+void MetaDataBase::reserve(size_t numItems) {
+    std::lock_guard<std::mutex> guard(mInternalData->mLock);
+    mInternalData->mItems.reserve(numItems);
+}
+
 bool MetaDataBase::remove(uint32_t key) {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
+    auto it = mInternalData->lowerBound(key);
 
-    if (i < 0) {
+    if (it == mInternalData->mItems.end() || it->mKey != key) {
         return false;
     }
 
-    mInternalData->mItems.removeItemsAt(i);
+    mInternalData->mItems.erase(it);
 
     return true;
 }
@@ -258,17 +299,14 @@ bool MetaDataBase::setData(
     bool overwrote_existing = true;
 
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
-    if (i < 0) {
-        typed_data item;
-        i = mInternalData->mItems.add(key, item);
+    auto it = mInternalData->lowerBound(key);
+    if (it == mInternalData->mItems.end() || it->mKey != key) {
+        it = mInternalData->mItems.insert(it, MetaDataInternal::Item{key, typed_data()});
 
         overwrote_existing = false;
     }
 
-    typed_data &item = mInternalData->mItems.editValueAt(i);
-
-    item.setData(type, data, size);
+    it->mData.setData(type, data, size);
 
     return overwrote_existing;
 }
@@ -276,33 +314,26 @@ bool MetaDataBase::setData(
 bool MetaDataBase::findData(uint32_t key, uint32_t *type,
                         const void **data, size_t *size) const {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
+    const typed_data *item = mInternalData->find(key);
 
-    if (i < 0) {
+    if (item == nullptr) {
         return false;
     }
 
-    const typed_data &item = mInternalData->mItems.valueAt(i);
-
-    item.getData(type, data, size);
+    item->getData(type, data, size);
 
     return true;
 }
 
 bool MetaDataBase::hasData(uint32_t key) const {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
-    ssize_t i = mInternalData->mItems.indexOfKey(key);
-
-    if (i < 0) {
-        return false;
-    }
-
-    return true;
+    return mInternalData->find(key) != nullptr;
 }
 
 MetaDataBase::typed_data::typed_data()
     : mType(0),
-      mSize(0) {
+      mSize(0),
+      mCapacity(0) {
 }
 
 MetaDataBase::typed_data::~typed_data() {
@@ -310,24 +341,39 @@ MetaDataBase::typed_data::~typed_data() {
 }
 
 MetaDataBase::typed_data::typed_data(const typed_data &from)
-    : mType(from.mType),
-      mSize(0) {
+    : mType(0),
+      mSize(0),
+      mCapacity(0) {
+    setData(from.mType, from.storage(), from.mSize);
+}
 
-    void *dst = allocateStorage(from.mSize);
-    if (dst) {
-        memcpy(dst, from.storage(), mSize);
+MetaDataBase::typed_data &MetaDataBase::typed_data::operator=(
+        const MetaDataBase::typed_data &from) {
+    if (this != &from) {
+        setData(from.mType, from.storage(), from.mSize);
     }
+
+    return *this;
+}
+
+MetaDataBase::typed_data::typed_data(typed_data &&from) noexcept
+    : mType(from.mType),
+      mSize(from.mSize),
+      mCapacity(from.mCapacity),
+      u(from.u) {
+    from.mType = 0;
+    from.mSize = 0;
+    from.mCapacity = 0;
 }
 
 MetaDataBase::typed_data &MetaDataBase::typed_data::operator=(
-        const MetaDataBase::typed_data &from) {
+        MetaDataBase::typed_data &&from) noexcept {
     if (this != &from) {
         clear();
-        mType = from.mType;
-        void *dst = allocateStorage(from.mSize);
-        if (dst) {
-            memcpy(dst, from.storage(), mSize);
-        }
+        std::swap(mType, from.mType);
+        std::swap(mSize, from.mSize);
+        std::swap(mCapacity, from.mCapacity);
+        std::swap(u, from.u);
     }
 
     return *this;
@@ -341,11 +387,9 @@ void MetaDataBase::typed_data::clear() {
 
 void MetaDataBase::typed_data::setData(
         uint32_t type, const void *data, size_t size) {
-    clear();
-
     mType = type;
 
-    void *dst = allocateStorage(size);
+    void *dst = allocateStorage(type, size);
     if (dst) {
         memcpy(dst, data, size);
     }
@@ -358,27 +402,46 @@ void MetaDataBase::typed_data::getData(
     *data = storage();
 }
 
-void *MetaDataBase::typed_data::allocateStorage(size_t size) {
-    mSize = size;
+// static
+bool MetaDataBase::typed_data::fitsReservoir(uint32_t type, size_t size) {
+    switch (type) {
+        case TYPE_INT32:
+        case TYPE_INT64:
+        case TYPE_FLOAT:
+        case TYPE_POINTER:
+        case TYPE_RECT:
+            return size <= sizeof(u.reservoir);
+        default:
+            return size <= sizeof(float);
+    }
+}
 
-    if (usesReservoir()) {
-        return &u.reservoir;
+// Reuses the current external storage if it is large enough.
+void *MetaDataBase::typed_data::allocateStorage(uint32_t type, size_t size) {
+    if (fitsReservoir(type, size)) {
+        freeStorage();
+        mSize = size;
+        return u.reservoir;
     }
 
-    u.ext_data = malloc(mSize);
-    if (u.ext_data == NULL) {
-        ALOGE("Couldn't allocate %zu bytes for item", size);
-        mSize = 0;
+    if (size > mCapacity) {
+        freeStorage();
+        u.ext_data = malloc(size);
+        if (u.ext_data == NULL) {
+            ALOGE("Couldn't allocate %zu bytes for item", size);
+            return NULL;
+        }
+        mCapacity = size;
     }
+    mSize = size;
     return u.ext_data;
 }
 
 void MetaDataBase::typed_data::freeStorage() {
     if (!usesReservoir()) {
-        if (u.ext_data) {
-            free(u.ext_data);
-            u.ext_data = NULL;
-        }
+        free(u.ext_data);
+        u.ext_data = NULL;
+        mCapacity = 0;
     }
 
     mSize = 0;
@@ -439,10 +502,10 @@ String8 MetaDataBase::toString() const {
     String8 s;
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
     for (int i = mInternalData->mItems.size(); --i >= 0;) {
-        int32_t key = mInternalData->mItems.keyAt(i);
+        int32_t key = mInternalData->mItems[i].mKey;
         char cc[5];
         MakeFourCCString(key, cc);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
+        const typed_data &item = mInternalData->mItems[i].mData;
         s.appendFormat("%s: %s", cc, item.asString(false).c_str());
         if (i != 0) {
             s.append(", ");
@@ -454,10 +517,10 @@ String8 MetaDataBase::toString() const {
 void MetaDataBase::dumpToLog() const {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
     for (int i = mInternalData->mItems.size(); --i >= 0;) {
-        int32_t key = mInternalData->mItems.keyAt(i);
+        int32_t key = mInternalData->mItems[i].mKey;
         char cc[5];
         MakeFourCCString(key, cc);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
+        const typed_data &item = mInternalData->mItems[i].mData;
         ALOGI("%s: %s", cc, item.asString(true /* verbose */).c_str());
     }
 }
@@ -472,8 +535,8 @@ status_t MetaDataBase::writeToParcel(Parcel &parcel) {
         return ret;
     }
     for (size_t i = 0; i < numItems; i++) {
-        int32_t key = mInternalData->mItems.keyAt(i);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
+        int32_t key = mInternalData->mItems[i].mKey;
+        const typed_data &item = mInternalData->mItems[i].mData;
         uint32_t type;
         const void *data;
         size_t size;
@@ -28,6 +28,14 @@
 #include <media/stagefright/MetaData.h>
 #include <utils/misc.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#define USE_NEON_START_CODE 1
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#define USE_SSE2_START_CODE 1
+#include <emmintrin.h>
+#endif
+
 namespace android {
 
 unsigned parseUE(ABitReader *br) {
@@ -288,6 +296,47 @@ void FindAVCDimensions(
     }
 }
 
+// Returns the offset of the first 0x00 0x00 0x01 start code in data at or after offset,
+// or size if there is none.
+static size_t findStartCode(const uint8_t *data, size_t size, size_t offset) {
+#if defined(USE_NEON_START_CODE) || defined(USE_SSE2_START_CODE)
+    // Compare 16 candidate positions at once. Start codes are rare in coded data,
+    // so most blocks are skipped without looking at single bytes.
+    static constexpr size_t kBlockSize = 16;
+    for (; offset + kBlockSize + 2 <= size; offset += kBlockSize) {
+        const uint8_t *p = &data[offset];
+#if defined(USE_NEON_START_CODE)
+        const uint8x16_t match = vandq_u8(
+                vandq_u8(vceqq_u8(vld1q_u8(p), vdupq_n_u8(0)),
+                         vceqq_u8(vld1q_u8(p + 1), vdupq_n_u8(0))),
+                vceqq_u8(vld1q_u8(p + 2), vdupq_n_u8(1)));
+        const uint64x2_t match64 = vreinterpretq_u64_u8(match);
+        if ((vgetq_lane_u64(match64, 0) | vgetq_lane_u64(match64, 1)) != 0) {
+            break;  // the scalar loop below finds it
+        }
+#else
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i match = _mm_and_si128(
+                _mm_and_si128(
+                        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), zero),
+                        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 1)), zero)),
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 2)), _mm_set1_epi8(1)));
+        const int mask = _mm_movemask_epi8(match);
+        if (mask != 0) {
+            return offset + __builtin_ctz(mask);
+        }
+#endif
+    }
+#endif
+    for (; offset + 2 < size; ++offset) {
+        if (data[offset + 2] == 0x01 && data[offset] == 0x00
+                && data[offset + 1] == 0x00) {
+            return offset;
+        }
+    }
+    return size;
+}
+
 status_t getNextNALUnit(
         const uint8_t **_data, size_t *_size,
         const uint8_t **nalStart, size_t *nalSize,
@@ -302,17 +351,10 @@ status_t getNextNALUnit(
         return -EAGAIN;
     }
 
-    size_t offset = 0;
-
     // A valid startcode consists of at least two 0x00 bytes followed by 0x01.
-    for (; offset + 2 < size; ++offset) {
-        if (data[offset + 2] == 0x01 && data[offset] == 0x00
-                && data[offset + 1] == 0x00) {
-            break;
-        }
-    }
-    if (offset + 2 >= size) {
-        *_data = &data[offset];
+    size_t offset = findStartCode(data, size, 0);
+    if (offset == size) {
+        *_data = &data[size - 2];
         *_size = 2;
         return -EAGAIN;
     }
@@ -320,25 +362,15 @@ status_t getNextNALUnit(
 
     size_t startOffset = offset;
 
-    for (;;) {
-        while (offset < size && data[offset] != 0x01) {
-            ++offset;
-        }
-
-        if (offset == size) {
-            if (startCodeFollows) {
-                offset = size + 2;
-                break;
-            }
-
+    // offset is set to the 0x01 byte of the next start code.
+    offset = findStartCode(data, size, startOffset);
+    if (offset == size) {
+        if (!startCodeFollows) {
             return -EAGAIN;
         }
-
-        if (data[offset - 1] == 0x00 && data[offset - 2] == 0x00) {
-            break;
-        }
-
-        ++offset;
+        offset = size + 2;
+    } else {
+        offset += 2;
     }
 
     size_t endOffset = offset - 2;
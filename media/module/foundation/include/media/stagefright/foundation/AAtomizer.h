@@ -31,15 +31,20 @@ namespace android {
 struct AAtomizer {
     static const char *Atomize(const char *name);
 
+    // As Atomize(), but returns NULL instead of adding a new atom once there
+    // are maxNumAtoms atoms.
+    static const char *Atomize(const char *name, size_t maxNumAtoms);
+
 private:
     static AAtomizer gAtomizer;
 
     Mutex mLock;
     Vector<List<AString> > mAtoms;
+    size_t mNumAtoms;
 
     AAtomizer();
 
-    const char *atomize(const char *name);
+    const char *atomize(const char *name, size_t maxNumAtoms);
 
     static uint32_t Hash(const char *s);
 
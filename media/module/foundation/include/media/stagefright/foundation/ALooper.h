@@ -26,6 +26,9 @@
 #include <utils/RefBase.h>
 #include <utils/threads.h>
 
+#include <unordered_map>
+#include <vector>
+
 namespace android {
 
 struct AHandler;
@@ -69,8 +72,15 @@ private:
 
     struct Event {
         int64_t mWhenUs;
+        // orders events of the same mWhenUs by the time they were posted.
+        uint64_t mSequence;
         sp<AMessage> mMessage;
         sp<RefBase> mToken;
+
+        bool isBefore(const Event &other) const {
+            return mWhenUs < other.mWhenUs
+                    || (mWhenUs == other.mWhenUs && mSequence < other.mSequence);
+        }
     };
 
     Mutex mLock;
@@ -78,7 +88,11 @@ private:
 
     AString mName;
 
-    List<Event> mEventQueue;
+    // Binary min-heap of the pending events, the next one to deliver first.
+    std::vector<Event> mEventQueue;
+    // Index in mEventQueue of the event posted with each postUnique() token.
+    std::unordered_map<RefBase *, size_t> mTokenIndices;
+    uint64_t mNextEventSequence;
 
     struct LooperThread;
     sp<LooperThread> mThread;
@@ -110,6 +124,17 @@ private:
 
     // END --- methods used only by AMessage
 
+    // Adds event to mEventQueue, returns true if it is the next one to deliver.
+    bool pushEvent_l(Event &&event);
+    // Removes the event at index of mEventQueue and returns it.
+    Event removeEvent_l(size_t index);
+    // Moves the event at index towards the front or the back of mEventQueue,
+    // to restore the heap order.
+    void siftUp_l(size_t index);
+    void siftDown_l(size_t index);
+    // Stores event at index of mEventQueue, keeping mTokenIndices up to date.
+    void setEvent_l(size_t index, Event &&event);
+
     bool loop();
 
     DISALLOW_EVIL_CONSTRUCTORS(ALooper);
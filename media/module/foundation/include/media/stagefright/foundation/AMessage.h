@@ -180,6 +180,10 @@ struct AMessage : public RefBase {
 
     AString debugString(int32_t indent = 0) const;
 
+    // The memory of freed messages is kept by each thread for its next messages.
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     enum Type {
         kTypeInt32,
         kTypeInt64,
@@ -310,15 +314,48 @@ private:
         const char *mName;
         size_t      mNameLength;
         Type mType;
+        // mName is interned by AAtomizer rather than owned by the item.
+        bool mNameIsAtom;
         void setName(const char *name, size_t len);
-        Item() : mName(nullptr), mNameLength(0), mType(kTypeInt32) { }
-        Item(const char *name, size_t length);
+        void freeName();
+        Item() : mName(nullptr), mNameLength(0), mType(kTypeInt32), mNameIsAtom(false) { }
     };
 
     enum {
-        kMaxNumItems = 256
+        kMaxNumItems = 256,
+        // Items of messages with up to this many items are stored in the message itself.
+        kNumInlineItems = 8,
+    };
+
+    // The subset of std::vector<Item> used by AMessage, without allocation for
+    // up to kNumInlineItems items. Like std::vector<Item>, it copies items shallowly.
+    struct ItemList {
+        ItemList() : mData(mInlineItems), mSize(0), mCapacity(kNumInlineItems) { }
+        ~ItemList();
+        ItemList &operator=(const ItemList &other);
+
+        size_t size() const { return mSize; }
+        Item &operator[](size_t index) { return mData[index]; }
+        const Item &operator[](size_t index) const { return mData[index]; }
+        Item *begin() { return mData; }
+        Item *end() { return mData + mSize; }
+        const Item *begin() const { return mData; }
+        const Item *end() const { return mData + mSize; }
+
+        // New items are default constructed.
+        void resize(size_t size);
+        void pop_back() { --mSize; }
+        void clear() { mSize = 0; }
+
+    private:
+        Item *mData;
+        size_t mSize;
+        size_t mCapacity;
+        Item mInlineItems[kNumInlineItems];
+
+        ItemList(const ItemList &) = delete;
     };
-    std::vector<Item> mItems;
+    ItemList mItems;
 
     /**
      * Allocates an item with the given key |name|. If the key already exists, the corresponding
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures posting to an ALooper with many pending delayed messages, as a
+// NuPlayer or MediaCodec looper has under load.
+
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+using namespace android;
+
+static constexpr int64_t kPendingDelayUs = 100000000;
+
+class DeliveryHandler : public AHandler {
+public:
+    void waitForDelivery() {
+        std::unique_lock lock(mLock);
+        mCondition.wait(lock, [this] { return mDelivered; });
+        mDelivered = false;
+    }
+
+protected:
+    void onMessageReceived(const sp<AMessage> &) override {
+        std::lock_guard lock(mLock);
+        mDelivered = true;
+        mCondition.notify_one();
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    bool mDelivered = false;
+};
+
+// Posts messages that will not be delivered during the benchmark, with delays
+// of 100 to 200 seconds in random order.
+static std::vector<sp<AMessage>> postPending(const sp<AHandler> &handler, size_t count,
+        bool unique) {
+    std::mt19937 random(42);
+    std::vector<sp<AMessage>> msgs;
+    for (size_t i = 0; i < count; ++i) {
+        sp<AMessage> msg = new AMessage(0, handler);
+        const int64_t delayUs = kPendingDelayUs + random() % kPendingDelayUs;
+        if (unique) {
+            msg->postUnique(msg /* token */, delayUs);
+        } else {
+            msg->post(delayUs);
+        }
+        msgs.push_back(msg);
+    }
+    return msgs;
+}
+
+// Reschedules one of the pending messages per iteration, as done for timeouts.
+// Args: number of pending messages.
+static void BM_PostUnique(benchmark::State& state) {
+    sp<ALooper> looper = new ALooper;
+    sp<DeliveryHandler> handler = new DeliveryHandler;
+    looper->registerHandler(handler);
+    const std::vector<sp<AMessage>> msgs = postPending(handler, state.range(0), true);
+
+    std::mt19937 random(43);
+    size_t index = 0;
+    for (auto _ : state) {
+        const sp<AMessage> &msg = msgs[index];
+        msg->postUnique(msg, kPendingDelayUs + random() % kPendingDelayUs);
+        if (++index == msgs.size()) {
+            index = 0;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    looper->unregisterHandler(handler->id());
+}
+
+BENCHMARK(BM_PostUnique)->RangeMultiplier(4)->Range(1, 4096);
+
+// Posts a message without delay and waits until it is delivered by the looper thread.
+// Args: number of pending messages.
+static void BM_PostAndDeliver(benchmark::State& state) {
+    sp<ALooper> looper = new ALooper;
+    looper->setName("BM_PostAndDeliver");
+    sp<DeliveryHandler> handler = new DeliveryHandler;
+    looper->registerHandler(handler);
+    postPending(handler, state.range(0), false);
+    looper->start();
+
+    sp<AMessage> msg = new AMessage(0, handler);
+    for (auto _ : state) {
+        msg->post();
+        handler->waitForDelivery();
+    }
+    state.SetItemsProcessed(state.iterations());
+    looper->stop();
+    looper->unregisterHandler(handler->id());
+}
+
+BENCHMARK(BM_PostAndDeliver)->RangeMultiplier(8)->Range(1, 4096)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures creating, filling, querying, duplicating and posting messages of
+// a typical size, as MediaCodec and NuPlayer do for each buffer.
+
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+using namespace android;
+
+static const char *const kNames[] = {
+    "index", "offset", "size", "timeUs", "flags", "generation",
+};
+
+static sp<AMessage> makeMessage(const sp<AHandler> &handler = nullptr) {
+    sp<AMessage> msg = new AMessage(0, handler);
+    for (size_t i = 0; i < std::size(kNames); ++i) {
+        msg->setInt32(kNames[i], i);
+    }
+    return msg;
+}
+
+static void BM_SetInt32(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(makeMessage());
+    }
+    state.SetItemsProcessed(state.iterations() * std::size(kNames));
+}
+
+BENCHMARK(BM_SetInt32);
+
+static void BM_FindInt32(benchmark::State& state) {
+    const sp<AMessage> msg = makeMessage();
+    for (auto _ : state) {
+        for (const char *name : kNames) {
+            int32_t value;
+            benchmark::DoNotOptimize(msg->findInt32(name, &value));
+            benchmark::DoNotOptimize(value);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * std::size(kNames));
+}
+
+BENCHMARK(BM_FindInt32);
+
+static void BM_Dup(benchmark::State& state) {
+    const sp<AMessage> msg = makeMessage();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(msg->dup());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_Dup);
+
+class DeliveryHandler : public AHandler {
+public:
+    void waitForDelivery() {
+        std::unique_lock lock(mLock);
+        mCondition.wait(lock, [this] { return mDelivered; });
+        mDelivered = false;
+    }
+
+protected:
+    void onMessageReceived(const sp<AMessage> &msg) override {
+        int32_t value;
+        msg->findInt32("timeUs", &value);
+        std::lock_guard lock(mLock);
+        mDelivered = true;
+        mCondition.notify_one();
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    bool mDelivered = false;
+};
+
+// Creates a message, posts it, and waits until it is delivered by the looper thread,
+// which releases it.
+static void BM_Post(benchmark::State& state) {
+    sp<ALooper> looper = new ALooper;
+    looper->setName("BM_Post");
+    sp<DeliveryHandler> handler = new DeliveryHandler;
+    looper->registerHandler(handler);
+    looper->start();
+
+    for (auto _ : state) {
+        makeMessage(handler)->post();
+        handler->waitForDelivery();
+    }
+    state.SetItemsProcessed(state.iterations());
+    looper->stop();
+    looper->unregisterHandler(handler->id());
+}
+
+BENCHMARK(BM_Post)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -17,10 +17,16 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "AData_test"
 
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <utils/RefBase.h>
 
+#include <media/stagefright/foundation/AAtomizer.h>
+#include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AHandler.h>
 #include <media/stagefright/foundation/ALooper.h>
@@ -327,6 +333,46 @@ TEST(AMessage_tests, deliversUniqueMessageOnce) {
   nanosleep(&millis100, nullptr); // just enough time for the looper thread to run
 }
 
+// Messages of the same time are delivered in the order they were posted, including a unique
+// message rescheduled among them.
+TEST(AMessage_tests, deliversMessagesOfSameTimeInPostingOrder) {
+  sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
+  sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
+  looper->registerHandler(mockHandler);
+
+  std::vector<sp<AMessage>> msgs;
+  for (int i = 0; i < 20; ++i) {
+    msgs.push_back(new AMessage(i, mockHandler));
+  }
+  sp<AMessage> uniqueMsg = new AMessage(20, mockHandler);
+  uniqueMsg->postUnique(uniqueMsg, 25);
+  // Post in decreasing then increasing delays, so that the order depends on the queue.
+  for (int i = 0; i < 10; ++i) {
+    msgs[i]->post(50 - 5 * (i % 2));
+  }
+  uniqueMsg->postUnique(uniqueMsg, 45); // after msgs[1, 3, .. 9]
+  for (int i = 10; i < 20; ++i) {
+    msgs[i]->post(50 - 5 * (i % 2));
+  }
+
+  looper->setClockUs(100);
+  {
+    InSequence inSequence;
+    for (int i = 1; i < 10; i += 2) {
+      EXPECT_CALL(*mockHandler, onMessageReceived(msgs[i])).Times(1);
+    }
+    EXPECT_CALL(*mockHandler, onMessageReceived(uniqueMsg)).Times(1);
+    for (int i = 11; i < 20; i += 2) {
+      EXPECT_CALL(*mockHandler, onMessageReceived(msgs[i])).Times(1);
+    }
+    for (int i = 0; i < 20; i += 2) {
+      EXPECT_CALL(*mockHandler, onMessageReceived(msgs[i])).Times(1);
+    }
+  }
+  looper->start();
+  nanosleep(&millis100, nullptr); // just enough time for the looper thread to run
+}
+
 TEST(AMessage_tests, postUnique_withNullToken_returnsInvalidArgument) {
   sp<NiceMock<MockHandler>> mockHandler = new NiceMock<MockHandler>;
   sp<ALooper> looper = new ALooper();
@@ -335,3 +381,206 @@ TEST(AMessage_tests, postUnique_withNullToken_returnsInvalidArgument) {
   sp<AMessage> msg = new AMessage(0, mockHandler);
   EXPECT_EQ(msg->postUnique(nullptr, 0), -EINVAL);
 }
+
+// Mirror the private limits of AMessage.
+constexpr size_t kNumInlineItems = 8;
+constexpr size_t kMaxNameAtomLength = 63;
+constexpr size_t kMaxNumNameAtoms = 4096;
+
+static std::string itemName(const char *prefix, size_t i) {
+  return prefix + std::to_string(i);
+}
+
+static void expectInt32Items(const sp<AMessage> &msg, const char *prefix,
+        const std::vector<size_t> &indices) {
+  ASSERT_EQ(indices.size(), msg->countEntries());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    const std::string name = itemName(prefix, indices[i]);
+    AMessage::Type type;
+    EXPECT_STREQ(name.c_str(), msg->getEntryNameAt(i, &type));
+    EXPECT_EQ(AMessage::kTypeInt32, type);
+    int32_t value;
+    EXPECT_TRUE(msg->findInt32(name.c_str(), &value)) << name;
+    EXPECT_EQ((int32_t)indices[i], value) << name;
+  }
+}
+
+// Items are stored in the message up to kNumInlineItems, then in an allocated array.
+TEST(AMessage_tests, itemsBeyondInlineItems) {
+  sp<AMessage> msg = new AMessage();
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < 3 * kNumInlineItems; ++i) {
+    msg->setInt32(itemName("item", i).c_str(), i);
+    indices.push_back(i);
+  }
+  expectInt32Items(msg, "item", indices);
+
+  // Setting existing items replaces them.
+  msg->setInt32("item0", 0);
+  msg->setInt32(itemName("item", 3 * kNumInlineItems - 1).c_str(), 3 * kNumInlineItems - 1);
+  expectInt32Items(msg, "item", indices);
+
+  // Removal moves the last item in place of the removed one, down to fewer than
+  // kNumInlineItems items.
+  while (indices.size() > kNumInlineItems / 2) {
+    const size_t index = indices.size() % 3 == 0 ? indices.size() - 1 : indices.size() / 3;
+    EXPECT_EQ(OK, msg->removeEntryAt(index));
+    indices[index] = indices.back();
+    indices.pop_back();
+    expectInt32Items(msg, "item", indices);
+  }
+  EXPECT_EQ(BAD_INDEX, msg->removeEntryAt(indices.size()));
+
+  for (size_t i = 100; i < 100 + 2 * kNumInlineItems; ++i) {
+    msg->setInt32(itemName("item", i).c_str(), i);
+    indices.push_back(i);
+  }
+  expectInt32Items(msg, "item", indices);
+
+  msg->clear();
+  EXPECT_EQ(0, msg->countEntries());
+  int32_t value;
+  EXPECT_FALSE(msg->findInt32("item0", &value));
+}
+
+TEST(AMessage_tests, dupCopiesItems) {
+  for (size_t count : {kNumInlineItems / 2, 3 * kNumInlineItems}) {
+    sp<AMessage> msg = new AMessage();
+    msg->setWhat(1234);
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < count; ++i) {
+      msg->setInt32(itemName("item", i).c_str(), i);
+      indices.push_back(i);
+    }
+    sp<AMessage> nested = new AMessage();
+    nested->setInt32("nestedItem", 42);
+    msg->setMessage("nested", nested);
+    msg->setString("string", "hello");
+    sp<ABuffer> buffer = new ABuffer(16);
+    msg->setBuffer("buffer", buffer);
+
+    sp<AMessage> copy = msg->dup();
+    EXPECT_EQ(1234u, copy->what());
+    EXPECT_EQ(count + 3, copy->countEntries());
+
+    // The copy does not change with the original.
+    msg->setInt32("item0", -1);
+    msg->removeEntryByName("string");
+    nested->setInt32("nestedItem", -1);
+
+    ASSERT_EQ(OK, copy->removeEntryByName("nested"));
+    ASSERT_EQ(OK, copy->removeEntryByName("buffer"));
+    AString string;
+    EXPECT_TRUE(copy->findString("string", &string));
+    EXPECT_EQ(AString("hello"), string);
+    ASSERT_EQ(OK, copy->removeEntryByName("string"));
+    expectInt32Items(copy, "item", indices);
+
+    // Messages are copied deeply, buffers are shared.
+    copy = msg->dup();
+    sp<AMessage> nestedCopy;
+    ASSERT_TRUE(copy->findMessage("nested", &nestedCopy));
+    EXPECT_NE(nested, nestedCopy);
+    int32_t value;
+    EXPECT_TRUE(nestedCopy->findInt32("nestedItem", &value));
+    EXPECT_EQ(-1, value);
+    sp<ABuffer> bufferCopy;
+    ASSERT_TRUE(copy->findBuffer("buffer", &bufferCopy));
+    EXPECT_EQ(buffer, bufferCopy);
+  }
+}
+
+// The memory of deleted messages is reused by the thread, messages must still start empty.
+TEST(AMessage_tests, reusedMessagesStartEmpty) {
+  auto useMessages = [] {
+    for (size_t round = 0; round < 4; ++round) {
+      std::vector<sp<AMessage>> msgs;
+      for (size_t i = 0; i < 100; ++i) {
+        sp<AMessage> msg = new AMessage();
+        EXPECT_EQ(0, msg->countEntries());
+        EXPECT_EQ(0u, msg->what());
+        const size_t count = (i % 2) ? kNumInlineItems + round : round;
+        for (size_t j = 0; j < count; ++j) {
+          msg->setInt32(itemName("item", j).c_str(), j);
+        }
+        msg->setString("string", "a string long enough not to be stored inline");
+        msgs.push_back(msg);
+      }
+      // Delete in a different order than allocated.
+      for (size_t i = 0; i < msgs.size(); i += 2) {
+        msgs[i].clear();
+      }
+    }
+  };
+  useMessages();
+  // Messages freed by a thread are released when it exits.
+  std::thread(useMessages).join();
+}
+
+TEST(AMessage_tests, longNames) {
+  sp<AMessage> msg = new AMessage();
+  const std::string longName(kMaxNameAtomLength + 1, 'x');
+  const std::string otherLongName = longName.substr(1) + 'y';
+  const std::string veryLongName(1000, 'z');
+  msg->setInt32(longName.c_str(), 1);
+  msg->setInt32(veryLongName.c_str(), 2);
+  msg->setInt32("short", 3);
+  msg->setInt32(longName.c_str(), 4);  // replaces
+  EXPECT_EQ(3, msg->countEntries());
+
+  int32_t value;
+  EXPECT_TRUE(msg->findInt32(std::string(longName).c_str(), &value));
+  EXPECT_EQ(4, value);
+  EXPECT_TRUE(msg->findInt32(veryLongName.c_str(), &value));
+  EXPECT_EQ(2, value);
+  EXPECT_FALSE(msg->findInt32(otherLongName.c_str(), &value));
+
+  sp<AMessage> copy = msg->dup();
+  EXPECT_TRUE(copy->findInt32(longName.c_str(), &value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(OK, msg->removeEntryByName(longName.c_str()));
+  EXPECT_TRUE(copy->findInt32(longName.c_str(), &value));
+}
+
+// Fills the atomizer of the process, so names are copied in the tests after this one.
+TEST(AMessage_tests, namesBeyondMaxNumNameAtoms) {
+  static const char *const kLateName = "AMessage_tests_lateName";
+  // More distinct names than kMaxNumNameAtoms, so that later names are copied.
+  constexpr size_t kItemsPerMessage = 200;
+  std::vector<sp<AMessage>> msgs;
+  for (size_t i = 0; i <= kMaxNumNameAtoms; ++i) {
+    if (i % kItemsPerMessage == 0) {
+      msgs.push_back(new AMessage());
+    }
+    msgs.back()->setInt32(itemName("atomFiller", i).c_str(), i);
+  }
+  sp<AMessage> msg = new AMessage();
+  msg->setInt32(kLateName, 1);
+  msg->setInt32("AMessage_tests_otherLateName", 2);
+  for (size_t i = 0; i < msgs.size(); ++i) {
+    int32_t value;
+    const size_t index = i * kItemsPerMessage + kItemsPerMessage / 2;
+    if (index <= kMaxNumNameAtoms) {
+      EXPECT_TRUE(msgs[i]->findInt32(itemName("atomFiller", index).c_str(), &value));
+      EXPECT_EQ((int32_t)index, value);
+    }
+  }
+
+  // kLateName gets an atom elsewhere, and this thread then caches it.
+  AAtomizer::Atomize(kLateName);
+  sp<AMessage> other = new AMessage();
+  other->setInt32(kLateName, 3);
+
+  // The item named with a copy is still found, and replaced rather than added.
+  int32_t value;
+  EXPECT_TRUE(msg->findInt32(kLateName, &value));
+  EXPECT_EQ(1, value);
+  msg->setInt32(kLateName, 4);
+  EXPECT_EQ(2, msg->countEntries());
+  EXPECT_TRUE(msg->findInt32(kLateName, &value));
+  EXPECT_EQ(4, value);
+  EXPECT_TRUE(other->findInt32(kLateName, &value));
+  EXPECT_EQ(3, value);
+  EXPECT_TRUE(msg->findInt32("AMessage_tests_otherLateName", &value));
+  EXPECT_EQ(2, value);
+}
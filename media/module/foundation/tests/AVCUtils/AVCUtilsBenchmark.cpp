@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the throughput of splitting an access unit into NAL units with
+// getNextNALUnit(), as done by ElementaryStreamQueue for each H.264 access unit.
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/foundation/avc_utils.h>
+
+using namespace android;
+
+// Args: access unit size, number of NAL units in it.
+static void BM_GetNextNALUnit(benchmark::State& state) {
+    const size_t size = state.range(0);
+    const size_t nalCount = state.range(1);
+    // Coded slice data has no start code emulation, and few zero bytes.
+    std::vector<uint8_t> accessUnit(size);
+    for (size_t i = 0; i < size; ++i) {
+        accessUnit[i] = (i % 61 == 0) ? 0x00 : 0x80 | (i & 0x7f);
+    }
+    for (size_t i = 0; i < nalCount; ++i) {
+        uint8_t *nal = &accessUnit[i * (size / nalCount)];
+        nal[0] = 0x00;
+        nal[1] = 0x00;
+        nal[2] = 0x00;
+        nal[3] = 0x01;
+        nal[4] = 0x41;  // non-IDR slice
+    }
+
+    size_t nals = 0;
+    for (auto _ : state) {
+        const uint8_t *data = accessUnit.data();
+        size_t dataSize = accessUnit.size();
+        const uint8_t *nalStart;
+        size_t nalSize;
+        while (getNextNALUnit(&data, &dataSize, &nalStart, &nalSize,
+                true /* startCodeFollows */) == OK) {
+            benchmark::DoNotOptimize(nalStart);
+            ++nals;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+    state.counters["nalUnits"] = benchmark::Counter(nals, benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_GetNextNALUnit)
+        ->Args({4096, 1})
+        ->Args({65536, 4})
+        ->Args({166666, 1})     // 80 Mbit/s at 60 fps
+        ->Args({166666, 16})
+        ->Args({1 << 20, 8});
+
+BENCHMARK_MAIN();
@@ -20,6 +20,8 @@
 
 #include <fstream>
 #include <memory>
+#include <random>
+#include <vector>
 
 #include "media/stagefright/foundation/ABitReader.h"
 #include "media/stagefright/foundation/avc_utils.h"
@@ -349,6 +351,118 @@ TEST_P(AVCFrameTest, FrameTest) {
     }
 }
 
+// The byte by byte implementation of getNextNALUnit() that the vectorized one must match.
+static status_t referenceGetNextNALUnit(const uint8_t **_data, size_t *_size,
+                                        const uint8_t **nalStart, size_t *nalSize,
+                                        bool startCodeFollows) {
+    const uint8_t *data = *_data;
+    size_t size = *_size;
+
+    *nalStart = NULL;
+    *nalSize = 0;
+
+    if (size < 3) {
+        return -EAGAIN;
+    }
+
+    size_t offset = 0;
+    for (; offset + 2 < size; ++offset) {
+        if (data[offset + 2] == 0x01 && data[offset] == 0x00 && data[offset + 1] == 0x00) {
+            break;
+        }
+    }
+    if (offset + 2 >= size) {
+        *_data = &data[offset];
+        *_size = 2;
+        return -EAGAIN;
+    }
+    offset += 3;
+
+    size_t startOffset = offset;
+
+    for (;;) {
+        while (offset < size && data[offset] != 0x01) {
+            ++offset;
+        }
+
+        if (offset == size) {
+            if (startCodeFollows) {
+                offset = size + 2;
+                break;
+            }
+
+            return -EAGAIN;
+        }
+
+        if (data[offset - 1] == 0x00 && data[offset - 2] == 0x00) {
+            break;
+        }
+
+        ++offset;
+    }
+
+    size_t endOffset = offset - 2;
+    while (endOffset > startOffset + 1 && data[endOffset - 1] == 0x00) {
+        --endOffset;
+    }
+
+    *nalStart = &data[startOffset];
+    *nalSize = endOffset - startOffset;
+
+    if (offset + 2 < size) {
+        *_data = &data[offset - 2];
+        *_size = size - offset + 2;
+    } else {
+        *_data = NULL;
+        *_size = 0;
+    }
+
+    return OK;
+}
+
+// Splits random buffers, dense in 0x00 and 0x01 bytes and of sizes around the
+// vector width, into NAL units with both implementations.
+TEST(GetNextNALUnitTest, MatchesReferenceImplementation) {
+    std::mt19937 random(0x4e414c /* seed */);
+    for (int iteration = 0; iteration < 100000; ++iteration) {
+        const size_t size = random() % 100;
+        // 0x00 and 0x01 bytes make up to 7 / 8 of the data.
+        const unsigned zeroes = 1 + random() % 4;
+        std::vector<uint8_t> buffer(size);
+        for (uint8_t &byte : buffer) {
+            const unsigned kind = random() % 8;
+            byte = kind < zeroes ? 0x00 : kind < zeroes + 3 ? 0x01 : random() & 0xff;
+        }
+
+        for (bool startCodeFollows : {false, true}) {
+            const uint8_t *data = buffer.data();
+            size_t dataSize = size;
+            const uint8_t *referenceData = buffer.data();
+            size_t referenceSize = size;
+            for (;;) {
+                const uint8_t *nalStart;
+                size_t nalSize;
+                const uint8_t *referenceNalStart;
+                size_t referenceNalSize;
+                status_t err = getNextNALUnit(&data, &dataSize, &nalStart, &nalSize,
+                                              startCodeFollows);
+                status_t referenceErr =
+                        referenceGetNextNALUnit(&referenceData, &referenceSize,
+                                                &referenceNalStart, &referenceNalSize,
+                                                startCodeFollows);
+                ASSERT_EQ(err, referenceErr) << "iteration " << iteration;
+                ASSERT_EQ(data, referenceData) << "iteration " << iteration;
+                ASSERT_EQ(dataSize, referenceSize) << "iteration " << iteration;
+                ASSERT_EQ(nalStart, referenceNalStart) << "iteration " << iteration;
+                ASSERT_EQ(nalSize, referenceNalSize) << "iteration " << iteration;
+                if (err != OK || dataSize == 0) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
 INSTANTIATE_TEST_SUITE_P(AVCUtilsTestAll, MpegAudioUnitTest,
                          ::testing::Values(make_tuple(0xFFFB9204, 418, 44100, 2, 128, 1152),
                                            make_tuple(0xFFFB7604, 289, 48000, 2, 96, 1152),
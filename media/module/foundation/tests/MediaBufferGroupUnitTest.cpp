@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MediaBufferGroupUnitTest"
+
+#include <utils/Log.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/stagefright/MediaBuffer.h>
+#include <media/stagefright/MediaBufferGroup.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kBufferSize = 1000;
+
+// A buffer whose remote refcount is set by the test, as if it was shared with another
+// process, without shared memory.
+class RemoteMediaBuffer : public MediaBuffer {
+public:
+    explicit RemoteMediaBuffer(size_t size) : MediaBuffer(size) {}
+
+    int remoteRefcount() const override {
+        return mRemoteRefcount.load();
+    }
+
+    void setRemoteRefcount(int refcount) {
+        mRemoteRefcount.store(refcount);
+    }
+
+private:
+    std::atomic<int> mRemoteRefcount{0};
+};
+
+} // namespace
+
+TEST(MediaBufferGroupUnitTest, BlockingAcquireWaitsForRelease) {
+    MediaBufferGroup group(2 /* buffers */, kBufferSize);
+    EXPECT_EQ(2u, group.buffers());
+
+    MediaBufferBase *first;
+    MediaBufferBase *second;
+    ASSERT_EQ(OK, group.acquire_buffer(&first));
+    ASSERT_EQ(OK, group.acquire_buffer(&second));
+    EXPECT_NE(first, second);
+    EXPECT_EQ(1, first->refcount());
+
+    MediaBufferBase *buffer;
+    EXPECT_EQ(WOULD_BLOCK, group.acquire_buffer(&buffer, true /* nonBlocking */));
+    EXPECT_EQ(nullptr, buffer);
+    EXPECT_FALSE(group.has_buffers());
+
+    std::thread releaser([first] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        first->release();
+    });
+    ASSERT_EQ(OK, group.acquire_buffer(&buffer));
+    EXPECT_EQ(first, buffer);
+    releaser.join();
+
+    buffer->release();
+    second->release();
+    EXPECT_TRUE(group.has_buffers());
+}
+
+TEST(MediaBufferGroupUnitTest, ReallocatesSmallestFreeBuffer) {
+    MediaBufferGroup group(0 /* growthLimit */);
+    group.add_buffer(new MediaBuffer(200));
+    group.add_buffer(new MediaBuffer(100));
+    group.add_buffer(new MediaBuffer(300));
+
+    // No buffer is big enough and the group cannot grow, so the smallest is replaced.
+    MediaBufferBase *buffer;
+    ASSERT_EQ(OK, group.acquire_buffer(&buffer, true /* nonBlocking */, 1000));
+    EXPECT_GE(buffer->size(), 1000u);
+    EXPECT_EQ(3u, group.buffers());
+
+    // The others are kept, and still acquired for smaller requests.
+    std::set<size_t> sizes;
+    MediaBufferBase *others[2];
+    for (MediaBufferBase *&other : others) {
+        ASSERT_EQ(OK, group.acquire_buffer(&other, true /* nonBlocking */, 150));
+        sizes.insert(other->size());
+    }
+    EXPECT_EQ((std::set<size_t>{200, 300}), sizes);
+
+    // The reallocated buffer is acquired for requests that only it can hold.
+    for (MediaBufferBase *other : others) {
+        other->release();
+    }
+    buffer->release();
+    ASSERT_EQ(OK, group.acquire_buffer(&buffer, true /* nonBlocking */, 500));
+    EXPECT_GE(buffer->size(), 1000u);
+    EXPECT_EQ(3u, group.buffers());
+    buffer->release();
+}
+
+TEST(MediaBufferGroupUnitTest, GrowsUpToGrowthLimit) {
+    constexpr size_t kGrowthLimit = 4;
+    MediaBufferGroup group(kGrowthLimit);
+    EXPECT_EQ(0u, group.buffers());
+    EXPECT_TRUE(group.has_buffers());
+
+    std::vector<MediaBufferBase *> buffers;
+    for (size_t i = 0; i < kGrowthLimit; ++i) {
+        MediaBufferBase *buffer;
+        ASSERT_EQ(OK, group.acquire_buffer(&buffer, true /* nonBlocking */, kBufferSize));
+        EXPECT_GE(buffer->size(), kBufferSize);
+        buffers.push_back(buffer);
+        EXPECT_EQ(i + 1, group.buffers());
+    }
+    EXPECT_FALSE(group.has_buffers());
+    MediaBufferBase *buffer;
+    EXPECT_EQ(WOULD_BLOCK,
+            group.acquire_buffer(&buffer, true /* nonBlocking */, kBufferSize));
+    EXPECT_EQ(kGrowthLimit, group.buffers());
+
+    for (MediaBufferBase *acquired : buffers) {
+        acquired->release();
+    }
+
+    // Buffers added beyond the limit replace free ones.
+    group.add_buffer(new MediaBuffer(kBufferSize));
+    EXPECT_EQ(kGrowthLimit, group.buffers());
+}
+
+TEST(MediaBufferGroupUnitTest, RemoteRelease) {
+    MediaBufferGroup group(1 /* growthLimit */);
+    RemoteMediaBuffer *remote = new RemoteMediaBuffer(kBufferSize);
+    group.add_buffer(remote);
+
+    // Released locally while still referenced by the remote process.
+    MediaBufferBase *buffer;
+    ASSERT_EQ(OK, group.acquire_buffer(&buffer, true /* nonBlocking */));
+    ASSERT_EQ(remote, buffer);
+    remote->setRemoteRefcount(1);
+    buffer->release();
+    EXPECT_EQ(WOULD_BLOCK, group.acquire_buffer(&buffer, true /* nonBlocking */));
+    EXPECT_FALSE(group.has_buffers());
+
+    // A blocked caller is woken up once the remote release is signaled.
+    std::thread releaser([&group, remote] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        remote->setRemoteRefcount(0);
+        group.signalBufferReturned(nullptr);
+    });
+    ASSERT_EQ(OK, group.acquire_buffer(&buffer));
+    EXPECT_EQ(remote, buffer);
+    releaser.join();
+    buffer->release();
+
+    // A buffer released remotely without signaling is still found when no other is free.
+    ASSERT_EQ(OK, group.acquire_buffer(&buffer, true /* nonBlocking */));
+    remote->setRemoteRefcount(1);
+    buffer->release();
+    EXPECT_EQ(WOULD_BLOCK, group.acquire_buffer(&buffer, true /* nonBlocking */));
+    remote->setRemoteRefcount(0);
+    ASSERT_EQ(OK, group.acquire_buffer(&buffer, true /* nonBlocking */));
+    EXPECT_EQ(remote, buffer);
+    buffer->release();
+}
+
+// Threads acquire buffers of various sizes, blocking or not, from a group with fewer
+// buffers than threads.  No buffer may be held by two threads, and all threads must
+// finish, as each returned buffer wakes up a blocked thread.
+TEST(MediaBufferGroupUnitTest, ConcurrentAcquireRelease) {
+    constexpr size_t kNumThreads = 8;
+    constexpr size_t kNumBuffers = 3;
+    constexpr size_t kIterations = 5000;
+    MediaBufferGroup group(kNumBuffers, kBufferSize, kNumBuffers /* growthLimit */);
+
+    std::mutex lock;
+    std::set<MediaBufferBase *> held;
+    std::atomic<size_t> wouldBlockCount{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kNumThreads; ++t) {
+        const bool nonBlocking = t % 2 != 0;
+        threads.emplace_back([&, t, nonBlocking] {
+            for (size_t i = 0; i < kIterations; ++i) {
+                const size_t requestedSize = ((i + t) % 3) * kBufferSize;
+                MediaBufferBase *buffer;
+                const status_t status = group.acquire_buffer(&buffer, nonBlocking, requestedSize);
+                if (status == WOULD_BLOCK && nonBlocking) {
+                    ++wouldBlockCount;
+                    std::this_thread::yield();
+                    continue;
+                }
+                ASSERT_EQ(OK, status);
+                EXPECT_GE(buffer->size(), requestedSize);
+                EXPECT_EQ(1, buffer->refcount());
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    ASSERT_TRUE(held.insert(buffer).second) << "buffer handed out twice";
+                }
+                if (i % 7 == 0) {
+                    std::this_thread::yield();
+                }
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    held.erase(buffer);
+                }
+                buffer->release();
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    ALOGV("%zu non-blocking acquisitions would have blocked", wouldBlockCount.load());
+
+    EXPECT_TRUE(held.empty());
+    EXPECT_EQ(kNumBuffers, group.buffers());
+    // All buffers are free again.
+    std::vector<MediaBufferBase *> buffers(kNumBuffers);
+    for (MediaBufferBase *&buffer : buffers) {
+        ASSERT_EQ(OK, group.acquire_buffer(&buffer, true /* nonBlocking */));
+    }
+    for (MediaBufferBase *buffer : buffers) {
+        buffer->release();
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures acquiring and releasing buffers of a MediaBufferGroup shared by
+// 1 to 8 threads, as the tracks of an extractor read concurrently.
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/MediaBuffer.h>
+#include <media/stagefright/MediaBufferGroup.h>
+
+using namespace android;
+
+static constexpr size_t kBufferSize = 1024;
+
+// Enough buffers for each thread, so that no thread blocks.
+static MediaBufferGroup& getGroup() {
+    static MediaBufferGroup group(16 /* buffers */, kBufferSize);
+    return group;
+}
+
+// Fewer buffers than threads, so that threads block until a buffer is returned.
+static MediaBufferGroup& getContendedGroup() {
+    static MediaBufferGroup group(2 /* buffers */, kBufferSize);
+    return group;
+}
+
+static void acquireRelease(benchmark::State& state, MediaBufferGroup &group) {
+    for (auto _ : state) {
+        MediaBufferBase *buffer;
+        if (group.acquire_buffer(&buffer, false /* nonBlocking */, kBufferSize) != OK) {
+            state.SkipWithError("acquire_buffer failed");
+            break;
+        }
+        benchmark::DoNotOptimize(buffer->data());
+        buffer->release();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_AcquireRelease(benchmark::State& state) {
+    acquireRelease(state, getGroup());
+}
+
+BENCHMARK(BM_AcquireRelease)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_AcquireReleaseContended(benchmark::State& state) {
+    acquireRelease(state, getContendedGroup());
+}
+
+BENCHMARK(BM_AcquireReleaseContended)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures setting, finding and copying the per sample metadata of an extractor,
+// and counts the allocations done for it, both by operator new and by malloc(),
+// which is wrapped at link time for libstagefright_foundation.
+
+#include <stdlib.h>
+
+#include <atomic>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/MetaDataBase.h>
+
+using namespace android;
+
+static std::atomic<size_t> gAllocations;
+
+extern "C" void *__real_malloc(size_t size);
+
+extern "C" void *__wrap_malloc(size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void *operator new(size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = __real_malloc(size);
+    if (ptr == nullptr) {
+        abort();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+// As set by MPEG4Extractor for an encrypted sample with two subsamples.
+static void setSampleMeta(MetaDataBase &meta, int64_t timeUs, bool encrypted) {
+    meta.setInt64(kKeyTime, timeUs);
+    meta.setInt64(kKeyDuration, 33333);
+    meta.setInt32(kKeyIsSyncFrame, (timeUs % 1000000) == 0);
+    if (encrypted) {
+        static const uint8_t kIV[16] = {};
+        static const uint8_t kKeyId[16] = {};
+        static const size_t kPlainSizes[] = {128, 64};
+        static const size_t kEncryptedSizes[] = {16384, 4096};
+        meta.setData(kKeyCryptoIV, 0, kIV, sizeof(kIV));
+        meta.setData(kKeyCryptoKey, 0, kKeyId, sizeof(kKeyId));
+        meta.setData(kKeyPlainSizes, 0, kPlainSizes, sizeof(kPlainSizes));
+        meta.setData(kKeyEncryptedSizes, 0, kEncryptedSizes, sizeof(kEncryptedSizes));
+    }
+}
+
+static void setAllocationsCounter(benchmark::State& state, size_t allocations) {
+    state.counters["allocations"] = benchmark::Counter(
+            allocations, benchmark::Counter::kAvgIterations);
+}
+
+// Sets and finds the metadata of a sample in the metadata of a recycled buffer,
+// which MediaBuffer::reset() clears.
+// Args: whether the sample is encrypted.
+static void BM_SetAndFindSampleMeta(benchmark::State& state) {
+    const bool encrypted = state.range(0);
+    MetaDataBase meta;
+    int64_t timeUs = 0;
+    const size_t allocations = gAllocations;
+    for (auto _ : state) {
+        meta.clear();
+        setSampleMeta(meta, timeUs, encrypted);
+        int64_t sampleTimeUs;
+        int32_t isSync;
+        benchmark::DoNotOptimize(meta.findInt64(kKeyTime, &sampleTimeUs));
+        benchmark::DoNotOptimize(meta.findInt32(kKeyIsSyncFrame, &isSync));
+        uint32_t type;
+        const void *data;
+        size_t size;
+        benchmark::DoNotOptimize(meta.findData(kKeyCryptoIV, &type, &data, &size));
+        timeUs += 33333;
+    }
+    setAllocationsCounter(state, gAllocations - allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_SetAndFindSampleMeta)->Arg(0)->Arg(1);
+
+// Creates the metadata of each sample, as extractors returning a new buffer per sample do.
+// Args: whether the sample is encrypted.
+static void BM_NewSampleMeta(benchmark::State& state) {
+    const bool encrypted = state.range(0);
+    int64_t timeUs = 0;
+    const size_t allocations = gAllocations;
+    for (auto _ : state) {
+        MetaDataBase meta;
+        meta.reserve(encrypted ? 7 : 3);
+        setSampleMeta(meta, timeUs, encrypted);
+        benchmark::DoNotOptimize(meta);
+        timeUs += 33333;
+    }
+    setAllocationsCounter(state, gAllocations - allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_NewSampleMeta)->Arg(0)->Arg(1);
+
+// Copies the metadata of a sample into the metadata of a recycled buffer.
+// Args: whether the sample is encrypted.
+static void BM_CopySampleMeta(benchmark::State& state) {
+    const bool encrypted = state.range(0);
+    MetaDataBase source;
+    setSampleMeta(source, 0, encrypted);
+    MetaDataBase meta;
+    const size_t allocations = gAllocations;
+    for (auto _ : state) {
+        meta = source;
+        benchmark::DoNotOptimize(meta);
+    }
+    setAllocationsCounter(state, gAllocations - allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_CopySampleMeta)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
@@ -44,6 +44,7 @@
 #include <utils/Vector.h>
 
 #include <inttypes.h>
+#include <string.h>
 
 namespace android {
 using hardware::hidl_handle;
@@ -59,6 +60,7 @@ typedef hidl::memory::V1_0::IMemory TMemory;
     do { unsigned tmp = y; ALOGV(x, tmp); } while (0)
 
 static const size_t kTSPacketSize = 188;
+static const unsigned kInvalidPID = 0x2000;  // PIDs are 13 bits.
 
 struct ATSParser::Program : public RefBase {
     Program(ATSParser *parser, unsigned programNumber, unsigned programMapPID,
@@ -77,6 +79,9 @@ struct ATSParser::Program : public RefBase {
             unsigned random_access_indicator,
             ABitReader *br, status_t *err, SyncEvent *event);
 
+    // Returns the stream that parsePID() passes the payload of pid to, if any.
+    sp<Stream> findStream(unsigned pid) const;
+
     void signalDiscontinuity(
             DiscontinuityType type, const sp<AMessage> &extra);
 
@@ -344,6 +349,14 @@ bool ATSParser::Program::parsePID(
     return true;
 }
 
+sp<ATSParser::Stream> ATSParser::Program::findStream(unsigned pid) const {
+    ssize_t index = mStreams.indexOfKey(pid);
+    if (index < 0) {
+        return NULL;
+    }
+    return mStreams.valueAt(index);
+}
+
 void ATSParser::Program::signalDiscontinuity(
         DiscontinuityType type, const sp<AMessage> &extra) {
     int64_t mediaTimeUs;
@@ -2004,7 +2017,88 @@ status_t ATSParser::feedTSPacket(const void *data, size_t size,
     }
 
     ABitReader br((const uint8_t *)data, kTSPacketSize);
-    return parseTS(&br, event);
+    return parseTS(&br, event, NULL /* stream */);
+}
+
+status_t ATSParser::feedTSPackets(const void *data, size_t size,
+        size_t *bytesConsumed, SyncEvent *event) {
+    const uint8_t *packets = (const uint8_t *)data;
+    const off64_t startOffset = (event != NULL) ? event->getOffset() : 0;
+
+    // Consecutive packets usually carry the same PID, so the stream it maps to
+    // is only looked up again when the PID changes.
+    unsigned streamPID = kInvalidPID;
+    sp<Stream> stream;
+
+    status_t err = OK;
+    size_t offset = 0;
+    while (offset + kTSPacketSize <= size) {
+        const uint8_t *packet = &packets[offset];
+        if (packet[0] != 0x47) {
+            size_t syncOffset = findSyncByte(packets, size, offset + 1);
+            ALOGW("lost sync at offset %lld, skipping %zu bytes",
+                    (long long)(startOffset + offset), syncOffset - offset);
+            offset = syncOffset;
+            streamPID = kInvalidPID;
+            stream.clear();
+            continue;
+        }
+
+        const unsigned PID = ((packet[1] & 0x1f) << 8) | packet[2];
+        if (PID != streamPID) {
+            stream = findStream(PID);
+            // PSI sections may change the mapping of any PID, look it up again.
+            streamPID = (stream != NULL) ? PID : kInvalidPID;
+        }
+
+        SyncEvent packetEvent(startOffset + offset);
+        ABitReader br(packet, kTSPacketSize);
+        err = parseTS(&br, (event != NULL) ? &packetEvent : NULL, stream);
+        offset += kTSPacketSize;
+
+        if (packetEvent.hasReturnedData()) {
+            // Let the caller handle this event before any later one.
+            *event = packetEvent;
+            break;
+        }
+        if (err != OK) {
+            break;
+        }
+    }
+
+    *bytesConsumed = offset;
+    return err;
+}
+
+// static
+size_t ATSParser::findSyncByte(const uint8_t *data, size_t size, size_t offset) {
+    while (offset < size) {
+        // memchr() is vectorized, unlike a byte by byte loop.
+        const uint8_t *sync = (const uint8_t *)memchr(&data[offset], 0x47, size - offset);
+        if (sync == NULL) {
+            return size;
+        }
+        offset = sync - data;
+        // A 0x47 in the payload is unlikely to be followed by another one a packet later.
+        if (offset + kTSPacketSize >= size || data[offset + kTSPacketSize] == 0x47) {
+            return offset;
+        }
+        ++offset;
+    }
+    return size;
+}
+
+sp<ATSParser::Stream> ATSParser::findStream(unsigned PID) const {
+    if (mPSISections.indexOfKey(PID) >= 0) {
+        return NULL;
+    }
+    for (size_t i = 0; i < mPrograms.size(); ++i) {
+        sp<Stream> stream = mPrograms.itemAt(i)->findStream(PID);
+        if (stream != NULL) {
+            return stream;
+        }
+    }
+    return NULL;
 }
 
 status_t ATSParser::setMediaCas(const sp<ICas> &cas) {
@@ -2346,7 +2440,7 @@ status_t ATSParser::parseAdaptationField(
     return OK;
 }
 
-status_t ATSParser::parseTS(ABitReader *br, SyncEvent *event) {
+status_t ATSParser::parseTS(ABitReader *br, SyncEvent *event, const sp<Stream> &stream) {
     ALOGV("---");
 
     if (br->numBitsLeft() < 32) {
@@ -2390,7 +2484,15 @@ status_t ATSParser::parseTS(ABitReader *br, SyncEvent *event) {
         err = parseAdaptationField(br, PID, &random_access_indicator);
     }
     if (err == OK) {
-        if (adaptation_field_control == 1 || adaptation_field_control == 3) {
+        if (stream != NULL
+                && (adaptation_field_control == 1 || adaptation_field_control == 3)) {
+            // Same as parsePID(), without looking up the PID again.
+            err = stream->parse(continuity_counter,
+                    payload_unit_start_indicator,
+                    transport_scrambling_control,
+                    random_access_indicator,
+                    br, event);
+        } else if (adaptation_field_control == 1 || adaptation_field_control == 3) {
             err = parsePID(br, PID, continuity_counter,
                     payload_unit_start_indicator,
                     transport_scrambling_control,
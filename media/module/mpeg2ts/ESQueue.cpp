@@ -1161,9 +1161,19 @@ status_t ElementaryStreamQueue::appendData(
         }
     }
 
+    // Dequeued access units are dropped from the front of mBuffer by advancing its
+    // offset, see consumeBuffer(), so data is only moved when the end is reached.
     size_t neededSize = (mBuffer == NULL ? 0 : mBuffer->size()) + size;
-    if (mBuffer == NULL || neededSize > mBuffer->capacity()) {
-        neededSize = (neededSize + 65535) & ~65535;
+    if (mBuffer != NULL && mBuffer->offset() + neededSize > mBuffer->capacity()
+            && neededSize <= mBuffer->capacity() / 2) {
+        // Reclaim the space of the dequeued access units. At least half of the
+        // buffer was consumed since the last move, so each byte is moved at most
+        // once on average, rather than once per access unit dequeued after it.
+        memmove(mBuffer->base(), mBuffer->data(), mBuffer->size());
+        mBuffer->setRange(0, mBuffer->size());
+    } else if (mBuffer == NULL || mBuffer->offset() + neededSize > mBuffer->capacity()) {
+        // Leave room for as much again, so that the buffer is not moved right away.
+        neededSize = (2 * neededSize + 65535) & ~65535;
 
         ALOGV("resizing buffer to size %zu", neededSize);
 
@@ -1179,7 +1189,7 @@ status_t ElementaryStreamQueue::appendData(
     }
 
     memcpy(mBuffer->data() + mBuffer->size(), data, size);
-    mBuffer->setRange(0, mBuffer->size() + size);
+    mBuffer->setRange(mBuffer->offset(), mBuffer->size() + size);
 
     RangeInfo info;
     info.mLength = size;
@@ -1281,7 +1291,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueScrambledAccessUnit() {
     // range on mBuffer. Note that the leading clear bytes includes the
     // PES header portion, while mBuffer doesn't.
     if ((int32_t)leadingClearBytes > pesOffset) {
-        mBuffer->setRange(0, leadingClearBytes - pesOffset);
+        mBuffer->setRange(mBuffer->offset(), leadingClearBytes - pesOffset);
     } else {
         mBuffer->setRange(0, 0);
     }
@@ -1388,11 +1398,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnit() {
         memcpy(accessUnit->data(), mBuffer->data(), info.mLength);
         accessUnit->meta()->setInt64("timeUs", info.mTimestampUs);
 
-        memmove(mBuffer->data(),
-                mBuffer->data() + info.mLength,
-                mBuffer->size() - info.mLength);
-
-        mBuffer->setRange(0, mBuffer->size() - info.mLength);
+        consumeBuffer(info.mLength);
 
         if (mFormat == NULL) {
             mFormat = new MetaData;
@@ -1479,12 +1485,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitDTSOrDTSHD() {
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-        mBuffer->data(),
-        mBuffer->data() + syncStartPos + payloadSize,
-        mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
+    consumeBuffer(syncStartPos + payloadSize);
 
     return accessUnit;
 }
@@ -1533,12 +1534,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitDTSUHD()
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-        mBuffer->data(),
-        mBuffer->data() + syncStartPos + payloadSize,
-        mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
+    consumeBuffer(syncStartPos + payloadSize);
 
     return accessUnit;
 }
@@ -1605,12 +1601,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitEAC3() {
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
+    consumeBuffer(syncStartPos + payloadSize);
 
     return accessUnit;
 }
@@ -1669,12 +1660,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAC4() {
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
+    consumeBuffer(syncStartPos + payloadSize);
     return accessUnit;
 }
 
@@ -1736,12 +1722,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitPCMAudio() {
         ptr[i] = ntohs(ptr[i]);
     }
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + 4 + payloadSize,
-            mBuffer->size() - 4 - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - 4 - payloadSize);
+    consumeBuffer(4 + payloadSize);
 
     return accessUnit;
 }
@@ -1885,9 +1866,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAAC() {
     sp<ABuffer> accessUnit = new ABuffer(offset);
     memcpy(accessUnit->data(), mBuffer->data(), offset);
 
-    memmove(mBuffer->data(), mBuffer->data() + offset,
-            mBuffer->size() - offset);
-    mBuffer->setRange(0, mBuffer->size() - offset);
+    consumeBuffer(offset);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
@@ -1895,6 +1874,15 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAAC() {
     return accessUnit;
 }
 
+void ElementaryStreamQueue::consumeBuffer(size_t size) {
+    if (size >= mBuffer->size()) {
+        // Start again from the beginning of the buffer.
+        mBuffer->setRange(0, 0);
+        return;
+    }
+    mBuffer->setRange(mBuffer->offset() + size, mBuffer->size() - size);
+}
+
 int64_t ElementaryStreamQueue::fetchTimestamp(
         size_t size, int32_t *pesOffset, int32_t *pesScramblingControl) {
     int64_t timeUs = -1;
@@ -2072,11 +2060,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitH264() {
             const NALPosition &pos = nals.itemAt(nals.size() - 1);
             size_t nextScan = pos.nalOffset + pos.nalSize;
 
-            memmove(mBuffer->data(),
-                    mBuffer->data() + nextScan,
-                    mBuffer->size() - nextScan);
-
-            mBuffer->setRange(0, mBuffer->size() - nextScan);
+            consumeBuffer(nextScan);
 
             int64_t timeUs = fetchTimestamp(nextScan);
             if (timeUs < 0LL) {
@@ -2158,11 +2142,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGAudio() {
     sp<ABuffer> accessUnit = new ABuffer(frameSize);
     memcpy(accessUnit->data(), data, frameSize);
 
-    memmove(mBuffer->data(),
-            mBuffer->data() + frameSize,
-            mBuffer->size() - frameSize);
-
-    mBuffer->setRange(0, mBuffer->size() - frameSize);
+    consumeBuffer(frameSize);
 
     int64_t timeUs = fetchTimestamp(frameSize);
     if (timeUs < 0LL) {
@@ -2285,11 +2265,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
         currentStartCode = data[offset + 3];
 
         if (currentStartCode == 0xb3 && mFormat == NULL) {
-            memmove(mBuffer->data(), mBuffer->data() + offset, size - offset);
+            consumeBuffer(offset);
+            data = mBuffer->data();
             size -= offset;
             (void)fetchTimestamp(offset);
             offset = 0;
-            mBuffer->setRange(0, size);
         }
 
         if ((prevStartCode == 0xb3 && currentStartCode != 0xb5)
@@ -2318,11 +2298,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
                 sp<ABuffer> csd = new ABuffer(offset);
                 memcpy(csd->data(), data, offset);
 
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                consumeBuffer(offset);
                 size -= offset;
                 (void)fetchTimestamp(offset);
                 offset = 0;
@@ -2361,11 +2337,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
                 sp<ABuffer> accessUnit = new ABuffer(offset);
                 memcpy(accessUnit->data(), data, offset);
 
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                consumeBuffer(offset);
 
                 int64_t timeUs = fetchTimestamp(offset);
                 if (timeUs < 0LL) {
@@ -2560,9 +2532,8 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
                     sp<ABuffer> accessUnit = new ABuffer(offset);
                     memcpy(accessUnit->data(), data, offset);
 
-                    memmove(data, &data[offset], size - offset);
+                    consumeBuffer(offset);
                     size -= offset;
-                    mBuffer->setRange(0, size);
 
                     int64_t timeUs = fetchTimestamp(offset);
                     if (timeUs < 0LL) {
@@ -2598,10 +2569,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
 
         if (discard) {
             (void)fetchTimestamp(offset);
-            memmove(data, &data[offset], size - offset);
+            consumeBuffer(offset);
+            data = mBuffer->data();
             size -= offset;
             offset = 0;
-            mBuffer->setRange(0, size);
         } else {
             offset += chunkSize;
         }
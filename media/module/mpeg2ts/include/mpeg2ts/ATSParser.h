@@ -122,6 +122,18 @@ struct ATSParser : public RefBase {
     status_t feedTSPacket(
             const void *data, size_t size, SyncEvent *event = NULL);
 
+    // Feed back-to-back TS packets into the parser, as feedTSPacket() would one
+    // by one. Packets of the same PID in a row go to their stream without
+    // looking up the PID again, and if a packet does not start with a sync
+    // byte, the data up to the next sync byte is skipped. The event goes in
+    // with the start offset of data; parsing stops after the packet that
+    // initializes it or fails to parse, so that the caller can handle it.
+    // bytesConsumed is set to the number of bytes parsed or skipped, which is
+    // at least one packet unless size is less than a packet.
+    status_t feedTSPackets(
+            const void *data, size_t size, size_t *bytesConsumed,
+            SyncEvent *event = NULL);
+
     void signalDiscontinuity(
             DiscontinuityType type, const sp<AMessage> &extra);
 
@@ -248,8 +260,17 @@ private:
     status_t parseAdaptationField(
             ABitReader *br, unsigned PID, unsigned *random_access_indicator);
 
-    // see feedTSPacket().
-    status_t parseTS(ABitReader *br, SyncEvent *event);
+    // see feedTSPacket(). If stream is not NULL, it is the stream of the PID of
+    // the packet, as returned by findStream().
+    status_t parseTS(ABitReader *br, SyncEvent *event, const sp<Stream> &stream);
+
+    // Returns the stream of PID, or NULL if packets of PID are not passed
+    // to a stream.
+    sp<Stream> findStream(unsigned PID) const;
+
+    // Returns the offset of the first sync byte from offset in data, which is
+    // followed by another one a packet later when data is long enough, or size.
+    static size_t findSyncByte(const uint8_t *data, size_t size, size_t offset);
 
     void updatePCR(unsigned PID, uint64_t PCR, uint64_t byteOffsetFromStart);
 
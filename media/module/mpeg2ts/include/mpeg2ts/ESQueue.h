@@ -131,6 +131,10 @@ private:
     sp<ABuffer> dequeueAccessUnitDTSOrDTSHD();
     sp<ABuffer> dequeueAccessUnitDTSUHD();
 
+    // drop the first "size" bytes of mBuffer, once they are dequeued.
+    // The offset of mBuffer is advanced instead of moving the rest of the data.
+    void consumeBuffer(size_t size);
+
     // consume a logical (compressed) access unit of size "size",
     // returns its timestamp in us (or -1 if no time information).
     int64_t fetchTimestamp(size_t size,
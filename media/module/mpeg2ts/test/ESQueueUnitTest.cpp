@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ESQueueUnitTest"
+
+#include <utils/Log.h>
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/MetaData.h>
+#include <mpeg2ts/ESQueue.h>
+
+using namespace android;
+
+// Synthetic elementary streams are fed to the queue in payloads of several access
+// units, which do not end on access unit boundaries unless the format requires it.
+// Payloads first grow, so that the queue buffer grows, then shrink, so that the data
+// left after dequeuing is moved back to the start of the buffer. Dequeuing lags
+// behind some payloads, so that data is left in the buffer at various offsets.
+// Each access unit must be one frame of the stream, with the timestamp of the
+// payload holding its first byte.
+
+namespace {
+
+struct Frame {
+    std::vector<uint8_t> data;
+    bool isSync = true;
+};
+
+struct AccessUnit {
+    std::vector<uint8_t> data;
+    int64_t timeUs;
+    bool isSync;
+};
+
+constexpr int64_t kPayloadDurationUs = 1000;
+
+int64_t getPayloadTimeUs(size_t payloadIndex) {
+    return (int64_t)(payloadIndex + 1) * kPayloadDurationUs;
+}
+
+// Payload sizes, in bytes, from 1 KiB up to 512 KiB then down again.
+std::vector<size_t> getPayloadSizes() {
+    std::vector<size_t> sizes;
+    for (size_t size = 1024; size <= 512 * 1024; size = size * 3 / 2) {
+        sizes.push_back(size);
+        sizes.push_back(size + 777);
+    }
+    for (size_t size = 512 * 1024; size >= 1024; size = size * 2 / 3) {
+        sizes.push_back(size);
+        sizes.push_back(size / 3);
+    }
+    return sizes;
+}
+
+// Appends frames in payloads of the given sizes and dequeues all access units.
+// After the payload at index i, at most maxDequeues[i % maxDequeues.size()] access units
+// are dequeued.
+// Payloads end at frame boundaries if alignToFrames is set, after the last frame starting
+// before the payload size is reached.
+// Returns the access units, and for each frame the index of the payload holding its start.
+std::vector<AccessUnit> runQueue(
+        ElementaryStreamQueue::Mode mode, const std::vector<Frame> &frames,
+        const std::vector<size_t> &maxDequeues, bool alignToFrames,
+        std::vector<size_t> *framePayloadIndices) {
+    std::vector<uint8_t> stream;
+    std::vector<size_t> frameOffsets;
+    for (const Frame &frame : frames) {
+        frameOffsets.push_back(stream.size());
+        stream.insert(stream.end(), frame.data.begin(), frame.data.end());
+    }
+
+    ElementaryStreamQueue queue(mode);
+    std::vector<AccessUnit> accessUnits;
+    auto dequeue = [&](size_t maxCount) {
+        for (size_t i = 0; i < maxCount; ++i) {
+            sp<ABuffer> accessUnit = queue.dequeueAccessUnit();
+            if (accessUnit == nullptr) break;
+            AccessUnit au;
+            au.data.assign(accessUnit->data(), accessUnit->data() + accessUnit->size());
+            EXPECT_TRUE(accessUnit->meta()->findInt64("timeUs", &au.timeUs));
+            int32_t isSync = 0;
+            au.isSync = accessUnit->meta()->findInt32("isSync", &isSync) && isSync != 0;
+            accessUnits.push_back(std::move(au));
+        }
+    };
+
+    const std::vector<size_t> payloadSizes = getPayloadSizes();
+    framePayloadIndices->clear();
+    size_t offset = 0;
+    size_t frameIndex = 0;
+    for (size_t i = 0; offset < stream.size(); ++i) {
+        size_t end = std::min(offset + payloadSizes[i % payloadSizes.size()], stream.size());
+        if (alignToFrames) {
+            const auto next = std::upper_bound(frameOffsets.begin(), frameOffsets.end(), end);
+            end = next == frameOffsets.end() ? stream.size() : *next;
+        }
+        for (; frameIndex < frames.size() && frameOffsets[frameIndex] < end; ++frameIndex) {
+            framePayloadIndices->push_back(i);
+        }
+        EXPECT_EQ(OK, queue.appendData(&stream[offset], end - offset, getPayloadTimeUs(i)));
+        offset = end;
+        dequeue(maxDequeues[i % maxDequeues.size()]);
+    }
+    dequeue(SIZE_MAX);
+    return accessUnits;
+}
+
+void expectFrames(const std::vector<Frame> &frames, const std::vector<size_t> &payloadIndices,
+        const std::vector<AccessUnit> &accessUnits, size_t frameCount) {
+    ASSERT_EQ(frameCount, accessUnits.size());
+    for (size_t i = 0; i < frameCount; ++i) {
+        ASSERT_EQ(frames[i].data, accessUnits[i].data) << "frame " << i;
+        EXPECT_EQ(getPayloadTimeUs(payloadIndices[i]), accessUnits[i].timeUs) << "frame " << i;
+        EXPECT_EQ(frames[i].isSync, accessUnits[i].isSync) << "frame " << i;
+    }
+}
+
+// Fills the frame up to size with bytes that do not form start or sync codes.
+void fillFrame(Frame *frame, size_t size, size_t seed) {
+    for (size_t i = frame->data.size(); i < size; ++i) {
+        frame->data.push_back(0x80 | ((i + seed) & 0x3f));
+    }
+}
+
+// Frames of an access unit delimiter and a single slice, with 4-byte start codes as
+// access units are rebuilt with.
+std::vector<Frame> makeH264Frames(size_t count) {
+    std::vector<Frame> frames;
+    for (size_t i = 0; i < count; ++i) {
+        const bool idr = i % 30 == 0;
+        Frame frame;
+        // first_mb_in_slice = 0
+        frame.data = {0x00, 0x00, 0x00, 0x01, 0x09, 0xf0,
+                0x00, 0x00, 0x00, 0x01, (uint8_t)(idr ? 0x65 : 0x41), 0x88};
+        frame.isSync = idr;
+        fillFrame(&frame, 100 + (i * 7919) % 60000, i);
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+// ADTS frames of AAC LC, 44.1 kHz, stereo, without CRC.
+std::vector<Frame> makeAdtsFrames(size_t count) {
+    std::vector<Frame> frames;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t size = 64 + (i * 1031) % 8000;
+        Frame frame;
+        frame.data = {0xff, 0xf1, 0x50, (uint8_t)(0x80 | (size >> 11)),
+                (uint8_t)(size >> 3), (uint8_t)(((size & 7) << 5) | 0x1f), 0xfc};
+        fillFrame(&frame, size, i);
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+// MPEG-1 layer III frames at 48 kHz, of all bitrates, with and without padding.
+std::vector<Frame> makeMpegAudioFrames(size_t count) {
+    static const size_t kBitrates[] = {
+            32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320};
+    std::vector<Frame> frames;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t bitrateIndex = i % 14;
+        const size_t padding = (i / 14) % 2;
+        Frame frame;
+        frame.data = {0xff, 0xfb,
+                (uint8_t)(((bitrateIndex + 1) << 4) | (1 << 2) | (padding << 1)), 0x00};
+        fillFrame(&frame, 144 * kBitrates[bitrateIndex] * 1000 / 48000 + padding, i);
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+// AC-3 frames at 48 kHz, stereo, of all frame sizes.
+std::vector<Frame> makeAc3Frames(size_t count) {
+    static const size_t kFrameSizeWords[] = {
+            64, 80, 96, 112, 128, 160, 192, 224, 256, 320,
+            384, 448, 512, 640, 768, 896, 1024, 1152, 1280};
+    std::vector<Frame> frames;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t frmsizecod = i % 38;
+        Frame frame;
+        // syncword, crc1, fscod and frmsizecod, bsid 8 and bsmod, acmod 2
+        frame.data = {0x0b, 0x77, 0x00, 0x00, (uint8_t)frmsizecod, 0x40, 0x40};
+        fillFrame(&frame, 2 * kFrameSizeWords[frmsizecod >> 1], i);
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+// No dequeue after one payload in three, all access units after the others.
+const std::vector<size_t> kLaggingDequeues = {0, SIZE_MAX, SIZE_MAX};
+
+} // namespace
+
+TEST(ESQueueUnitTest, H264) {
+    const std::vector<Frame> frames = makeH264Frames(400);
+    std::vector<size_t> payloadIndices;
+    const std::vector<AccessUnit> accessUnits = runQueue(ElementaryStreamQueue::H264, frames,
+            kLaggingDequeues, false /* alignToFrames */, &payloadIndices);
+    // The last frame is only dequeued once the next one starts.
+    expectFrames(frames, payloadIndices, accessUnits, frames.size() - 1);
+}
+
+TEST(ESQueueUnitTest, Aac) {
+    const std::vector<Frame> frames = makeAdtsFrames(2000);
+    std::vector<size_t> payloadIndices;
+    // A payload is dequeued as a single access unit. Keep one more queued, most of the time.
+    const std::vector<AccessUnit> accessUnits = runQueue(ElementaryStreamQueue::AAC, frames,
+            {0, 1, 1, 1, 1, 1, 1, 1, 1, 2}, true /* alignToFrames */, &payloadIndices);
+
+    // Access units are the frames of each payload.
+    std::vector<Frame> payloads;
+    std::vector<size_t> payloadIndexOfPayloads;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (i == 0 || payloadIndices[i] != payloadIndices[i - 1]) {
+            payloads.emplace_back();
+            payloadIndexOfPayloads.push_back(payloadIndices[i]);
+        }
+        payloads.back().data.insert(
+                payloads.back().data.end(), frames[i].data.begin(), frames[i].data.end());
+    }
+    expectFrames(payloads, payloadIndexOfPayloads, accessUnits, payloads.size());
+}
+
+TEST(ESQueueUnitTest, MpegAudio) {
+    const std::vector<Frame> frames = makeMpegAudioFrames(6000);
+    std::vector<size_t> payloadIndices;
+    const std::vector<AccessUnit> accessUnits = runQueue(ElementaryStreamQueue::MPEG_AUDIO,
+            frames, kLaggingDequeues, false /* alignToFrames */, &payloadIndices);
+    expectFrames(frames, payloadIndices, accessUnits, frames.size());
+}
+
+TEST(ESQueueUnitTest, Ac3) {
+    const std::vector<Frame> frames = makeAc3Frames(4000);
+    std::vector<size_t> payloadIndices;
+    const std::vector<AccessUnit> accessUnits = runQueue(ElementaryStreamQueue::AC3,
+            frames, kLaggingDequeues, false /* alignToFrames */, &payloadIndices);
+    expectFrames(frames, payloadIndices, accessUnits, frames.size());
+}
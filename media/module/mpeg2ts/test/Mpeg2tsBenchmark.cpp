@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the throughput of demuxing a synthetic 80 Mbit/s, 60 fps H.264 stream,
+// as fed to the ElementaryStreamQueue by ATSParser, one PES payload at a time,
+// and as fed to ATSParser by MPEG2TSExtractor, as a transport stream.
+
+#include <algorithm>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/MetaData.h>
+#include <mpeg2ts/ATSParser.h>
+#include <mpeg2ts/AnotherPacketSource.h>
+#include <mpeg2ts/ESQueue.h>
+
+using namespace android;
+
+static constexpr size_t kBitRate = 80000000;
+static constexpr size_t kFrameRate = 60;
+static constexpr size_t kFrameSize = kBitRate / 8 / kFrameRate;
+static constexpr int64_t kFrameDurationUs = 1000000 / kFrameRate;
+
+// An access unit delimiter followed by a single slice, with no zero bytes in the
+// slice data, so that the only start codes are the ones of the two NAL units.
+static std::vector<uint8_t> makeFrame(bool idr) {
+    static const uint8_t kAud[] = {0x00, 0x00, 0x00, 0x01, 0x09, 0xf0};
+    std::vector<uint8_t> frame(kAud, kAud + sizeof(kAud));
+    // first_mb_in_slice = 0
+    const uint8_t slice[] = {0x00, 0x00, 0x00, 0x01, (uint8_t)(idr ? 0x65 : 0x41), 0x88};
+    frame.insert(frame.end(), slice, slice + sizeof(slice));
+    for (size_t i = frame.size(); i < kFrameSize; ++i) {
+        frame.push_back(0x80 | (i & 0x7f));
+    }
+    return frame;
+}
+
+// Args: frames per PES payload.
+static void BM_ESQueueH264(benchmark::State& state) {
+    const size_t framesPerPes = state.range(0);
+    std::vector<uint8_t> pes;
+    for (size_t i = 0; i < framesPerPes; ++i) {
+        const std::vector<uint8_t> frame = makeFrame(i == 0 /* idr */);
+        pes.insert(pes.end(), frame.begin(), frame.end());
+    }
+
+    ElementaryStreamQueue queue(ElementaryStreamQueue::H264);
+    int64_t timeUs = 0;
+    size_t accessUnits = 0;
+    for (auto _ : state) {
+        if (queue.appendData(pes.data(), pes.size(), timeUs) != OK) {
+            state.SkipWithError("appendData failed");
+            break;
+        }
+        timeUs += framesPerPes * kFrameDurationUs;
+        sp<ABuffer> accessUnit;
+        while ((accessUnit = queue.dequeueAccessUnit()) != nullptr) {
+            benchmark::DoNotOptimize(accessUnit->data());
+            ++accessUnits;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * pes.size());
+    state.counters["accessUnits"] = accessUnits;
+}
+
+BENCHMARK(BM_ESQueueH264)->Arg(1)->Arg(8)->Arg(30);
+
+static constexpr size_t kTSPacketSize = 188;
+static constexpr unsigned kPmtPID = 0x100;
+static constexpr unsigned kVideoPID = 0x101;
+static constexpr size_t kIdrInterval = 30;
+// The number of packets MPEG2TSExtractor::feedMore() feeds at once.
+static constexpr size_t kFeedPackets = 32;
+
+// CRC-32/MPEG-2 of PSI sections.
+static uint32_t crc32(const uint8_t *data, size_t size) {
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= (uint32_t)data[i] << 24;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+class TSWriter {
+public:
+    const std::vector<uint8_t> &data() const { return mData; }
+
+    void writeSection(unsigned pid, std::vector<uint8_t> section) {
+        const uint32_t crc = crc32(section.data(), section.size());
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            section.push_back(crc >> shift);
+        }
+        section.insert(section.begin(), 0x00);  // pointer_field
+        writePackets(pid, section.data(), section.size(), 0xff /* padding */);
+    }
+
+    void writePes(unsigned pid, const std::vector<uint8_t> &payload, uint64_t pts) {
+        std::vector<uint8_t> pes = {
+            0x00, 0x00, 0x01, 0xe0,  // video stream
+            0x00, 0x00,              // unbounded PES_packet_length
+            0x84,                    // data_alignment_indicator
+            0x80,                    // PTS only
+            0x05,                    // PES_header_data_length
+            (uint8_t)(0x21 | ((pts >> 29) & 0x0e)),
+            (uint8_t)(pts >> 22),
+            (uint8_t)(0x01 | ((pts >> 14) & 0xfe)),
+            (uint8_t)(pts >> 7),
+            (uint8_t)(0x01 | ((pts << 1) & 0xfe)),
+        };
+        pes.insert(pes.end(), payload.begin(), payload.end());
+        writePackets(pid, pes.data(), pes.size(), -1 /* stuffing */);
+    }
+
+private:
+    std::vector<uint8_t> mData;
+    uint8_t mContinuityCounters[0x2000] = {};
+
+    // Splits data into packets of pid. If padding is negative, the last packet
+    // is completed with adaptation field stuffing, otherwise with padding.
+    void writePackets(unsigned pid, const uint8_t *data, size_t size, int padding) {
+        bool start = true;
+        while (size > 0) {
+            size_t payloadSize = std::min(size, kTSPacketSize - 4);
+            const size_t stuffingSize =
+                    (padding < 0) ? kTSPacketSize - 4 - payloadSize : 0;
+            mData.push_back(0x47);
+            mData.push_back((start ? 0x40 : 0x00) | (pid >> 8));
+            mData.push_back(pid & 0xff);
+            mData.push_back((stuffingSize > 0 ? 0x30 : 0x10)
+                    | (mContinuityCounters[pid]++ & 0x0f));
+            if (stuffingSize > 0) {
+                mData.push_back(stuffingSize - 1);  // adaptation_field_length
+                if (stuffingSize > 1) {
+                    mData.push_back(0x00);  // no flags
+                    mData.insert(mData.end(), stuffingSize - 2, 0xff);
+                }
+            }
+            mData.insert(mData.end(), data, data + payloadSize);
+            if (padding >= 0) {
+                mData.insert(mData.end(), kTSPacketSize - 4 - payloadSize, padding);
+            }
+            data += payloadSize;
+            size -= payloadSize;
+            start = false;
+        }
+    }
+};
+
+// One second of a single program with a 3840x2160 baseline H.264 stream,
+// with the PAT and PMT repeated before each IDR frame.
+static const std::vector<uint8_t> &getTransportStream() {
+    static const std::vector<uint8_t> ts = [] {
+        static const uint8_t kSpsPps[] = {
+            0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0xc0, 0x33, 0xda, 0x00, 0xf0, 0x01, 0x0f, 0x90,
+            0x00, 0x00, 0x00, 0x01, 0x68, 0xce, 0x3c, 0x80,
+        };
+        const std::vector<uint8_t> pat = {
+            0x00, 0xb0, 0x0d, 0x00, 0x01, 0xc1, 0x00, 0x00,
+            0x00, 0x01, 0xe0 | (kPmtPID >> 8), kPmtPID & 0xff,  // program 1
+        };
+        const std::vector<uint8_t> pmt = {
+            0x02, 0xb0, 0x12, 0x00, 0x01, 0xc1, 0x00, 0x00,
+            0xe0 | (kVideoPID >> 8), kVideoPID & 0xff,  // PCR_PID
+            0xf0, 0x00,
+            0x1b, 0xe0 | (kVideoPID >> 8), kVideoPID & 0xff, 0xf0, 0x00,  // H.264
+        };
+        TSWriter writer;
+        for (size_t i = 0; i < kFrameRate; ++i) {
+            const bool idr = (i % kIdrInterval) == 0;
+            std::vector<uint8_t> frame = makeFrame(idr);
+            if (idr) {
+                writer.writeSection(0 /* pid */, pat);
+                writer.writeSection(kPmtPID, pmt);
+                // After the access unit delimiter.
+                frame.insert(frame.begin() + 6, kSpsPps, kSpsPps + sizeof(kSpsPps));
+            }
+            writer.writePes(kVideoPID, frame, 90000 + i * 90000 / kFrameRate);
+        }
+        return writer.data();
+    }();
+    return ts;
+}
+
+static size_t drainVideo(const sp<ATSParser> &parser) {
+    sp<AnotherPacketSource> source = parser->getSource(ATSParser::VIDEO);
+    size_t accessUnits = 0;
+    status_t finalResult;
+    while (source != NULL && source->hasBufferAvailable(&finalResult)) {
+        sp<ABuffer> accessUnit;
+        source->dequeueAccessUnit(&accessUnit);
+        ++accessUnits;
+    }
+    return accessUnits;
+}
+
+// As MPEG2TSExtractor did before feeding several packets at once.
+static void BM_ATSParserFeedTSPacket(benchmark::State& state) {
+    const std::vector<uint8_t> &ts = getTransportStream();
+    size_t accessUnits = 0;
+    for (auto _ : state) {
+        sp<ATSParser> parser = new ATSParser;
+        for (size_t offset = 0; offset < ts.size(); offset += kTSPacketSize) {
+            ATSParser::SyncEvent event(offset);
+            if (parser->feedTSPacket(&ts[offset], kTSPacketSize, &event) != OK) {
+                state.SkipWithError("feedTSPacket failed");
+                break;
+            }
+        }
+        accessUnits += drainVideo(parser);
+    }
+    state.SetBytesProcessed(state.iterations() * ts.size());
+    state.counters["accessUnits"] = accessUnits;
+}
+
+BENCHMARK(BM_ATSParserFeedTSPacket);
+
+// As MPEG2TSExtractor::feedMore().
+static void BM_ATSParserFeedTSPackets(benchmark::State& state) {
+    const std::vector<uint8_t> &ts = getTransportStream();
+    size_t accessUnits = 0;
+    for (auto _ : state) {
+        sp<ATSParser> parser = new ATSParser;
+        for (size_t offset = 0; offset < ts.size();) {
+            ATSParser::SyncEvent event(offset);
+            size_t consumed;
+            if (parser->feedTSPackets(&ts[offset],
+                    std::min(ts.size() - offset, kFeedPackets * kTSPacketSize),
+                    &consumed, &event) != OK) {
+                state.SkipWithError("feedTSPackets failed");
+                break;
+            }
+            offset += consumed;
+        }
+        accessUnits += drainVideo(parser);
+    }
+    state.SetBytesProcessed(state.iterations() * ts.size());
+    state.counters["accessUnits"] = accessUnits;
+}
+
+BENCHMARK(BM_ATSParserFeedTSPackets);
+
+BENCHMARK_MAIN();
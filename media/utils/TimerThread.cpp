@@ -16,6 +16,7 @@
 
 #define LOG_TAG "TimerThread"
 
+#include <algorithm>
 #include <optional>
 #include <sstream>
 #include <unistd.h>
@@ -56,7 +57,7 @@ bool TimerThread::cancelTask(Handle handle) {
     std::shared_ptr<const Request> request = isNoTimeoutHandle(handle) ?
              mNoTimeoutMap.remove(handle) : mMonitorThread.remove(handle);
     if (!request) return false;
-    mRetiredQueue.add(std::move(request));
+    mRetiredQueue.add(std::move(request), getShardIndex(handle));
     return true;
 }
 
@@ -275,49 +276,47 @@ std::string TimerThread::Request::toString() const {
         .append(" tid ").append(std::to_string(tid));
 }
 
-void TimerThread::RequestQueue::add(std::shared_ptr<const Request> request) {
-    std::lock_guard lg(mRQMutex);
-    mRequestQueue.emplace_back(std::chrono::system_clock::now(), std::move(request));
-    if (mRequestQueue.size() > mRequestQueueMax) {
-        mRequestQueue.pop_front();
+void TimerThread::RequestQueue::add(std::shared_ptr<const Request> request, size_t shardIndex) {
+    Shard& shard = mShards[shardIndex & mask_from_count_v<SHARD_COUNT>];
+    std::lock_guard lg(shard.mRQMutex);
+    shard.mRequestQueue.emplace_back(std::chrono::system_clock::now(), std::move(request));
+    if (shard.mRequestQueue.size() > mRequestQueueMax) {
+        shard.mRequestQueue.pop_front();
     }
 }
 
 void TimerThread::RequestQueue::copyRequests(
         std::vector<std::shared_ptr<const Request>>& requests, size_t n) const {
-    std::lock_guard lg(mRQMutex);
-    const size_t size = mRequestQueue.size();
-    size_t i = n >=  size ? 0 : size - n;
+    std::vector<std::pair<std::chrono::system_clock::time_point,
+                          std::shared_ptr<const Request>>> merged;
+    for (const Shard& shard : mShards) {
+        std::lock_guard lg(shard.mRQMutex);
+        merged.insert(merged.end(), shard.mRequestQueue.begin(), shard.mRequestQueue.end());
+    }
+    // Merge the shards in order of add(), keeping at most the last mRequestQueueMax.
+    std::stable_sort(merged.begin(), merged.end(),
+            [](const auto& r1, const auto& r2) { return r1.first < r2.first; });
+    const size_t size = merged.size();
+    size_t i = size - std::min({n, size, mRequestQueueMax});
     for (; i < size; ++i) {
-        const auto &[time, request] = mRequestQueue[i];
-        requests.emplace_back(request);
+        requests.emplace_back(std::move(merged[i].second));
     }
 }
 
 TimerThread::Handle TimerThread::NoTimeoutMap::add(std::shared_ptr<const Request> request) {
-    std::lock_guard lg(mNTMutex);
-    // A unique handle is obtained by mNoTimeoutRequests.fetch_add(1),
-    // This need not be under a lock, but we do so anyhow.
-    const Handle handle = getUniqueHandle_l();
-    mMap[handle] = request;
-    return handle;
+    const pid_t tid = request->tid;
+    return mMap.add(tid, HANDLE_TYPE::NO_TIMEOUT, Duration{} /* timeout */, std::move(request));
 }
 
 std::shared_ptr<const TimerThread::Request> TimerThread::NoTimeoutMap::remove(Handle handle) {
-    std::lock_guard lg(mNTMutex);
-    auto it = mMap.find(handle);
-    if (it == mMap.end()) return {};
-    auto request = it->second;
-    mMap.erase(it);
-    return request;
+    return mMap.remove(handle).value_or(nullptr);
 }
 
 void TimerThread::NoTimeoutMap::copyRequests(
         std::vector<std::shared_ptr<const Request>>& requests) const {
-    std::lock_guard lg(mNTMutex);
-    for (const auto &[handle, request] : mMap) {
+    mMap.forEach([&requests](const std::shared_ptr<const Request>& request) {
         requests.emplace_back(request);
-    }
+    });
 }
 
 TimerThread::MonitorThread::MonitorThread(RequestQueue& timeoutQueue)
@@ -339,16 +338,22 @@ TimerThread::MonitorThread::~MonitorThread() {
 void TimerThread::MonitorThread::threadFunc() {
     std::unique_lock _l(mMutex);
     ::android::base::ScopedLockAssertion lock_assertion(mMutex);
+    std::vector<std::pair<Handle, MonitorRequest>> expired;
     while (!mShouldExit) {
-        Handle nextDeadline = INVALID_HANDLE;
-        Handle now = INVALID_HANDLE;
-        if (!mMonitorRequests.empty()) {
-            nextDeadline = mMonitorRequests.begin()->first;
-            now = std::chrono::steady_clock::now();
-            if (nextDeadline < now) {
-                auto node = mMonitorRequests.extract(mMonitorRequests.begin());
-                // Deadline has expired, handle the request.
-                auto secondChanceDuration = node.mapped().first->secondChanceDuration;
+        // While we scan, a concurrent add() may be missed, so it must notify.
+        mWakeDeadline.store(Handle::max().time_since_epoch().count());
+        const Handle now = std::chrono::steady_clock::now();
+        Handle nextDeadline = mMonitorRequests.extractExpired(now, expired);
+        if (!expired.empty()) {
+            // Deadlines have expired, handle the requests in deadline order.
+            std::sort(expired.begin(), expired.end(),
+                    [](const auto& e1, const auto& e2) { return e1.first < e2.first; });
+
+            // Move the requests with a second chance while we hold the lock,
+            // so that a concurrent remove() finds them in mSecondChanceRequests.
+            bool timedOut = false;
+            for (auto& [handle, data] : expired) {
+                auto secondChanceDuration = data.first->secondChanceDuration;
                 if (secondChanceDuration.count() != 0) {
                     // We now apply the second chance duration to find the clock
                     // monotonic second deadline.  The unique key is then the
@@ -358,34 +363,38 @@ void TimerThread::MonitorThread::threadFunc() {
                     // any clock monotonic advancement during suspend.
                     auto newHandle = now + secondChanceDuration;
                     ALOGD("%s: TimeCheck second chance applied for %s",
-                            __func__, node.mapped().first->tag.c_str()); // should be rare event.
+                            __func__, data.first->tag.c_str()); // should be rare event.
                     mSecondChanceRequests.emplace_hint(mSecondChanceRequests.end(),
-                            std::make_pair(newHandle, nextDeadline),
-                            std::move(node.mapped()));
+                            std::make_pair(newHandle, handle), std::move(data));
                     // increment second chance counter.
                     mSecondChanceCount.fetch_add(1 /* arg */, std::memory_order_relaxed);
                 } else {
-                    {
-                        _l.unlock();
-                        // We add Request to retired queue early so that it can be dumped out.
-                        mTimeoutQueue.add(std::move(node.mapped().first));
-                        node.mapped().second(nextDeadline);
-                        // Caution: we don't hold lock when we call TimerCallback,
-                        // but this is the timeout case!  We will crash soon,
-                        // maybe before returning.
-                        // anything left over is released here outside lock.
-                    }
-                    // reacquire the lock - if something was added, we loop immediately to check.
-                    _l.lock();
+                    timedOut = true;
                 }
-                // always process expiring monitor requests first.
-                continue;
             }
+            if (timedOut) {
+                _l.unlock();
+                for (auto& [handle, data] : expired) {
+                    if (!data.first) continue;  // moved to mSecondChanceRequests.
+                    // We add Request to retired queue early so that it can be dumped out.
+                    mTimeoutQueue.add(std::move(data.first));
+                    data.second(handle);
+                    // Caution: we don't hold lock when we call TimerCallback,
+                    // but this is the timeout case!  We will crash soon,
+                    // maybe before returning.
+                }
+                // anything left over is released here outside lock.
+                expired.clear();
+                // reacquire the lock - if something was added, we loop immediately to check.
+                _l.lock();
+            }
+            expired.clear();
+            // always process expiring monitor requests first.
+            continue;
         }
         // now process any second chance requests.
         if (!mSecondChanceRequests.empty()) {
             Handle secondDeadline = mSecondChanceRequests.begin()->first.first;
-            if (now == INVALID_HANDLE) now = std::chrono::steady_clock::now();
             if (secondDeadline < now) {
                 auto node = mSecondChanceRequests.extract(mSecondChanceRequests.begin());
                 {
@@ -405,13 +414,12 @@ void TimerThread::MonitorThread::threadFunc() {
                 continue;
             }
             // update the deadline.
-            if (nextDeadline == INVALID_HANDLE) {
-                nextDeadline = secondDeadline;
-            } else {
-                nextDeadline = std::min(nextDeadline, secondDeadline);
-            }
+            nextDeadline = std::min(nextDeadline, secondDeadline);
         }
-        if (nextDeadline != INVALID_HANDLE) {
+        // A concurrent add() with an earlier deadline now notifies,
+        // which waits on mMutex until we wait on mCond.
+        mWakeDeadline.store(nextDeadline.time_since_epoch().count());
+        if (nextDeadline != Handle::max()) {
             mCond.wait_until(_l, nextDeadline);
         } else {
             mCond.wait(_l);
@@ -421,27 +429,28 @@ void TimerThread::MonitorThread::threadFunc() {
 
 TimerThread::Handle TimerThread::MonitorThread::add(
         std::shared_ptr<const Request> request, TimerCallback&& func, Duration timeout) {
-    std::lock_guard _l(mMutex);
-    const Handle handle = getUniqueHandle_l(timeout);
-    mMonitorRequests.emplace_hint(mMonitorRequests.end(),
-            handle, std::make_pair(std::move(request), std::move(func)));
-    mCond.notify_all();
+    const pid_t tid = request->tid;
+    const Handle handle = mMonitorRequests.add(tid, HANDLE_TYPE::TIMEOUT, timeout,
+            std::make_pair(std::move(request), std::move(func)));
+    // Most requests are cancelled long before the deadline the thread waits for,
+    // so only wake the thread if this request expires earlier.
+    if (handle.time_since_epoch().count() < mWakeDeadline.load()) {
+        std::lock_guard _l(mMutex);
+        mCond.notify_all();
+    }
     return handle;
 }
 
 std::shared_ptr<const TimerThread::Request> TimerThread::MonitorThread::remove(Handle handle) {
+    if (auto data = mMonitorRequests.remove(handle)) {
+        return std::move(data->first);  // request, func (data->second) is released
+                                        // outside of lock.
+    }
+
+    // The request may have expired and been given a second chance.
     std::pair<std::shared_ptr<const Request>, TimerCallback> data;
     std::unique_lock ul(mMutex);
     ::android::base::ScopedLockAssertion lock_assertion(mMutex);
-    if (const auto it = mMonitorRequests.find(handle);
-        it != mMonitorRequests.end()) {
-        data = std::move(it->second);
-        mMonitorRequests.erase(it);
-        ul.unlock();  // manually release lock here so func (data.second)
-                      // is released outside of lock.
-        return data.first;  // request
-    }
-
     // this check is O(N), but since the second chance requests are ordered
     // in terms of earliest expiration time, we would expect better than average results.
     for (auto it = mSecondChanceRequests.begin(); it != mSecondChanceRequests.end(); ++it) {
@@ -458,14 +467,12 @@ std::shared_ptr<const TimerThread::Request> TimerThread::MonitorThread::remove(H
 
 void TimerThread::MonitorThread::copyRequests(
         std::vector<std::shared_ptr<const Request>>& requests) const {
-    std::lock_guard lg(mMutex);
-    for (const auto &[deadline, monitorpair] : mMonitorRequests) {
+    mMonitorRequests.forEach([&requests](const MonitorRequest& monitorpair) {
         requests.emplace_back(monitorpair.first);
-    }
+    });
     // we combine the second map with the first map - this is
     // everything that is pending on the monitor thread.
-    // The second map will be older than the first map so this
-    // is in order.
+    std::lock_guard lg(mMutex);
     for (const auto &[deadline, monitorpair] : mSecondChanceRequests) {
         requests.emplace_back(monitorpair.first);
     }
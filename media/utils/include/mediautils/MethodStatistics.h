@@ -16,9 +16,16 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <sstream>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <android-base/thread_annotations.h>
@@ -35,6 +42,13 @@ namespace android::mediautils {
  *
  * Here, Code is the enumeration type for the method
  * lookup.
+ *
+ * Events for the codes in the method map are assigned a dense index
+ * and buffered per calling thread, in a single producer single consumer queue
+ * registered with the MethodStatistics on the first event of the thread.
+ * event() takes no lock, so concurrent binder threads do not contend.
+ * The buffered events are merged into the statistics, under mLock, before
+ * the statistics are read, or by the calling thread when its queue is full.
  */
 template <typename Code>
 class MethodStatistics {
@@ -50,13 +64,42 @@ public:
      */
     explicit MethodStatistics(
             const std::initializer_list<std::pair<const Code, std::string>>& methodMap = {})
-        : mMethodMap{methodMap} {}
+        : mMethodMap{methodMap} {
+        // The index follows the method map order, which is the code order.
+        for (const auto& [code, name] : mMethodMap) {
+            mCodeToIndex.emplace(code, mIndexedCodes.size());
+            mIndexedCodes.push_back(code);
+        }
+        std::lock_guard lg(mLock);
+        mIndexedStatistics.resize(mIndexedCodes.size());
+    }
+
+    ~MethodStatistics() {
+        // Threads which sent events keep a reference to their queue, let them release it.
+        std::lock_guard lg(mLock);
+        for (const auto& threadEvents : mThreadEvents) {
+            threadEvents->mOwnerDestroyed.store(true, std::memory_order_release);
+        }
+    }
 
     /**
      * Adds a method event, typically execution time in ms.
      */
     template <typename C>
     void event(C&& code, FloatType executeMs) {
+        if (const size_t index = getIndexForCode(code); index != kNoIndex) {
+            ThreadEvents& threadEvents = getThreadEvents();
+            const size_t rear = threadEvents.mRear.load(std::memory_order_relaxed);
+            if (rear - threadEvents.mFront.load(std::memory_order_acquire)
+                    == ThreadEvents::kCapacity) {
+                // Only if nothing read the statistics for kCapacity events of this thread.
+                std::lock_guard lg(mLock);
+                merge_l(threadEvents);
+            }
+            threadEvents.mEvents[rear & (ThreadEvents::kCapacity - 1)] = {index, executeMs};
+            threadEvents.mRear.store(rear + 1, std::memory_order_release);
+            return;
+        }
         std::lock_guard lg(mLock);
         auto it = mStatisticsMap.lower_bound(code);
         if (it != mStatisticsMap.end() && it->first == static_cast<Code>(code)) {
@@ -80,15 +123,18 @@ public:
      * Returns the number of times the method was invoked by event().
      */
     size_t getMethodCount(const Code& code) const {
-        std::lock_guard lg(mLock);
-        auto it = mStatisticsMap.find(code);
-        return it == mStatisticsMap.end() ? 0 : it->second.getN();
+        return getStatistics(code).getN();
     }
 
     /**
      * Returns the statistics object for the method.
      */
     StatsType getStatistics(const Code& code) const {
+        if (const size_t index = getIndexForCode(code); index != kNoIndex) {
+            flushAll();
+            std::lock_guard lg(mLock);
+            return mIndexedStatistics[index];
+        }
         std::lock_guard lg(mLock);
         auto it = mStatisticsMap.find(code);
         return it == mStatisticsMap.end() ? StatsType{} : it->second;
@@ -99,25 +145,131 @@ public:
      */
     std::string dump() const {
         std::stringstream ss;
+        flushAll();
         std::lock_guard lg(mLock);
+        // Merge the indexed methods with events into the code order.
+        std::map<Code, const StatsType*, std::less<>> statisticsMap;
+        for (size_t i = 0; i < mIndexedStatistics.size(); ++i) {
+            if (mIndexedStatistics[i].getN() != 0) {
+                statisticsMap.emplace(mIndexedCodes[i], &mIndexedStatistics[i]);
+            }
+        }
+        for (const auto &[code, stats] : mStatisticsMap) {
+            statisticsMap.emplace(code, &stats);
+        }
         if constexpr (std::is_same_v<Code, std::string>) {
-            for (const auto &[code, stats] : mStatisticsMap) {
+            for (const auto &[code, stats] : statisticsMap) {
                 ss << code <<
-                        " n=" << stats.getN() << " " << stats.toString() << "\n";
+                        " n=" << stats->getN() << " " << stats->toString() << "\n";
             }
         } else /* constexpr */ {
-            for (const auto &[code, stats] : mStatisticsMap) {
+            for (const auto &[code, stats] : statisticsMap) {
                 ss << int(code) << " " << getMethodForCode(code) <<
-                        " n=" << stats.getN() << " " << stats.toString() << "\n";
+                        " n=" << stats->getN() << " " << stats->toString() << "\n";
             }
         }
         return ss.str();
     }
 
 private:
+    static constexpr size_t kNoIndex = SIZE_MAX;
+
+    // The events of one thread, as pairs of index and value.
+    // The thread appends at mRear, and events are merged from mFront with mLock held.
+    struct alignas(64) ThreadEvents {  // avoid false sharing between threads
+        static constexpr size_t kCapacity = 256;  // power of 2.
+        std::array<std::pair<size_t, FloatType>, kCapacity> mEvents;
+        std::atomic<size_t> mRear{};   // written by the thread.
+        std::atomic<size_t> mFront{};  // written with mLock held.
+        std::atomic<bool> mThreadExited{};
+        std::atomic<bool> mOwnerDestroyed{};
+    };
+
+    // The queues of a thread, one per MethodStatistics it sent events to.
+    struct ThreadLocalEvents {
+        std::vector<std::pair<uint64_t /* id */, std::shared_ptr<ThreadEvents>>> mEntries;
+        ~ThreadLocalEvents() {
+            for (const auto& [id, threadEvents] : mEntries) {
+                threadEvents->mThreadExited.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    // Returns the queue of the calling thread, registering it on the first call.
+    ThreadEvents& getThreadEvents() {
+        thread_local ThreadLocalEvents threadLocalEvents;
+        auto& entries = threadLocalEvents.mEntries;
+        // Instances are few, and the most recent is likely the one called again.
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+            if (it->first == mId) return *it->second;
+        }
+        std::erase_if(entries, [](const auto& entry) {
+            return entry.second->mOwnerDestroyed.load(std::memory_order_acquire);
+        });
+        auto threadEvents = std::make_shared<ThreadEvents>();
+        {
+            std::lock_guard lg(mLock);
+            mThreadEvents.push_back(threadEvents);
+        }
+        return *entries.emplace_back(mId, std::move(threadEvents)).second;
+    }
+
+    // Ids rather than addresses identify instances, as an address may be reused.
+    static uint64_t getNextId() {
+        static std::atomic<uint64_t> nextId{};
+        return nextId.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Returns the dense index for the code, or kNoIndex if not in the method map.
+    // mCodeToIndex is not modified after construction, so no lock is needed.
+    template <typename C>
+    size_t getIndexForCode(const C& code) const {
+        if constexpr (kHashCodes) {
+            const auto it = mCodeToIndex.find(static_cast<Code>(code));
+            return it == mCodeToIndex.end() ? kNoIndex : it->second;
+        } else /* constexpr */ {
+            const auto it = mCodeToIndex.find(code);
+            return it == mCodeToIndex.end() ? kNoIndex : it->second;
+        }
+    }
+
+    void merge_l(ThreadEvents& threadEvents) const REQUIRES(mLock) {
+        const size_t front = threadEvents.mFront.load(std::memory_order_relaxed);
+        const size_t rear = threadEvents.mRear.load(std::memory_order_acquire);
+        for (size_t i = front; i != rear; ++i) {
+            const auto& [index, value] = threadEvents.mEvents[i & (ThreadEvents::kCapacity - 1)];
+            mIndexedStatistics[index].add(value);
+        }
+        threadEvents.mFront.store(rear, std::memory_order_release);
+    }
+
+    void flushAll() const EXCLUDES(mLock) {
+        std::lock_guard lg(mLock);
+        for (const auto& threadEvents : mThreadEvents) {
+            merge_l(*threadEvents);
+        }
+        // The queues of exited threads are released once merged.
+        std::erase_if(mThreadEvents, [](const auto& threadEvents) {
+            return threadEvents->mThreadExited.load(std::memory_order_acquire)
+                    && threadEvents->mFront.load(std::memory_order_relaxed)
+                            == threadEvents->mRear.load(std::memory_order_acquire);
+        });
+    }
+
+    // Integral and enum codes are hashed, others (std::string) use a transparent
+    // comparator for heterogeneous key lookup.
+    static constexpr bool kHashCodes = std::is_integral_v<Code> || std::is_enum_v<Code>;
+
     // Note: we use a transparent comparator std::less<> for heterogeneous key lookup.
     const std::map<Code, std::string, std::less<>> mMethodMap;
+    std::conditional_t<kHashCodes, std::unordered_map<Code, size_t>,
+            std::map<Code, size_t, std::less<>>> mCodeToIndex;  // const after ctor
+    std::vector<Code> mIndexedCodes;                            // const after ctor
+    const uint64_t mId = getNextId();
+
     mutable std::mutex mLock;
+    mutable std::vector<std::shared_ptr<ThreadEvents>> mThreadEvents GUARDED_BY(mLock);
+    mutable std::vector<StatsType> mIndexedStatistics GUARDED_BY(mLock);
     std::map<Code, StatsType, std::less<>> mStatisticsMap GUARDED_BY(mLock);
 };
 
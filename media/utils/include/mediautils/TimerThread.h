@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <deque>
@@ -23,8 +24,10 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <android-base/thread_annotations.h>
@@ -90,21 +93,46 @@ class TimerThread {
                 enum_as_value(HANDLE_TYPE::TIMEOUT);
     }
 
-    // Returns a unique Handle that doesn't exist in the container.
-    template <size_t MAX_TYPED_HANDLES, size_t HANDLE_TYPE_AS_VALUE, typename C, typename T>
-    static Handle getUniqueHandleForHandleType_l(C container, T timeout) {
-        static_assert(MAX_TYPED_HANDLES > 0 && HANDLE_TYPE_AS_VALUE < MAX_TYPED_HANDLES
-                && is_power_of_2_v<MAX_TYPED_HANDLES>,
+    // Pending and retired requests are split into SHARD_COUNT independently locked
+    // shards, selected by the thread id of the caller, so that scheduleTask() and
+    // cancelTask() from different threads rarely contend.
+    //
+    // The shard is encoded in the Handle lsbs above the HANDLE_TYPE, so cancelTask()
+    // finds the request without search.
+    //
+    // SHARD_COUNT is part of the class layout and of the inline methods below, and this
+    // header is included through TimeCheck.h by modules built with their own flags,
+    // so it is not selectable at build time: every translation unit must agree on it.
+    // Change it here, 1 gives a single lock.
+    static constexpr size_t SHARD_COUNT = 8;
+    // SHARD_COUNT must be a power of 2.
+    static_assert(is_power_of_2_v<SHARD_COUNT>);
+
+    // The number of distinct Handle lsb values, for each HANDLE_TYPE in each shard.
+    static constexpr size_t HANDLE_KEYS = HANDLE_TYPES * SHARD_COUNT;
+
+    static inline size_t getShardIndex(Handle handle) {
+        return (handle.time_since_epoch().count() & mask_from_count_v<HANDLE_KEYS>)
+                / HANDLE_TYPES;
+    }
+
+    // Returns a unique Handle that doesn't exist in the container, with the
+    // lsbs modulo MAX_TYPED_HANDLES equal to handleTypeAsValue.
+    template <size_t MAX_TYPED_HANDLES, typename C, typename T>
+    static Handle getUniqueHandleForHandleType_l(
+            const C& container, T timeout, size_t handleTypeAsValue) {
+        static_assert(MAX_TYPED_HANDLES > 0 && is_power_of_2_v<MAX_TYPED_HANDLES>,
                 " handles must be power of two");
 
         // Our initial handle is the deadline as computed from steady_clock.
         auto deadline = std::chrono::steady_clock::now() + timeout;
 
         // We adjust the lsbs by the minimum increment to have the correct
-        // HANDLE_TYPE in the least significant bits.
-        auto remainder = deadline.time_since_epoch().count() & HANDLE_TYPE_MASK;
-        size_t offset = HANDLE_TYPE_AS_VALUE > remainder ? HANDLE_TYPE_AS_VALUE - remainder :
-                     MAX_TYPED_HANDLES + HANDLE_TYPE_AS_VALUE - remainder;
+        // HANDLE_TYPE (and shard) in the least significant bits.
+        const size_t remainder = deadline.time_since_epoch().count()
+                & mask_from_count_v<MAX_TYPED_HANDLES>;
+        size_t offset = handleTypeAsValue > remainder ? handleTypeAsValue - remainder :
+                     MAX_TYPED_HANDLES + handleTypeAsValue - remainder;
         deadline += std::chrono::steady_clock::duration(offset);
 
         // To avoid key collisions, advance the handle by MAX_TYPED_HANDLES (the modulus factor)
@@ -279,13 +307,14 @@ class TimerThread {
 
   private:
     // Deque of requests, in order of add().
+    // Each shard has its own deque of up to maxSize requests, merged on copy.
     // This class is thread-safe.
     class RequestQueue {
       public:
         explicit RequestQueue(size_t maxSize)
             : mRequestQueueMax(maxSize) {}
 
-        void add(std::shared_ptr<const Request>);
+        void add(std::shared_ptr<const Request>, size_t shardIndex = 0);
 
         // return up to the last "n" requests retired.
         void copyRequests(std::vector<std::shared_ptr<const Request>>& requests,
@@ -293,23 +322,93 @@ class TimerThread {
 
       private:
         const size_t mRequestQueueMax;
-        mutable std::mutex mRQMutex;
-        std::deque<std::pair<std::chrono::system_clock::time_point,
-                             std::shared_ptr<const Request>>>
-                mRequestQueue GUARDED_BY(mRQMutex);
+        struct alignas(64) Shard {  // avoid false sharing between shards
+            mutable std::mutex mRQMutex;
+            std::deque<std::pair<std::chrono::system_clock::time_point,
+                                 std::shared_ptr<const Request>>>
+                    mRequestQueue GUARDED_BY(mRQMutex);
+        };
+        std::array<Shard, SHARD_COUNT> mShards;
+    };
+
+    // A map of Handle to T with O(1) add and remove, split into SHARD_COUNT
+    // independently locked hash maps.
+    // This class is thread-safe.
+    template <typename T>
+    class ShardedHandleMap {
+      public:
+        // Adds value with a unique handle of handleType, for a deadline of now + timeout,
+        // to the shard selected by tid.
+        Handle add(pid_t tid, HANDLE_TYPE handleType, Duration timeout, T&& value) {
+            const size_t shardIndex = static_cast<size_t>(tid) & mask_from_count_v<SHARD_COUNT>;
+            Shard& shard = mShards[shardIndex];
+            std::lock_guard lg(shard.mMutex);
+            const Handle handle = getUniqueHandleForHandleType_l<HANDLE_KEYS>(
+                    shard.mMap, timeout, enum_as_value(handleType) + shardIndex * HANDLE_TYPES);
+            shard.mMap.emplace(handle, std::move(value));
+            return handle;
+        }
+
+        // Removes the value with the handle. The value is destroyed by the caller,
+        // outside of the lock.
+        std::optional<T> remove(Handle handle) {
+            Shard& shard = mShards[getShardIndex(handle)];
+            std::lock_guard lg(shard.mMutex);
+            auto node = shard.mMap.extract(handle);
+            if (node.empty()) return {};
+            return std::move(node.mapped());
+        }
+
+        // Moves the values with a handle before deadline to expired,
+        // and returns the earliest remaining handle, or Handle::max() if none.
+        Handle extractExpired(Handle deadline, std::vector<std::pair<Handle, T>>& expired) {
+            Handle next = Handle::max();
+            for (Shard& shard : mShards) {
+                std::lock_guard lg(shard.mMutex);
+                for (auto it = shard.mMap.begin(); it != shard.mMap.end(); ) {
+                    if (it->first < deadline) {
+                        expired.emplace_back(it->first, std::move(it->second));
+                        it = shard.mMap.erase(it);
+                    } else {
+                        next = std::min(next, it->first);
+                        ++it;
+                    }
+                }
+            }
+            return next;
+        }
+
+        // Calls f(value) for each value, with the lock of its shard held.
+        template <typename F>
+        void forEach(F&& f) const {
+            for (const Shard& shard : mShards) {
+                std::lock_guard lg(shard.mMutex);
+                for (const auto& [handle, value] : shard.mMap) {
+                    f(value);
+                }
+            }
+        }
+
+      private:
+        // The lsbs of a Handle are identical in a shard, so hash without them.
+        struct HandleHash {
+            size_t operator()(Handle handle) const {
+                return std::hash<Duration::rep>{}(
+                        handle.time_since_epoch().count() / HANDLE_KEYS);
+            }
+        };
+        struct alignas(64) Shard {  // avoid false sharing between shards
+            mutable std::mutex mMutex;
+            std::unordered_map<Handle, T, HandleHash> mMap GUARDED_BY(mMutex);
+        };
+        std::array<Shard, SHARD_COUNT> mShards;
     };
 
     // A storage map of tasks without timeouts.  There is no TimerCallback
     // required, it just tracks the tasks with the tag, scheduled time and the tid.
     // These tasks show up on a pendingToString() until manually cancelled.
     class NoTimeoutMap {
-        mutable std::mutex mNTMutex;
-        std::map<Handle, std::shared_ptr<const Request>> mMap GUARDED_BY(mNTMutex);
-        Handle getUniqueHandle_l() REQUIRES(mNTMutex) {
-            return getUniqueHandleForHandleType_l<
-                    HANDLE_TYPES, enum_as_value(HANDLE_TYPE::NO_TIMEOUT)>(
-                mMap, Duration{} /* timeout */);
-        }
+        ShardedHandleMap<std::shared_ptr<const Request>> mMap;  // locked internally
 
       public:
         bool isValidHandle(Handle handle) const; // lock free
@@ -327,10 +426,17 @@ class TimerThread {
         mutable std::mutex mMutex;
         mutable std::condition_variable mCond GUARDED_BY(mMutex);
 
-        // Ordered map of requests based on time of deadline.
-        //
-        std::map<Handle, std::pair<std::shared_ptr<const Request>, TimerCallback>>
-                mMonitorRequests GUARDED_BY(mMutex);
+        // Map of requests, with a handle based on time of deadline.
+        // It is locked internally, by shard, so add() and remove() do not take mMutex
+        // unless the thread must be woken for an earlier deadline.
+        using MonitorRequest = std::pair<std::shared_ptr<const Request>, TimerCallback>;
+        ShardedHandleMap<MonitorRequest> mMonitorRequests;
+
+        // The deadline the thread waits for, as a steady_clock count, written with
+        // mMutex held.  add() notifies the thread only for an earlier deadline.
+        // It is the maximum when there is no deadline, and while the thread scans
+        // mMonitorRequests, so that add() then always notifies.
+        std::atomic<Duration::rep> mWakeDeadline{Handle::max().time_since_epoch().count()};
 
         // Due to monotonic/steady clock inaccuracies during suspend,
         // we allow an additional second chance waiting time to prevent
@@ -353,11 +459,6 @@ class TimerThread {
         std::thread mThread;
 
         void threadFunc();
-        Handle getUniqueHandle_l(Duration timeout) REQUIRES(mMutex) {
-            return getUniqueHandleForHandleType_l<
-                    HANDLE_TYPES, enum_as_value(HANDLE_TYPE::TIMEOUT)>(
-                mMonitorRequests, timeout);
-        }
 
       public:
         MonitorThread(RequestQueue &timeoutQueue);
@@ -14,8 +14,10 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <chrono>
 #include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include <mediautils/TimerThread.h>
 
@@ -274,4 +276,31 @@ TEST(TimerThread, TrackedTasks) {
     ASSERT_EQ(4ul, countChars(thread.retiredToString(), REQUEST_START));
 }
 
+TEST(TimerThread, ConcurrentTasks) {
+    constexpr size_t kThreads = 8;
+    constexpr size_t kTasksPerThread = 1000;
+    TimerThread thread;
+    std::atomic<size_t> timeouts{};
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < kTasksPerThread; ++j) {
+                const auto handle = j % 2 == 0 ? thread.scheduleTask("timeout",
+                        [&](TimerThread::Handle) { ++timeouts; }, 60s, 0s) :
+                        thread.trackTask("notimeout");
+                // The shard of the handle is within range.
+                ASSERT_GT(TimerThread::SHARD_COUNT, TimerThread::getShardIndex(handle));
+                ASSERT_TRUE(thread.cancelTask(handle));
+                ASSERT_FALSE(thread.cancelTask(handle));
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    ASSERT_EQ(0ul, timeouts);
+    ASSERT_EQ(0ul, countChars(thread.pendingToString(), REQUEST_START));
+    // The retired queue holds at most the last 16 requests over all shards.
+    ASSERT_EQ(16ul, countChars(thread.retiredToString(), REQUEST_START));
+}
+
 }  // namespace
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <mediautils/MethodStatistics.h>
+
+using namespace android::mediautils;
+
+/*
+ * Measures MethodStatistics::event() from 1 to 16 concurrent threads,
+ * as called by the binder threads of AudioFlinger for every transaction.
+ *
+ * BM_EventIndexed uses codes from the method map, which are queued per thread without a lock.
+ * BM_EventUnindexed uses codes not in the method map, which take the common lock.
+ */
+
+static constexpr int kMethodCount = 64;
+
+static MethodStatistics<int>& getMethodStatistics() {
+    static MethodStatistics<int> methodStatistics{
+        {0, "method0"}, {1, "method1"}, {2, "method2"}, {3, "method3"},
+        {4, "method4"}, {5, "method5"}, {6, "method6"}, {7, "method7"},
+    };
+    return methodStatistics;
+}
+
+static void BM_EventIndexed(benchmark::State& state) {
+    MethodStatistics<int>& methodStatistics = getMethodStatistics();
+    int code = state.thread_index();
+    for (auto _ : state) {
+        methodStatistics.event(code & 7, 1.f);
+        ++code;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_EventIndexed)->ThreadRange(1, 16)->UseRealTime();
+
+static void BM_EventUnindexed(benchmark::State& state) {
+    MethodStatistics<int>& methodStatistics = getMethodStatistics();
+    int code = state.thread_index();
+    for (auto _ : state) {
+        methodStatistics.event(8 + code % kMethodCount, 1.f);
+        ++code;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_EventUnindexed)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -19,6 +19,8 @@
 #include <mediautils/MethodStatistics.h>
 
 #include <atomic>
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include <utils/Log.h>
 
@@ -70,3 +72,58 @@ TEST(methodstatistics_tests, events) {
     ASSERT_EQ(0.f, unsetStats.getMean());
     ASSERT_EQ(0U, methodStatistics.getMethodCount(UNKNOWN_CODE));
 }
+
+TEST(methodstatistics_tests, concurrent_events) {
+    MethodStatistics<CodeType> methodStatistics{
+            {HELLO_CODE, HELLO_NAME},
+            {WORLD_CODE, WORLD_NAME},
+    };
+
+    // More events than a thread queue holds, so some are merged by the thread.
+    constexpr size_t kThreads = 10;
+    constexpr size_t kEventsPerThread = 1001;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < kEventsPerThread; ++j) {
+                methodStatistics.event(HELLO_CODE, 1.f);
+                methodStatistics.event(UNKNOWN_CODE, 2.f);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    ASSERT_EQ(kThreads * kEventsPerThread, methodStatistics.getMethodCount(HELLO_CODE));
+    ASSERT_EQ(1.f, methodStatistics.getStatistics(HELLO_CODE).getMean());
+    ASSERT_EQ(kThreads * kEventsPerThread, methodStatistics.getMethodCount(UNKNOWN_CODE));
+    ASSERT_EQ(0U, methodStatistics.getMethodCount(WORLD_CODE));
+
+    // Only methods with events are dumped, in code order.
+    const std::string dump = methodStatistics.dump();
+    const size_t helloPos = dump.find(HELLO_NAME);
+    ASSERT_NE(std::string::npos, helloPos);
+    ASSERT_LT(helloPos, dump.find(std::to_string(UNKNOWN_CODE)));
+    ASSERT_EQ(std::string::npos, dump.find(WORLD_NAME));
+}
+
+TEST(methodstatistics_tests, thread_and_instance_lifetime) {
+    // A thread keeps sending events to successive instances, reading some of them
+    // while other threads exit with events not yet merged.
+    for (size_t i = 0; i < 4; ++i) {
+        MethodStatistics<CodeType> methodStatistics{
+                {HELLO_CODE, HELLO_NAME},
+        };
+        for (size_t j = 0; j < 3; ++j) {
+            std::thread([&] { methodStatistics.event(HELLO_CODE, 1.f); }).join();
+        }
+        methodStatistics.event(HELLO_CODE, 2.f);
+        ASSERT_EQ(4U, methodStatistics.getMethodCount(HELLO_CODE));
+        ASSERT_EQ(1.25f, methodStatistics.getStatistics(HELLO_CODE).getMean());
+
+        // Events after a read are merged on the next read.
+        for (size_t j = 0; j < 1000; ++j) {
+            methodStatistics.event(HELLO_CODE, 1.f);
+        }
+        ASSERT_EQ(1004U, methodStatistics.getMethodCount(HELLO_CODE));
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+
+#include <benchmark/benchmark.h>
+#include <mediautils/TimerThread.h>
+
+using namespace std::chrono_literals;
+using namespace android::mediautils;
+
+/*
+ * Measures the throughput of scheduleTask() + cancelTask() pairs, as done by
+ * a TimeCheck around each binder call, from 1 to 16 concurrent threads.
+ *
+ * The timeouts are long compared to the benchmark, so no task times out,
+ * and only the add and cancel paths are measured.
+ */
+
+static TimerThread& getTimerThread() {
+    static TimerThread timerThread;
+    return timerThread;
+}
+
+static void BM_ScheduleCancel(benchmark::State& state) {
+    TimerThread& timerThread = getTimerThread();
+    for (auto _ : state) {
+        const auto handle = timerThread.scheduleTask(
+                "BM_ScheduleCancel", [](TimerThread::Handle) {}, 60s /* timeout */,
+                5s /* secondChanceDuration */);
+        benchmark::DoNotOptimize(timerThread.cancelTask(handle));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ScheduleCancel)->ThreadRange(1, 16)->UseRealTime();
+
+// As above, but with tasks of no timeout, which are not monitored.
+static void BM_TrackCancel(benchmark::State& state) {
+    TimerThread& timerThread = getTimerThread();
+    for (auto _ : state) {
+        const auto handle = timerThread.trackTask("BM_TrackCancel");
+        benchmark::DoNotOptimize(timerThread.cancelTask(handle));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_TrackCancel)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK_MAIN();
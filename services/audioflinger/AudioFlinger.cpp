@@ -43,6 +43,7 @@
 #include <com_android_media_audioserver.h>
 #include <media/AidlConversion.h>
 #include <media/AudioParameter.h>
+#include <media/AudioResampler.h>
 #include <media/AudioValidator.h>
 #include <media/IMediaLogService.h>
 #include <media/IPermissionProvider.h>
@@ -806,6 +807,7 @@ void AudioFlinger::dumpInternals_l(int fd) {
     }
     dprintf(fd, "Bluetooth latency modes are %senabled\n",
             mBluetoothLatencyModesEnabled ? "" : "not ");
+    writeStr(fd, AudioResampler::dumpFilterCache());
 }
 
 void AudioFlinger::dumpStats(int fd) {
@@ -48,6 +48,7 @@
 #include <system/audio_effects/effect_spatializer.h>
 #include <system/audio_effects/effect_visualizer.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 
 #include <algorithm>
 
@@ -771,6 +772,13 @@ void EffectModule::process()
                     outBuffer = mOutConversionBuffer;
                 }
             }
+            // the scratch conversion buffers are shared, see ScratchBufferFrameCount.
+            if (mInConversionBuffer != nullptr) {
+                mInConversionFrameCount.prepareProcess(mInConversionBuffer.get());
+            }
+            if (mOutConversionBuffer != nullptr) {
+                mOutConversionFrameCount.prepareProcess(mOutConversionBuffer.get());
+            }
             ret = mEffectInterface->process();
             if (!mSupportsFloat) { // convert output int16_t back to float.
                 sp<EffectBufferHalInterface> target =
@@ -1307,6 +1315,7 @@ void EffectModule::setInBuffer(const sp<EffectBufferHalInterface>& buffer) {
     }
     mInBuffer = buffer;
     mEffectInterface->setInBuffer(buffer);
+    mInConversionFrameCount.set(0);
 
     // aux effects do in place conversion to float - we don't allocate mInConversionBuffer.
     // Theoretically insert effects can also do in-place conversions (destroying
@@ -1326,15 +1335,19 @@ void EffectModule::setInBuffer(const sp<EffectBufferHalInterface>& buffer) {
         ALOGV("%s: setInBuffer updating for inChannels:%d inFrameCount:%zu total size:%zu",
                 __func__, inChannels, inFrameCount, size);
 
-        if (size > 0 && (mInConversionBuffer == nullptr
-                || size > mInConversionBuffer->getSize())) {
+        // the conversion buffer is only used within process(), so it is shared with the
+        // other effects of the thread. Request it even if the current one is large enough,
+        // as the effect may have moved to another thread.
+        if (size > 0) {
             mInConversionBuffer.clear();
-            ALOGV("%s: allocating mInConversionBuffer %zu", __func__, size);
-            (void)getCallback()->allocateHalBuffer(size, &mInConversionBuffer);
+            ALOGV("%s: getting mInConversionBuffer %zu", __func__, size);
+            (void)getCallback()->allocateScratchHalBuffer(
+                    size, kInConversionScratchIndex, &mInConversionBuffer);
         }
         if (mInConversionBuffer != nullptr) {
             mInConversionBuffer->setFrameCount(inFrameCount);
             mEffectInterface->setInBuffer(mInConversionBuffer);
+            mInConversionFrameCount.set(inFrameCount);
         } else if (size > 0) {
             ALOGE("%s cannot create mInConversionBuffer", __func__);
         }
@@ -1353,6 +1366,7 @@ void EffectModule::setOutBuffer(const sp<EffectBufferHalInterface>& buffer) {
     }
     mOutBuffer = buffer;
     mEffectInterface->setOutBuffer(buffer);
+    mOutConversionFrameCount.set(0);
 
     // Note: Any effect that does not accumulate does not need mOutConversionBuffer and
     // can do in-place conversion from int16_t to float.  We don't optimize here.
@@ -1368,15 +1382,16 @@ void EffectModule::setOutBuffer(const sp<EffectBufferHalInterface>& buffer) {
         ALOGV("%s: setOutBuffer updating for outChannels:%d outFrameCount:%zu total size:%zu",
                 __func__, outChannels, outFrameCount, size);
 
-        if (size > 0 && (mOutConversionBuffer == nullptr
-                || size > mOutConversionBuffer->getSize())) {
+        if (size > 0) {
             mOutConversionBuffer.clear();
-            ALOGV("%s: allocating mOutConversionBuffer %zu", __func__, size);
-            (void)getCallback()->allocateHalBuffer(size, &mOutConversionBuffer);
+            ALOGV("%s: getting mOutConversionBuffer %zu", __func__, size);
+            (void)getCallback()->allocateScratchHalBuffer(
+                    size, kOutConversionScratchIndex, &mOutConversionBuffer);
         }
         if (mOutConversionBuffer != nullptr) {
             mOutConversionBuffer->setFrameCount(outFrameCount);
             mEffectInterface->setOutBuffer(mOutConversionBuffer);
+            mOutConversionFrameCount.set(outFrameCount);
         } else if (size > 0) {
             ALOGE("%s cannot create mOutConversionBuffer", __func__);
         }
@@ -2339,6 +2354,7 @@ void EffectChain::process_l() {
 
     size_t size = mEffects.size();
     if (doProcess) {
+        const int64_t processBeginNs = systemTime();
         // Only the input and output buffers of the chain can be external,
         // and 'update' / 'commit' do nothing for allocated buffers, thus
         // it's not needed to consider any other buffers here.
@@ -2353,6 +2369,7 @@ void EffectChain::process_l() {
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->commit();
         }
+        mProcessTimes.record(systemTime() - processBeginNs);
     }
     bool doResetVolume = false;
     for (size_t i = 0; i < size; i++) {
@@ -2817,6 +2834,10 @@ void EffectChain::dump(int fd, const Vector<String16>& args) const
             (int)outBufferStr.size(), "Out buffer      ");
     result.appendFormat("\t%s   %s   %d\n",
             inBufferStr.c_str(), outBufferStr.c_str(), mActiveTrackCnt);
+    const auto processTimes = mProcessTimes.getSnapshot();
+    if (processTimes.count > 0) {
+        result.appendFormat("\tProcess time: %s\n", processTimes.toString().c_str());
+    }
     write(fd, result.c_str(), result.size());
 
     for (size_t i = 0; i < numEffects; ++i) {
@@ -3169,6 +3190,15 @@ status_t EffectChain::EffectCallback::allocateHalBuffer(
     return mAfThreadCallback->getEffectsFactoryHal()->allocateBuffer(size, buffer);
 }
 
+status_t EffectChain::EffectCallback::allocateScratchHalBuffer(
+        size_t size, size_t index, sp<EffectBufferHalInterface>* buffer) {
+    const sp<IAfThreadBase> t = thread().promote();
+    if (t == nullptr) {
+        return allocateHalBuffer(size, buffer);
+    }
+    return t->allocateEffectScratchBuffer(size, index, buffer);
+}
+
 status_t EffectChain::EffectCallback::addEffectToHal(
         const sp<EffectHalInterface>& effect) {
     status_t result = NO_INIT;
@@ -20,9 +20,11 @@
 #include "DeviceEffectManager.h"
 #include "IAfEffect.h"
 
+#include <afutils/ScratchBufferFrameCount.h>
 #include <android-base/macros.h>  // DISALLOW_COPY_AND_ASSIGN
 #include <mediautils/Synchronization.h>
 #include <private/media/AudioEffectShared.h>
+#include <timing/CycleTimeHistogram.h>
 
 #include <map>  // avoid transitive dependency
 #include <optional>
@@ -287,8 +289,15 @@ private:
     bool     mIsOutput;             // direction of the AF thread
 
     bool    mSupportsFloat;         // effect supports float processing
-    sp<EffectBufferHalInterface> mInConversionBuffer;  // Buffers for HAL conversion if needed.
+    // Buffers for HAL conversion if needed, scratch buffers shared with the other effects
+    // of the thread.
+    static constexpr size_t kInConversionScratchIndex = 0;
+    static constexpr size_t kOutConversionScratchIndex = 1;
+    static_assert(kOutConversionScratchIndex < IAfThreadBase::kEffectScratchBufferCount);
+    sp<EffectBufferHalInterface> mInConversionBuffer;
     sp<EffectBufferHalInterface> mOutConversionBuffer;
+    afutils::ScratchBufferFrameCount mInConversionFrameCount;
+    afutils::ScratchBufferFrameCount mOutConversionFrameCount;
     uint32_t mInChannelCountRequested;
     uint32_t mOutChannelCountRequested;
 
@@ -640,6 +649,8 @@ public:
         status_t createEffectHal(const effect_uuid_t *pEffectUuid,
                int32_t sessionId, int32_t deviceId, sp<EffectHalInterface> *effect) override;
         status_t allocateHalBuffer(size_t size, sp<EffectBufferHalInterface>* buffer) override;
+        status_t allocateScratchHalBuffer(size_t size, size_t index,
+                sp<EffectBufferHalInterface>* buffer) override;
         bool updateOrphanEffectChains(const sp<IAfEffectBase>& effect) override;
 
         audio_io_handle_t io() const override;
@@ -769,6 +780,9 @@ public:
              const sp<EffectCallback> mEffectCallback;
 
              wp<IAfEffectModule> mVolumeControlEffect;
+
+             // duration of process_l() effect processing, for dump.
+             audioflinger::CycleTimeHistogram mProcessTimes;
 };
 
 class DeviceEffectProxy : public IAfDeviceEffectProxy, public EffectBase {
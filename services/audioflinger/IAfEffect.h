@@ -75,6 +75,13 @@ public:
     virtual status_t createEffectHal(const effect_uuid_t *pEffectUuid,
             int32_t sessionId, int32_t deviceId, sp<EffectHalInterface> *effect) = 0;
     virtual status_t allocateHalBuffer(size_t size, sp<EffectBufferHalInterface>* buffer) = 0;
+    // Scratch buffers only hold data during an EffectModule::process() call, so they may be
+    // shared by all the effects processed on the same thread. index selects one of several
+    // scratch buffers used at the same time.
+    virtual status_t allocateScratchHalBuffer(size_t size, size_t index __unused,
+            sp<EffectBufferHalInterface>* buffer) {
+        return allocateHalBuffer(size, buffer);
+    }
     virtual bool updateOrphanEffectChains(const sp<IAfEffectBase>& effect) = 0;
 
     // Methods usually implemented with help from EffectChain: pay attention to mutex locking order
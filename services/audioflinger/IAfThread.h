@@ -51,6 +51,7 @@ class IAfMmapPlaybackThread;
 class IAfPlaybackThread;
 class IAfRecordThread;
 
+class EffectBufferHalInterface;
 class IAfEffectChain;
 class IAfEffectHandle;
 class IAfEffectModule;
@@ -299,6 +300,11 @@ public:
     // get a copy of mEffectChains vector
     virtual Vector<sp<IAfEffectChain>> getEffectChains_l() const
             REQUIRES(mutex()) = 0;
+    // get one of the scratch buffers shared by the effects processed by the thread,
+    // with at least 'size' bytes. See EffectCallbackInterface::allocateScratchHalBuffer().
+    static constexpr size_t kEffectScratchBufferCount = 2;
+    virtual status_t allocateEffectScratchBuffer(size_t size, size_t index,
+            sp<EffectBufferHalInterface>* buffer) = 0;
     // set audio mode to all effect chains
     virtual void setMode(audio_mode_t mode)
             EXCLUDES_ThreadBase_Mutex = 0;
@@ -576,11 +576,16 @@ public:
     using MetadataInserter = std::back_insert_iterator<SinkMetadatas>;
     virtual void copyMetadataTo(MetadataInserter& backInserter) const = 0; // see IAfTrack
 
+    // Frames the RecordThread read from the HAL directly into the track buffer,
+    // bypassing the RecordThread buffer and the RecordBufferConverter.
+    virtual int64_t framesReadDirect() const = 0;
+
     // private to Threads
     virtual AudioBufferProvider::Buffer& sinkBuffer() = 0;
     virtual audioflinger::SynchronizedRecordState& synchronizedRecordState() = 0;
     virtual RecordBufferConverter* recordBufferConverter() const = 0;
     virtual ResamplerBufferProvider* resamplerBufferProvider() const = 0;
+    virtual void addFramesReadDirect(size_t frames) = 0;
 };
 
 // PatchProxyBufferProvider interface is implemented by PatchTrack and PatchRecord.
@@ -767,6 +767,26 @@ String8 PatchPanel::Patch::dump(audio_patch_handle_t myHandle) const
     double latencyMs;
     if (getLatencyMs(&latencyMs) == OK) {
         result.appendFormat("  latency: %.2lf ms", latencyMs);
+
+        // break down the end-to-end latency if it is computed from the server latencies.
+        auto recordTrack = mRecord.const_track();
+        auto playbackTrack = mPlayback.const_track();
+        double recordServerLatencyMs, playbackTrackLatencyMs;
+        if (audio_is_linear_pcm(recordTrack->format())
+                && recordTrack->getServerLatencyMs(&recordServerLatencyMs) == OK
+                && playbackTrack->getTrackLatencyMs(&playbackTrackLatencyMs) == OK) {
+            result.appendFormat(" (record %.2lf ms + playback %.2lf ms)",
+                    recordServerLatencyMs, playbackTrackLatencyMs);
+        }
+    }
+
+    // add the share of frames read by the record thread directly into the patch buffer.
+    if (auto recordTrack = mRecord.const_track(); recordTrack != nullptr) {
+        const int64_t framesReleased = recordTrack->serverProxy()->framesReleased();
+        if (framesReleased > 0) {
+            result.appendFormat("  direct read: %.1lf %%",
+                    recordTrack->framesReadDirect() * 100. / framesReleased);
+        }
     }
     return result;
 }
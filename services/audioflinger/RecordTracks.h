@@ -97,6 +97,14 @@ public:
     ResamplerBufferProvider* resamplerBufferProvider() const final {
         return mResamplerBufferProvider;
     }
+    int64_t framesReadDirect() const final {
+        return mFramesReadDirect.load(std::memory_order_relaxed);
+    }
+    void addFramesReadDirect(size_t frames) final {
+        // single writer, the RecordThread.
+        mFramesReadDirect.store(mFramesReadDirect.load(std::memory_order_relaxed) + frames,
+                std::memory_order_relaxed);
+    }
 
     std::string trackFlagsAsString() const final { return toString(mFlags); }
 
@@ -132,6 +140,8 @@ private:
 
             std::string                        mSharedAudioPackageName = {};
             int32_t                            mStartFrames = -1;
+
+            std::atomic<int64_t>               mFramesReadDirect = 0;  // for dump
 };
 
 // playback track, used by PatchPanel
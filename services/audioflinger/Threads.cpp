@@ -1157,6 +1157,11 @@ void ThreadBase::dumpBase_l(int fd, const Vector<String16>& /* args */)
             isOutput() ? "write" : "read",
             mMonopipePipeDepthStats.toString().c_str());
     }
+
+    const std::string cycleTimes = mCycleTimes.toString("    ");
+    if (!cycleTimes.empty()) {
+        dprintf(fd, "  Threadloop cycle times:\n%s", cycleTimes.c_str());
+    }
 }
 
 void ThreadBase::dumpEffectChains_l(int fd, const Vector<String16>& args)
@@ -1909,6 +1914,29 @@ void ThreadBase::unlockEffectChains(const Vector<sp<IAfEffectChain>>& effectChai
     }
 }
 
+status_t ThreadBase::allocateEffectScratchBuffer(
+        size_t size, size_t index, sp<EffectBufferHalInterface>* buffer)
+{
+    if (index >= kEffectScratchBufferCount) {
+        return BAD_VALUE;
+    }
+    audio_utils::lock_guard _l(mEffectScratchBufferMutex);
+    sp<EffectBufferHalInterface>& scratchBuffer = mEffectScratchBuffers[index];
+    // Effects holding a smaller buffer keep it until they are reconfigured.
+    if (scratchBuffer == nullptr || size > scratchBuffer->getSize()) {
+        sp<EffectBufferHalInterface> newBuffer;
+        const status_t status =
+                mAfThreadCallback->getEffectsFactoryHal()->allocateBuffer(size, &newBuffer);
+        if (status != OK) {
+            return status;
+        }
+        ALOGV("%s(%zu): allocated %zu bytes", __func__, index, size);
+        scratchBuffer = std::move(newBuffer);
+    }
+    *buffer = scratchBuffer;
+    return OK;
+}
+
 sp<IAfEffectChain> ThreadBase::getEffectChain(audio_session_t sessionId) const
 {
     audio_utils::lock_guard _l(mutex());
@@ -2113,6 +2141,21 @@ NO_THREAD_SAFETY_ANALYSIS
                         mMonopipePipeDepthStats.getStdDev());
     }
 
+    // thread loop cycle times since the last report, e.g. "mixTimeMs.p99".
+    const auto cycleTimes = mCycleTimes.takeIntervalSnapshots();
+    for (size_t i = 0; i < cycleTimes.size(); ++i) {
+        const auto delta = cycleTimes[i] - mLastRecordedCycleTimes[i];
+        if (delta.count == 0) continue;
+        const std::string key = std::string(MM_PREFIX)
+                + audioflinger::ThreadCycleTimes::toString(
+                        (audioflinger::ThreadCycleTimes::Phase)i) + "TimeMs.";
+        item->setDouble((key + "mean").c_str(), delta.getMeanNs() * 1e-6);
+        item->setDouble((key + "p50").c_str(), delta.getPercentileNs(50.) * 1e-6);
+        item->setDouble((key + "p99").c_str(), delta.getPercentileNs(99.) * 1e-6);
+        item->setDouble((key + "max").c_str(), delta.maxNs * 1e-6);
+    }
+    mLastRecordedCycleTimes = cycleTimes;
+
     item->selfrecord();
 }
 
@@ -4364,7 +4407,10 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
             mCurrentWriteLength = 0;
             if (mMixerStatus == MIXER_TRACKS_READY) {
                 // threadLoop_mix() sets mCurrentWriteLength
+                const int64_t mixBeginNs = systemTime();
                 threadLoop_mix();
+                mCycleTimes.record(audioflinger::ThreadCycleTimes::PHASE_MIX,
+                        systemTime() - mixBeginNs);
             } else if ((mMixerStatus != MIXER_DRAIN_TRACK)
                         && (mMixerStatus != MIXER_DRAIN_ALL)) {
                 // threadLoop_sleepTime sets mSleepTimeUs to 0 if data
@@ -4452,6 +4498,7 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
 
             // only process effects if we're going to write
             if (mSleepTimeUs == 0 && mType != OFFLOAD) {
+                const int64_t effectsBeginNs = systemTime();
                 for (size_t i = 0; i < effectChains.size(); i ++) {
                     effectChains[i]->process_l();
                     // TODO: Write haptic data directly to sink buffer when mixing.
@@ -4476,6 +4523,10 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                                 AUDIO_FORMAT_PCM_FLOAT, mNormalFrameCount * mHapticChannelCount);
                     }
                 }
+                if (!effectChains.empty()) {
+                    mCycleTimes.record(audioflinger::ThreadCycleTimes::PHASE_EFFECTS,
+                            systemTime() - effectsBeginNs);
+                }
             }
         }
         // Process effect chains for offloaded thread even if no audio
@@ -4567,6 +4618,8 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                     const int64_t lastIoBeginNs = systemTime();
                     ret = threadLoop_write();
                     const int64_t lastIoEndNs = systemTime();
+                    mCycleTimes.record(audioflinger::ThreadCycleTimes::PHASE_WRITE,
+                            lastIoEndNs - lastIoBeginNs);
                     if (ret < 0) {
                         mBytesRemaining = 0;
                     } else if (ret > 0) {
@@ -4716,7 +4769,16 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                     mSleepTimeUs = deltaNs / 1000;
                 }
                 if (!mSignalPending && mConfigEvents.isEmpty() && !exitPending()) {
+                    const int64_t sleepBeginNs = systemTime();
                     mWaitWorkCV.wait_for(_l, std::chrono::microseconds(mSleepTimeUs));
+                    // An early wakeup is a signal, not a timing error; only overshoot counts.
+                    const int64_t overshootNs =
+                            systemTime() - sleepBeginNs - microseconds((nsecs_t)mSleepTimeUs);
+                    if (overshootNs >= 0) {
+                        mCycleTimes.record(
+                                audioflinger::ThreadCycleTimes::PHASE_SLEEP_OVERSHOOT,
+                                overshootNs);
+                    }
                 }
                 ATRACE_END();
             }
@@ -5344,6 +5406,16 @@ MixerThread::MixerThread(const sp<IAfThreadCallback>& afThreadCallback, AudioStr
         info.type = NBLog::FASTMIXER;
         mFastMixerNBLogWriter->log<NBLog::EVENT_THREAD_INFO>(info);
 
+        // optionally start a helper that mixes part of the fast tracks on another core,
+        // for devices with many fast tracks on small cores.
+        if (property_get_bool("ro.audio.fast_mixer_helper", false /* default_value */)) {
+            mFastMixerHelper = new FastMixerHelper();
+            mFastMixerHelper->run("FastMixerHelper", PRIORITY_URGENT_AUDIO);
+            sendPrioConfigEvent(getpid(), mFastMixerHelper->getTid(), kPriorityFastMixer,
+                    false /*forApp*/);
+            mFastMixer->setHelper(mFastMixerHelper);
+        }
+
         // start the fast mixer
         mFastMixer->run("FastMixer", PRIORITY_URGENT_AUDIO);
         pid_t tid = mFastMixer->getTid();
@@ -5411,6 +5483,11 @@ MixerThread::~MixerThread()
         delete fastTrack->mBufferProvider;
         sq->end(false /*didModify*/);
         mFastMixer.clear();
+        if (mFastMixerHelper != 0) {
+            mFastMixerHelper->requestExit();
+            mFastMixerHelper->requestExitAndWait();
+            mFastMixerHelper.clear();
+        }
 #ifdef AUDIO_WATCHDOG
         if (mAudioWatchdog != 0) {
             mAudioWatchdog->requestExit();
@@ -8699,10 +8776,15 @@ reacquire_wakelock:
         // thread mutex is now unlocked, mActiveTracks unknown, activeTracks.size() > 0
 
         size_t size = effectChains.size();
+        const int64_t effectsBeginNs = size > 0 ? systemTime() : 0;
         for (size_t i = 0; i < size; i++) {
             // thread mutex is not locked, but effect chain is locked
             effectChains[i]->process_l();
         }
+        if (size > 0) {
+            mCycleTimes.record(audioflinger::ThreadCycleTimes::PHASE_EFFECTS,
+                    systemTime() - effectsBeginNs);
+        }
 
         // Push a new fast capture state if fast capture is not already running, or cblk change
         if (mFastCapture != 0) {
@@ -8770,6 +8852,29 @@ reacquire_wakelock:
 
         int32_t rear = mRsmpInRear & (mRsmpInFramesP2 - 1);
         ssize_t framesRead = 0; // not needed, remove clang-tidy warning.
+
+        // If the only active track is a software patch PatchRecord with the input stream
+        // configuration, read the HAL directly into the PatchRecord buffer, which is shared with
+        // the PatchTrack mixed by the PlaybackThread. This skips the copy through mRsmpInBuffer.
+        // When the buffer has less than a HAL buffer of contiguous space, fall back to
+        // the RecordThread buffer for this cycle, which also handles the overrun.
+        sp<IAfRecordTrack> directTrack;
+        if (mPipeSource == 0 && activeTracks.size() == 1 && canReadDirect(activeTracks[0])) {
+            AudioBufferProvider::Buffer& sinkBuffer = activeTracks[0]->sinkBuffer();
+            sinkBuffer.frameCount = mFrameCount;
+            if (activeTracks[0]->getNextBuffer(&sinkBuffer) == OK) {
+                if (sinkBuffer.frameCount == mFrameCount) {
+                    directTrack = activeTracks[0];
+                } else {
+                    // release without consuming any frame before falling back.
+                    sinkBuffer.frameCount = 0;
+                    activeTracks[0]->releaseBuffer(&sinkBuffer);
+                }
+            }
+        }
+        void* const readBuffer = directTrack != 0 ? directTrack->sinkBuffer().raw
+                : (uint8_t*)mRsmpInBuffer + rear * mFrameSize;
+
         const int64_t lastIoBeginNs = systemTime(); // start IO timing
 
         // If an NBAIO source is present, use it to read the normal capture's data
@@ -8819,8 +8924,7 @@ reacquire_wakelock:
         } else {
             ATRACE_BEGIN("read");
             size_t bytesRead;
-            status_t result = mSource->read(
-                    (uint8_t*)mRsmpInBuffer + rear * mFrameSize, mBufferSize, &bytesRead);
+            status_t result = mSource->read(readBuffer, mBufferSize, &bytesRead);
             ATRACE_END();
             if (result < 0) {
                 framesRead = result;
@@ -8830,6 +8934,8 @@ reacquire_wakelock:
         }
 
         const int64_t lastIoEndNs = systemTime(); // end IO timing
+        mCycleTimes.record(audioflinger::ThreadCycleTimes::PHASE_READ,
+                lastIoEndNs - lastIoBeginNs);
 
         // Update server timestamp with server stats
         // systemTime() is optional if the hardware supports timestamps.
@@ -8889,21 +8995,31 @@ reacquire_wakelock:
             sleepUs = kRecordThreadSleepUs;
         }
         if (framesRead <= 0) {
+            if (directTrack != 0) {
+                // nothing was read into the direct track buffer, release it unconsumed.
+                directTrack->sinkBuffer().frameCount = 0;
+                directTrack->releaseBuffer(&directTrack->sinkBuffer());
+            }
             goto unlock;
         }
         ALOG_ASSERT(framesRead > 0);
         mFramesRead += framesRead;
 
 #ifdef TEE_SINK
-        (void)mTee.write((uint8_t*)mRsmpInBuffer + rear * mFrameSize, framesRead);
+        (void)mTee.write(readBuffer, framesRead);
 #endif
         // If destination is non-contiguous, we now correct for reading past end of buffer.
-        {
+        if (directTrack == 0) {
             size_t part1 = mRsmpInFramesP2 - rear;
             if ((size_t) framesRead > part1) {
                 memcpy(mRsmpInBuffer, (uint8_t*)mRsmpInBuffer + mRsmpInFramesP2 * mFrameSize,
                         (framesRead - part1) * mFrameSize);
             }
+        } else {
+            // mRsmpInRear counts these frames too, so copy them as history for a track
+            // started later with startFrames.
+            audioflinger::CaptureHistory::write(mRsmpInBuffer, mRsmpInFramesP2, mFrameSize,
+                    rear, readBuffer, framesRead);
         }
         mRsmpInRear = audio_utils::safe_add_overflow(mRsmpInRear, (int32_t)framesRead);
 
@@ -8921,6 +9037,30 @@ reacquire_wakelock:
                 continue;
             }
 
+            // the frames were read directly into the track buffer, so only release them.
+            // mRsmpInBuffer was not written, so keep the track in sync with mRsmpInRear.
+            if (activeTrack == directTrack) {
+                activeTrack->resamplerBufferProvider()->setFront(mRsmpInRear);
+                activeTrack->clearOverflow();
+                if (activeTrack->synchronizedRecordState().updateRecordFrames(framesRead) == 0) {
+                    activeTrack->sinkBuffer().frameCount = framesRead;
+                    if (activeTrack->isSilenced()) {
+                        memset(activeTrack->sinkBuffer().raw, 0, framesRead * mFrameSize);
+                    }
+                    activeTrack->releaseBuffer(&activeTrack->sinkBuffer());
+                    activeTrack->addFramesReadDirect(framesRead);
+                } else {
+                    // the frames are dropped until the sync event, release them unconsumed.
+                    activeTrack->sinkBuffer().frameCount = 0;
+                    activeTrack->releaseBuffer(&activeTrack->sinkBuffer());
+                }
+                activeTrack->updateTrackFrameInfo(
+                        activeTrack->serverProxy()->framesReleased(),
+                        mTimestamp.mPosition[ExtendedTimestamp::LOCATION_SERVER],
+                        mSampleRate, mTimestamp);
+                continue;
+            }
+
             // TODO: This code probably should be moved to RecordTrack.
             // TODO: Update the activeTrack buffer converter in case of reconfigure.
 
@@ -9094,6 +9234,16 @@ void RecordThread::standbyIfNotAlreadyInStandby()
     }
 }
 
+bool RecordThread::canReadDirect(const sp<IAfRecordTrack>& track) const
+{
+    // Direct tracks include PassthruPatchRecord, which reads the HAL on its own.
+    return track->isPatchTrack() && !track->isFastTrack() && !track->isDirect()
+            && audio_has_proportional_frames(mFormat)
+            && track->format() == mFormat
+            && track->channelMask() == mChannelMask
+            && track->sampleRate() == mSampleRate;
+}
+
 void RecordThread::inputStandBy()
 {
     // Idle the fast capture if it's currently running
@@ -9721,22 +9871,9 @@ void ResamplerBufferProvider::reset()
     const auto threadBase = mRecordTrack->thread().promote();
     auto* const recordThread = static_cast<RecordThread *>(threadBase->asIAfRecordThread().get());
     mRsmpInUnrel = 0;
-    const int32_t rear = recordThread->mRsmpInRear;
-    ssize_t deltaFrames = 0;
-    if (mRecordTrack->startFrames() >= 0) {
-        int32_t startFrames = mRecordTrack->startFrames();
-        // Accept a recent wraparound of mRsmpInRear
-        if (startFrames <= rear) {
-            deltaFrames = rear - startFrames;
-        } else {
-            deltaFrames = (int32_t)((int64_t)rear + UINT32_MAX + 1 - startFrames);
-        }
-        // start frame cannot be further in the past than start of resampling buffer
-        if ((size_t) deltaFrames > recordThread->mRsmpInFrames) {
-            deltaFrames = recordThread->mRsmpInFrames;
-        }
-    }
-    mRsmpInFront = audio_utils::safe_sub_overflow(rear, static_cast<int32_t>(deltaFrames));
+    // start frame cannot be further in the past than start of resampling buffer
+    mRsmpInFront = audioflinger::CaptureHistory::getStartFront(recordThread->mRsmpInRear,
+            mRecordTrack->startFrames(), recordThread->mRsmpInFrames);
 }
 
 void ResamplerBufferProvider::sync(
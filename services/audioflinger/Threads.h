@@ -34,9 +34,13 @@
 #include <mediautils/Synchronization.h>
 #include <mediautils/ThreadSnapshot.h>
 #include <psh_utils/Token.h>
+#include <timing/CaptureHistory.h>
+#include <timing/CycleTimeHistogram.h>
 #include <timing/MonotonicFrameCounter.h>
 #include <utils/Log.h>
 
+#include <array>  // avoid transitive dependency
+
 namespace android {
 
 class AsyncCallbackThread;
@@ -447,6 +451,8 @@ public:
     Vector<sp<IAfEffectChain>> getEffectChains_l() const final REQUIRES(mutex()) {
         return mEffectChains;
     }
+    status_t allocateEffectScratchBuffer(size_t size, size_t index,
+            sp<EffectBufferHalInterface>* buffer) final;
                 // set audio mode to all effect chains
     void setMode(audio_mode_t mode) final;
                 // get effect module with corresponding ID on specified audio session
@@ -730,6 +736,12 @@ protected:
                 const audio_io_handle_t mId;
     Vector<sp<IAfEffectChain>> mEffectChains GUARDED_BY(mutex());
 
+    // scratch buffers shared by the effects of the thread, a leaf mutex as effects may be
+    // configured with or without the thread mutex held.
+    mutable audio_utils::mutex mEffectScratchBufferMutex;
+    std::array<sp<EffectBufferHalInterface>, kEffectScratchBufferCount> mEffectScratchBuffers
+            GUARDED_BY(mEffectScratchBufferMutex);
+
                 static const int        kThreadNameLength = 16; // prctl(PR_SET_NAME) limit
                 char                    mThreadName[kThreadNameLength]; // guaranteed NUL-terminated
     sp<os::IPowerManager> mPowerManager GUARDED_BY(mutex());
@@ -769,6 +781,10 @@ protected:
     audio_utils::Statistics<double> mIoJitterMs GUARDED_BY(mutex()) {0.995 /* alpha */};
     audio_utils::Statistics<double> mProcessTimeMs GUARDED_BY(mutex()) {0.995 /* alpha */};
 
+                // Per-cycle phase durations, recorded by the thread loop without a lock,
+                // read by dump() and sendStatistics().
+                audioflinger::ThreadCycleTimes mCycleTimes;
+
     // NO_THREAD_SAFETY_ANALYSIS  GUARDED_BY(mutex())
                 audio_utils::Statistics<double> mLatencyMs{0.995 /* alpha */};
                 audio_utils::Statistics<double> mMonopipePipeDepthStats{0.999 /* alpha */};
@@ -776,6 +792,7 @@ protected:
                 // Save the last count when we delivered statistics to mediametrics.
                 int64_t                 mLastRecordedTimestampVerifierN = 0;
                 int64_t                 mLastRecordedTimeNs = 0;  // BOOTTIME to include suspend.
+                audioflinger::ThreadCycleTimes::Snapshots mLastRecordedCycleTimes;
 
                 bool                    mIsMsdDevice = false;
                 // A condition that must be evaluated by the thread loop has changed and
@@ -1695,6 +1712,7 @@ protected:
 private:
                 // one-time initialization, no locks required
                 sp<FastMixer>     mFastMixer;     // non-0 if there is also a fast mixer
+                sp<FastMixerHelper> mFastMixerHelper; // non-0 if the fast mixer has a helper
                 sp<AudioWatchdog> mAudioWatchdog; // non-0 if there is an audio watchdog thread
 
                 // contents are not guaranteed to be consistent, no locks required
@@ -2163,6 +2181,10 @@ private:
             // Call the HAL standby method unconditionally, and don't change mStandby flag
             void    inputStandBy();
 
+            // Returns true if the HAL can be read directly into the track buffer, that is
+            // for a PatchRecord with the same configuration as the input stream.
+            bool    canReadDirect(const sp<IAfRecordTrack>& track) const;
+
     void checkBtNrec_l() REQUIRES(mutex());
 
     int32_t getOldestFront_l() REQUIRES(mutex());
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <media/audiohal/EffectBufferHalInterface.h>
+
+#include <cstddef>
+
+namespace android::afutils {
+
+/**
+ * ScratchBufferFrameCount
+ *
+ * The frame count with which one effect HAL uses a scratch buffer shared with
+ * the other effects of a thread.
+ *
+ * An effect HAL reloads its buffers when EffectBufferHalInterface::checkFrameCountChange()
+ * returns true, which also clears the change.  With a shared buffer, the first effect
+ * to process after a setFrameCount() clears it for all, and the other effect HALs would
+ * keep their previous frame count.  So each effect using the buffer flags the change
+ * again, just before processing, until its HAL has processed with its own frame count.
+ *
+ * This class is not thread safe, it is used with the effect mutex held.
+ */
+class ScratchBufferFrameCount {
+public:
+    /**
+     * Sets the frame count of the buffer given to the effect HAL.
+     *
+     * \param frameCount the frame count, or 0 if the effect HAL does not use the buffer.
+     */
+    void set(size_t frameCount) { mFrameCount = frameCount; }
+
+    /**
+     * Makes the effect HAL reload the buffer if needed, call before each process().
+     *
+     * \param buffer the scratch buffer given to the effect HAL.
+     */
+    void prepareProcess(EffectBufferHalInterface* buffer) {
+        if (mFrameCount == 0) return;
+        // The frame count is also reset if another effect set a different one,
+        // as it would be given to this effect HAL on its next reload.
+        if (mFrameCount != mProcessedFrameCount
+                || buffer->audioBuffer()->frameCount != mFrameCount) {
+            buffer->setFrameCount(mFrameCount);
+            mProcessedFrameCount = mFrameCount;
+        }
+    }
+
+private:
+    size_t mFrameCount = 0;
+    size_t mProcessedFrameCount = 0;  // the frame count last flagged before a process().
+};
+
+} // namespace android::afutils
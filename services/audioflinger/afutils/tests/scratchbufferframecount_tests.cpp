@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "scratchbufferframecount_tests"
+
+#include <afutils/ScratchBufferFrameCount.h>
+
+#include <gtest/gtest.h>
+
+using namespace android;
+using namespace android::afutils;
+
+namespace {
+
+// An allocated buffer, with the frame count change flag of the HAL buffers.
+class TestBuffer : public EffectBufferHalInterface {
+public:
+    audio_buffer_t* audioBuffer() override { return &mAudioBuffer; }
+    void* externalData() const override { return nullptr; }
+    size_t getSize() const override { return 0; }
+    void setExternalData(void*) override {}
+    void setFrameCount(size_t frameCount) override {
+        mAudioBuffer.frameCount = frameCount;
+        mFrameCountChanged = true;
+    }
+    bool checkFrameCountChange() override {
+        const bool result = mFrameCountChanged;
+        mFrameCountChanged = false;
+        return result;
+    }
+    void update() override {}
+    void commit() override {}
+    void update(size_t) override {}
+    void commit(size_t) override {}
+
+private:
+    audio_buffer_t mAudioBuffer{};
+    bool mFrameCountChanged = false;
+};
+
+// An EffectModule using the scratch buffer, with an effect HAL which reloads the buffer
+// as EffectHalHidl does, and keeps the frame count it was given.
+struct TestEffect {
+    void setBuffer(const sp<TestBuffer>& buffer, size_t frameCount) {
+        mBuffer = buffer;
+        buffer->setFrameCount(frameCount);
+        mScratchFrameCount.set(frameCount);
+    }
+
+    void process() {
+        mScratchFrameCount.prepareProcess(mBuffer.get());
+        if (mBuffer->checkFrameCountChange()) {
+            mHalFrameCount = mBuffer->audioBuffer()->frameCount;
+        }
+    }
+
+    sp<TestBuffer> mBuffer;
+    ScratchBufferFrameCount mScratchFrameCount;
+    size_t mHalFrameCount = 0;
+};
+
+TEST(ScratchBufferFrameCountTest, AllEffectsReloadOnFrameCountChange) {
+    const auto scratch = sp<TestBuffer>::make();
+    TestEffect effects[3];
+    for (auto& effect : effects) effect.setBuffer(scratch, 256);
+    for (auto& effect : effects) effect.process();
+    for (const auto& effect : effects) EXPECT_EQ(256U, effect.mHalFrameCount);
+
+    // thread reconfiguration, all the effects get the new frame count
+    // before any of them processes.
+    for (auto& effect : effects) effect.setBuffer(scratch, 480);
+    for (auto& effect : effects) effect.process();
+    for (const auto& effect : effects) EXPECT_EQ(480U, effect.mHalFrameCount);
+
+    // no reload once all the effect HALs have the frame count.
+    for (auto& effect : effects) effect.process();
+    EXPECT_FALSE(scratch->checkFrameCountChange());
+}
+
+TEST(ScratchBufferFrameCountTest, DifferentFrameCounts) {
+    const auto scratch = sp<TestBuffer>::make();
+    TestEffect first;
+    TestEffect second;
+    first.setBuffer(scratch, 256);
+    second.setBuffer(scratch, 128);
+    for (int i = 0; i < 3; ++i) {
+        first.process();
+        EXPECT_EQ(256U, first.mHalFrameCount);
+        second.process();
+        EXPECT_EQ(128U, second.mHalFrameCount);
+    }
+}
+
+TEST(ScratchBufferFrameCountTest, UnusedBuffer) {
+    const auto scratch = sp<TestBuffer>::make();
+    TestEffect user;
+    user.setBuffer(scratch, 256);
+    user.process();
+    ScratchBufferFrameCount notUser;
+    notUser.set(0);
+    scratch->setFrameCount(256);
+    (void)scratch->checkFrameCountChange();
+    notUser.prepareProcess(scratch.get());
+    EXPECT_FALSE(scratch->checkFrameCountChange());
+}
+
+} // namespace
@@ -40,6 +40,7 @@
 #include <audio_utils/channels.h>
 #include <audio_utils/format.h>
 #include <audio_utils/mono_blend.h>
+#include <audio_utils/primitives.h>
 #include <cutils/bitops.h>
 #include <media/AudioMixer.h>
 #include "FastMixer.h"
@@ -103,6 +104,9 @@ void FastMixer::onIdle()
 
 void FastMixer::onExit()
 {
+    waitHelperIdle();
+    delete mHelperMixer;
+    free(mHelperMixerBuffer);
     delete mMixer;
     free(mMixerBuffer);
     free(mSinkBuffer);
@@ -120,6 +124,14 @@ bool FastMixer::isSubClassCommand(FastThreadState::Command command)
     }
 }
 
+void FastMixer::waitHelperIdle()
+{
+    if (mHelperBusy) {
+        // mHelperBusy stays set, so that the late mix is still added to the next write.
+        (void) mHelper->waitMix(-1 /* timeoutNs */);
+    }
+}
+
 void FastMixer::updateMixerTrack(int index, Reason reason) {
     const FastMixerState * const current = (const FastMixerState *) mCurrent;
     const FastTrack * const fastTrack = &current->mFastTracks[index];
@@ -135,12 +147,24 @@ void FastMixer::updateMixerTrack(int index, Reason reason) {
         return;
     }
 
+    AudioMixer* mixer = getMixer(index);
     switch (reason) {
     case REASON_REMOVE:
-        mMixer->destroy(index);
+        mixer->destroy(index);
+        mMixerTrackMask &= ~(1 << index);
+        mHelperTrackMask &= ~(1 << index);
         break;
     case REASON_ADD: {
-        const status_t status = mMixer->create(
+        // Balance the track count between the mixers.  The first track, normally the
+        // MixerThread submix, stays on mMixer.
+        if (mHelperMixer != nullptr
+                && popcount(mHelperTrackMask) < popcount(mMixerTrackMask)) {
+            mixer = mHelperMixer;
+            mHelperTrackMask |= 1 << index;
+        } else {
+            mMixerTrackMask |= 1 << index;
+        }
+        const status_t status = mixer->create(
                 index, fastTrack->mChannelMask, fastTrack->mFormat, AUDIO_SESSION_OUTPUT_MIX);
         LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
                 "%s: cannot create fast track index"
@@ -149,7 +173,7 @@ void FastMixer::updateMixerTrack(int index, Reason reason) {
     }
         [[fallthrough]];  // now fallthrough to update the newly created track.
     case REASON_MODIFY:
-        mMixer->setBufferProvider(index, fastTrack->mBufferProvider);
+        mixer->setBufferProvider(index, fastTrack->mBufferProvider);
 
         float vlf, vrf;
         if (fastTrack->mVolumeProvider != nullptr) {
@@ -163,28 +187,28 @@ void FastMixer::updateMixerTrack(int index, Reason reason) {
         // set volume to avoid ramp whenever the track is updated (or created).
         // Note: this does not distinguish from starting fresh or
         // resuming from a paused state.
-        mMixer->setParameter(index, AudioMixer::VOLUME, AudioMixer::VOLUME0, &vlf);
-        mMixer->setParameter(index, AudioMixer::VOLUME, AudioMixer::VOLUME1, &vrf);
+        mixer->setParameter(index, AudioMixer::VOLUME, AudioMixer::VOLUME0, &vlf);
+        mixer->setParameter(index, AudioMixer::VOLUME, AudioMixer::VOLUME1, &vrf);
 
-        mMixer->setParameter(index, AudioMixer::RESAMPLE, AudioMixer::REMOVE, nullptr);
-        mMixer->setParameter(index, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER,
-                (void *)mMixerBuffer);
-        mMixer->setParameter(index, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+        mixer->setParameter(index, AudioMixer::RESAMPLE, AudioMixer::REMOVE, nullptr);
+        mixer->setParameter(index, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER,
+                mixer == mHelperMixer ? mHelperMixerBuffer : mMixerBuffer);
+        mixer->setParameter(index, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
                 (void *)(uintptr_t)mMixerBufferFormat);
-        mMixer->setParameter(index, AudioMixer::TRACK, AudioMixer::FORMAT,
+        mixer->setParameter(index, AudioMixer::TRACK, AudioMixer::FORMAT,
                 (void *)(uintptr_t)fastTrack->mFormat);
-        mMixer->setParameter(index, AudioMixer::TRACK, AudioMixer::CHANNEL_MASK,
+        mixer->setParameter(index, AudioMixer::TRACK, AudioMixer::CHANNEL_MASK,
                 (void *)(uintptr_t)fastTrack->mChannelMask);
-        mMixer->setParameter(index, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
+        mixer->setParameter(index, AudioMixer::TRACK, AudioMixer::MIXER_CHANNEL_MASK,
                 (void *)(uintptr_t)mSinkChannelMask);
-        mMixer->setParameter(index, AudioMixer::TRACK, AudioMixer::HAPTIC_ENABLED,
+        mixer->setParameter(index, AudioMixer::TRACK, AudioMixer::HAPTIC_ENABLED,
                 (void *)(uintptr_t)fastTrack->mHapticPlaybackEnabled);
-        mMixer->setParameter(index, AudioMixer::TRACK, AudioMixer::HAPTIC_SCALE,
+        mixer->setParameter(index, AudioMixer::TRACK, AudioMixer::HAPTIC_SCALE,
                 (void *)(&(fastTrack->mHapticScale)));
-        mMixer->setParameter(index, AudioMixer::TRACK, AudioMixer::HAPTIC_MAX_AMPLITUDE,
+        mixer->setParameter(index, AudioMixer::TRACK, AudioMixer::HAPTIC_MAX_AMPLITUDE,
                 (void *)(&(fastTrack->mHapticMaxAmplitude)));
 
-        mMixer->enable(index);
+        mixer->enable(index);
         break;
     default:
         LOG_ALWAYS_FATAL("%s: invalid update reason %d", __func__, reason);
@@ -198,6 +222,9 @@ void FastMixer::onStateChange()
     FastMixerDumpState * const dumpState = (FastMixerDumpState *) mDumpState;
     const size_t frameCount = current->mFrameCount;
 
+    // the helper mixer may be reconfigured below.
+    waitHelperIdle();
+
     // update boottime offset, in case it has changed
     mTimestamp.mTimebaseOffset[ExtendedTimestamp::TIMEBASE_BOOTTIME] =
             mBoottimeOffset.load();
@@ -240,6 +267,13 @@ void FastMixer::onStateChange()
         mMixer = nullptr;
         free(mMixerBuffer);
         mMixerBuffer = nullptr;
+        delete mHelperMixer;
+        mHelperMixer = nullptr;
+        free(mHelperMixerBuffer);
+        mHelperMixerBuffer = nullptr;
+        mHelperBusy = false;    // a late mix in the old format is dropped
+        mMixerTrackMask = 0;
+        mHelperTrackMask = 0;
         free(mSinkBuffer);
         mSinkBuffer = nullptr;
         if (frameCount > 0 && mSampleRate > 0) {
@@ -256,6 +290,10 @@ void FastMixer::onStateChange()
                     * audio_bytes_per_sample(mMixerBufferFormat);
             mMixerBufferSize = mixerFrameSize * frameCount;
             (void)posix_memalign(&mMixerBuffer, 32, mMixerBufferSize);
+            if (mHelper != nullptr) {
+                mHelperMixer = new AudioMixer(frameCount, mSampleRate);
+                (void)posix_memalign(&mHelperMixerBuffer, 32, mMixerBufferSize);
+            }
             const size_t sinkFrameSize = mSinkChannelCount
                     * audio_bytes_per_sample(mFormat.mFormat);
             if (sinkFrameSize > mixerFrameSize) { // need a sink buffer
@@ -322,6 +360,7 @@ void FastMixer::onStateChange()
         }
 
         mFastTracksGen = current->mFastTracksGen;
+        dumpState->mHelperTrackMask = mHelperTrackMask;
     }
 }
 
@@ -357,9 +396,20 @@ void FastMixer::onWork()
         // AudioMixer::mState.enabledTracks is undefined if mState.hook == process__validate,
         // so we keep a side copy of enabledTracks
         bool anyEnabledTracks = false;
+        bool anyEnabledHelperTracks = false;
 
         // for each track, update volume and check for underrun
         unsigned currentTrackMask = current->mTrackMask;
+        // When the helper missed the previous write, its tracks are not mixed again until
+        // its late mix has been added to the output, so their data is delayed, not lost.
+        bool lateHelperMix = false;
+        if (mHelperBusy) {
+            currentTrackMask &= ~mHelperTrackMask;
+            if (mHelper->isIdle()) {
+                lateHelperMix = true;
+                mHelperBusy = false;
+            }
+        }
         while (currentTrackMask != 0) {
             const int i = __builtin_ctz(currentTrackMask);
             currentTrackMask &= ~(1 << i);
@@ -384,13 +434,15 @@ void FastMixer::onWork()
             fastTrack->mBufferProvider->onTimestamp(perTrackTimestamp);
 
             const int name = i;
+            AudioMixer* const mixer = getMixer(i);
+            bool& anyEnabled = mixer == mHelperMixer ? anyEnabledHelperTracks : anyEnabledTracks;
             if (fastTrack->mVolumeProvider != nullptr) {
                 const gain_minifloat_packed_t vlr = fastTrack->mVolumeProvider->getVolumeLR();
                 float vlf = float_from_gain(gain_minifloat_unpack_left(vlr));
                 float vrf = float_from_gain(gain_minifloat_unpack_right(vlr));
 
-                mMixer->setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME0, &vlf);
-                mMixer->setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME1, &vrf);
+                mixer->setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME0, &vlf);
+                mixer->setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME1, &vrf);
             }
             // FIXME The current implementation of framesReady() for fast tracks
             // takes a tryLock, which can block
@@ -406,25 +458,30 @@ void FastMixer::onWork()
                 if (framesReady == 0) {
                     underruns.mBitFields.mEmpty++;
                     underruns.mBitFields.mMostRecent = UNDERRUN_EMPTY;
-                    mMixer->disable(name);
+                    mixer->disable(name);
                 } else {
                     // allow mixing partial buffer
                     underruns.mBitFields.mPartial++;
                     underruns.mBitFields.mMostRecent = UNDERRUN_PARTIAL;
-                    mMixer->enable(name);
-                    anyEnabledTracks = true;
+                    mixer->enable(name);
+                    anyEnabled = true;
                 }
             } else {
                 underruns.mBitFields.mFull++;
                 underruns.mBitFields.mMostRecent = UNDERRUN_FULL;
-                mMixer->enable(name);
-                anyEnabledTracks = true;
+                mixer->enable(name);
+                anyEnabled = true;
             }
             ftDump->mUnderruns = underruns;
             ftDump->mFramesReady = framesReady;
             ftDump->mFramesWritten = trackFramesWritten;
         }
 
+        // the helper mixes its tracks concurrently with ours.
+        if (anyEnabledHelperTracks) {
+            mHelper->startMix(mHelperMixer);
+        }
+
         if (anyEnabledTracks) {
             // process() is CPU-bound
             mMixer->process();
@@ -433,6 +490,31 @@ void FastMixer::onWork()
             mMixerBufferState = UNDEFINED;
         }
 
+        const auto addHelperMix = [&]() {
+            const size_t sampleCount = frameCount * mSinkChannelCount;
+            if (mMixerBufferState == MIXED) {
+                accumulate_float((float *)mMixerBuffer, (const float *)mHelperMixerBuffer,
+                        sampleCount);
+            } else {
+                memcpy(mMixerBuffer, mHelperMixerBuffer, mMixerBufferSize);
+                mMixerBufferState = MIXED;
+            }
+            dumpState->mHelperMixes++;
+        };
+        if (lateHelperMix) {
+            addHelperMix();
+        }
+        if (anyEnabledHelperTracks) {
+            // A helper late by more than half a period is left to complete on its own,
+            // and its mix is added to the next write, so that our write is not late as well.
+            if (mHelper->waitMix(mPeriodNs / 2)) {
+                addHelperMix();
+            } else {
+                mHelperBusy = true;
+                dumpState->mHelperLateMixes++;
+            }
+        }
+
     } else if (mMixerBufferState == MIXED) {
         mMixerBufferState = UNDEFINED;
     }
@@ -22,6 +22,7 @@
 #include "StateQueue.h"
 #include "FastMixerState.h"
 #include "FastMixerDumpState.h"
+#include "FastMixerHelper.h"
 #include <afutils/NBAIO_Tee.h>
 
 namespace android {
@@ -45,6 +46,10 @@ public:
     virtual void setBoottimeOffset(int64_t boottimeOffset) {
         mBoottimeOffset.store(boottimeOffset); /* memory_order_seq_cst */
     }
+
+    // Sets an optional, already running, helper thread that mixes part of the fast tracks.
+    // Must be called before run().
+            void setHelper(const sp<FastMixerHelper>& helper) { mHelper = helper; }
 private:
             FastMixerStateQueue mSQ;
 
@@ -65,6 +70,15 @@ private:
     // called when a fast track of index has been removed, added, or modified
     void updateMixerTrack(int index, Reason reason);
 
+    // returns the mixer, mMixer or mHelperMixer, configured with the fast track of index.
+    AudioMixer* getMixer(int index) const {
+        return (mHelperTrackMask & (1 << index)) != 0 ? mHelperMixer : mMixer;
+    }
+
+    // waits for the helper to complete a late mix, before its mixer may be reconfigured.
+    // The late mix is then added to the next write by onWork().
+    void waitHelperIdle();
+
     // FIXME these former local variables need comments
     static const FastMixerState sInitial;
 
@@ -85,6 +99,15 @@ private:
     size_t          mMixerBufferSize = 0;
     static constexpr audio_format_t mMixerBufferFormat = AUDIO_FORMAT_PCM_FLOAT;
 
+    // When there is a helper, fast tracks are split between mMixer, mixing into mMixerBuffer,
+    // and mHelperMixer, mixing into mHelperMixerBuffer on the helper thread.
+    sp<FastMixerHelper> mHelper;
+    AudioMixer*     mHelperMixer = nullptr;
+    void*           mHelperMixerBuffer = nullptr;
+    unsigned        mMixerTrackMask = 0;    // fast tracks configured in mMixer
+    unsigned        mHelperTrackMask = 0;   // fast tracks configured in mHelperMixer
+    bool            mHelperBusy = false;    // helper is late, its mix is not yet in the output
+
     // audio channel count, excludes haptic channels.  Set in onStateChange().
     uint32_t        mAudioChannelCount = 0;
 
@@ -61,6 +61,10 @@ void FastMixerDumpState::dump(int fd) const
                 mSampleRate, mFrameCount, measuredWarmupMs, mWarmupCycles,
                 mixPeriodSec * 1e3, mLatencyMs);
     dprintf(fd, "  FastMixer Timestamp stats: %s\n", mTimestampVerifier.toString().c_str());
+    if (mHelperMixes != 0 || mHelperLateMixes != 0) {
+        dprintf(fd, "  FastMixer helper: trackMask=%#x mixes=%u lateMixes=%u\n",
+                mHelperTrackMask, mHelperMixes, mHelperLateMixes);
+    }
 #ifdef FAST_THREAD_STATISTICS
     // find the interval of valid samples
     const uint32_t bounds = mBounds;
@@ -73,6 +73,9 @@ struct FastMixerDumpState : FastThreadDumpState {
     uint32_t mSampleRate = 0;
     size_t   mFrameCount = 0;
     uint32_t mTrackMask = 0;      // mask of active tracks
+    uint32_t mHelperTrackMask = 0;  // mask of tracks mixed by the FastMixerHelper, if any
+    uint32_t mHelperMixes = 0;      // total number of helper mixes summed in time
+    uint32_t mHelperLateMixes = 0;  // total number of helper mixes too late to be summed
     FastTrackDump   mTracks[FastMixerState::kMaxFastTracks];
 
     // For timestamp statistics.
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// <IMPORTANT_WARNING>
+// The design rules of FastMixer threadLoop() apply to startMix(), waitMix() and threadLoop():
+// avoid library and system calls except the futex wait and wake.
+// </IMPORTANT_WARNING>
+
+#define LOG_TAG "FastMixerHelper"
+//#define LOG_NDEBUG 0
+
+#define ATRACE_TAG ATRACE_TAG_AUDIO
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <audio_utils/clock.h>
+#include <media/AudioMixer.h>
+#include <utils/Log.h>
+#include <utils/Timers.h>
+#include <utils/Trace.h>
+#include "FastMixerHelper.h"
+
+namespace android {
+
+static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t)
+        && std::atomic<int32_t>::is_always_lock_free, "futex word must be a plain int32_t");
+
+// Interval of the wakes by requestExit(), until the helper is not sleeping.
+static constexpr useconds_t kExitWakeIntervalUs = 1000;
+
+static void futexWait(std::atomic<int32_t>* addr, int32_t expected,
+        const struct timespec* timeout) {
+    (void) syscall(__NR_futex, reinterpret_cast<int32_t*>(addr), FUTEX_WAIT_PRIVATE,
+            expected, timeout);
+}
+
+static void futexWake(std::atomic<int32_t>* addr) {
+    (void) syscall(__NR_futex, reinterpret_cast<int32_t*>(addr), FUTEX_WAKE_PRIVATE, 1);
+}
+
+FastMixerHelper::FastMixerHelper()
+    : Thread(false /*canCallJava*/)
+{
+}
+
+FastMixerHelper::~FastMixerHelper() = default;
+
+void FastMixerHelper::startMix(AudioMixer* mixer)
+{
+    ALOG_ASSERT(isIdle());
+    mMixer = mixer;
+    // FastMixer is the only writer, release publishes mMixer and the mixer state.
+    mRequestSequence.store(mRequestSequence.load(std::memory_order_relaxed) + 1,
+            std::memory_order_release);
+    futexWake(&mRequestSequence);
+}
+
+bool FastMixerHelper::waitMix(int64_t timeoutNs)
+{
+    const int32_t request = mRequestSequence.load(std::memory_order_relaxed);
+    // Usually the helper completes during the FastMixer's own mix, so check before sleeping.
+    int32_t done = mDoneSequence.load(std::memory_order_acquire);
+    if (done == request) {
+        return true;
+    }
+    ATRACE_BEGIN("wait helper");
+    const int64_t startNs = systemTime();
+    // mWaiting and mDoneSequence are sequentially consistent, so either the helper sees
+    // mWaiting and wakes us, or we see the new mDoneSequence before sleeping.
+    mWaiting.store(true);
+    while ((done = mDoneSequence.load()) != request) {
+        struct timespec ts;
+        const struct timespec* timeout = nullptr;
+        if (timeoutNs >= 0) {
+            const int64_t remainingNs = timeoutNs - (systemTime() - startNs);
+            if (remainingNs <= 0) {
+                break;
+            }
+            ts.tv_sec = remainingNs / NANOS_PER_SECOND;
+            ts.tv_nsec = remainingNs % NANOS_PER_SECOND;
+            timeout = &ts;
+        }
+        futexWait(&mDoneSequence, done, timeout);
+    }
+    mWaiting.store(false, std::memory_order_relaxed);
+    ATRACE_END();
+    return done == request;
+}
+
+void FastMixerHelper::requestExit()
+{
+    mExitPending.store(true);
+    Thread::requestExit();
+    // mRequestSequence is only written by FastMixer, so it cannot be changed to make a
+    // wait about to begin return.  Instead, wake the helper until it is not sleeping:
+    // mSleeping and mExitPending are sequentially consistent, so once the helper has
+    // set mSleeping, either it sees mExitPending, or we see mSleeping and wake it.
+    while (mSleeping.load()) {
+        futexWake(&mRequestSequence);
+        usleep(kExitWakeIntervalUs);
+    }
+}
+
+bool FastMixerHelper::threadLoop()
+{
+    int32_t request = mDoneSequence.load(std::memory_order_relaxed);
+    for (;;) {
+        const int32_t next = mRequestSequence.load(std::memory_order_acquire);
+        if (mExitPending.load()) {
+            break;
+        }
+        if (next == request) {
+            mSleeping.store(true);
+            if (!mExitPending.load()) {
+                futexWait(&mRequestSequence, request, nullptr /* timeout */);
+            }
+            mSleeping.store(false);
+            continue;
+        }
+        request = next;
+
+        ATRACE_BEGIN("helper mix");
+        mMixer->process();
+        ATRACE_END();
+        mMixCount.store(mMixCount.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+
+        mDoneSequence.store(request);
+        if (mWaiting.load()) {
+            futexWake(&mDoneSequence);
+        }
+    }
+    return false;
+}
+
+}  // namespace android
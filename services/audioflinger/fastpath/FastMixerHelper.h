@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <utils/Thread.h>
+
+namespace android {
+
+class AudioMixer;
+
+// FastMixerHelper is an optional second fast thread for FastMixer.
+//
+// FastMixer assigns about half of its fast tracks to a second AudioMixer, and each cycle
+// hands that mixer to the helper, which runs AudioMixer::process() into its own partial
+// buffer while FastMixer mixes the other tracks.  FastMixer then waits for the helper,
+// sums the partial buffer into its own and writes to the sink.
+//
+// The handoff follows the StateQueue design: FastMixer publishes a request by
+// incrementing a sequence number, the helper acknowledges by publishing the same
+// sequence number once the mix is complete.  Neither side takes a lock; futex wait and
+// wake are used only to sleep when the other side is not ready, at the same well-known
+// points as FastThread.
+//
+// The helper must run at the same SCHED_FIFO priority as FastMixer, and preferably on
+// another core.  It is created and started by the MixerThread before the FastMixer.
+class FastMixerHelper : public Thread {
+
+public:
+    FastMixerHelper();
+    ~FastMixerHelper() override;
+
+    // Called by FastMixer only.
+    // Starts mixer->process() on the helper thread.  The helper must be idle.
+    // The mixer and its buffers must not be accessed by the caller until the mix is complete.
+    void startMix(AudioMixer* mixer);
+
+    // Called by FastMixer only.
+    // Waits for the mix started by startMix() to complete, for at most timeoutNs,
+    // or without limit if timeoutNs is negative.  Returns true if the helper is idle.
+    bool waitMix(int64_t timeoutNs);
+
+    // Returns true if no mix is in progress.
+    bool isIdle() const {
+        return mDoneSequence.load(std::memory_order_acquire)
+                == mRequestSequence.load(std::memory_order_relaxed);
+    }
+
+    // Total number of mixes completed, for dump.
+    uint32_t getMixCount() const { return mMixCount.load(std::memory_order_relaxed); }
+
+    // Thread
+    void requestExit() override;
+
+private:
+    bool threadLoop() override;
+
+    // Written by FastMixer, published by mRequestSequence.
+    AudioMixer*             mMixer = nullptr;
+
+    // Both are futex words: FastMixer waits on mDoneSequence, the helper on mRequestSequence.
+    std::atomic<int32_t>    mRequestSequence{0};    // incremented by FastMixer on startMix()
+    std::atomic<int32_t>    mDoneSequence{0};       // set by helper to the completed request
+    std::atomic_bool        mWaiting{false};        // FastMixer is waiting on mDoneSequence
+
+    std::atomic<uint32_t>   mMixCount{0};
+
+    // Set by requestExit(), which is not called by FastMixer so it does not change
+    // mRequestSequence.  The helper is woken while mSleeping, its wait on mRequestSequence.
+    std::atomic_bool        mExitPending{false};
+    std::atomic_bool        mSleeping{false};
+};  // class FastMixerHelper
+
+}  // namespace android
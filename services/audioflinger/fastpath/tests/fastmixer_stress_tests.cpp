@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "fastmixer_stress_tests"
+
+#include "../FastMixer.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <audio_utils/clock.h>
+#include <gtest/gtest.h>
+#include <utils/Timers.h>
+
+using namespace android;
+
+/*
+ * Drives a FastMixer with synthetic fast tracks into a sink that behaves as a HAL with
+ * a 2 ms period, and reports the deadline misses, with and without a FastMixerHelper.
+ *
+ * Each synthetic track busy-waits in getNextBuffer() to emulate the cost of
+ * a track on a small core, so the total mix load is proportional to the track count.
+ *
+ * The deadline misses depend on the device load and scheduling, so they are reported
+ * rather than checked.
+ */
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr size_t kFrameCount = 96;   // 2 ms
+constexpr int64_t kPeriodNs = kFrameCount * NANOS_PER_SECOND / kSampleRate;
+constexpr int64_t kTrackLoadNs = 50'000;
+constexpr int64_t kRunNs = 2 * NANOS_PER_SECOND;
+
+// A fast track always ready with looped noise, costing kTrackLoadNs per pull.
+class SyntheticTrack : public ExtendedAudioBufferProvider {
+public:
+    SyntheticTrack() : mData(kFrameCount * 4 * FCC_2) {
+        uint32_t seed = 1;
+        for (int16_t& sample : mData) {
+            seed = seed * 1664525 + 1013904223;
+            sample = (int16_t)(seed >> 20);  // about -18 dBFS
+        }
+    }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        const int64_t endNs = systemTime() + kTrackLoadNs;
+        while (systemTime() < endNs) {}
+        const size_t frames = mData.size() / FCC_2;
+        buffer->frameCount = std::min(buffer->frameCount, frames - mPosition);
+        buffer->raw = &mData[mPosition * FCC_2];
+        return OK;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        mPosition = (mPosition + buffer->frameCount) % (mData.size() / FCC_2);
+        mFramesReleased.store(mFramesReleased.load() + buffer->frameCount);
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+    }
+
+    size_t framesReady() const override { return SIZE_MAX / 2; }
+    int64_t framesReleased() const override { return mFramesReleased.load(); }
+
+private:
+    std::vector<int16_t> mData;
+    size_t mPosition = 0;
+    std::atomic<int64_t> mFramesReleased{};
+};
+
+// A blocking sink consuming one buffer per period, as a double buffered HAL would:
+// write() blocks until a buffer is free, and a write after both buffers have been consumed,
+// so the HAL has nothing to play, is a deadline miss.
+class DeadlineSink : public NBAIO_Sink {
+public:
+    DeadlineSink() : NBAIO_Sink(Format_from_SR_C(kSampleRate, FCC_2, AUDIO_FORMAT_PCM_16_BIT)) {
+        const NBAIO_Format offers[] = { mFormat };
+        size_t numCounterOffers = 0;
+        (void) negotiate(offers, std::size(offers), nullptr, numCounterOffers);
+    }
+
+    ssize_t write(const void* /* buffer */, size_t count) override {
+        const int64_t nowNs = systemTime();
+        if (mDeadlineNs == 0 || nowNs > mDeadlineNs + kPeriodNs) {
+            if (mDeadlineNs != 0) {
+                mMisses.store(mMisses.load() + 1);
+            }
+            mDeadlineNs = nowNs;  // restart the period clock after a miss.
+        } else {
+            const struct timespec ts = {
+                .tv_sec = static_cast<time_t>(mDeadlineNs / NANOS_PER_SECOND),
+                .tv_nsec = static_cast<long>(mDeadlineNs % NANOS_PER_SECOND), // NOLINT
+            };
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+        }
+        mDeadlineNs += kPeriodNs;
+        mFramesWritten += count;
+        mWrites.store(mWrites.load() + 1);
+        return count;
+    }
+
+    int64_t misses() const { return mMisses.load(); }
+    int64_t writes() const { return mWrites.load(); }
+
+private:
+    int64_t mDeadlineNs = 0;  // when the previous buffer is consumed.
+    std::atomic<int64_t> mMisses{};
+    std::atomic<int64_t> mWrites{};
+};
+
+struct StressResult {
+    int64_t writes;
+    int64_t misses;
+    uint32_t helperMixes;
+    uint32_t helperLateMixes;
+};
+
+StressResult runFastMixer(size_t trackCount, bool useHelper) {
+    std::vector<std::unique_ptr<SyntheticTrack>> tracks;
+    const sp<DeadlineSink> sink = sp<DeadlineSink>::make();
+    FastMixerDumpState dumpState;
+
+    sp<FastMixerHelper> helper;
+    const sp<FastMixer> fastMixer = sp<FastMixer>::make(AUDIO_IO_HANDLE_NONE);
+    if (useHelper) {
+        helper = sp<FastMixerHelper>::make();
+        helper->run("FastMixerHelper", PRIORITY_URGENT_AUDIO);
+        fastMixer->setHelper(helper);
+    }
+
+    FastMixerStateQueue* sq = fastMixer->sq();
+    FastMixerState* state = sq->begin();
+    for (size_t i = 0; i < trackCount; ++i) {
+        tracks.push_back(std::make_unique<SyntheticTrack>());
+        FastTrack* fastTrack = &state->mFastTracks[i];
+        fastTrack->mBufferProvider = tracks.back().get();
+        fastTrack->mChannelMask = AUDIO_CHANNEL_OUT_STEREO;
+        fastTrack->mFormat = AUDIO_FORMAT_PCM_16_BIT;
+        fastTrack->mGeneration++;
+        state->mTrackMask |= 1u << i;
+    }
+    state->mFastTracksGen++;
+    state->mOutputSink = sink.get();
+    state->mOutputSinkGen++;
+    state->mFrameCount = kFrameCount;
+    state->mSinkChannelMask = AUDIO_CHANNEL_NONE;
+    state->mCommand = FastMixerState::MIX_WRITE;
+    state->mDumpState = &dumpState;
+    sq->end();
+    sq->push(FastMixerStateQueue::BLOCK_UNTIL_PUSHED);
+
+    fastMixer->run("FastMixer", PRIORITY_URGENT_AUDIO);
+    const struct timespec runTs = { .tv_sec = kRunNs / NANOS_PER_SECOND, .tv_nsec = 0 };
+    nanosleep(&runTs, nullptr);
+
+    state = sq->begin();
+    state->mCommand = FastMixerState::EXIT;
+    sq->end();
+    sq->push(FastMixerStateQueue::BLOCK_UNTIL_PUSHED);
+    fastMixer->join();
+    if (helper != nullptr) {
+        helper->requestExit();
+        helper->requestExitAndWait();
+    }
+    return { sink->writes(), sink->misses(), dumpState.mHelperMixes, dumpState.mHelperLateMixes };
+}
+
+class FastMixerStressTest : public ::testing::TestWithParam<std::tuple<size_t, bool>> {};
+
+TEST_P(FastMixerStressTest, DeadlineMisses) {
+    const auto [trackCount, useHelper] = GetParam();
+    const StressResult result = runFastMixer(trackCount, useHelper);
+
+    printf("tracks:%zu helper:%d writes:%lld misses:%lld (%.2f%%) helperMixes:%u late:%u\n",
+            trackCount, useHelper, (long long)result.writes, (long long)result.misses,
+            result.writes > 0 ? 100. * result.misses / result.writes : 0.,
+            result.helperMixes, result.helperLateMixes);
+    RecordProperty("writes", std::to_string(result.writes));
+    RecordProperty("misses", std::to_string(result.misses));
+
+    EXPECT_GT(result.writes, kRunNs / kPeriodNs / 2);
+    if (useHelper) {
+        EXPECT_GT(result.helperMixes + result.helperLateMixes, 0U);
+    } else {
+        EXPECT_EQ(0U, result.helperMixes + result.helperLateMixes);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(FastMixerStress, FastMixerStressTest,
+        ::testing::Combine(
+                ::testing::Values(4, 8, 16, 24, FastMixerState::kMaxFastTracks),
+                ::testing::Bool()),
+        [](const ::testing::TestParamInfo<FastMixerStressTest::ParamType>& info) {
+            return std::to_string(std::get<0>(info.param)) + "tracks_"
+                    + (std::get<1>(info.param) ? "helper" : "nohelper");
+        });
+
+} // namespace
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <audio_utils/safe_math.h>
+
+namespace android::audioflinger {
+
+/**
+ * CaptureHistory
+ *
+ * Position arithmetic of the RecordThread circular capture buffer.
+ *
+ * The rear of the buffer counts all frames captured, modulo 2^32, so that a track
+ * may start with frames captured before it was started (shared audio history).
+ * Every captured frame must therefore be in the buffer, even when it was read
+ * directly into a track buffer.
+ *
+ * This class is not thread safe.
+ */
+class CaptureHistory {
+public:
+    /**
+     * Copies frames into the circular buffer at rear, wrapping around its end.
+     *
+     * \param buffer     the circular buffer of framesP2 frames.
+     * \param framesP2   the size of the buffer in frames, a power of 2.
+     * \param frameSize  the size of a frame in bytes.
+     * \param rear       the position of the first frame to write, before wrapping.
+     * \param frames     the frames to copy.
+     * \param frameCount the number of frames to copy, at most framesP2.
+     */
+    static void write(void* buffer, size_t framesP2, size_t frameSize, int32_t rear,
+            const void* frames, size_t frameCount) {
+        const size_t offset = (size_t)rear & (framesP2 - 1);
+        const size_t part1 = std::min(frameCount, framesP2 - offset);
+        memcpy((uint8_t*)buffer + offset * frameSize, frames, part1 * frameSize);
+        memcpy(buffer, (const uint8_t*)frames + part1 * frameSize,
+                (frameCount - part1) * frameSize);
+    }
+
+    /**
+     * Returns the front of a track starting at startFrames.
+     *
+     * \param rear          the position after the last frame captured.
+     * \param startFrames   the position of the first frame to read, or negative to read
+     *                      only frames captured from now on.  A start after rear is
+     *                      taken as a recent wraparound of rear.
+     * \param historyFrames the number of frames kept in the buffer, which limits
+     *                      how far back the front may be.
+     */
+    static int32_t getStartFront(int32_t rear, int32_t startFrames, size_t historyFrames) {
+        int64_t deltaFrames = 0;
+        if (startFrames >= 0) {
+            deltaFrames = startFrames <= rear
+                    ? (int64_t)rear - startFrames
+                    : (int64_t)rear + UINT32_MAX + 1 - startFrames;
+            deltaFrames = std::min(deltaFrames, (int64_t)historyFrames);
+        }
+        return audio_utils::safe_sub_overflow(rear, (int32_t)deltaFrames);
+    }
+};
+
+} // namespace android::audioflinger
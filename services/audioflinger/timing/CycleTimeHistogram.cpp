@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "CycleTimeHistogram"
+
+#include <algorithm>
+#include <cmath>
+
+#include <android-base/stringprintf.h>
+#include <utils/Log.h>
+#include "CycleTimeHistogram.h"
+
+namespace android::audioflinger {
+
+int64_t CycleTimeHistogram::Snapshot::getPercentileNs(double percentile) const {
+    if (count <= 0) return 0;
+    const auto rank = (int64_t)std::ceil(std::clamp(percentile, 0., 100.) * 0.01 * count);
+    int64_t cumulative = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        cumulative += counts[i];
+        if (cumulative >= std::max(rank, int64_t{1})) {
+            return i + 1 < kBucketCount
+                    ? std::min(getBucketLowerBoundNs(i + 1), maxNs) : maxNs;
+        }
+    }
+    return maxNs; // count is not consistent with counts, from a concurrent snapshot.
+}
+
+CycleTimeHistogram::Snapshot CycleTimeHistogram::Snapshot::operator-(
+        const Snapshot& earlier) const {
+    Snapshot delta;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        delta.counts[i] = counts[i] - earlier.counts[i];  // modulo 2^32.
+    }
+    delta.count = count - earlier.count;
+    delta.sumNs = sumNs - earlier.sumNs;
+    delta.maxNs = maxNs;
+    return delta;
+}
+
+std::string CycleTimeHistogram::Snapshot::toString() const {
+    return base::StringPrintf("n:%lld mean:%.3lf p50:%.3lf p90:%.3lf p99:%.3lf max:%.3lf ms",
+            (long long)count, getMeanNs() * 1e-6,
+            getPercentileNs(50.) * 1e-6, getPercentileNs(90.) * 1e-6,
+            getPercentileNs(99.) * 1e-6, maxNs * 1e-6);
+}
+
+CycleTimeHistogram::Snapshot CycleTimeHistogram::getSnapshot() const {
+    Snapshot snapshot;
+    // Read the totals first, as record() updates them last.
+    snapshot.count = mCount.load(std::memory_order_relaxed);
+    snapshot.sumNs = mSumNs.load(std::memory_order_relaxed);
+    snapshot.maxNs = mMaxNs.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        snapshot.counts[i] = mCounts[i].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+CycleTimeHistogram::Snapshot CycleTimeHistogram::takeIntervalSnapshot() {
+    Snapshot snapshot = getSnapshot();
+    snapshot.maxNs = mIntervalMaxNs.exchange(0, std::memory_order_relaxed);
+    return snapshot;
+}
+
+/* static */
+const char* ThreadCycleTimes::toString(Phase phase) {
+    switch (phase) {
+    case PHASE_MIX: return "mix";
+    case PHASE_EFFECTS: return "effects";
+    case PHASE_WRITE: return "write";
+    case PHASE_READ: return "read";
+    case PHASE_SLEEP_OVERSHOOT: return "sleepOvershoot";
+    default: return "unknown";
+    }
+}
+
+ThreadCycleTimes::Snapshots ThreadCycleTimes::getSnapshots() const {
+    Snapshots snapshots;
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        snapshots[i] = mHistograms[i].getSnapshot();
+    }
+    return snapshots;
+}
+
+ThreadCycleTimes::Snapshots ThreadCycleTimes::takeIntervalSnapshots() {
+    Snapshots snapshots;
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        snapshots[i] = mHistograms[i].takeIntervalSnapshot();
+    }
+    return snapshots;
+}
+
+std::string ThreadCycleTimes::toString(const std::string& prefix) const {
+    std::string result;
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        const auto snapshot = mHistograms[i].getSnapshot();
+        if (snapshot.count == 0) continue;
+        result.append(prefix).append(toString((Phase)i)).append(": ")
+                .append(snapshot.toString()).append("\n");
+    }
+    return result;
+}
+
+} // namespace android::audioflinger
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace android::audioflinger {
+
+/**
+ * CycleTimeHistogram
+ *
+ * A histogram of durations, such as the time spent in one phase of a thread loop cycle.
+ *
+ * Buckets are logarithmic with 4 buckets per octave, so a percentile is reported
+ * within 19% of its true value.  The first bucket holds durations below 2^10 ns (1 us),
+ * the last bucket durations of 2^34 ns (17 s) and above.
+ *
+ * There must be a single writer thread, which may record without any lock:
+ * a record() is a handful of relaxed atomic loads and stores, with no read-modify-write,
+ * so it can be left enabled in the audio thread loops.  Any thread may take a snapshot
+ * concurrently; the snapshot is then not necessarily consistent with a single instant,
+ * which is acceptable for statistics.
+ */
+class CycleTimeHistogram {
+public:
+    static constexpr int kMinLog2Ns = 10;
+    static constexpr int kMaxLog2Ns = 34;
+    static constexpr int kBucketsPerOctave = 4;
+    static constexpr size_t kBucketCount =
+            (kMaxLog2Ns - kMinLog2Ns) * kBucketsPerOctave + 2 /* underflow and overflow */;
+
+    /**
+     * A copy of the histogram, which may be examined at leisure.
+     */
+    struct Snapshot {
+        std::array<uint32_t, kBucketCount> counts{};
+        int64_t count = 0;
+        int64_t sumNs = 0;
+        // Over the lifetime of the histogram, or since the previous interval snapshot
+        // for takeIntervalSnapshot().  operator- keeps the maxNs of the later snapshot.
+        int64_t maxNs = 0;
+
+        /**
+         * Returns an upper bound of the given percentile, in nanoseconds.
+         *
+         * \param percentile between 0 and 100.
+         * \return the upper edge of the bucket holding the percentile,
+         *         limited to maxNs, or 0 if the snapshot is empty.
+         */
+        int64_t getPercentileNs(double percentile) const;
+
+        /** Returns the mean duration in nanoseconds, or 0 if the snapshot is empty. */
+        double getMeanNs() const { return count > 0 ? (double)sumNs / count : 0.; }
+
+        /**
+         * Returns the durations recorded since the earlier snapshot.
+         * Their maxNs is only the maximum of those durations if this snapshot was returned
+         * by takeIntervalSnapshot() and the earlier one by the previous call.
+         */
+        Snapshot operator-(const Snapshot& earlier) const;
+
+        /** Returns "n:count mean:ms p50:ms p90:ms p99:ms max:ms". */
+        std::string toString() const;
+    };
+
+    /**
+     * Records a duration.  Only one thread may call this method.
+     *
+     * \param durationNs the duration in nanoseconds, negative values are counted as 0.
+     */
+    void record(int64_t durationNs) {
+        if (durationNs < 0) durationNs = 0;
+        auto& count = mCounts[getBucket(durationNs)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        mCount.store(mCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        mSumNs.store(mSumNs.load(std::memory_order_relaxed) + durationNs,
+                std::memory_order_relaxed);
+        if (durationNs > mMaxNs.load(std::memory_order_relaxed)) {
+            mMaxNs.store(durationNs, std::memory_order_relaxed);
+        }
+        if (durationNs > mIntervalMaxNs.load(std::memory_order_relaxed)) {
+            mIntervalMaxNs.store(durationNs, std::memory_order_relaxed);
+        }
+    }
+
+    /** Returns a copy of the histogram, may be called from any thread. */
+    Snapshot getSnapshot() const;
+
+    /**
+     * Returns a copy of the histogram, with maxNs over the durations recorded since
+     * the previous call rather than over the lifetime, and starts a new interval.
+     * Only one thread may call this method, for example to report periodic metrics.
+     *
+     * A duration recorded concurrently may be counted in the maxNs of either interval,
+     * or of both.
+     */
+    Snapshot takeIntervalSnapshot();
+
+    /** Returns the bucket index for a non-negative duration. */
+    static constexpr size_t getBucket(int64_t durationNs) {
+        if (durationNs < (int64_t{1} << kMinLog2Ns)) return 0;
+        if (durationNs >= (int64_t{1} << kMaxLog2Ns)) return kBucketCount - 1;
+        const int log2 = 63 - __builtin_clzll((uint64_t)durationNs);
+        const int fraction = (durationNs >> (log2 - 2)) & (kBucketsPerOctave - 1);
+        return 1 + (log2 - kMinLog2Ns) * kBucketsPerOctave + fraction;
+    }
+
+    /** Returns the smallest duration counted in a bucket. */
+    static constexpr int64_t getBucketLowerBoundNs(size_t bucket) {
+        if (bucket == 0) return 0;
+        if (bucket >= kBucketCount - 1) return int64_t{1} << kMaxLog2Ns;
+        const size_t index = bucket - 1;
+        const int log2 = kMinLog2Ns + index / kBucketsPerOctave;
+        return (int64_t)(kBucketsPerOctave + index % kBucketsPerOctave) << (log2 - 2);
+    }
+
+private:
+    std::array<std::atomic<uint32_t>, kBucketCount> mCounts{};
+    std::atomic<int64_t> mCount{};
+    std::atomic<int64_t> mSumNs{};
+    std::atomic<int64_t> mMaxNs{};
+    std::atomic<int64_t> mIntervalMaxNs{};  // reset by takeIntervalSnapshot().
+};
+
+/**
+ * ThreadCycleTimes
+ *
+ * The per-cycle durations of an audio thread loop, one CycleTimeHistogram per phase.
+ *
+ * As with CycleTimeHistogram, the thread loop records without a lock and
+ * dump or metrics may read concurrently.
+ */
+class ThreadCycleTimes {
+public:
+    enum Phase {
+        PHASE_MIX,              // PlaybackThread: threadLoop_mix().
+        PHASE_EFFECTS,          // all effect chains process_l().
+        PHASE_WRITE,            // PlaybackThread: threadLoop_write(), the HAL or pipe write.
+        PHASE_READ,             // RecordThread: the HAL or pipe read.
+        PHASE_SLEEP_OVERSHOOT,  // time slept beyond the requested sleep time.
+        PHASE_COUNT,
+    };
+
+    using Snapshots = std::array<CycleTimeHistogram::Snapshot, PHASE_COUNT>;
+
+    /** Returns a short lower camel case name for a phase, e.g. "mix", "sleepOvershoot". */
+    static const char* toString(Phase phase);
+
+    void record(Phase phase, int64_t durationNs) { mHistograms[phase].record(durationNs); }
+
+    const CycleTimeHistogram& get(Phase phase) const { return mHistograms[phase]; }
+
+    Snapshots getSnapshots() const;
+
+    /** Returns CycleTimeHistogram::takeIntervalSnapshot() for each phase. */
+    Snapshots takeIntervalSnapshots();
+
+    /**
+     * Returns one line per phase with a recorded duration, or an empty string.
+     *
+     * \param prefix prepended to each line, for example indentation.
+     */
+    std::string toString(const std::string& prefix = {}) const;
+
+private:
+    std::array<CycleTimeHistogram, PHASE_COUNT> mHistograms;
+};
+
+} // namespace android::audioflinger
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "capturehistory_tests"
+
+#include "../CaptureHistory.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace android;
+using namespace android::audioflinger;
+
+namespace {
+
+constexpr size_t kFramesP2 = 1024;
+constexpr size_t kHistoryFrames = 7 * 128;  // mRsmpInFrames, at most kFramesP2.
+constexpr size_t kHalFrames = 128;
+
+// Mimics the RecordThread reading the HAL directly into a track buffer,
+// each frame holding its capture position.
+class CaptureHistoryTest : public ::testing::Test {
+protected:
+    void directRead(size_t frameCount) {
+        std::vector<int32_t> trackBuffer(frameCount);
+        for (size_t i = 0; i < frameCount; ++i) {
+            trackBuffer[i] = audio_utils::safe_add_overflow(mRear, (int32_t)i);
+        }
+        CaptureHistory::write(mBuffer.data(), kFramesP2, sizeof(int32_t), mRear,
+                trackBuffer.data(), frameCount);
+        mRear = audio_utils::safe_add_overflow(mRear, (int32_t)frameCount);
+    }
+
+    // Checks that a track started at front reads the frames captured from front to rear.
+    void expectHistoryFrom(int32_t front) {
+        for (int32_t position = front; position != mRear;
+                position = audio_utils::safe_add_overflow(position, 1)) {
+            ASSERT_EQ(position, mBuffer[(size_t)position & (kFramesP2 - 1)]);
+        }
+    }
+
+    std::vector<int32_t> mBuffer = std::vector<int32_t>(kFramesP2, -1);
+    int32_t mRear = 0;
+};
+
+TEST_F(CaptureHistoryTest, StartFramesAfterDirectRead) {
+    for (int i = 0; i < 20; ++i) {
+        directRead(kHalFrames);
+    }
+    const int32_t startFrames = mRear - 500;
+    const int32_t front = CaptureHistory::getStartFront(mRear, startFrames, kHistoryFrames);
+    EXPECT_EQ(startFrames, front);
+    expectHistoryFrom(front);
+}
+
+TEST_F(CaptureHistoryTest, PartialReadsWrapAround) {
+    // reads which do not divide the buffer size, so that some wrap around its end.
+    for (int i = 0; i < 20; ++i) {
+        directRead(kHalFrames - 1);
+    }
+    const int32_t front = CaptureHistory::getStartFront(mRear, 0 /* startFrames */,
+            kHistoryFrames);
+    EXPECT_EQ(mRear - (int32_t)kHistoryFrames, front);  // limited to the history.
+    expectHistoryFrom(front);
+}
+
+TEST_F(CaptureHistoryTest, NoStartFrames) {
+    directRead(kHalFrames);
+    EXPECT_EQ(mRear, CaptureHistory::getStartFront(mRear, -1 /* startFrames */,
+            kHistoryFrames));
+}
+
+TEST_F(CaptureHistoryTest, RearWraparound) {
+    mRear = INT32_MAX - 300;
+    const int32_t startFrames = mRear;
+    for (int i = 0; i < 5; ++i) {
+        directRead(kHalFrames);
+    }
+    ASSERT_LT(mRear, 0);
+    const int32_t front = CaptureHistory::getStartFront(mRear, startFrames, kHistoryFrames);
+    EXPECT_EQ(startFrames, front);
+    expectHistoryFrom(front);
+}
+
+} // namespace
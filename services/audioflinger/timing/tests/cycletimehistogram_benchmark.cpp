@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../CycleTimeHistogram.h"
+
+#include <atomic>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+#include <utils/Timers.h>
+
+using namespace android::audioflinger;
+
+/*
+ * The cost of the thread loop cycle time instrumentation.
+ *
+ * BM_Record is a record() alone, BM_TimedPhase the systemTime() pair and record()
+ * added around each phase of a thread loop cycle, and BM_RecordWithReader a record()
+ * with another thread taking snapshots, as dumpsys or mediametrics would.
+ *
+ * For scale, a PlaybackThread cycle is typically 2 to 20 ms and records 4 phases.
+ */
+
+static void BM_Record(benchmark::State& state) {
+    CycleTimeHistogram histogram;
+    int64_t durationNs = 0;
+    for (auto _ : state) {
+        histogram.record(durationNs);
+        durationNs = (durationNs + 104'729) & 0x3ffffff;  // spread over buckets, up to 67 ms.
+    }
+    benchmark::DoNotOptimize(histogram.getSnapshot().count);
+}
+
+BENCHMARK(BM_Record);
+
+static void BM_TimedPhase(benchmark::State& state) {
+    ThreadCycleTimes cycleTimes;
+    for (auto _ : state) {
+        const int64_t beginNs = systemTime();
+        benchmark::ClobberMemory();  // the phase.
+        cycleTimes.record(ThreadCycleTimes::PHASE_MIX, systemTime() - beginNs);
+    }
+}
+
+BENCHMARK(BM_TimedPhase);
+
+static void BM_RecordWithReader(benchmark::State& state) {
+    CycleTimeHistogram histogram;
+    std::atomic_bool done{};
+    std::thread reader([&] {
+        while (!done.load(std::memory_order_relaxed)) {
+            benchmark::DoNotOptimize(histogram.getSnapshot().getPercentileNs(99.));
+        }
+    });
+    int64_t durationNs = 0;
+    for (auto _ : state) {
+        histogram.record(durationNs);
+        durationNs = (durationNs + 104'729) & 0x3ffffff;
+    }
+    done = true;
+    reader.join();
+}
+
+BENCHMARK(BM_RecordWithReader);
+
+static void BM_Snapshot(benchmark::State& state) {
+    ThreadCycleTimes cycleTimes;
+    for (int64_t i = 0; i < 10'000; ++i) {
+        cycleTimes.record(ThreadCycleTimes::PHASE_MIX, i * 1'000);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cycleTimes.toString());
+    }
+}
+
+BENCHMARK(BM_Snapshot);
+
+BENCHMARK_MAIN();
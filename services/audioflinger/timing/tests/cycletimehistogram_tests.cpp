@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "cycletimehistogram_tests"
+
+#include "../CycleTimeHistogram.h"
+
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace android::audioflinger;
+
+namespace {
+
+TEST(CycleTimeHistogramTest, Buckets) {
+    using H = CycleTimeHistogram;
+    EXPECT_EQ(0U, H::getBucket(0));
+    EXPECT_EQ(0U, H::getBucket(1023));
+    EXPECT_EQ(1U, H::getBucket(1024));
+    EXPECT_EQ(H::kBucketCount - 1, H::getBucket(int64_t{1} << 34));
+    EXPECT_EQ(H::kBucketCount - 1, H::getBucket(INT64_MAX));
+
+    // every bucket lower bound falls in that bucket, and the value below it in the previous one.
+    for (size_t i = 1; i < H::kBucketCount; ++i) {
+        const int64_t lowerBoundNs = H::getBucketLowerBoundNs(i);
+        EXPECT_EQ(i, H::getBucket(lowerBoundNs));
+        EXPECT_EQ(i - 1, H::getBucket(lowerBoundNs - 1));
+        // buckets are no wider than 1/4 of their lower bound.
+        if (i > 1 && i < H::kBucketCount - 1) {
+            EXPECT_LE(H::getBucketLowerBoundNs(i + 1) - lowerBoundNs, lowerBoundNs / 4);
+        }
+    }
+}
+
+TEST(CycleTimeHistogramTest, Empty) {
+    CycleTimeHistogram histogram;
+    const auto snapshot = histogram.getSnapshot();
+    EXPECT_EQ(0, snapshot.count);
+    EXPECT_EQ(0, snapshot.getPercentileNs(50.));
+    EXPECT_EQ(0., snapshot.getMeanNs());
+}
+
+TEST(CycleTimeHistogramTest, Percentiles) {
+    CycleTimeHistogram histogram;
+    // 1 ms to 100 ms.
+    for (int64_t i = 1; i <= 100; ++i) {
+        histogram.record(i * 1'000'000);
+    }
+    const auto snapshot = histogram.getSnapshot();
+    EXPECT_EQ(100, snapshot.count);
+    EXPECT_EQ(100'000'000, snapshot.maxNs);
+    EXPECT_DOUBLE_EQ(50.5e6, snapshot.getMeanNs());
+
+    for (const double percentile : { 1., 10., 50., 90., 99. }) {
+        const int64_t expectedNs = (int64_t)percentile * 1'000'000;
+        const int64_t percentileNs = snapshot.getPercentileNs(percentile);
+        EXPECT_GE(percentileNs, expectedNs) << percentile;
+        EXPECT_LE(percentileNs, expectedNs * 5 / 4) << percentile;
+    }
+    EXPECT_EQ(100'000'000, snapshot.getPercentileNs(100.));
+}
+
+TEST(CycleTimeHistogramTest, NegativeIsZero) {
+    CycleTimeHistogram histogram;
+    histogram.record(-5);
+    const auto snapshot = histogram.getSnapshot();
+    EXPECT_EQ(1U, snapshot.counts[0]);
+    EXPECT_EQ(0, snapshot.sumNs);
+}
+
+TEST(CycleTimeHistogramTest, Delta) {
+    CycleTimeHistogram histogram;
+    histogram.record(10'000'000);
+    const auto before = histogram.getSnapshot();
+    histogram.record(1'000'000);
+    histogram.record(1'000'000);
+    const auto delta = histogram.getSnapshot() - before;
+    EXPECT_EQ(2, delta.count);
+    EXPECT_EQ(2'000'000, delta.sumNs);
+    EXPECT_EQ(0U, delta.counts[CycleTimeHistogram::getBucket(10'000'000)]);
+    EXPECT_EQ(2U, delta.counts[CycleTimeHistogram::getBucket(1'000'000)]);
+    EXPECT_LE(delta.getPercentileNs(99.), 1'250'000);
+}
+
+// As dumped for each effect chain, which records its process_l() duration.
+TEST(CycleTimeHistogramTest, SnapshotToString) {
+    CycleTimeHistogram histogram;
+    for (int i = 0; i < 3; ++i) {
+        histogram.record(2'000'000);
+    }
+    EXPECT_EQ("n:3 mean:2.000 p50:2.000 p90:2.000 p99:2.000 max:2.000 ms",
+            histogram.getSnapshot().toString());
+}
+
+TEST(CycleTimeHistogramTest, IntervalMax) {
+    CycleTimeHistogram histogram;
+    histogram.record(10'000'000);
+    const auto first = histogram.takeIntervalSnapshot();
+    EXPECT_EQ(10'000'000, first.maxNs);
+    histogram.record(1'000'000);
+    const auto second = histogram.takeIntervalSnapshot();
+    const auto delta = second - first;
+    EXPECT_EQ(1, delta.count);
+    EXPECT_EQ(1'000'000, delta.maxNs);
+    EXPECT_EQ(1'000'000, delta.getPercentileNs(99.));
+    EXPECT_EQ(0, (histogram.takeIntervalSnapshot() - second).maxNs);
+    EXPECT_EQ(10'000'000, histogram.getSnapshot().maxNs);  // lifetime
+}
+
+TEST(CycleTimeHistogramTest, ConcurrentSnapshot) {
+    CycleTimeHistogram histogram;
+    constexpr int64_t kRecords = 1'000'000;
+    std::atomic_bool done{};
+    std::thread writer([&] {
+        for (int64_t i = 0; i < kRecords; ++i) {
+            histogram.record(i & 0xfffff);
+        }
+        done = true;
+    });
+    int64_t lastCount = 0;
+    while (!done) {
+        const auto snapshot = histogram.getSnapshot();
+        EXPECT_GE(snapshot.count, lastCount);  // single writer, so monotonic.
+        lastCount = snapshot.count;
+    }
+    writer.join();
+    const auto snapshot = histogram.getSnapshot();
+    EXPECT_EQ(kRecords, snapshot.count);
+    int64_t total = 0;
+    for (const auto count : snapshot.counts) total += count;
+    EXPECT_EQ(kRecords, total);
+}
+
+TEST(ThreadCycleTimesTest, ToString) {
+    ThreadCycleTimes cycleTimes;
+    EXPECT_EQ("", cycleTimes.toString());
+    cycleTimes.record(ThreadCycleTimes::PHASE_MIX, 1'000'000);
+    cycleTimes.record(ThreadCycleTimes::PHASE_SLEEP_OVERSHOOT, 200'000);
+    const std::string dump = cycleTimes.toString("  ");
+    EXPECT_EQ(0U, dump.find("  mix: n:1 "));
+    EXPECT_NE(std::string::npos, dump.find("\n  sleepOvershoot: n:1 "));
+    EXPECT_EQ(std::string::npos, dump.find("write"));
+    EXPECT_EQ(1, cycleTimes.getSnapshots()[ThreadCycleTimes::PHASE_MIX].count);
+}
+
+} // namespace
@@ -23,6 +23,7 @@
 #include "iface_statsd.h"
 
 #include <pwd.h> //getpwuid
+#include <string.h>
 
 #include <android-base/stringprintf.h>
 #include <android/content/pm/IPackageManagerNative.h>  // package info
@@ -114,7 +115,39 @@ MediaMetricsService::~MediaMetricsService()
     mItems.clear();
 }
 
-status_t MediaMetricsService::submitInternal(mediametrics::Item *item, bool release)
+status_t MediaMetricsService::submitBuffers(const char *buffer, size_t length)
+{
+    status_t status = NO_ERROR;
+    std::vector<std::shared_ptr<const mediametrics::Item>> batch;
+    while (length > 0) {
+        // Each item byte string starts with its total size.
+        uint32_t size;
+        if (length < sizeof(size)) {
+            status = BAD_VALUE;
+            break;
+        }
+        memcpy(&size, buffer, sizeof(size));
+        if (size < sizeof(size) || size > length) {
+            status = BAD_VALUE;
+            break;
+        }
+        mediametrics::Item *item = new mediametrics::Item();
+        status_t itemStatus = item->readFromByteString(buffer, size);
+        if (itemStatus == NO_ERROR) {
+            itemStatus = submitInternal(item, true /* release */, &batch);
+        } else {
+            delete item;
+        }
+        if (status == NO_ERROR) status = itemStatus;
+        buffer += size;
+        length -= size;
+    }
+    saveItems(batch.data(), batch.size());
+    return status;
+}
+
+status_t MediaMetricsService::submitInternal(mediametrics::Item *item, bool release,
+        std::vector<std::shared_ptr<const mediametrics::Item>> *batch)
 {
     // calling PID is 0 for one-way calls.
     const pid_t pid = IPCThreadState::self()->getCallingPid();
@@ -212,7 +245,11 @@ status_t MediaMetricsService::submitInternal(mediametrics::Item *item, bool rele
     (void)mAudioAnalytics.submit(sitem, isTrusted);
 
     (void)dump2Statsd(sitem, mStatsdLog);  // failure should be logged in function.
-    saveItem(sitem);
+    if (batch != nullptr) {
+        batch->emplace_back(std::move(sitem));
+    } else {
+        saveItem(sitem);
+    }
     return NO_ERROR;
 }
 
@@ -482,15 +519,26 @@ void MediaMetricsService::processExpirations()
 
 void MediaMetricsService::saveItem(const std::shared_ptr<const mediametrics::Item>& item)
 {
+    saveItems(&item, 1);
+}
+
+void MediaMetricsService::saveItems(
+        const std::shared_ptr<const mediametrics::Item> *items, size_t count)
+{
+    if (count == 0) return;
     std::lock_guard _l(mLock);
-    // we assume the items are roughly in time order.
-    mItems.emplace_back(item);
-    if (isPullable(item->getKey())) {
-        registerStatsdCallbacksIfNeeded();
-        mPullableItems[item->getKey()].emplace_back(item);
+    for (size_t i = 0; i < count; ++i) {
+        const auto& item = items[i];
+        // we assume the items are roughly in time order.
+        mItems.emplace_back(item);
+        if (isPullable(item->getKey())) {
+            registerStatsdCallbacksIfNeeded();
+            mPullableItems[item->getKey()].emplace_back(item);
+        }
     }
-    ++mItemsFinalized;
-    if (expirations(item)
+    mItemsFinalized += (int64_t)count;
+    // expire up to the first item we just inserted.
+    if (expirations(items[0])
             && (!mExpireFuture.valid()
                || mExpireFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
         mExpireFuture = std::async(std::launch::async, [this] { processExpirations(); });
@@ -15,6 +15,8 @@
  */
 
 #include <media/MediaMetricsItem.h>
+#include <mediametricsservice/TimeMachine.h>
+#include <mediametricsservice/TransactionLog.h>
 #include <benchmark/benchmark.h>
 
 class MyItem : public android::mediametrics::BaseItem {
@@ -44,4 +46,123 @@ static void BM_SubmitBuffer(benchmark::State& state)
 
 BENCHMARK(BM_SubmitBuffer)->Iterations(4000);   // Adjust magic number until test runs
 
+/*
+ * Measures the items/s delivered to the service by Item::selfrecord(),
+ * one transaction per item, and by Item::selfrecord(items), one transaction
+ * per batch of Arg items.
+ */
+static std::vector<std::unique_ptr<android::mediametrics::Item>> makeItems(size_t count)
+{
+    std::vector<std::unique_ptr<android::mediametrics::Item>> items;
+    for (size_t i = 0; i < count; ++i) {
+        auto& item = items.emplace_back(std::make_unique<android::mediametrics::Item>(
+                "audio.track.benchmark" + std::to_string(i)));
+        (*item).set(AMEDIAMETRICS_PROP_EVENT, "update")
+                .set(AMEDIAMETRICS_PROP_UNDERRUN, (int32_t)i)
+                .set(AMEDIAMETRICS_PROP_VOLUME_LEFT, 1.);
+    }
+    return items;
+}
+
+static void BM_SelfRecord(benchmark::State& state)
+{
+    const auto items = makeItems(state.range(0));
+    for (auto _ : state) {
+        for (const auto& item : items) {
+            if (!item->selfrecord()) {
+                // As BM_SubmitBuffer, the one-way queue may be full.
+                state.SkipWithError("failed");
+                return;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * items.size());
+}
+
+static void BM_SelfRecordBatch(benchmark::State& state)
+{
+    const auto items = makeItems(state.range(0));
+    std::vector<const android::mediametrics::Item *> batch;
+    for (const auto& item : items) batch.push_back(item.get());
+    for (auto _ : state) {
+        if (!android::mediametrics::Item::selfrecord(batch)) {
+            state.SkipWithError("failed");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * items.size());
+}
+
+// Adjust magic numbers until test runs, as for BM_SubmitBuffer.
+BENCHMARK(BM_SelfRecord)->Arg(16)->Iterations(250);
+BENCHMARK(BM_SelfRecordBatch)->Arg(16)->Iterations(250);
+
+/*
+ * Measures sustained ingest into the TimeMachine, as done by the AudioAnalytics
+ * for each item received, from 1 to 8 concurrent threads.
+ *
+ * Each thread puts items of its own 64 keys, which are a few audio track
+ * properties changing at each put, so the property histories are full and
+ * the puts also exercise the discarding of the oldest elements.
+ * Every 1024 puts, a new key is created, so the key count eventually exceeds
+ * the high water mark and garbage collection is included.
+ */
+static void BM_TimeMachinePut(benchmark::State& state)
+{
+    static android::mediametrics::TimeMachine timeMachine;
+    constexpr size_t kKeys = 64;
+    std::vector<std::shared_ptr<android::mediametrics::Item>> items;
+    for (size_t i = 0; i < kKeys; ++i) {
+        items.emplace_back(std::make_shared<android::mediametrics::Item>(
+                "audio.track." + std::to_string(state.thread_index()) + "." + std::to_string(i)));
+    }
+    int64_t time = systemTime(SYSTEM_TIME_REALTIME);
+    size_t puts = 0;
+    size_t newKeys = 0;
+    for (auto _ : state) {
+        auto& item = items[puts % kKeys];
+        if (++puts % 1024 == 0) {
+            item = std::make_shared<android::mediametrics::Item>("audio.track."
+                    + std::to_string(state.thread_index()) + ".new" + std::to_string(newKeys++));
+        }
+        (*item).set(AMEDIAMETRICS_PROP_EVENT, "update")
+                .set(AMEDIAMETRICS_PROP_UNDERRUN, (int32_t)puts)
+                .set(AMEDIAMETRICS_PROP_FRAMECOUNT, (int32_t)(puts * 960))
+                .set(AMEDIAMETRICS_PROP_VOLUME_LEFT, (double)(puts & 0xff) / 256.)
+                .setTimestamp(++time);
+        benchmark::DoNotOptimize(timeMachine.put(item, true /* isTrusted */));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_TimeMachinePut)->ThreadRange(1, 8)->UseRealTime();
+
+/*
+ * Measures sustained ingest into the TransactionLog, from 1 to 8 concurrent threads,
+ * each thread putting items of its own 16 keys.  The log is kept full,
+ * so garbage collection is included.
+ */
+static void BM_TransactionLogPut(benchmark::State& state)
+{
+    static android::mediametrics::TransactionLog transactionLog;
+    constexpr size_t kKeys = 16;
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < kKeys; ++i) {
+        keys.emplace_back(
+                "audio.track." + std::to_string(state.thread_index()) + "." + std::to_string(i));
+    }
+    int64_t time = systemTime(SYSTEM_TIME_REALTIME);
+    size_t puts = 0;
+    for (auto _ : state) {
+        auto item = std::make_shared<android::mediametrics::Item>(keys[puts++ % kKeys]);
+        (*item).set(AMEDIAMETRICS_PROP_EVENT, "update")
+                .set(AMEDIAMETRICS_PROP_UNDERRUN, (int32_t)puts)
+                .setTimestamp(++time);
+        benchmark::DoNotOptimize(transactionLog.put(item));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_TransactionLogPut)->ThreadRange(1, 8)->UseRealTime();
+
 BENCHMARK_MAIN();
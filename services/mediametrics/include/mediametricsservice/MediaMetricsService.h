@@ -45,6 +45,11 @@ public:
         return binder::Status::fromStatusT(status);
     }
 
+    binder::Status submitBuffers(const std::vector<uint8_t>& buffers) override {
+        status_t status = submitBuffers((char *)buffers.data(), buffers.size());
+        return binder::Status::fromStatusT(status);
+    }
+
     /**
      * Submits the indicated record to the mediaanalytics service.
      *
@@ -62,6 +67,16 @@ public:
                 ?: submitInternal(item, true /* release */);
     }
 
+    /**
+     * Submits the items of a batch, saving them to the item queue together.
+     *
+     * \param buffer the concatenated item byte strings, each starting with its total size.
+     * \param length the length of the buffer.
+     * \return BAD_VALUE if the buffer is malformed, otherwise
+     *         the status of the first item failing, if any.
+     */
+    status_t submitBuffers(const char *buffer, size_t length);
+
     status_t dump(int fd, const Vector<String16>& args) override;
 
     static constexpr const char * const kServiceName = "media.metrics";
@@ -88,7 +103,10 @@ protected:
 
     // Internal call where release is true if ownership of item is transferred
     // to the service (that is, the service will eventually delete the item).
-    status_t submitInternal(mediametrics::Item *item, bool release);
+    // If batch is not nullptr, the item is appended to batch for saveItems(),
+    // instead of being saved.
+    status_t submitInternal(mediametrics::Item *item, bool release,
+            std::vector<std::shared_ptr<const mediametrics::Item>> *batch = nullptr);
 
 private:
     void processExpirations();
@@ -96,6 +114,7 @@ private:
     static bool isContentValid(const mediametrics::Item *item, bool isTrusted);
     bool isRateLimited(mediametrics::Item *) const;
     void saveItem(const std::shared_ptr<const mediametrics::Item>& item);
+    void saveItems(const std::shared_ptr<const mediametrics::Item> *items, size_t count);
 
     bool expirations(const std::shared_ptr<const mediametrics::Item>& item) REQUIRES(mLock);
 
@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <any>
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <sstream>
@@ -61,12 +63,87 @@ std::ostream & operator<< (std::ostream& s,
  * Any URL that ends with '#' (AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED)
  * will have a time sequence that keeps duplicates.
  *
- * The TimeMachine is NOT thread safe.
+ * The TimeMachine is internally locked, see the Locking Strategy below.
  */
 class TimeMachine final { // made final as we have copy constructor instead of dup() override.
 public:
     using Elem = Item::Prop::Elem;  // use the Item property element.
-    using PropertyHistory = std::multimap<int64_t /* time */, Elem>;
+
+    /**
+     * The time sequence of a property, ordered by time, as a ring buffer of at most
+     * kTimeSequenceMaxElements elements, so that a put does not allocate once
+     * the sequence is full.
+     *
+     * Elements are indexed from the oldest (0) to the newest (size() - 1).
+     */
+    class PropertyHistory {
+    public:
+        using value_type = std::pair<int64_t /* time */, Elem>;
+
+        bool empty() const { return mElements.empty(); }
+        size_t size() const { return mElements.size(); }
+
+        const value_type& operator[](size_t index) const {
+            return mElements[(mOldest + index) % mElements.size()];
+        }
+
+        const value_type& back() const { return (*this)[size() - 1]; }
+
+        // Returns the index of the first element after time, or size() if none.
+        size_t upperBound(int64_t time) const {
+            return partitionPoint([time](int64_t t) { return t <= time; });
+        }
+
+        // Returns the index of the first element at or after time, or size() if none.
+        size_t lowerBound(int64_t time) const {
+            return partitionPoint([time](int64_t t) { return t < time; });
+        }
+
+        /**
+         * Inserts an element after the elements at or before time,
+         * discarding the oldest element if the sequence is full.
+         *
+         * \return true if an element was discarded.
+         */
+        bool emplace(int64_t time, Elem&& elem) {
+            if (mElements.size() < kTimeSequenceMaxElements) {
+                // Not yet wrapped, mOldest is 0.
+                mElements.emplace(mElements.begin() + upperBound(time), time, std::move(elem));
+                return false;
+            }
+            if (time >= back().first) {  // the usual case, replace the oldest element.
+                mElements[mOldest] = {time, std::move(elem)};
+                mOldest = (mOldest + 1) % mElements.size();
+                return true;
+            }
+            const size_t index = upperBound(time);
+            if (index == 0) return true; // older than all elements, discarded.
+            std::rotate(mElements.begin(), mElements.begin() + mOldest, mElements.end());
+            mOldest = 0;
+            mElements.erase(mElements.begin());
+            mElements.emplace(mElements.begin() + index - 1, time, std::move(elem));
+            return true;
+        }
+
+    private:
+        template <typename P>
+        size_t partitionPoint(P pred) const {
+            size_t low = 0;
+            size_t high = size();
+            while (low < high) {
+                const size_t mid = low + (high - low) / 2;
+                if (pred((*this)[mid].first)) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            return low;
+        }
+
+        std::vector<value_type> mElements;
+        size_t mOldest = 0;  // index in mElements of the oldest element.
+    };
 
 private:
 
@@ -111,11 +188,9 @@ private:
             const auto tsptr = mPropertyMap.find(property);
             if (tsptr == mPropertyMap.end()) return BAD_VALUE;
             const auto& timeSequence = tsptr->second;
-            auto eptr = timeSequence.upper_bound(time);
-            if (eptr == timeSequence.begin()) return BAD_VALUE;
-            --eptr;
-            if (eptr == timeSequence.end()) return BAD_VALUE;
-            const T* vptr = std::get_if<T>(&eptr->second);
+            const size_t index = timeSequence.upperBound(time);
+            if (index == 0) return BAD_VALUE;
+            const T* vptr = std::get_if<T>(&timeSequence[index - 1].second);
             if (vptr == nullptr) return BAD_VALUE;
             *value = *vptr;
             return NO_ERROR;
@@ -150,13 +225,10 @@ private:
             Elem el{std::forward<T>(e)};
             if (timeSequence.empty()           // no elements
                     || property.back() == AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED
-                    || timeSequence.rbegin()->second != el) { // value changed
-                timeSequence.emplace_hint(timeSequence.end(), time, std::move(el));
-
-                if (timeSequence.size() > kTimeSequenceMaxElements) {
+                    || timeSequence.back().second != el) { // value changed
+                if (timeSequence.emplace(time, std::move(el))) {
                     ALOGV("%s: restricting maximum elements (discarding oldest) for %s",
                             __func__, property.c_str());
-                    timeSequence.erase(timeSequence.begin());
                 }
             }
         }
@@ -189,9 +261,9 @@ private:
                 const std::string &key,
                 const std::pair<std::string /* prop */, PropertyHistory>& tsPair,
                 int64_t time) {
-            const auto timeSequence = tsPair.second;
-            auto eptr = timeSequence.lower_bound(time);
-            if (eptr == timeSequence.end()) {
+            const auto& timeSequence = tsPair.second;
+            size_t index = timeSequence.lowerBound(time);
+            if (index == timeSequence.size()) {
                 return {}; // don't dump anything. tsPair.first + "={};\n";
             }
             std::stringstream ss;
@@ -199,14 +271,15 @@ private:
 
             time_string_t last_timestring{}; // last timestring used.
             while (true) {
-                const time_string_t timestring = mediametrics::timeStringFromNs(eptr->first);
+                const auto& [elemTime, elem] = timeSequence[index];
+                const time_string_t timestring = mediametrics::timeStringFromNs(elemTime);
                 // find common prefix offset.
                 const size_t offset = commonTimePrefixPosition(timestring.time,
                         last_timestring.time);
                 last_timestring = timestring;
                 ss << "(" << (offset == 0 ? "" : "~") << &timestring.time[offset]
-                    << ") " << eptr->second;
-                if (++eptr == timeSequence.end()) {
+                    << ") " << elem;
+                if (++index == timeSequence.size()) {
                     break;
                 }
                 ss << ", ";
@@ -255,21 +328,27 @@ public:
         *this = other;
     }
     TimeMachine& operator=(const TimeMachine& other) {
-        std::lock_guard lock(mLock);
-        mHistory.clear();
+        for (size_t i = 0; i < HISTORY_STRIPES; ++i) {
+            HistoryStripe& stripe = mHistoryStripes[i];
+            const HistoryStripe& otherStripe = other.mHistoryStripes[i];
+            std::lock_guard lock(stripe.mLock);
+            mKeyCount -= stripe.mHistory.size();
+            stripe.mHistory.clear();
 
-        {
-            std::lock_guard lock2(other.mLock);
-            mHistory = other.mHistory;
-            mGarbageCollectionCount = other.mGarbageCollectionCount.load();
-        }
+            {
+                std::lock_guard lock2(otherStripe.mLock);
+                stripe.mHistory = otherStripe.mHistory;
+            }
+            mKeyCount += stripe.mHistory.size();
 
-        // Now that we safely have our own shared pointers, let's dup them
-        // to ensure they are decoupled.  We do this by acquiring the other lock.
-        for (const auto &[lkey, lhist] : mHistory) {
-            std::lock_guard lock2(other.getLockForKey(lkey));
-            mHistory[lkey] = std::make_shared<KeyHistory>(*lhist);
+            // Now that we safely have our own shared pointers, let's dup them
+            // to ensure they are decoupled.  We do this by acquiring the other lock.
+            for (const auto &[lkey, lhist] : stripe.mHistory) {
+                std::lock_guard lock2(other.getLockForKey(lkey));
+                stripe.mHistory[lkey] = std::make_shared<KeyHistory>(*lhist);
+            }
         }
+        mGarbageCollectionCount = other.mGarbageCollectionCount.load();
         return *this;
     }
 
@@ -283,28 +362,26 @@ public:
         ALOGV("%s(%zu, %zu): key: %s  isTrusted:%d  size:%zu",
                 __func__, mKeyLowWaterMark, mKeyHighWaterMark,
                 key.c_str(), (int)isTrusted, item->count());
-        std::shared_ptr<KeyHistory> keyHistory;
-        {
+        std::shared_ptr<KeyHistory> keyHistory = getKeyHistory(key);
+        if (keyHistory == nullptr) {
+            if (!isTrusted) return PERMISSION_DENIED;
+
             std::vector<std::any> garbage;
-            std::lock_guard lock(mLock);
-
-            auto it = mHistory.find(key);
-            if (it == mHistory.end()) {
-                if (!isTrusted) return PERMISSION_DENIED;
-
-                (void)gc(garbage);
-
-                // We set the allowUid for client access on key creation.
-                int32_t allowUid = -1;
-                (void)item->get(AMEDIAMETRICS_PROP_ALLOWUID, &allowUid);
-                // no keylock needed here as we are sole owner
-                // until placed on mHistory.
-                keyHistory = std::make_shared<KeyHistory>(
-                    key, allowUid, time);
-                mHistory[key] = keyHistory;
-            } else {
-                keyHistory = it->second;
-            }
+            (void)gc(garbage);
+
+            // We set the allowUid for client access on key creation.
+            int32_t allowUid = -1;
+            (void)item->get(AMEDIAMETRICS_PROP_ALLOWUID, &allowUid);
+            // no keylock needed here as we are sole owner
+            // until placed on the history.
+            auto newKeyHistory = std::make_shared<KeyHistory>(key, allowUid, time);
+
+            HistoryStripe& stripe = getStripeForKey(key);
+            std::lock_guard lock(stripe.mLock);
+            // Another thread may have created the key meanwhile.
+            auto [it, inserted] = stripe.mHistory.try_emplace(key, std::move(newKeyHistory));
+            if (inserted) ++mKeyCount;
+            keyHistory = it->second;
         }
 
         // deferred contains remote properties (for other keys) to do later.
@@ -340,13 +417,8 @@ public:
             std::string remoteKey = name.substr(1, end - 1);
             std::string remoteName = name.substr(end + 1);
             if (remoteKey.size() == 0 || remoteName.size() == 0) continue;
-            std::shared_ptr<KeyHistory> remoteKeyHistory;
-            {
-                std::lock_guard lock(mLock);
-                auto it = mHistory.find(remoteKey);
-                if (it == mHistory.end()) continue;
-                remoteKeyHistory = it->second;
-            }
+            std::shared_ptr<KeyHistory> remoteKeyHistory = getKeyHistory(remoteKey);
+            if (remoteKeyHistory == nullptr) continue;
             std::lock_guard lock(getLockForKey(remoteKey));
             remoteKeyHistory->putProp(remoteName, prop, time);
         }
@@ -356,13 +428,8 @@ public:
     template <typename T>
     status_t get(const std::string &key, const std::string &property,
             T* value, int32_t uidCheck = -1, int64_t time = 0) const {
-        std::shared_ptr<KeyHistory> keyHistory;
-        {
-            std::lock_guard lock(mLock);
-            const auto it = mHistory.find(key);
-            if (it == mHistory.end()) return BAD_VALUE;
-            keyHistory = it->second;
-        }
+        std::shared_ptr<KeyHistory> keyHistory = getKeyHistory(key);
+        if (keyHistory == nullptr) return BAD_VALUE;
         std::lock_guard lock(getLockForKey(key));
         return keyHistory->checkPermission(uidCheck)
                 ?: keyHistory->getValue(property, value, time);
@@ -417,16 +484,18 @@ public:
      *  Returns number of keys in the Time Machine.
      */
     size_t size() const {
-        std::lock_guard lock(mLock);
-        return mHistory.size();
+        return mKeyCount;
     }
 
     /**
      * Clears all properties from the Time Machine.
      */
     void clear() {
-        std::lock_guard lock(mLock);
-        mHistory.clear();
+        for (HistoryStripe& stripe : mHistoryStripes) {
+            std::lock_guard lock(stripe.mLock);
+            mKeyCount -= stripe.mHistory.size();
+            stripe.mHistory.clear();
+        }
         mGarbageCollectionCount = 0;
     }
 
@@ -444,17 +513,27 @@ public:
      */
     std::pair<std::string, int32_t> dump(
             int32_t lines = INT32_MAX, int64_t sinceNs = 0, const char *prefix = nullptr) const {
-        std::lock_guard lock(mLock);
+        // Keys are dumped in order, so gather them from all stripes first.
+        std::vector<std::pair<std::string, std::shared_ptr<KeyHistory>>> keyHistories;
+        for (const HistoryStripe& stripe : mHistoryStripes) {
+            std::lock_guard lock(stripe.mLock);
+            for (auto it = prefix != nullptr
+                        ? stripe.mHistory.lower_bound(prefix) : stripe.mHistory.begin();
+                    it != stripe.mHistory.end();
+                    ++it) {
+                if (prefix != nullptr && !startsWith(it->first, prefix)) break;
+                keyHistories.emplace_back(*it);
+            }
+        }
+        std::sort(keyHistories.begin(), keyHistories.end(),
+                [](const auto& a, const auto& b) { return a.first < b.first; });
+
         std::stringstream ss;
         int32_t ll = lines;
-
-        for (auto it = prefix != nullptr ? mHistory.lower_bound(prefix) : mHistory.begin();
-                it != mHistory.end();
-                ++it) {
+        for (const auto& [key, keyHistory] : keyHistories) {
             if (ll <= 0) break;
-            if (prefix != nullptr && !startsWith(it->first, prefix)) break;
-            std::lock_guard lock2(getLockForKey(it->first));
-            auto [s, l] = it->second->dump(ll, sinceNs);
+            std::lock_guard lock(getLockForKey(key));
+            auto [s, l] = keyHistory->dump(ll, sinceNs);
             ss << s;
             ll -= l;
         }
@@ -467,30 +546,58 @@ public:
 
 private:
 
+    // KEY_LOCKS is the number of mutexes for keys.
+    // It need not be a power of 2, but faster that way.
+    static inline constexpr size_t KEY_LOCKS = 256;
+    // HISTORY_STRIPES is the number of stripes of the key History.
+    static inline constexpr size_t HISTORY_STRIPES = 16;
+
+    struct HistoryStripe {
+        mutable std::mutex mLock;  // Lock for mHistory
+        History mHistory GUARDED_BY(mLock);
+    };
+
+    static size_t hashKey(const std::string &key) {
+        return std::hash<std::string>{}(key);
+    }
+
+    HistoryStripe& getStripeForKey(const std::string &key) {
+        return mHistoryStripes[hashKey(key) % HISTORY_STRIPES];
+    }
+
+    const HistoryStripe& getStripeForKey(const std::string &key) const {
+        return mHistoryStripes[hashKey(key) % HISTORY_STRIPES];
+    }
+
     // Obtains the lock for a KeyHistory.
     std::mutex &getLockForKey(const std::string &key) const
             RETURN_CAPABILITY(mPseudoKeyHistoryLock) {
-        return mKeyLocks[std::hash<std::string>{}(key) % std::size(mKeyLocks)];
+        return mKeyLocks[hashKey(key) % std::size(mKeyLocks)];
+    }
+
+    // Finds a KeyHistory.  Returns nullptr if not found.
+    std::shared_ptr<KeyHistory> getKeyHistory(const std::string& key) const {
+        const HistoryStripe& stripe = getStripeForKey(key);
+        std::lock_guard lock(stripe.mLock);
+        const auto it = stripe.mHistory.find(key);
+        return it == stripe.mHistory.end() ? nullptr : it->second;
     }
 
     // Finds a KeyHistory from a URL.  Returns nullptr if not found.
+    // The key is the longest prefix of the URL, before a '.', which is a key.
     std::shared_ptr<KeyHistory> getKeyHistoryFromUrl(
             const std::string& url, std::string* key, std::string *prop) const {
-        std::lock_guard lock(mLock);
-
-        auto it = mHistory.upper_bound(url);
-        if (it == mHistory.begin()) {
-           return nullptr;
-        }
-        --it;  // go to the actual key, if it exists.
-
-        const std::string& itKey = it->first;
-        if (strncmp(itKey.c_str(), url.c_str(), itKey.size())) {
-            return nullptr;
+        for (size_t end = url.rfind('.'); end != std::string::npos && end > 0;
+                end = url.rfind('.', end - 1)) {
+            std::string itKey = url.substr(0, end);
+            std::shared_ptr<KeyHistory> keyHistory = getKeyHistory(itKey);
+            if (keyHistory != nullptr) {
+                if (key) *key = std::move(itKey);
+                if (prop) *prop = url.substr(end + 1);
+                return keyHistory;
+            }
         }
-        if (key) *key = itKey;
-        if (prop) *prop = url.substr(itKey.size() + 1);
-        return it->second;
+        return nullptr;
     }
 
     /**
@@ -504,38 +611,51 @@ private:
      *
      * \return true if garbage collection was done.
      */
-    bool gc(std::vector<std::any>& garbage) REQUIRES(mLock) {
+    bool gc(std::vector<std::any>& garbage) EXCLUDES(mGcLock) {
         // TODO: something better than this for garbage collection.
-        if (mHistory.size() < mKeyHighWaterMark) return false;
+        if (mKeyCount < mKeyHighWaterMark) return false;
+
+        std::lock_guard gcLock(mGcLock);
+        // Another thread may have collected meanwhile.
+        if (mKeyCount < mKeyHighWaterMark) return false;
 
         // erase everything explicitly expired.
-        std::multimap<int64_t, std::string> accessList;
+        std::vector<std::pair<int64_t /* time */, std::string /* key */>> accessList;
         // use a stale vector with precise type to avoid type erasure overhead in garbage
         std::vector<std::shared_ptr<KeyHistory>> stale;
 
-        for (auto it = mHistory.begin(); it != mHistory.end();) {
-            const std::string& key = it->first;
-            std::shared_ptr<KeyHistory> &keyHist = it->second;
-
-            std::lock_guard lock(getLockForKey(it->first));
-            int64_t expireTime = keyHist->getValue("_expire", -1 /* default */);
-            if (expireTime != -1) {
-                stale.emplace_back(std::move(it->second));
-                it = mHistory.erase(it);
-            } else {
-                accessList.emplace(keyHist->getLastModificationTime(), key);
-                ++it;
+        for (HistoryStripe& stripe : mHistoryStripes) {
+            std::lock_guard stripeLock(stripe.mLock);
+            for (auto it = stripe.mHistory.begin(); it != stripe.mHistory.end();) {
+                const std::string& key = it->first;
+                std::shared_ptr<KeyHistory> &keyHist = it->second;
+
+                std::lock_guard lock(getLockForKey(it->first));
+                int64_t expireTime = keyHist->getValue("_expire", -1 /* default */);
+                if (expireTime != -1) {
+                    stale.emplace_back(std::move(it->second));
+                    it = stripe.mHistory.erase(it);
+                    --mKeyCount;
+                } else {
+                    accessList.emplace_back(keyHist->getLastModificationTime(), key);
+                    ++it;
+                }
             }
         }
 
-        if (mHistory.size() > mKeyLowWaterMark) {
-           const size_t toDelete = mHistory.size() - mKeyLowWaterMark;
+        if (mKeyCount > mKeyLowWaterMark) {
+           // oldest first, keys of the same time in order.
+           std::sort(accessList.begin(), accessList.end());
+           const size_t toDelete = mKeyCount - mKeyLowWaterMark;
            auto it = accessList.begin();
-           for (size_t i = 0; i < toDelete; ++i) {
-               auto it2 = mHistory.find(it->second);
+           for (size_t i = 0; i < toDelete && it != accessList.end(); ++i, ++it) {
+               HistoryStripe& stripe = getStripeForKey(it->second);
+               std::lock_guard stripeLock(stripe.mLock);
+               auto it2 = stripe.mHistory.find(it->second);
+               if (it2 == stripe.mHistory.end()) continue;  // cleared meanwhile.
                stale.emplace_back(std::move(it2->second));
-               mHistory.erase(it2);
-               ++it;
+               stripe.mHistory.erase(it2);
+               --mKeyCount;
            }
         }
         garbage.emplace_back(std::move(accessList));
@@ -543,7 +663,7 @@ private:
 
         ALOGD("%s(%zu, %zu): key size:%zu",
                 __func__, mKeyLowWaterMark, mKeyHighWaterMark,
-                mHistory.size());
+                mKeyCount.load());
 
         ++mGarbageCollectionCount;
         return true;
@@ -557,9 +677,12 @@ private:
     /**
      * Locking Strategy
      *
-     * Each key in the History has a KeyHistory. To get a shared pointer to
-     * the KeyHistory requires a lookup of mHistory under mLock.  Once the shared
-     * pointer to KeyHistory is obtained, the mLock for mHistory can be released.
+     * Each key in the History has a KeyHistory. The History is striped by the hash
+     * of the key string, and each stripe has its own mLock. To get a shared pointer to
+     * the KeyHistory requires a lookup of the stripe of the key under its mLock.
+     * Once the shared pointer to KeyHistory is obtained, the stripe mLock can be released.
+     * So puts and gets of different keys rarely contend, and no lock is held across
+     * all keys except briefly by garbage collection, dump, and copy.
      *
      * Once the shared pointer to the key's KeyHistory is obtained, the KeyHistory
      * can be locked for read and modification through the method getLockForKey().
@@ -574,12 +697,10 @@ private:
      * in parallel.
      */
 
-    mutable std::mutex mLock;           // Lock for mHistory
-    History mHistory GUARDED_BY(mLock);
+    HistoryStripe mHistoryStripes[HISTORY_STRIPES];
+    std::atomic<size_t> mKeyCount{};  // Number of keys in all stripes.
+    std::mutex mGcLock;  // Serializes garbage collection.
 
-    // KEY_LOCKS is the number of mutexes for keys.
-    // It need not be a power of 2, but faster that way.
-    static inline constexpr size_t KEY_LOCKS = 256;
     mutable std::mutex mKeyLocks[KEY_LOCKS];  // Hash-striped lock for KeyHistory based on key.
 
     // Used for thread-safety analysis, we create a fake mutex object to represent
@@ -16,10 +16,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <any>
+#include <atomic>
+#include <functional>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <android-base/thread_annotations.h>
 #include <media/MediaMetricsItem.h>
@@ -35,7 +40,9 @@ namespace android::mediametrics {
  *
  * These Views have a cost in shared pointer storage, so they aren't quite free.
  *
- * The TransactionLog is NOT thread safe.
+ * The TransactionLog is internally locked. It is sharded by the hash of the item key,
+ * so that puts of different keys rarely contend, and the views over all keys
+ * are merged from the shards on read.
  */
 class TransactionLog final { // made final as we have copy constructor instead of dup() override.
 public:
@@ -59,8 +66,9 @@ public:
                   __func__, highWaterMark, lowWaterMark);
     }
 
-    // The TransactionLog copy constructor/assignment is effectively an
-    // instantaneous, isochronous snapshot of the other TransactionLog.
+    // The TransactionLog copy constructor/assignment copies the other
+    // TransactionLog one shard at a time, so the snapshot is isochronous
+    // only if there are no concurrent puts to the other TransactionLog.
     //
     // The contents of the Transaction Log are shared pointers to immutable instances -
     // std::shared_ptr<const mediametrics::Item>, so we use a shallow copy,
@@ -72,13 +80,19 @@ public:
     }
 
     TransactionLog& operator=(const TransactionLog &other) {
-        std::lock_guard lock(mLock);
-        mLog.clear();
-        mItemMap.clear();
-
-        std::lock_guard lock2(other.mLock);
-        mLog = other.mLog;
-        mItemMap = other.mItemMap;
+        for (size_t i = 0; i < kLogShards; ++i) {
+            Shard& shard = mShards[i];
+            const Shard& otherShard = other.mShards[i];
+            std::lock_guard lock(shard.mLock);
+            mSize -= shard.mLog.size();
+            shard.mLog.clear();
+            shard.mItemMap.clear();
+
+            std::lock_guard lock2(otherShard.mLock);
+            shard.mLog = otherShard.mLog;
+            shard.mItemMap = otherShard.mItemMap;
+            mSize += shard.mLog.size();
+        }
         mGarbageCollectionCount = other.mGarbageCollectionCount.load();
 
         return *this;
@@ -92,11 +106,13 @@ public:
         const int64_t time = item->getTimestamp();
 
         std::vector<std::any> garbage;  // objects destroyed after lock.
-        std::lock_guard lock(mLock);
-
         (void)gc(garbage);
-        mLog.emplace_hint(mLog.end(), time, item);
-        mItemMap[key].emplace_hint(mItemMap[key].end(), time, item);
+
+        Shard& shard = getShardForKey(key);
+        std::lock_guard lock(shard.mLock);
+        insert(shard.mLog, time, item);
+        insert(shard.mItemMap[key], time, item);
+        ++mSize;
         return NO_ERROR;  // no errors for now.
     }
 
@@ -105,8 +121,16 @@ public:
      */
     std::vector<std::shared_ptr<const mediametrics::Item>> get(
             int64_t startTime = 0, int64_t endTime = INT64_MAX) const {
-        std::lock_guard lock(mLock);
-        return getItemsInRange(mLog, startTime, endTime);
+        std::vector<std::shared_ptr<const mediametrics::Item>> ret;
+        for (const Shard& shard : mShards) {
+            const size_t merged = ret.size();
+            {
+                std::lock_guard lock(shard.mLock);
+                appendItemsInRange(shard.mLog, startTime, endTime, ret);
+            }
+            mergeByTime(ret, merged);
+        }
+        return ret;
     }
 
     /**
@@ -115,10 +139,13 @@ public:
     std::vector<std::shared_ptr<const mediametrics::Item>> get(
             const std::string& key,
             int64_t startTime = 0, int64_t endTime = INT64_MAX) const {
-        std::lock_guard lock(mLock);
-        auto mapIt = mItemMap.find(key);
-        if (mapIt == mItemMap.end()) return {};
-        return getItemsInRange(mapIt->second, startTime, endTime);
+        const Shard& shard = getShardForKey(key);
+        std::vector<std::shared_ptr<const mediametrics::Item>> ret;
+        std::lock_guard lock(shard.mLock);
+        auto mapIt = shard.mItemMap.find(key);
+        if (mapIt == shard.mItemMap.end()) return {};
+        appendItemsInRange(mapIt->second, startTime, endTime, ret);
+        return ret;
     }
 
     /**
@@ -134,16 +161,37 @@ public:
      */
     std::pair<std::string, int32_t> dump(
             int32_t lines, int64_t sinceNs, const char *prefix = nullptr) const {
+        // Gather the matching items of all shards, the consolidated items are
+        // merged in time order and the categorized items are sorted by key.
+        std::vector<std::shared_ptr<const mediametrics::Item>> log;
+        std::vector<std::pair<std::string, std::vector<std::shared_ptr<const mediametrics::Item>>>>
+                itemMap;
+        for (const Shard& shard : mShards) {
+            const size_t merged = log.size();
+            std::lock_guard lock(shard.mLock);
+            appendItemsInRange(shard.mLog, sinceNs, INT64_MAX, log, prefix);
+            mergeByTime(log, merged);
+            for (auto it = prefix != nullptr
+                        ? shard.mItemMap.lower_bound(prefix) : shard.mItemMap.begin();
+                    it != shard.mItemMap.end();
+                    ++it) {
+                if (prefix != nullptr && !startsWith(it->first, prefix)) break;
+                appendItemsInRange(it->second, sinceNs, INT64_MAX,
+                        itemMap.emplace_back(it->first, decltype(log){}).second);
+            }
+        }
+        std::sort(itemMap.begin(), itemMap.end(),
+                [](const auto& a, const auto& b) { return a.first < b.first; });
+
         std::stringstream ss;
         int32_t ll = lines;
-        std::lock_guard lock(mLock);
 
         // All audio items in time order.
         if (ll > 0) {
             ss << "Consolidated:\n";
             --ll;
         }
-        auto [s, l] = dumpMapTimeItem(mLog, ll, sinceNs, prefix);
+        auto [s, l] = dumpItems(log, ll);
         ss << s;
         ll -= l;
 
@@ -153,14 +201,11 @@ public:
             --ll;
         }
 
-        for (auto it = prefix != nullptr ? mItemMap.lower_bound(prefix) : mItemMap.begin();
-                it != mItemMap.end();
-                ++it) {
+        for (const auto& [key, items] : itemMap) {
             if (ll <= 0) break;
-            if (prefix != nullptr && !startsWith(it->first, prefix)) break;
-            std::tie(s, l) = dumpMapTimeItem(it->second, ll - 1, sinceNs, prefix);
+            std::tie(s, l) = dumpItems(items, ll - 1);
             if (l == 0) continue; // don't show empty groups (due to sinceNs).
-            ss << " " << it->first << "\n" << s;
+            ss << " " << key << "\n" << s;
             ll -= l + 1;
         }
         return { ss.str(), lines - ll };
@@ -170,8 +215,7 @@ public:
      *  Returns number of Items in the TransactionLog.
      */
     size_t size() const {
-        std::lock_guard lock(mLock);
-        return mLog.size();
+        return mSize;
     }
 
     /**
@@ -179,9 +223,12 @@ public:
      */
     // TODO: Garbage Collector, sweep and expire old values
     void clear() {
-        std::lock_guard lock(mLock);
-        mLog.clear();
-        mItemMap.clear();
+        for (Shard& shard : mShards) {
+            std::lock_guard lock(shard.mLock);
+            mSize -= shard.mLog.size();
+            shard.mLog.clear();
+            shard.mItemMap.clear();
+        }
         mGarbageCollectionCount = 0;
     }
 
@@ -190,103 +237,170 @@ public:
     }
 
 private:
-    using MapTimeItem =
-            std::multimap<int64_t /* time */, std::shared_ptr<const mediametrics::Item>>;
+    // Items in time order, items of the same time in put order.
+    // As items are put mostly in time order, a vector is used, so a put usually appends
+    // without allocating, and garbage collection erases from the front.
+    using TimeItems =
+            std::vector<std::pair<int64_t /* time */, std::shared_ptr<const mediametrics::Item>>>;
 
-    static std::pair<std::string, int32_t> dumpMapTimeItem(
-            const MapTimeItem& mapTimeItem,
-            int32_t lines, int64_t sinceNs = 0, const char *prefix = nullptr) {
+    // kLogShards is the number of shards of the TransactionLog.
+    static inline constexpr size_t kLogShards = 16;
+
+    struct Shard {
+        mutable std::mutex mLock;
+
+        TimeItems mLog GUARDED_BY(mLock);
+        std::map<std::string /* item_key */, TimeItems> mItemMap GUARDED_BY(mLock);
+    };
+
+    Shard& getShardForKey(const std::string& key) {
+        return mShards[std::hash<std::string>{}(key) % kLogShards];
+    }
+
+    const Shard& getShardForKey(const std::string& key) const {
+        return mShards[std::hash<std::string>{}(key) % kLogShards];
+    }
+
+    static TimeItems::const_iterator lowerBound(const TimeItems& timeItems, int64_t time) {
+        return std::lower_bound(timeItems.begin(), timeItems.end(), time,
+                [](const auto& timeItem, int64_t t) { return timeItem.first < t; });
+    }
+
+    static TimeItems::const_iterator upperBound(const TimeItems& timeItems, int64_t time) {
+        return std::upper_bound(timeItems.begin(), timeItems.end(), time,
+                [](int64_t t, const auto& timeItem) { return t < timeItem.first; });
+    }
+
+    static void insert(TimeItems& timeItems, int64_t time,
+            const std::shared_ptr<const mediametrics::Item>& item) {
+        if (timeItems.empty() || timeItems.back().first <= time) {
+            timeItems.emplace_back(time, item);  // the usual case.
+        } else {
+            timeItems.emplace(upperBound(timeItems, time), time, item);
+        }
+    }
+
+    static std::pair<std::string, int32_t> dumpItems(
+            const std::vector<std::shared_ptr<const mediametrics::Item>>& items,
+            int32_t lines) {
         std::stringstream ss;
         int32_t ll = lines;
-        // Note: for our data, mapTimeItem.lower_bound(0) == mapTimeItem.begin().
-        for (auto it = mapTimeItem.lower_bound(sinceNs);
-                it != mapTimeItem.end(); ++it) {
+        for (const auto& item : items) {
             if (ll <= 0) break;
-            if (prefix != nullptr && !startsWith(it->second->getKey(), prefix)) {
-                continue;
-            }
-            ss << "  " << it->second->toString() << "\n";
+            ss << "  " << item->toString() << "\n";
             --ll;
         }
         return { ss.str(), lines - ll };
     }
 
+    // Merges items[merged, end) into the time ordered items[0, merged).
+    static void mergeByTime(
+            std::vector<std::shared_ptr<const mediametrics::Item>>& items, size_t merged) {
+        std::inplace_merge(items.begin(), items.begin() + merged, items.end(),
+                [](const auto& a, const auto& b) {
+                    return a->getTimestamp() < b->getTimestamp();
+                });
+    }
+
     /**
-     * Garbage collects if the TimeMachine size exceeds the high water mark.
+     * Garbage collects if the TransactionLog size exceeds the high water mark.
+     *
+     * The oldest items of all shards are collected down to the low water mark.
+     * Items of the same time are all collected or all kept.
      *
      * \param garbage a type-erased vector of elements to be destroyed
      *        outside of lock.  Move large items to be destroyed here.
      *
      * \return true if garbage collection was done.
      */
-    bool gc(std::vector<std::any>& garbage) REQUIRES(mLock) {
-        if (mLog.size() < mHighWaterMark) return false;
-
-        auto eraseEnd = mLog.begin();
-        size_t toRemove = mLog.size() - mLowWaterMark;
-        // remove at least those elements.
-
-        // use a stale vector with precise type to avoid type erasure overhead in garbage
-        std::vector<std::shared_ptr<const mediametrics::Item>> stale;
-
-        for (size_t i = 0; i < toRemove; ++i) {
-            stale.emplace_back(std::move(eraseEnd->second));
-            ++eraseEnd; // amortized O(1)
+    bool gc(std::vector<std::any>& garbage)
+            NO_THREAD_SAFETY_ANALYSIS { // thread safety doesn't cover the array of locks
+        if (mSize < mHighWaterMark) return false;
+
+        // Lock all shards in order, as the oldest items may be in any shard.
+        std::unique_lock<std::mutex> locks[kLogShards];
+        for (size_t i = 0; i < kLogShards; ++i) {
+            locks[i] = std::unique_lock(mShards[i].mLock);
+        }
+        // Another thread may have collected meanwhile.
+        if (mSize < mHighWaterMark) return false;
+
+        // Find the time of the last item to remove, merging the shards in time order
+        // with a min-heap of the oldest unmerged item time of each shard.
+        const size_t toRemove = mSize - mLowWaterMark;
+        size_t heads[kLogShards];
+        std::vector<std::pair<int64_t /* time */, size_t /* shard */>> heap;
+        for (size_t i = 0; i < kLogShards; ++i) {
+            heads[i] = 0;
+            if (!mShards[i].mLog.empty()) heap.emplace_back(mShards[i].mLog[0].first, i);
         }
-        // ensure that eraseEnd is an lower bound on timeToErase.
-        const int64_t timeToErase = eraseEnd->first;
-        while (eraseEnd != mLog.end()) {
-            auto it = eraseEnd;
-            --it;  // amortized O(1)
-            if (it->first != timeToErase) {
-                break;  // eraseEnd represents a unique time jump.
+        std::make_heap(heap.begin(), heap.end(), std::greater<>());
+        int64_t timeToErase = INT64_MIN;
+        for (size_t i = 0; i < toRemove && !heap.empty(); ++i) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+            const size_t oldest = heap.back().second;
+            timeToErase = heap.back().first;
+            heap.pop_back();
+            if (++heads[oldest] < mShards[oldest].mLog.size()) {
+                heap.emplace_back(mShards[oldest].mLog[heads[oldest]].first, oldest);
+                std::push_heap(heap.begin(), heap.end(), std::greater<>());
             }
-            stale.emplace_back(std::move(eraseEnd->second));
-            ++eraseEnd;
         }
 
-        mLog.erase(mLog.begin(), eraseEnd);  // O(ptr_diff)
-
+        // use a stale vector with precise type to avoid type erasure overhead in garbage
+        std::vector<std::shared_ptr<const mediametrics::Item>> stale;
+        size_t itemMapSize = 0;
         size_t itemMapCount = 0;
-        for (auto it = mItemMap.begin(); it != mItemMap.end();) {
-            auto &keyHist = it->second;
-            auto it2 = keyHist.lower_bound(timeToErase);
-            if (it2 == keyHist.end()) {
-                garbage.emplace_back(std::move(keyHist)); // directly move keyhist to garbage
-                it = mItemMap.erase(it);
-            } else {
-                for (auto it3 = keyHist.begin(); it3 != it2; ++it3) {
-                    stale.emplace_back(std::move(it3->second));
+
+        for (Shard& shard : mShards) {
+            const auto eraseEnd = upperBound(shard.mLog, timeToErase);
+            for (auto it = shard.mLog.begin(); it != eraseEnd; ++it) {
+                stale.emplace_back(std::move(it->second));
+            }
+            mSize -= (size_t)(eraseEnd - shard.mLog.cbegin());
+            shard.mLog.erase(shard.mLog.begin(), eraseEnd);
+
+            for (auto it = shard.mItemMap.begin(); it != shard.mItemMap.end();) {
+                auto &keyHist = it->second;
+                auto it2 = upperBound(keyHist, timeToErase);
+                if (it2 == keyHist.end()) {
+                    garbage.emplace_back(std::move(keyHist)); // directly move keyhist to garbage
+                    it = shard.mItemMap.erase(it);
+                } else {
+                    for (auto it3 = keyHist.begin(); it3 != it2; ++it3) {
+                        stale.emplace_back(std::move(it3->second));
+                    }
+                    keyHist.erase(keyHist.begin(), it2);
+                    itemMapCount += keyHist.size();
+                    ++it;
                 }
-                keyHist.erase(keyHist.begin(), it2);
-                itemMapCount += keyHist.size();
-                 ++it;
             }
+            itemMapSize += shard.mItemMap.size();
         }
 
         garbage.emplace_back(std::move(stale));
 
         ALOGD("%s(%zu, %zu): log size:%zu item map size:%zu, item map items:%zu",
                 __func__, mLowWaterMark, mHighWaterMark,
-                mLog.size(), mItemMap.size(), itemMapCount);
+                mSize.load(), itemMapSize, itemMapCount);
         ++mGarbageCollectionCount;
         return true;
     }
 
-    static std::vector<std::shared_ptr<const mediametrics::Item>> getItemsInRange(
-            const MapTimeItem& map,
-            int64_t startTime = 0, int64_t endTime = INT64_MAX) {
-        auto it = map.lower_bound(startTime);
-        if (it == map.end()) return {};
-
-        auto it2 = map.upper_bound(endTime);
-
-        std::vector<std::shared_ptr<const mediametrics::Item>> ret;
-        while (it != it2) {
-            ret.push_back(it->second);
-            ++it;
+    static void appendItemsInRange(
+            const TimeItems& timeItems, int64_t startTime, int64_t endTime,
+            std::vector<std::shared_ptr<const mediametrics::Item>>& items,
+            const char *prefix = nullptr) {
+        if (startTime > endTime) return;
+        // Note: for our data, lowerBound(timeItems, 0) == timeItems.begin().
+        auto it = lowerBound(timeItems, startTime);
+        auto it2 = upperBound(timeItems, endTime);
+        for (; it != it2; ++it) {
+            if (prefix != nullptr && !startsWith(it->second->getKey(), prefix)) {
+                continue;
+            }
+            items.push_back(it->second);
         }
-        return ret;
     }
 
     const size_t mLowWaterMark = kLogItemsLowWater;
@@ -294,10 +408,8 @@ private:
 
     std::atomic<size_t> mGarbageCollectionCount{};
 
-    mutable std::mutex mLock;
-
-    MapTimeItem mLog GUARDED_BY(mLock);
-    std::map<std::string /* item_key */, MapTimeItem> mItemMap GUARDED_BY(mLock);
+    Shard mShards[kLogShards];
+    std::atomic<size_t> mSize{};  // Number of items in all shards.
 };
 
 } // namespace android::mediametrics
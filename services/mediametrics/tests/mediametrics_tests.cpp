@@ -18,6 +18,7 @@
 #include <utils/Log.h>
 
 #include <stdio.h>
+#include <algorithm>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -240,6 +241,41 @@ TEST(mediametrics_tests, instantiate) {
   mediaMetrics->dump(fileno(stdout), {} /* args */);
 }
 
+TEST(mediametrics_tests, submit_buffers) {
+  sp mediaMetrics = new MediaMetricsService();
+
+  std::unique_ptr<mediametrics::Item> audiotrack_key(mediametrics::Item::create("audiotrack"));
+  audiotrack_key->addInt32("foo", 10);
+  std::unique_ptr<mediametrics::Item> random_key(mediametrics::Item::create("random_key"));
+  random_key->setInt32("foo", 10);
+
+  std::vector<char> batch;
+  const auto append = [&batch](const mediametrics::Item &item) {
+    char *data;
+    size_t length;
+    ASSERT_EQ(NO_ERROR, item.writeToByteString(&data, &length));
+    batch.insert(batch.end(), data, data + length);
+    free(data);
+  };
+
+  // known keys are accepted
+  append(*audiotrack_key);
+  append(*audiotrack_key);
+  ASSERT_EQ(NO_ERROR, mediaMetrics->submitBuffers(batch.data(), batch.size()));
+
+  // random keys are ignored, the first failure is returned
+  append(*random_key);
+  append(*audiotrack_key);
+  ASSERT_EQ(PERMISSION_DENIED, mediaMetrics->submitBuffers(batch.data(), batch.size()));
+
+  // a truncated batch is rejected
+  ASSERT_EQ(BAD_VALUE, mediaMetrics->submitBuffers(batch.data(), batch.size() - 1));
+
+  ASSERT_EQ(NO_ERROR, mediaMetrics->submitBuffers(nullptr, 0));
+
+  mediaMetrics->dump(fileno(stdout), {} /* args */);
+}
+
 TEST(mediametrics_tests, package_installer_check) {
   ASSERT_EQ(false, MediaMetricsService::useUidForPackage(
       "abcd", "installer"));  // ok, package name has no dot.
@@ -713,6 +749,132 @@ TEST(mediametrics_tests, time_machine_gc) {
   printf("After\n%s\n", timeMachine.dump().first.c_str());
 }
 
+TEST(mediametrics_tests, time_machine_property_history) {
+  using PropertyHistory = android::mediametrics::TimeMachine::PropertyHistory;
+  PropertyHistory history;
+  // The previous std::multimap implementation: insert after equal times,
+  // then discard the oldest if full.
+  std::multimap<int64_t, int32_t> expected;
+  size_t maxElements = 0;
+  auto emplace = [&](int64_t time) {
+    const bool discarded = history.emplace(time, (int32_t)expected.size());
+    expected.emplace(time, (int32_t)expected.size());
+    if (discarded) {
+      maxElements = expected.size() - 1;
+      expected.erase(expected.begin());
+    }
+    ASSERT_EQ(expected.size(), history.size());
+    size_t i = 0;
+    for (const auto& [t, value] : expected) {
+      ASSERT_EQ(t, history[i].first) << "index " << i;
+      ASSERT_EQ(value, std::get<int32_t>(history[i].second)) << "index " << i;
+      ++i;
+    }
+  };
+
+  // Fill the ring with even times, then wrap around it more than once.
+  int64_t time = 0;
+  for (; maxElements == 0; time += 2) {
+    emplace(time);
+  }
+  ASSERT_GT(maxElements, (size_t)2);
+  for (size_t i = 0; i < maxElements * 5 / 2; ++i, time += 2) {
+    emplace(time);
+  }
+  ASSERT_EQ(maxElements, history.size());
+  ASSERT_EQ(time - 2, history.back().first);
+
+  // Out of order puts into the full, wrapped ring.
+  const int64_t oldest = history[0].first;
+  emplace(time - 5);                 // between the last two elements.
+  emplace(history[0].first + 1);     // becomes the oldest.
+  const int64_t middle = history[maxElements / 2].first;
+  emplace(middle);                   // equal time, inserted after.
+  ASSERT_EQ((size_t)2, history.upperBound(middle) - history.lowerBound(middle));
+  emplace(middle - 1);
+
+  // Older than all elements, dropped.
+  const int32_t oldestValue = std::get<int32_t>(history[0].second);
+  ASSERT_TRUE(history.emplace(oldest - 1, (int32_t)-1));
+  ASSERT_TRUE(history.emplace(history[0].first - 1, (int32_t)-1));
+  ASSERT_EQ(maxElements, history.size());
+  ASSERT_EQ(oldestValue, std::get<int32_t>(history[0].second));
+
+  // In order again, after the ring was rotated.
+  for (size_t i = 0; i < maxElements + 3; ++i, time += 2) {
+    emplace(time);
+  }
+
+  // Searches.
+  ASSERT_EQ((size_t)0, history.lowerBound(history[0].first));
+  ASSERT_EQ((size_t)1, history.upperBound(history[0].first));
+  ASSERT_EQ((size_t)0, history.upperBound(history[0].first - 1));
+  ASSERT_EQ(maxElements, history.upperBound(time));
+  ASSERT_EQ(maxElements - 1, history.lowerBound(history.back().first));
+}
+
+TEST(mediametrics_tests, time_machine_url) {
+  android::mediametrics::TimeMachine timeMachine;
+
+  auto item = std::make_shared<mediametrics::Item>("audio.track");
+  (*item).set("volume", (int32_t)1)
+         .set("12.volume", (int32_t)2);
+  ASSERT_EQ(NO_ERROR, timeMachine.put(item, true));
+
+  auto item2 = std::make_shared<mediametrics::Item>("audio.track.12");
+  (*item2).set("volume", (int32_t)3);
+  ASSERT_EQ(NO_ERROR, timeMachine.put(item2, true));
+
+  // The key is the longest prefix of the URL, before a '.', which is a key.
+  int32_t i32;
+  ASSERT_EQ(NO_ERROR, timeMachine.get("audio.track.volume", &i32, -1));
+  ASSERT_EQ(1, i32);
+  ASSERT_EQ(NO_ERROR, timeMachine.get("audio.track.12.volume", &i32, -1));
+  ASSERT_EQ(3, i32);
+  // audio.track.1 is not a key, and audio.track has no 1.volume property.
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("audio.track.1.volume", &i32, -1));
+
+  // The property is only looked up in the longest key.
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("audio.track.12.12.volume", &i32, -1));
+
+  ASSERT_EQ(NO_ERROR, timeMachine.put("audio.track.12.underrun", (int32_t)4));
+  ASSERT_EQ(NO_ERROR, timeMachine.get("audio.track.12", "underrun", &i32, -1));
+  ASSERT_EQ(4, i32);
+
+  ASSERT_EQ(BAD_VALUE, timeMachine.put("audio.track", (int32_t)5));
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("audio", &i32, -1));
+  ASSERT_EQ(BAD_VALUE, timeMachine.get(".volume", &i32, -1));
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("audio.record.volume", &i32, -1));
+}
+
+TEST(mediametrics_tests, time_machine_timed_get) {
+  android::mediametrics::TimeMachine timeMachine;
+  auto item = std::make_shared<mediametrics::Item>("Key");
+  constexpr int32_t kPuts = 200;
+  for (int32_t i = 0; i < kPuts; ++i) {
+    (*item).set("i32", i)
+           .setTimestamp(10 * (i + 1));
+    ASSERT_EQ(NO_ERROR, timeMachine.put(item, true));
+  }
+
+  // The newest values are kept, read as of a time between puts.
+  int32_t i32;
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.i32", &i32, -1, 10 * kPuts + 5));
+  ASSERT_EQ(kPuts - 1, i32);
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.i32", &i32, -1, 10 * (kPuts - 10) + 5));
+  ASSERT_EQ(kPuts - 11, i32);
+
+  // The oldest values were discarded.
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Key.i32", &i32, -1, 15));
+
+  // A value put out of order is read in time order.
+  ASSERT_EQ(NO_ERROR, timeMachine.put("Key.i32", (int32_t)-1, 10 * (kPuts - 10) + 2));
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.i32", &i32, -1, 10 * (kPuts - 10) + 5));
+  ASSERT_EQ(-1, i32);
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.i32", &i32, -1, 10 * (kPuts - 9)));
+  ASSERT_EQ(kPuts - 10, i32);
+}
+
 TEST(mediametrics_tests, transaction_log_gc) {
   auto item = std::make_shared<mediametrics::Item>("Key1");
   (*item).set("one", (int32_t)1)
@@ -743,6 +905,38 @@ TEST(mediametrics_tests, transaction_log_gc) {
   ASSERT_EQ((size_t)2, transactionLog.size());
 }
 
+TEST(mediametrics_tests, transaction_log_order) {
+  android::mediametrics::TransactionLog transactionLog;
+
+  // items of many keys, some put out of time order.
+  for (int64_t i = 0; i < 100; ++i) {
+    auto item = std::make_shared<mediametrics::Item>("Key" + std::to_string(i % 10));
+    (*item).set("value", (int32_t)i)
+           .setTimestamp(100 + (i % 7 == 0 ? i - 5 : i));
+    ASSERT_EQ(NO_ERROR, transactionLog.put(item));
+  }
+  ASSERT_EQ((size_t)100, transactionLog.size());
+
+  // all keys are merged in time order.
+  auto items = transactionLog.get();
+  ASSERT_EQ((size_t)100, items.size());
+  for (size_t i = 1; i < items.size(); ++i) {
+    ASSERT_LE(items[i - 1]->getTimestamp(), items[i]->getTimestamp());
+  }
+  ASSERT_EQ((size_t)std::count_if(items.begin(), items.end(), [](const auto &item) {
+                return item->getTimestamp() >= 150 && item->getTimestamp() <= 159; }),
+            transactionLog.get(150, 159).size());
+
+  items = transactionLog.get("Key3");
+  ASSERT_EQ((size_t)10, items.size());
+  for (size_t i = 0; i < items.size(); ++i) {
+    ASSERT_EQ("Key3", items[i]->getKey());
+    if (i > 0) {
+      ASSERT_LE(items[i - 1]->getTimestamp(), items[i]->getTimestamp());
+    }
+  }
+}
+
 TEST(mediametrics_tests, analytics_actions) {
   mediametrics::AnalyticsActions analyticsActions;
   bool action1 = false;
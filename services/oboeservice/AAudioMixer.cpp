@@ -21,6 +21,7 @@
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include <cstring>
+#include <audio_utils/primitives.h>
 #include <utils/Trace.h>
 
 #include "AAudioMixer.h"
@@ -88,7 +89,7 @@ int32_t AAudioMixer::mix(
             if (framesToMixFromPart > framesAvailableFromPart) {
                 framesToMixFromPart = framesAvailableFromPart;
             }
-            mixPart(destination, (float *)wrappingBuffer.data[partIndex],
+            mixPart(destination, (const float *)wrappingBuffer.data[partIndex],
                     framesToMixFromPart);
 
             destination += framesToMixFromPart * mSamplesPerFrame;
@@ -105,12 +106,13 @@ int32_t AAudioMixer::mix(
     return (framesDesired - framesLeft); // framesRead
 }
 
-void AAudioMixer::mixPart(float *destination, float *source, int32_t numFrames) {
-    int32_t numSamples = numFrames * mSamplesPerFrame;
-    // TODO maybe optimize using SIMD
-    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++) {
-        *destination++ += *source++;
-    }
+void AAudioMixer::mixPart(float *destination, const float *source, int32_t numFrames) {
+    // accumulate_float() is vectorized.
+    accumulate_float(destination, source, numFrames * mSamplesPerFrame);
+}
+
+void AAudioMixer::accumulate(const AAudioMixer &other) {
+    mixPart(mOutputBuffer.get(), other.mOutputBuffer.get(), mFramesPerBurst);
 }
 
 float *AAudioMixer::getOutputBuffer() {
@@ -41,12 +41,19 @@ public:
                 const std::shared_ptr<android::FifoBuffer>& fifo,
                 bool allowUnderflow);
 
+    /**
+     * Add the output of another mixer, allocated with the same parameters, to this one.
+     * This is used to combine streams mixed on a helper thread.
+     * @param other mixer to read from
+     */
+    void accumulate(const AAudioMixer &other);
+
     float *getOutputBuffer();
 
     int32_t getFramesPerBurst() const { return mFramesPerBurst; }
 
 private:
-    void mixPart(float *destination, float *source, int32_t numFrames);
+    void mixPart(float *destination, const float *source, int32_t numFrames);
 
     std::unique_ptr<float[]> mOutputBuffer;
     int32_t  mSamplesPerFrame = 0;
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AAudioMixerHelper"
+//#define LOG_NDEBUG 0
+#include <utils/Log.h>
+
+#define ATRACE_TAG ATRACE_TAG_AUDIO
+
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
+#include <utils/Trace.h>
+
+#include "AAudioMixerHelper.h"
+
+using namespace aaudio;
+
+AAudioMixerHelper::AAudioMixerHelper(std::function<void()> mixFunction)
+        : mMixFunction(std::move(mixFunction)) {}
+
+AAudioMixerHelper::~AAudioMixerHelper() {
+    stop();
+}
+
+aaudio_result_t AAudioMixerHelper::start() {
+    if (mThread.joinable()) {
+        ALOGE("%s() already started", __func__);
+        return AAUDIO_ERROR_INVALID_STATE;
+    }
+    mThread = std::thread(&AAudioMixerHelper::threadLoop, this);
+    pthread_setname_np(mThread.native_handle(), "AAudioMixHelper");
+
+    // The helper is on the critical path of the mixer so it needs the same priority.
+    int policy;
+    sched_param param;
+    if (pthread_getschedparam(pthread_self(), &policy, &param) == 0 && policy != SCHED_OTHER) {
+        const int err = pthread_setschedparam(mThread.native_handle(), policy, &param);
+        ALOGW_IF(err != 0, "%s() cannot set scheduling policy %d priority %d, error %d",
+                 __func__, policy, param.sched_priority, err);
+    }
+    return AAUDIO_OK;
+}
+
+void AAudioMixerHelper::stop() {
+    if (!mThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExitPending = true;
+    }
+    mCondition.notify_all();
+    mThread.join();
+}
+
+void AAudioMixerHelper::startMix() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        ALOGW_IF(mDoneCount != mRequestCount, "%s() helper is busy", __func__);
+        mRequestCount++;
+    }
+    mCondition.notify_all();
+}
+
+bool AAudioMixerHelper::waitMix(int64_t timeoutNanos) {
+    std::unique_lock<std::mutex> lock(mLock);
+    return mCondition.wait_for(lock, std::chrono::nanoseconds(timeoutNanos),
+            [this]() REQUIRES(mLock) { return mDoneCount == mRequestCount; });
+}
+
+bool AAudioMixerHelper::isIdle() {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mDoneCount == mRequestCount;
+}
+
+void AAudioMixerHelper::threadLoop() {
+    std::unique_lock<std::mutex> lock(mLock);
+    for (;;) {
+        // Finish a mix that was started before exiting, so the mixer can use its result.
+        mCondition.wait(lock, [this]() REQUIRES(mLock) {
+            return mRequestCount != mDoneCount || mExitPending;
+        });
+        if (mRequestCount == mDoneCount) {
+            break; // mExitPending
+        }
+        const int32_t request = mRequestCount;
+        lock.unlock();
+        ATRACE_BEGIN("aaMixHelper");
+        mMixFunction();
+        ATRACE_END();
+        lock.lock();
+        mDoneCount = request;
+        mCondition.notify_all();
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAUDIO_AAUDIO_MIXER_HELPER_H
+#define AAUDIO_AAUDIO_MIXER_HELPER_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <aaudio/AAudio.h>
+#include <android-base/thread_annotations.h>
+
+namespace aaudio {
+
+/**
+ * A second thread for the mixer of a shared endpoint with many streams.
+ *
+ * Each burst, the mixer thread calls startMix() so that the helper runs the mix function,
+ * which mixes some of the streams into a second AAudioMixer, while the mixer thread mixes
+ * the others. The mixer thread then calls waitMix() with a timeout so that a late helper
+ * cannot make the write to the device late as well.
+ */
+class AAudioMixerHelper {
+public:
+    /**
+     * @param mixFunction called on the helper thread for each startMix()
+     */
+    explicit AAudioMixerHelper(std::function<void()> mixFunction);
+
+    ~AAudioMixerHelper();
+
+    /**
+     * Start the helper thread, with the scheduling policy and priority of the caller,
+     * which should be the mixer thread.
+     */
+    aaudio_result_t start();
+
+    /**
+     * Wait for the mix in progress, if any, then join the helper thread.
+     */
+    void stop();
+
+    /**
+     * Run the mix function on the helper thread.
+     * The helper must be idle.
+     */
+    void startMix();
+
+    /**
+     * Wait for the mix started by startMix() to complete.
+     *
+     * @param timeoutNanos maximum time to wait
+     * @return true if the helper is idle
+     */
+    bool waitMix(int64_t timeoutNanos);
+
+    /**
+     * @return true if no mix is in progress
+     */
+    bool isIdle();
+
+private:
+    void threadLoop();
+
+    const std::function<void()> mMixFunction;
+
+    std::mutex              mLock;
+    std::condition_variable mCondition;
+    int32_t                 mRequestCount GUARDED_BY(mLock) = 0;
+    int32_t                 mDoneCount GUARDED_BY(mLock) = 0;
+    bool                    mExitPending GUARDED_BY(mLock) = false;
+    std::thread             mThread;
+};
+
+} /* namespace aaudio */
+
+#endif //AAUDIO_AAUDIO_MIXER_HELPER_H
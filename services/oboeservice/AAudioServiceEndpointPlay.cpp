@@ -31,6 +31,7 @@
 #include <vector>
 
 #include "core/AudioStreamBuilder.h"
+#include "utility/AAudioUtilities.h"
 #include "AAudioServiceEndpoint.h"
 #include "AAudioServiceStreamShared.h"
 #include "AAudioServiceEndpointPlay.h"
@@ -51,6 +52,9 @@ aaudio_result_t AAudioServiceEndpointPlay::open(const aaudio::AAudioStreamReques
     if (result == AAUDIO_OK) {
         mMixer.allocate(getStreamInternal()->getSamplesPerFrame(),
                         getStreamInternal()->getFramesPerBurst());
+        mHelperMixer.allocate(getStreamInternal()->getSamplesPerFrame(),
+                              getStreamInternal()->getFramesPerBurst());
+        mMinStreamsForHelper = AAudioProperty_getMixerHelperMinStreams();
 
         int32_t burstsPerBuffer = AudioSystem::getAAudioMixerBurstCount();
         if (burstsPerBuffer == 0) {
@@ -63,11 +67,79 @@ aaudio_result_t AAudioServiceEndpointPlay::open(const aaudio::AAudioStreamReques
     return result;
 }
 
+// Mix one application stream into the mixer and update its timing.
+void AAudioServiceEndpointPlay::mixStream(AAudioMixer &mixer, const MixerStream &mixerStream,
+                                          int64_t mmapFramesWritten) {
+    int64_t clientFramesRead = 0;
+    sp<AAudioServiceStreamShared> streamShared =
+            static_cast<AAudioServiceStreamShared *>(mixerStream.stream.get());
+
+    {
+        // Lock the AudioFifo to protect against close.
+        std::lock_guard <std::mutex> lock(streamShared->audioDataQueueLock);
+        std::shared_ptr<SharedRingBuffer> audioDataQueue
+                = streamShared->getAudioDataQueue_l();
+        std::shared_ptr<FifoBuffer> fifo;
+        if (audioDataQueue && (fifo = audioDataQueue->getFifoBuffer())) {
+
+            // Determine offset between framePosition in client's stream
+            // vs the underlying MMAP stream.
+            clientFramesRead = fifo->getReadCounter();
+            // These two indices refer to the same frame.
+            int64_t positionOffset = mmapFramesWritten - clientFramesRead;
+            streamShared->setTimestampPositionOffset(positionOffset);
+
+            int32_t framesMixed = mixer.mix(mixerStream.index, fifo,
+                                            mixerStream.allowUnderflow);
+
+            if (streamShared->isFlowing()) {
+                // Consider it an underflow if we got less than a burst
+                // after the data started flowing.
+                bool underflowed = mixerStream.allowUnderflow
+                                   && framesMixed < mixer.getFramesPerBurst();
+                if (underflowed) {
+                    streamShared->incrementXRunCount();
+                }
+            } else if (framesMixed > 0) {
+                // Mark beginning of data flow after a start.
+                streamShared->setFlowing(true);
+            }
+            clientFramesRead = fifo->getReadCounter();
+        }
+    }
+
+    if (clientFramesRead > 0) {
+        // This timestamp represents the completion of data being read out of the
+        // client buffer. It is sent to the client and used in the timing model
+        // to decide when the client has room to write more data.
+        Timestamp timestamp(clientFramesRead, AudioClock::getNanoseconds());
+        streamShared->markTransferTime(timestamp);
+    }
+}
+
+// Called by the helper thread.
+void AAudioServiceEndpointPlay::mixHelperStreams() {
+    mHelperMixer.clear();
+    for (const auto& mixerStream : mHelperStreams) {
+        mixStream(mHelperMixer, mixerStream, mHelperMmapFramesWritten);
+    }
+}
+
+bool AAudioServiceEndpointPlay::isHelperStream(const sp<AAudioServiceStreamBase>& stream) const {
+    return std::any_of(mHelperStreams.begin(), mHelperStreams.end(),
+            [&stream](const MixerStream& mixerStream) {
+                return mixerStream.stream == stream;
+            });
+}
+
 // Mix data from each application stream and write result to the shared MMAP stream.
 void *AAudioServiceEndpointPlay::callbackLoop() {
     ALOGD("%s() entering >>>>>>>>>>>>>>> MIXER", __func__);
     aaudio_result_t result = AAUDIO_OK;
     int64_t timeoutNanos = getStreamInternal()->calculateReasonableTimeout();
+    // A helper later than this is not waited for, so that the write is on time.
+    const int64_t helperTimeoutNanos = getFramesPerBurst() * AAUDIO_NANOS_PER_SECOND
+            / getSampleRate() / 2;
 
     // result might be a frame count
     while (mCallbackEnabled.load() && getStreamInternal()->isActive() && (result >= 0)) {
@@ -78,9 +150,21 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
             int index = 0;
             int64_t mmapFramesWritten = getStreamInternal()->getFramesWritten();
 
+            // When the helper missed the previous write, it still owns its streams.
+            // They are not mixed again until its late mix has been added to the output,
+            // so their data is delayed by a burst rather than lost.
+            bool helperOwnsStreams = false;
+            if (mHelperLate) {
+                helperOwnsStreams = true;
+                if (mHelper->isIdle()) {
+                    mMixer.accumulate(mHelperMixer);
+                    mHelperLate = false;
+                }
+            }
+
             std::lock_guard <std::mutex> lock(mLockStreams);
+            mMixerStreams.clear();
             for (const auto& clientStream : mRegisteredStreams) {
-                int64_t clientFramesRead = 0;
                 bool allowUnderflow = true;
 
                 if (clientStream->isSuspended()) {
@@ -95,51 +179,43 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
                     continue; // this stream is not running so skip it.
                 }
 
-                sp<AAudioServiceStreamShared> streamShared =
-                        static_cast<AAudioServiceStreamShared *>(clientStream.get());
-
-                {
-                    // Lock the AudioFifo to protect against close.
-                    std::lock_guard <std::mutex> lock(streamShared->audioDataQueueLock);
-                    std::shared_ptr<SharedRingBuffer> audioDataQueue
-                            = streamShared->getAudioDataQueue_l();
-                    std::shared_ptr<FifoBuffer> fifo;
-                    if (audioDataQueue && (fifo = audioDataQueue->getFifoBuffer())) {
-
-                        // Determine offset between framePosition in client's stream
-                        // vs the underlying MMAP stream.
-                        clientFramesRead = fifo->getReadCounter();
-                        // These two indices refer to the same frame.
-                        int64_t positionOffset = mmapFramesWritten - clientFramesRead;
-                        streamShared->setTimestampPositionOffset(positionOffset);
-
-                        int32_t framesMixed = mMixer.mix(index, fifo, allowUnderflow);
-
-                        if (streamShared->isFlowing()) {
-                            // Consider it an underflow if we got less than a burst
-                            // after the data started flowing.
-                            bool underflowed = allowUnderflow
-                                               && framesMixed < mMixer.getFramesPerBurst();
-                            if (underflowed) {
-                                streamShared->incrementXRunCount();
-                            }
-                        } else if (framesMixed > 0) {
-                            // Mark beginning of data flow after a start.
-                            streamShared->setFlowing(true);
-                        }
-                        clientFramesRead = fifo->getReadCounter();
-                    }
+                if (!(helperOwnsStreams && isHelperStream(clientStream))) {
+                    mMixerStreams.push_back({clientStream, index, allowUnderflow});
                 }
+                index++; // just used for labelling tracks in systrace
+            }
 
-                if (clientFramesRead > 0) {
-                    // This timestamp represents the completion of data being read out of the
-                    // client buffer. It is sent to the client and used in the timing model
-                    // to decide when the client has room to write more data.
-                    Timestamp timestamp(clientFramesRead, AudioClock::getNanoseconds());
-                    streamShared->markTransferTime(timestamp);
+            // With many streams, give half of them to the helper thread.
+            const bool useHelper = !helperOwnsStreams && mMinStreamsForHelper > 0
+                    && mMixerStreams.size() >= mMinStreamsForHelper;
+            if (!helperOwnsStreams) {
+                mHelperStreams.clear();
+            }
+            if (useHelper) {
+                if (mHelper == nullptr) {
+                    mHelper = std::make_unique<AAudioMixerHelper>(
+                            [this]() { mixHelperStreams(); });
+                    mHelper->start();
                 }
+                const size_t numMixerStreams = (mMixerStreams.size() + 1) / 2;
+                mHelperStreams.assign(mMixerStreams.begin() + numMixerStreams,
+                                      mMixerStreams.end());
+                mMixerStreams.resize(numMixerStreams);
+                mHelperMmapFramesWritten = mmapFramesWritten;
+                mHelper->startMix();
+            }
 
-                index++; // just used for labelling tracks in systrace
+            for (const auto& mixerStream : mMixerStreams) {
+                mixStream(mMixer, mixerStream, mmapFramesWritten);
+            }
+
+            if (useHelper) {
+                if (mHelper->waitMix(helperTimeoutNanos)) {
+                    mMixer.accumulate(mHelperMixer);
+                } else {
+                    ALOGW("%s() helper mix is late, added to the next burst", __func__);
+                    mHelperLate = true;
+                }
             }
         }
 
@@ -157,6 +233,14 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
         }
     }
 
+    if (mHelper != nullptr) {
+        mHelper->stop();
+        mHelper.reset();
+    }
+    mHelperLate = false;
+    mHelperStreams.clear();
+    mMixerStreams.clear();
+
     ALOGD("%s() exiting, enabled = %d, state = %d, result = %d <<<<<<<<<<<<< MIXER",
           __func__, mCallbackEnabled.load(), getStreamInternal()->getState(), result);
     return nullptr; // TODO review
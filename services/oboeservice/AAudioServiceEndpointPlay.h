@@ -19,6 +19,7 @@
 
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <vector>
 
 #include "client/AudioStreamInternal.h"
@@ -28,6 +29,7 @@
 #include "AAudioServiceStreamShared.h"
 #include "AAudioServiceStreamMMAP.h"
 #include "AAudioMixer.h"
+#include "AAudioMixerHelper.h"
 #include "AAudioService.h"
 
 namespace aaudio {
@@ -44,8 +46,36 @@ public:
     void *callbackLoop() override;
 
 private:
+    // A stream to be mixed in the current burst.
+    struct MixerStream {
+        android::sp<AAudioServiceStreamBase> stream;
+        int                                  index; // for labelling tracks in systrace
+        bool                                 allowUnderflow;
+    };
+
+    void mixStream(AAudioMixer &mixer, const MixerStream &mixerStream,
+                   int64_t mmapFramesWritten);
+
+    void mixHelperStreams();
+
+    bool isHelperStream(const android::sp<AAudioServiceStreamBase>& stream) const;
+
     bool                     mLatencyTuningEnabled = false; // TODO implement tuning
     AAudioMixer              mMixer;    //
+
+    // Only used by the mixer thread.
+    std::vector<MixerStream> mMixerStreams;
+    // With at least this many active streams, half of them are mixed on a helper thread.
+    // 0 disables the helper, see AAudioProperty_getMixerHelperMinStreams().
+    size_t                   mMinStreamsForHelper = 0;
+    std::unique_ptr<AAudioMixerHelper> mHelper;
+    bool                     mHelperLate = false; // the helper missed the last write
+
+    // Written by the mixer thread before startMix(), then used by the helper thread
+    // until the mix is complete.
+    AAudioMixer              mHelperMixer;
+    std::vector<MixerStream> mHelperStreams;
+    int64_t                  mHelperMmapFramesWritten = 0;
 };
 
 } /* namespace aaudio */
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Simulates the mixer of a shared MMAP endpoint with N client streams,
+// each with a stereo float FIFO holding two bursts.
+// BM_MixSerial mixes every stream on the calling thread.
+// BM_MixWithHelper mixes half of the streams on an AAudioMixerHelper,
+// as AAudioServiceEndpointPlay does when its helper is enabled, see
+// AAudioProperty_getMixerHelperMinStreams().  Compare the two on the target device,
+// with several CPUs available, to choose that property.
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "AAudioMixer.h"
+#include "AAudioMixerHelper.h"
+
+using android::FifoBuffer;
+using android::FifoBufferAllocated;
+
+static constexpr int32_t kChannelCount = 2;
+static constexpr int32_t kBytesPerFrame = kChannelCount * sizeof(float);
+
+static std::vector<std::shared_ptr<FifoBuffer>> makeFifos(int32_t numStreams,
+                                                          int32_t framesPerBurst) {
+    std::vector<std::shared_ptr<FifoBuffer>> fifos;
+    for (int32_t i = 0; i < numStreams; i++) {
+        fifos.push_back(std::make_shared<FifoBufferAllocated>(kBytesPerFrame,
+                                                              2 * framesPerBurst));
+    }
+    return fifos;
+}
+
+// Simulate each client writing a burst.
+static void writeBursts(const std::vector<std::shared_ptr<FifoBuffer>>& fifos,
+                        int32_t framesPerBurst) {
+    for (const auto& fifo : fifos) {
+        fifo->advanceWriteIndex(framesPerBurst);
+    }
+}
+
+// Args: number of streams, frames per burst.
+static void BM_MixSerial(benchmark::State& state) {
+    const int32_t numStreams = state.range(0);
+    const int32_t framesPerBurst = state.range(1);
+    auto fifos = makeFifos(numStreams, framesPerBurst);
+    AAudioMixer mixer;
+    mixer.allocate(kChannelCount, framesPerBurst);
+
+    for (auto _ : state) {
+        writeBursts(fifos, framesPerBurst);
+        mixer.clear();
+        for (int32_t i = 0; i < numStreams; i++) {
+            mixer.mix(i, fifos[i], true /* allowUnderflow */);
+        }
+        benchmark::DoNotOptimize(mixer.getOutputBuffer());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * numStreams * framesPerBurst);
+}
+
+static void BM_MixWithHelper(benchmark::State& state) {
+    const int32_t numStreams = state.range(0);
+    const int32_t framesPerBurst = state.range(1);
+    const int32_t numMixerStreams = (numStreams + 1) / 2;
+    auto fifos = makeFifos(numStreams, framesPerBurst);
+    AAudioMixer mixer;
+    mixer.allocate(kChannelCount, framesPerBurst);
+    AAudioMixer helperMixer;
+    helperMixer.allocate(kChannelCount, framesPerBurst);
+    aaudio::AAudioMixerHelper helper([&]() {
+        helperMixer.clear();
+        for (int32_t i = numMixerStreams; i < numStreams; i++) {
+            helperMixer.mix(i, fifos[i], true /* allowUnderflow */);
+        }
+    });
+    helper.start();
+
+    for (auto _ : state) {
+        writeBursts(fifos, framesPerBurst);
+        mixer.clear();
+        helper.startMix();
+        for (int32_t i = 0; i < numMixerStreams; i++) {
+            mixer.mix(i, fifos[i], true /* allowUnderflow */);
+        }
+        // Wait without limit so that every iteration includes the whole mix.
+        helper.waitMix(INT64_MAX);
+        mixer.accumulate(helperMixer);
+        benchmark::DoNotOptimize(mixer.getOutputBuffer());
+        benchmark::ClobberMemory();
+    }
+    helper.stop();
+    state.SetItemsProcessed(state.iterations() * numStreams * framesPerBurst);
+}
+
+static void MixerArgs(benchmark::internal::Benchmark* b) {
+    for (int framesPerBurst : {96, 192}) {
+        for (int numStreams : {1, 2, 4, 8, 16, 32}) {
+            b->Args({numStreams, framesPerBurst});
+        }
+    }
+}
+
+BENCHMARK(BM_MixSerial)->Apply(MixerArgs)->UseRealTime();
+BENCHMARK(BM_MixWithHelper)->Apply(MixerArgs)->UseRealTime();
+
+BENCHMARK_MAIN();